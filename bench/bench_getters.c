@@ -0,0 +1,819 @@
+/**
+ * @file bench_getters.c
+ * @brief Benchmark de las funciones que leen /proc, sobre árboles de procfs capturados o generados.
+ *
+ * Recorre cada árbol pasado como argumento y, además, uno generado que emula un host grande (256 CPUs, 500 discos y
+ * 5000 interfaces). Para cada función informa los nanosegundos por llamada, el throughput de parseo (MB/s del
+ * contenido leído) y las reservas de memoria por llamada en régimen, es decir, después de las primeras llamadas que
+ * dimensionan las tablas. Al final mide el ciclo completo: todas las funciones seguidas, como en un tick del
+ * exportador, y falla si en régimen el ciclo reserva memoria.
+ *
+ * Sobre cada árbol mide también el exportador completo: todos los colectores (los de procesos y cgroups incluidos, este
+ * último sobre una jerarquía cgroup v2 generada) ejecutados en sus hilos y la publicación de la exposición como
+ * instantánea (con su copia gzip) mientras un scrape tiene tomada la anterior. Tampoco debe reservar memoria en
+ * régimen.
+ *
+ * Las reservas se cuentan reemplazando malloc(), calloc(), realloc() y las variantes alineadas en el propio binario,
+ * que las reenvía a las de glibc (__libc_malloc() y compañía). Así cuentan también las que hace la libc por dentro
+ * (fopen(), opendir(), strdup(), getline(), regexec()...), que --wrap del enlazador no veía.
+ */
+
+#include "../include/collector.h"
+#include "../include/expose_metrics.h"
+#include "../include/metrics.h"
+#include "../include/metrics_snapshot.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Tiempo mínimo de medición por caso, en nanosegundos.
+ */
+#define BENCH_MIN_NS 200000000ULL
+
+/**
+ * @brief Llamadas de calentamiento antes de medir (la primera dimensiona las tablas y la segunda calcula tasas).
+ */
+#define BENCH_WARMUP 2
+
+/**
+ * @brief Ciclos seguidos sin reservas con los que el exportador se considera dimensionado antes de medirlo.
+ */
+#define EXPORTER_SETTLED 4
+
+/**
+ * @brief Tiempo máximo para que el exportador se dimensione, en nanosegundos.
+ */
+#define EXPORTER_SETTLE_NS 10000000000ULL
+
+/**
+ * @brief Cantidad de CPUs del árbol generado.
+ */
+#define LARGE_CPUS 256
+
+/**
+ * @brief Cantidad de dispositivos de bloque del árbol generado.
+ */
+#define LARGE_DISKS 500
+
+/**
+ * @brief Cantidad de interfaces de red del árbol generado.
+ */
+#define LARGE_IFACES 5000
+
+/**
+ * @brief Archivos de un árbol de procfs que leen las funciones medidas, relativos a la raíz.
+ */
+static const char* const tree_files[] = {
+    "stat", "meminfo", "vmstat", "diskstats", "net/dev", "loadavg", "pressure/cpu", "pressure/memory", "pressure/io",
+};
+
+/**
+ * @brief Archivos de cada cgroup de la jerarquía generada.
+ */
+static const char* const cgroup_files[] = {"cgroup.controllers", "cpu.stat", "memory.current"};
+
+/**
+ * @brief Cgroups hijos de la raíz en la jerarquía generada.
+ */
+static const char* const cgroup_children[] = {"system.slice", "user.slice"};
+
+/**
+ * @brief Reservas de memoria hechas desde el código del exportador (también desde los hilos de los colectores).
+ */
+static atomic_ullong allocations;
+
+/**
+ * @brief Acumulador para que el compilador no descarte los resultados.
+ */
+static volatile unsigned long long sink;
+
+/**
+ * @brief Colectores del exportador medidos por run_exporter().
+ */
+static collector_registry_t exporter;
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+/**
+ * @brief Reemplazo de malloc() que cuenta la reserva.
+ * @param size Bytes a reservar.
+ * @return Memoria reservada, o NULL.
+ */
+void* malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+
+/**
+ * @brief Reemplazo de calloc() que cuenta la reserva.
+ * @param count Cantidad de elementos.
+ * @param size Tamaño de cada elemento.
+ * @return Memoria reservada e inicializada en cero, o NULL.
+ */
+void* calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+/**
+ * @brief Reemplazo de realloc() que cuenta la reserva.
+ * @param ptr Memoria a agrandar o achicar.
+ * @param size Nuevo tamaño.
+ * @return Memoria reservada, o NULL.
+ */
+void* realloc(void* ptr, size_t size)
+{
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+/**
+ * @brief Reemplazo de aligned_alloc() que cuenta la reserva.
+ * @param alignment Alineación.
+ * @param size Bytes a reservar.
+ * @return Memoria reservada, o NULL.
+ */
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    allocations++;
+    return __libc_memalign(alignment, size);
+}
+
+/**
+ * @brief Reemplazo de posix_memalign() que cuenta la reserva.
+ * @param ptr Donde se devuelve la memoria reservada.
+ * @param alignment Alineación.
+ * @param size Bytes a reservar.
+ * @return 0 si se reservó, ENOMEM si falta memoria.
+ */
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    allocations++;
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr != NULL ? 0 : ENOMEM;
+}
+
+/**
+ * @brief Reemplazo de free() para que toda la memoria pase por el mismo asignador.
+ * @param ptr Memoria a liberar.
+ */
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+/**
+ * @brief Devuelve el tiempo monotónico en nanosegundos.
+ * @return Tiempo actual.
+ */
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * @brief Lee /proc/stat y calcula el uso por núcleo.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+static int run_stat(void)
+{
+    // get_cpu_usage() se omite: es aritmética sobre la instantánea y, con un árbol fijo, informa un error por llamada
+    proc_stat_snapshot_t snapshot;
+    if (read_proc_stat(&snapshot) != 0)
+    {
+        return -1;
+    }
+    sink += snapshot.ctxt + get_cpu_core_usage()->count;
+    return 0;
+}
+
+/**
+ * @brief Lee /proc/meminfo.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+static int run_meminfo(void)
+{
+    const meminfo_snapshot_t* mem = get_meminfo();
+    if (mem == NULL)
+    {
+        return -1;
+    }
+    sink += mem->mem_available;
+    return 0;
+}
+
+/**
+ * @brief Lee /proc/vmstat y calcula las tasas.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+static int run_vmstat(void)
+{
+    return get_vmstat_rates() != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Lee /proc/diskstats y calcula las tasas por disco.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+static int run_diskstats(void)
+{
+    const disk_table_t* disks = get_disk_stats();
+    if (disks == NULL)
+    {
+        return -1;
+    }
+    sink += disks->used;
+    return 0;
+}
+
+/**
+ * @brief Lee /proc/net/dev y calcula las tasas por interfaz.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+static int run_net_dev(void)
+{
+    const net_table_t* ifaces = get_net_stats();
+    if (ifaces == NULL)
+    {
+        return -1;
+    }
+    sink += ifaces->used;
+    return 0;
+}
+
+/**
+ * @brief Lee /proc/loadavg.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+static int run_loadavg(void)
+{
+    loadavg_snapshot_t load;
+    if (read_loadavg(&load) != 0)
+    {
+        return -1;
+    }
+    sink += load.entities;
+    return 0;
+}
+
+/**
+ * @brief Lee los archivos de /proc/pressure (los que falten en el árbol se omiten, como en el exportador).
+ * @return 0.
+ */
+static int run_pressure(void)
+{
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        const pressure_sample_t* pressure = get_pressure_stats((pressure_resource_t)r);
+        sink += pressure != NULL ? pressure->present : 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Ejecuta todos los colectores y publica la exposición mientras un scrape tiene tomada la anterior.
+ * @return 0.
+ */
+static int run_exporter(void)
+{
+    collector_registry_run_all(&exporter);
+    metrics_snapshot_t* scrape = metrics_snapshot_acquire();
+    publish_metrics(&exporter);
+    metrics_snapshot_release(scrape);
+    return 0;
+}
+
+/**
+ * @brief Función medida y archivos que lee.
+ */
+typedef struct
+{
+    const char* name; /**< Nombre del caso. */
+    int (*run)(void); /**< Función a medir; 0 si leyó, -1 en caso de error. */
+    size_t first;     /**< Primer archivo que lee, en tree_files. */
+    size_t count;     /**< Cantidad de archivos consecutivos que lee. */
+} getter_t;
+
+/**
+ * @brief Funciones medidas, en el orden de un ciclo del exportador.
+ */
+static const getter_t getters[] = {
+    {"stat", run_stat, 0, 1},
+    {"meminfo", run_meminfo, 1, 1},
+    {"vmstat", run_vmstat, 2, 1},
+    {"diskstats", run_diskstats, 3, 1},
+    {"net/dev", run_net_dev, 4, 1},
+    {"loadavg", run_loadavg, 5, 1},
+    {"pressure", run_pressure, 6, 3},
+};
+
+/**
+ * @brief Cantidad de funciones medidas.
+ */
+#define GETTER_COUNT (sizeof(getters) / sizeof(getters[0]))
+
+/**
+ * @brief Ejecuta todas las funciones seguidas, como un ciclo del exportador.
+ * @return 0 si todas leyeron, -1 si alguna falló.
+ */
+static int run_tick(void)
+{
+    int ret = 0;
+    for (size_t i = 0; i < GETTER_COUNT; i++)
+    {
+        ret |= getters[i].run();
+    }
+    return ret;
+}
+
+/**
+ * @brief Mide una función.
+ * @param run Función a medir.
+ * @param ns Nanosegundos promedio por llamada.
+ * @param allocs Reservas promedio por llamada.
+ * @return 0 si todas las llamadas leyeron, -1 si alguna falló.
+ */
+static int measure(int (*run)(void), double* ns, double* allocs)
+{
+    int ret = 0;
+    for (int i = 0; i < BENCH_WARMUP; i++)
+    {
+        ret |= run();
+    }
+
+    unsigned long long iterations = 0, start = now_ns(), elapsed, before = allocations;
+    do
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            ret |= run();
+        }
+        iterations += 16;
+        elapsed = now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+    *ns = (double)elapsed / (double)iterations;
+    *allocs = (double)(allocations - before) / (double)iterations;
+    return ret;
+}
+
+/**
+ * @brief Suma el tamaño de archivos del árbol (los de /proc real informan 0).
+ * @param root Raíz del árbol.
+ * @param first Primer archivo, en tree_files.
+ * @param count Cantidad de archivos.
+ * @return Bytes.
+ */
+static size_t tree_bytes(const char* root, size_t first, size_t count)
+{
+    char path[PATH_MAX];
+    struct stat st;
+    size_t bytes = 0;
+    for (size_t i = first; i < first + count; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", root, tree_files[i]);
+        if (stat(path, &st) == 0)
+        {
+            bytes += (size_t)st.st_size;
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Mide todas las funciones sobre un árbol de procfs.
+ * @param root Raíz del árbol.
+ * @param label Descripción del árbol.
+ * @return 0 si todas leyeron correctamente, -1 en caso contrario.
+ */
+static int bench_tree(const char* root, const char* label)
+{
+    set_procfs_root(root);
+    if (init_proc_files() != 0)
+    {
+        fprintf(stderr, "%s: no se pudieron abrir los archivos\n", root);
+        close_proc_files();
+        return -1;
+    }
+
+    int status = 0;
+    double ns, allocs;
+    printf("\n%s (%s)\n%-12s %10s %12s %10s %12s\n", label, root, "función", "bytes", "ns/llamada", "MB/s",
+           "reservas");
+    for (size_t i = 0; i < GETTER_COUNT; i++)
+    {
+        const getter_t* g = &getters[i];
+        size_t bytes = tree_bytes(root, g->first, g->count);
+        if (measure(g->run, &ns, &allocs) != 0)
+        {
+            fprintf(stderr, "%s: error al leer %s\n", root, g->name);
+            status = -1;
+        }
+        printf("%-12s %10zu %12.1f %10.1f %12.2f\n", g->name, bytes, ns, (double)bytes / ns * 1e3, allocs);
+    }
+
+    size_t bytes = tree_bytes(root, 0, sizeof(tree_files) / sizeof(tree_files[0]));
+    status |= measure(run_tick, &ns, &allocs);
+    printf("%-12s %10zu %12.1f %10.1f %12.2f\n", "ciclo", bytes, ns, (double)bytes / ns * 1e3, allocs);
+    if (allocs > 0.0)
+    {
+        fprintf(stderr, "%s: el ciclo reserva memoria en régimen (%.2f reservas por ciclo)\n", root, allocs);
+        status = -1;
+    }
+
+    close_proc_files();
+    return status;
+}
+
+/**
+ * @brief Abre un archivo del árbol generado para escribirlo.
+ * @param root Raíz del árbol.
+ * @param name Ruta relativa a la raíz.
+ * @return Archivo abierto, o NULL en caso de error.
+ */
+static FILE* create_tree_file(const char* root, const char* name)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL)
+    {
+        perror(path);
+    }
+    return fp;
+}
+
+/**
+ * @brief Copia un archivo del árbol capturado al generado, omitiendo las líneas con un prefijo dado.
+ * @param src Raíz del árbol capturado.
+ * @param dst Raíz del árbol generado.
+ * @param name Ruta relativa a la raíz.
+ * @param skip Prefijo de las líneas a omitir, o NULL.
+ * @param out Archivo de destino ya abierto, o NULL para crearlo.
+ * @return 0 si se copió, -1 en caso de error.
+ */
+static int copy_tree_file(const char* src, const char* dst, const char* name, const char* skip, FILE* out)
+{
+    char path[PATH_MAX];
+    char line[8192];
+    snprintf(path, sizeof(path), "%s/%s", src, name);
+    FILE* in = fopen(path, "r");
+    if (in == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    FILE* fp = out != NULL ? out : create_tree_file(dst, name);
+    if (fp == NULL)
+    {
+        fclose(in);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        if (skip == NULL || strncmp(line, skip, strlen(skip)) != 0)
+        {
+            fputs(line, fp);
+        }
+    }
+    fclose(in);
+    if (out == NULL)
+    {
+        fclose(fp);
+    }
+    return 0;
+}
+
+/**
+ * @brief Genera un árbol que emula un host grande a partir de uno capturado.
+ *
+ * Los archivos por CPU, disco e interfaz se amplían; el resto se copia del árbol capturado.
+ *
+ * @param src Raíz del árbol capturado.
+ * @param dst Raíz del árbol a generar (ya creada).
+ * @return 0 si se generó, -1 en caso de error.
+ */
+static int generate_large_tree(const char* src, const char* dst)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/net", dst);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/pressure", dst);
+    mkdir(path, 0755);
+
+    FILE* fp = create_tree_file(dst, "stat");
+    if (fp == NULL)
+    {
+        return -1;
+    }
+    fprintf(fp, "cpu  %d 0 %d %d %d 0 %d 0 0 0\n", LARGE_CPUS * 3056, LARGE_CPUS * 801, LARGE_CPUS * 40212,
+            LARGE_CPUS * 184, LARGE_CPUS);
+    for (int i = 0; i < LARGE_CPUS; i++)
+    {
+        fprintf(fp, "cpu%d %d 0 %d %d %d 0 1 0 0 0\n", i, 3056 + i, 801 + i, 40212 + i, 184);
+    }
+    int ret = copy_tree_file(src, dst, "stat", "cpu", fp);
+    fclose(fp);
+
+    if ((fp = create_tree_file(dst, "diskstats")) == NULL)
+    {
+        return -1;
+    }
+    for (int i = 0; i < LARGE_DISKS; i++)
+    {
+        fprintf(fp, " %3d %7d sd%c%c %llu %d %llu %d %llu %d %llu %d 0 %d %d 0 0 0 0\n", 8 + i / 16, (i % 16) * 16,
+                'a' + i / 26 % 26, 'a' + i % 26, 1234567ULL + i, 3456, 987654321ULL + i, 12345, 7654321ULL + i, 6789,
+                123456789ULL + i, 54321, 98765, 66666);
+    }
+    fclose(fp);
+
+    if ((fp = create_tree_file(dst, "net/dev")) == NULL)
+    {
+        return -1;
+    }
+    fputs("Inter-|   Receive                                                |  Transmit\n"
+          " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls "
+          "carrier compressed\n",
+          fp);
+    for (int i = 0; i < LARGE_IFACES; i++)
+    {
+        fprintf(fp,
+                "veth%07x: %llu %llu    0    0    0     0          0         0 %llu %llu    0    0    0     0       0"
+                "          0\n",
+                i, 123456789012ULL + i, 9876543ULL + i, 23456789012ULL + i, 8765432ULL + i);
+    }
+    fclose(fp);
+
+    ret |= copy_tree_file(src, dst, "meminfo", NULL, NULL);
+    ret |= copy_tree_file(src, dst, "vmstat", NULL, NULL);
+    ret |= copy_tree_file(src, dst, "loadavg", NULL, NULL);
+    for (size_t i = 6; i < sizeof(tree_files) / sizeof(tree_files[0]); i++)
+    {
+        ret |= copy_tree_file(src, dst, tree_files[i], NULL, NULL);
+    }
+    return ret;
+}
+
+/**
+ * @brief Ejecuta el exportador hasta que queda dimensionado.
+ *
+ * El barrido de procesos se reparte entre ciclos según su presupuesto de CPU, de modo que su sección aparece después
+ * de una cantidad variable de ciclos, y las tablas y buffers crecen en los primeros. Se espera a que la exposición
+ * incluya el barrido y a que EXPORTER_SETTLED ciclos seguidos no reserven memoria.
+ *
+ * @return 0 si quedó dimensionado, -1 si no llegó dentro de EXPORTER_SETTLE_NS.
+ */
+static int settle_exporter(void)
+{
+    unsigned long long start = now_ns();
+    int settled = 0;
+    while (now_ns() - start < EXPORTER_SETTLE_NS)
+    {
+        unsigned long long before = allocations;
+        run_exporter();
+        metrics_snapshot_t* snapshot = metrics_snapshot_acquire();
+        int swept = snapshot != NULL && strstr(snapshot->text, "top_process_last_scan_timestamp_seconds") != NULL;
+        metrics_snapshot_release(snapshot);
+        settled = swept && allocations == before ? settled + 1 : 0;
+        if (settled == EXPORTER_SETTLED)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Genera una jerarquía cgroup v2 con una raíz y dos hijos.
+ * @param root Raíz de la jerarquía (ya creada).
+ * @return 0 si se generó, -1 en caso de error.
+ */
+static int generate_cgroup_tree(const char* root)
+{
+    char dir[PATH_MAX];
+    for (size_t c = 0; c <= sizeof(cgroup_children) / sizeof(cgroup_children[0]); c++)
+    {
+        const char* child = c > 0 ? cgroup_children[c - 1] : NULL;
+        snprintf(dir, sizeof(dir), "%s%s%s", root, child != NULL ? "/" : "", child != NULL ? child : "");
+        if (child != NULL && mkdir(dir, 0755) != 0)
+        {
+            perror(dir);
+            return -1;
+        }
+        for (size_t f = 0; f < sizeof(cgroup_files) / sizeof(cgroup_files[0]); f++)
+        {
+            FILE* fp = create_tree_file(dir, cgroup_files[f]);
+            if (fp == NULL)
+            {
+                return -1;
+            }
+            if (f == 1)
+            {
+                fprintf(fp, "usage_usec %zu\nuser_usec %zu\nsystem_usec %zu\n", 123456 * (c + 1), 100000 * (c + 1),
+                        23456 * (c + 1));
+            }
+            else if (f == 2)
+            {
+                fprintf(fp, "%zu\n", 1048576 * (c + 1));
+            }
+            else
+            {
+                fputs("cpu memory io\n", fp);
+            }
+            fclose(fp);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Borra la jerarquía cgroup v2 generada.
+ * @param root Raíz de la jerarquía.
+ */
+static void remove_cgroup_tree(const char* root)
+{
+    char path[PATH_MAX];
+    for (size_t c = 0; c <= sizeof(cgroup_children) / sizeof(cgroup_children[0]); c++)
+    {
+        const char* child = c > 0 ? cgroup_children[c - 1] : NULL;
+        for (size_t f = 0; f < sizeof(cgroup_files) / sizeof(cgroup_files[0]); f++)
+        {
+            snprintf(path, sizeof(path), "%s/%s%s%s", root, child != NULL ? child : "", child != NULL ? "/" : "",
+                     cgroup_files[f]);
+            unlink(path);
+        }
+        if (child != NULL)
+        {
+            snprintf(path, sizeof(path), "%s/%s", root, child);
+            rmdir(path);
+        }
+    }
+    rmdir(root);
+}
+
+/**
+ * @brief Mide el exportador completo sobre un árbol de procfs: todos los colectores en sus hilos y la publicación.
+ * @param root Raíz del árbol.
+ * @param cgroups Raíz de la jerarquía cgroup v2 generada.
+ * @return 0 si se recolectó y publicó sin reservar memoria en régimen, -1 en caso contrario.
+ */
+static int bench_exporter(const char* root, const char* cgroups)
+{
+    set_procfs_root(root);
+    init_metrics();
+    configure_cgroup_metrics(cgroups, 0);
+    collector_registry_init(&exporter);
+    int status = 0;
+    if (register_collectors(&exporter) != 0 || collector_configure(&exporter, "process=on") != 0 ||
+        collector_configure(&exporter, "cgroup=on") != 0 || collector_registry_start(&exporter, 1000) != 0)
+    {
+        fprintf(stderr, "%s: no se pudieron iniciar los colectores\n", root);
+        status = -1;
+    }
+
+    // Con un árbol fijo el uso de CPU no avanza y el colector lo informa en cada ciclo: esos mensajes se descartan
+    fflush(stderr);
+    int saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (saved_stderr >= 0 && null_fd >= 0)
+    {
+        dup2(null_fd, STDERR_FILENO);
+    }
+    int settled = status == 0 ? settle_exporter() : -1;
+    double ns, allocs;
+    if (settled == 0)
+    {
+        status = measure(run_exporter, &ns, &allocs);
+    }
+    if (saved_stderr >= 0 && null_fd >= 0)
+    {
+        dup2(saved_stderr, STDERR_FILENO);
+    }
+    if (null_fd >= 0)
+    {
+        close(null_fd);
+    }
+    if (saved_stderr >= 0)
+    {
+        close(saved_stderr);
+    }
+
+    if (status == 0 && settled != 0)
+    {
+        fprintf(stderr, "%s: el exportador sigue reservando memoria después de dimensionarse\n", root);
+        status = -1;
+    }
+    else if (status == 0)
+    {
+        metrics_snapshot_t* snapshot = metrics_snapshot_acquire();
+        size_t bytes = snapshot != NULL ? snapshot->len : 0;
+        metrics_snapshot_release(snapshot);
+        printf("%-12s %10zu %12.1f %10.1f %12.2f\n", "exportador", bytes, ns, (double)bytes / ns * 1e3, allocs);
+        if (allocs > 0.0)
+        {
+            fprintf(stderr, "%s: la recolección y publicación reservan memoria en régimen (%.2f reservas por ciclo)\n",
+                    root, allocs);
+            status = -1;
+        }
+    }
+
+    collector_registry_destroy(&exporter);
+    metrics_snapshot_shutdown();
+    close_proc_files();
+    return status;
+}
+
+/**
+ * @brief Borra el árbol generado.
+ * @param root Raíz del árbol.
+ */
+static void remove_tree(const char* root)
+{
+    char path[PATH_MAX];
+    for (size_t i = 0; i < sizeof(tree_files) / sizeof(tree_files[0]); i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", root, tree_files[i]);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/net", root);
+    rmdir(path);
+    snprintf(path, sizeof(path), "%s/pressure", root);
+    rmdir(path);
+    rmdir(root);
+}
+
+/**
+ * @brief Punto de entrada del benchmark.
+ * @param argc Cantidad de argumentos.
+ * @param argv Argumentos: árboles de procfs a medir; el primero es también la base del árbol generado (por defecto
+ * bench/fixtures/small).
+ * @return 0 si todas las funciones leyeron correctamente y ni el ciclo ni el exportador reservan memoria en régimen,
+ * 1 en caso contrario.
+ */
+int main(int argc, char* argv[])
+{
+    const char* base = argc > 1 ? argv[1] : "bench/fixtures/small";
+    int status = 0;
+
+    char cgroups[] = "/tmp/bench-cgroup-XXXXXX";
+    if (mkdtemp(cgroups) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    if (generate_cgroup_tree(cgroups) != 0)
+    {
+        remove_cgroup_tree(cgroups);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        status |= bench_tree(argv[i], "árbol capturado");
+        status |= bench_exporter(argv[i], cgroups);
+    }
+    if (argc == 1)
+    {
+        status |= bench_tree(base, "árbol capturado");
+        status |= bench_exporter(base, cgroups);
+    }
+
+    char large[] = "/tmp/bench-procfs-XXXXXX";
+    if (mkdtemp(large) == NULL)
+    {
+        perror("mkdtemp");
+        remove_cgroup_tree(cgroups);
+        return 1;
+    }
+    if (generate_large_tree(base, large) == 0)
+    {
+        char label[128];
+        snprintf(label, sizeof(label), "host grande generado: %d CPUs, %d discos, %d interfaces", LARGE_CPUS,
+                 LARGE_DISKS, LARGE_IFACES);
+        status |= bench_tree(large, label);
+        status |= bench_exporter(large, cgroups);
+    }
+    else
+    {
+        status = -1;
+    }
+    remove_tree(large);
+    remove_cgroup_tree(cgroups);
+
+    return status != 0;
+}
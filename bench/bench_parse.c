@@ -0,0 +1,558 @@
+/**
+ * @file bench_parse.c
+ * @brief Benchmark del parseo de /proc: tokenizador propio contra el camino anterior basado en sscanf().
+ *
+ * Reproduce archivos de /proc capturados (árbol de procfs pasado como argumento) y, además, versiones ampliadas de
+ * /proc/diskstats y /proc/net/dev que emulan hosts con cientos de dispositivos e interfaces. Para cada archivo
+ * informa los nanosegundos por parseo de ambas implementaciones y verifica que den el mismo resultado.
+ */
+
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Tiempo mínimo de medición por caso, en nanosegundos.
+ */
+#define BENCH_MIN_NS 200000000ULL
+
+/**
+ * @brief Cantidad de dispositivos de bloque de la versión ampliada de /proc/diskstats.
+ */
+#define BENCH_DISKS 500
+
+/**
+ * @brief Cantidad de interfaces de la versión ampliada de /proc/net/dev.
+ */
+#define BENCH_IFACES 2000
+
+/**
+ * @brief Buffer con el contenido de un archivo.
+ */
+typedef struct
+{
+    char* buf;  /**< Contenido, terminado en '\0'. */
+    size_t len; /**< Longitud del contenido. */
+} fixture_t;
+
+/**
+ * @brief Acumulador para que el compilador no descarte los resultados.
+ */
+static volatile unsigned long long sink;
+
+/**
+ * @brief Devuelve el tiempo monotónico en nanosegundos.
+ * @return Tiempo actual.
+ */
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * @brief Carga un archivo capturado.
+ * @param dir Directorio de fixtures.
+ * @param name Nombre del archivo.
+ * @param fixture Buffer a completar.
+ * @return 0 si se cargó, -1 en caso de error.
+ */
+static int load_fixture(const char* dir, const char* name, fixture_t* fixture)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    fixture->buf = malloc((size_t)size + 1);
+    fixture->len = fread(fixture->buf, 1, (size_t)size, fp);
+    fixture->buf[fixture->len] = '\0';
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * @brief Genera una versión de /proc/diskstats con muchos dispositivos.
+ * @param fixture Buffer a completar.
+ */
+static void synth_diskstats(fixture_t* fixture)
+{
+    size_t cap = BENCH_DISKS * 160;
+    fixture->buf = malloc(cap);
+    fixture->len = 0;
+    for (int i = 0; i < BENCH_DISKS; i++)
+    {
+        fixture->len += (size_t)snprintf(fixture->buf + fixture->len, cap - fixture->len,
+                                         " %3d %7d sd%c%c %llu %d %llu %d %llu %d %llu %d 0 %d %d 0 0 0 0\n",
+                                         8 + i / 16, (i % 16) * 16, 'a' + i / 26 % 26, 'a' + i % 26, 1234567ULL + i,
+                                         3456, 987654321ULL + i, 12345, 7654321ULL + i, 6789, 123456789ULL + i,
+                                         54321, 98765, 66666);
+    }
+}
+
+/**
+ * @brief Genera una versión de /proc/net/dev con muchas interfaces.
+ * @param fixture Buffer a completar.
+ */
+static void synth_net_dev(fixture_t* fixture)
+{
+    size_t cap = BENCH_IFACES * 200 + 512;
+    fixture->buf = malloc(cap);
+    fixture->len = (size_t)snprintf(fixture->buf, cap, "%s",
+                                    "Inter-|   Receive                                                |  Transmit\n"
+                                    " face |bytes    packets errs drop fifo frame compressed multicast|bytes    "
+                                    "packets errs drop fifo colls carrier compressed\n");
+    for (int i = 0; i < BENCH_IFACES; i++)
+    {
+        fixture->len += (size_t)snprintf(fixture->buf + fixture->len, cap - fixture->len,
+                                         "veth%07x: %llu %llu    0    0    0     0          0         0 %llu %llu    0 "
+                                         "   0    0     0       0          0\n",
+                                         i, 123456789012ULL + i, 9876543ULL + i, 23456789012ULL + i, 8765432ULL + i);
+    }
+}
+
+/**
+ * @brief Copia una línea a un buffer local, como hacía fgets() en la implementación anterior.
+ * @param cursor Posición actual; avanza a la línea siguiente.
+ * @param end Fin del contenido.
+ * @param line Buffer de destino.
+ * @param size Tamaño del buffer de destino.
+ * @return 1 si se copió una línea, 0 si no quedan más.
+ */
+static int copy_line(const char** cursor, const char* end, char* line, size_t size)
+{
+    if (*cursor >= end)
+    {
+        return 0;
+    }
+    const char* eol = memchr(*cursor, '\n', (size_t)(end - *cursor));
+    size_t n = (size_t)((eol != NULL ? eol : end) - *cursor);
+    if (n >= size)
+    {
+        n = size - 1;
+    }
+    memcpy(line, *cursor, n);
+    line[n] = '\0';
+    *cursor = eol != NULL ? eol + 1 : end;
+    return 1;
+}
+
+/**
+ * @brief Implementación anterior del parseo de /proc/stat basada en sscanf().
+ * @param fixture Contenido del archivo.
+ * @param snapshot Instantánea a completar.
+ */
+static void sscanf_proc_stat(const fixture_t* fixture, proc_stat_snapshot_t* snapshot)
+{
+    char line[BUFFER_SIZE * 4];
+    const char* cursor = fixture->buf;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    while (copy_line(&cursor, fixture->buf + fixture->len, line, sizeof(line)))
+    {
+        // "cpu  %llu" también aceptaría las líneas "cpuN", por eso se compara el prefijo antes
+        if ((strncmp(line, "cpu ", 4) == 0 &&
+             sscanf(line, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu", &snapshot->user, &snapshot->nice,
+                    &snapshot->system, &snapshot->idle, &snapshot->iowait, &snapshot->irq, &snapshot->softirq,
+                    &snapshot->steal) == 8) ||
+            sscanf(line, "intr %llu", &snapshot->intr) == 1 || sscanf(line, "ctxt %llu", &snapshot->ctxt) == 1 ||
+            sscanf(line, "btime %llu", &snapshot->btime) == 1 ||
+            sscanf(line, "processes %llu", &snapshot->processes) == 1 ||
+            sscanf(line, "procs_running %llu", &snapshot->procs_running) == 1 ||
+            sscanf(line, "procs_blocked %llu", &snapshot->procs_blocked) == 1 ||
+            sscanf(line, "softirq %llu", &snapshot->softirqs) == 1)
+        {
+            continue;
+        }
+    }
+}
+
+/**
+ * @brief Parseo de /proc/meminfo basado en sscanf(), con un intento por campo buscado y por línea.
+ * @param fixture Contenido del archivo.
+ * @param m Instantánea a completar.
+ */
+static void sscanf_meminfo(const fixture_t* fixture, meminfo_snapshot_t* m)
+{
+    char line[BUFFER_SIZE];
+    const char* cursor = fixture->buf;
+    const struct
+    {
+        const char* format;
+        unsigned long long* value;
+    } fields[] = {
+        {"MemTotal: %llu", &m->mem_total},
+        {"MemFree: %llu", &m->mem_free},
+        {"MemAvailable: %llu", &m->mem_available},
+        {"Buffers: %llu", &m->buffers},
+        {"Cached: %llu", &m->cached},
+        {"SwapCached: %llu", &m->swap_cached},
+        {"Active: %llu", &m->active},
+        {"Inactive: %llu", &m->inactive},
+        {"Dirty: %llu", &m->dirty},
+        {"Writeback: %llu", &m->writeback},
+        {"AnonPages: %llu", &m->anon_pages},
+        {"Mapped: %llu", &m->mapped},
+        {"Shmem: %llu", &m->shmem},
+        {"Slab: %llu", &m->slab},
+        {"SReclaimable: %llu", &m->sreclaimable},
+        {"SUnreclaim: %llu", &m->sunreclaim},
+        {"KernelStack: %llu", &m->kernel_stack},
+        {"PageTables: %llu", &m->page_tables},
+        {"SwapTotal: %llu", &m->swap_total},
+        {"SwapFree: %llu", &m->swap_free},
+        {"CommitLimit: %llu", &m->commit_limit},
+        {"Committed_AS: %llu", &m->committed_as},
+        {"AnonHugePages: %llu", &m->anon_hugepages},
+        {"HugePages_Total: %llu", &m->hugepages_total},
+        {"HugePages_Free: %llu", &m->hugepages_free},
+        {"HugePages_Rsvd: %llu", &m->hugepages_rsvd},
+        {"HugePages_Surp: %llu", &m->hugepages_surp},
+        {"Hugepagesize: %llu", &m->hugepagesize},
+    };
+
+    memset(m, 0, sizeof(*m));
+    while (copy_line(&cursor, fixture->buf + fixture->len, line, sizeof(line)))
+    {
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        {
+            if (sscanf(line, fields[i].format, fields[i].value) == 1)
+            {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Parseo de /proc/vmstat basado en sscanf(), con un intento por campo buscado y por línea.
+ * @param fixture Contenido del archivo.
+ * @param v Instantánea a completar.
+ */
+static void sscanf_vmstat(const fixture_t* fixture, vmstat_snapshot_t* v)
+{
+    char line[BUFFER_SIZE];
+    const char* cursor = fixture->buf;
+    const struct
+    {
+        const char* format;
+        unsigned long long* value;
+    } fields[] = {
+        {"pgfault %llu", &v->pgfault}, {"pgmajfault %llu", &v->pgmajfault}, {"pswpin %llu", &v->pswpin},
+        {"pswpout %llu", &v->pswpout}, {"oom_kill %llu", &v->oom_kill},
+    };
+
+    memset(v, 0, sizeof(*v));
+    while (copy_line(&cursor, fixture->buf + fixture->len, line, sizeof(line)))
+    {
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        {
+            if (sscanf(line, fields[i].format, fields[i].value) == 1)
+            {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Parseo de /proc/diskstats por dispositivo basado en sscanf().
+ * @param fixture Contenido del archivo.
+ * @return Suma de control de los contadores de todos los dispositivos.
+ */
+static unsigned long long sscanf_diskstats(const fixture_t* fixture)
+{
+    char line[BUFFER_SIZE];
+    char name[32];
+    const char* cursor = fixture->buf;
+    unsigned int major, minor;
+    unsigned long long reads, read_sectors, writes, write_sectors, io_ticks, sum = 0;
+
+    while (copy_line(&cursor, fixture->buf + fixture->len, line, sizeof(line)))
+    {
+        if (sscanf(line, "%u %u %31s %llu %*u %llu %*u %llu %*u %llu %*u %*u %llu %*u", &major, &minor, name, &reads,
+                   &read_sectors, &writes, &write_sectors, &io_ticks) == 8)
+        {
+            sum += reads + read_sectors + writes + write_sectors + io_ticks;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Implementación anterior del parseo de /proc/net/dev basada en sscanf().
+ * @param fixture Contenido del archivo.
+ * @param total_rx Total de bytes recibidos.
+ * @param total_tx Total de bytes transmitidos.
+ */
+static void sscanf_net_dev(const fixture_t* fixture, unsigned long long* total_rx, unsigned long long* total_tx)
+{
+    char line[BUFFER_SIZE];
+    const char* cursor = fixture->buf;
+    unsigned long long rx, tx;
+
+    *total_rx = 0;
+    *total_tx = 0;
+    while (copy_line(&cursor, fixture->buf + fixture->len, line, sizeof(line)))
+    {
+        if (sscanf(line, "%*s %llu %*u %*u %*u %*u %*u %*u %*u %llu", &rx, &tx) == 2)
+        {
+            *total_rx += rx;
+            *total_tx += tx;
+        }
+    }
+}
+
+/**
+ * @brief Caso de benchmark: un archivo y sus dos implementaciones de parseo.
+ */
+typedef struct
+{
+    const char* name;                                           /**< Nombre del caso. */
+    const fixture_t* fixture;                                   /**< Contenido a parsear. */
+    unsigned long long (*scan)(const fixture_t* fixture);       /**< Tokenizador propio. */
+    unsigned long long (*sscanf_ref)(const fixture_t* fixture); /**< Implementación con sscanf(). */
+} bench_case_t;
+
+/**
+ * @brief Parsea /proc/stat con el tokenizador.
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_scan_stat(const fixture_t* f)
+{
+    proc_stat_snapshot_t s;
+    parse_proc_stat(f->buf, f->len, &s, NULL);
+    return s.user + s.idle + s.ctxt + s.intr + s.procs_running + s.softirqs;
+}
+
+/**
+ * @brief Parsea /proc/stat con sscanf().
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_sscanf_stat(const fixture_t* f)
+{
+    proc_stat_snapshot_t s;
+    sscanf_proc_stat(f, &s);
+    return s.user + s.idle + s.ctxt + s.intr + s.procs_running + s.softirqs;
+}
+
+/**
+ * @brief Suma de control de una instantánea de /proc/meminfo.
+ * @param m Instantánea.
+ * @return Suma de todos los campos.
+ */
+static unsigned long long meminfo_checksum(const meminfo_snapshot_t* m)
+{
+    const unsigned long long* values = (const unsigned long long*)m;
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < sizeof(*m) / sizeof(*values); i++)
+    {
+        sum += values[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Parsea /proc/meminfo con el tokenizador.
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_scan_meminfo(const fixture_t* f)
+{
+    meminfo_snapshot_t m;
+    parse_meminfo(f->buf, f->len, &m);
+    return meminfo_checksum(&m);
+}
+
+/**
+ * @brief Parsea /proc/meminfo con sscanf().
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_sscanf_meminfo(const fixture_t* f)
+{
+    meminfo_snapshot_t m;
+    sscanf_meminfo(f, &m);
+    return meminfo_checksum(&m);
+}
+
+/**
+ * @brief Parsea /proc/vmstat con el tokenizador.
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_scan_vmstat(const fixture_t* f)
+{
+    vmstat_snapshot_t v;
+    parse_vmstat(f->buf, f->len, &v);
+    return v.pgfault + v.pgmajfault + v.pswpin + v.pswpout + v.oom_kill;
+}
+
+/**
+ * @brief Parsea /proc/vmstat con sscanf().
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_sscanf_vmstat(const fixture_t* f)
+{
+    vmstat_snapshot_t v;
+    sscanf_vmstat(f, &v);
+    return v.pgfault + v.pgmajfault + v.pswpin + v.pswpout + v.oom_kill;
+}
+
+/**
+ * @brief Tabla de dispositivos del caso de /proc/diskstats, conservada entre iteraciones como en el exportador.
+ */
+static disk_table_t bench_disks;
+
+/**
+ * @brief Parsea /proc/diskstats con el tokenizador y la tabla de dispositivos.
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_scan_diskstats(const fixture_t* f)
+{
+    unsigned long long sum = 0;
+    parse_disk_devices(&bench_disks, f->buf, f->len);
+    for (size_t i = 0; i < bench_disks.capacity; i++)
+    {
+        const disk_device_t* dev = &bench_disks.slots[i];
+        if (dev->state == DISK_SLOT_USED)
+        {
+            sum += dev->cur.reads + dev->cur.read_sectors + dev->cur.writes + dev->cur.write_sectors +
+                   dev->cur.io_ticks;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Parsea /proc/diskstats con sscanf().
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_sscanf_diskstats(const fixture_t* f)
+{
+    return sscanf_diskstats(f);
+}
+
+/**
+ * @brief Tabla de interfaces del caso de /proc/net/dev, conservada entre iteraciones como en el exportador.
+ */
+static net_table_t bench_ifaces;
+
+/**
+ * @brief Parsea /proc/net/dev con el tokenizador y la tabla de interfaces.
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_scan_net_dev(const fixture_t* f)
+{
+    unsigned long long sum = 0;
+    parse_net_devices(&bench_ifaces, f->buf, f->len);
+    for (size_t i = 0; i < bench_ifaces.capacity; i++)
+    {
+        const net_iface_t* iface = &bench_ifaces.slots[i];
+        if (iface->state == NET_SLOT_USED)
+        {
+            sum += iface->cur.rx_bytes + iface->cur.tx_bytes;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Parsea /proc/net/dev con sscanf().
+ * @param f Contenido.
+ * @return Suma de control.
+ */
+static unsigned long long run_sscanf_net_dev(const fixture_t* f)
+{
+    unsigned long long rx, tx;
+    sscanf_net_dev(f, &rx, &tx);
+    return rx + tx;
+}
+
+/**
+ * @brief Mide los nanosegundos por llamada de una función de parseo.
+ * @param fn Función a medir.
+ * @param fixture Contenido a parsear.
+ * @return Nanosegundos promedio por parseo.
+ */
+static double measure(unsigned long long (*fn)(const fixture_t*), const fixture_t* fixture)
+{
+    unsigned long long iterations = 0, start = now_ns(), elapsed;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            sink += fn(fixture);
+        }
+        iterations += 64;
+        elapsed = now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+    return (double)elapsed / (double)iterations;
+}
+
+/**
+ * @brief Punto de entrada del benchmark.
+ * @param argc Cantidad de argumentos.
+ * @param argv Argumentos: árbol de procfs capturado (por defecto bench/fixtures/small).
+ * @return 0 si todos los casos coinciden, 1 en caso contrario.
+ */
+int main(int argc, char* argv[])
+{
+    const char* dir = argc > 1 ? argv[1] : "bench/fixtures/small";
+    fixture_t stat, meminfo, vmstat, diskstats, net_dev, big_diskstats, big_net_dev;
+
+    if (load_fixture(dir, "stat", &stat) != 0 || load_fixture(dir, "meminfo", &meminfo) != 0 ||
+        load_fixture(dir, "vmstat", &vmstat) != 0 || load_fixture(dir, "diskstats", &diskstats) != 0 ||
+        load_fixture(dir, "net/dev", &net_dev) != 0)
+    {
+        return 1;
+    }
+    synth_diskstats(&big_diskstats);
+    disk_table_init(&bench_disks, NULL, NULL);
+    synth_net_dev(&big_net_dev);
+    net_table_init(&bench_ifaces, NULL, NULL);
+
+    const bench_case_t cases[] = {
+        {"stat", &stat, run_scan_stat, run_sscanf_stat},
+        {"meminfo", &meminfo, run_scan_meminfo, run_sscanf_meminfo},
+        {"vmstat", &vmstat, run_scan_vmstat, run_sscanf_vmstat},
+        {"diskstats", &diskstats, run_scan_diskstats, run_sscanf_diskstats},
+        {"net_dev", &net_dev, run_scan_net_dev, run_sscanf_net_dev},
+        {"diskstats x500", &big_diskstats, run_scan_diskstats, run_sscanf_diskstats},
+        {"net_dev x2000", &big_net_dev, run_scan_net_dev, run_sscanf_net_dev},
+    };
+
+    int status = 0;
+    printf("%-16s %10s %14s %14s %8s\n", "archivo", "bytes", "scan ns/op", "sscanf ns/op", "mejora");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        const bench_case_t* c = &cases[i];
+        if (c->scan(c->fixture) != c->sscanf_ref(c->fixture))
+        {
+            fprintf(stderr, "%s: el tokenizador y sscanf() no coinciden\n", c->name);
+            status = 1;
+        }
+        double scan_ns = measure(c->scan, c->fixture);
+        double sscanf_ns = measure(c->sscanf_ref, c->fixture);
+        printf("%-16s %10zu %14.1f %14.1f %7.1fx\n", c->name, c->fixture->len, scan_ns, sscanf_ns, sscanf_ns / scan_ns);
+    }
+
+    return status;
+}
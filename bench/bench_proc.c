@@ -0,0 +1,396 @@
+/**
+ * @file bench_proc.c
+ * @brief Benchmark del colector de procesos: costo por proceso y consumo de CPU con el presupuesto aplicado.
+ *
+ * Mide tres cosas:
+ *  - el costo en espacio de usuario (parseo, tabla por pid y selección de los N mayores) con 20000 procesos
+ *    sintéticos;
+ *  - el costo real por proceso de barrer /proc en este host (openat, read y parseo), proyectado a 20000 procesos;
+ *  - el colector llamado con el período por defecto sobre un árbol proc generado con 20000 procesos, de los que unos
+ *    pocos consumen CPU e I/O en cada ciclo, hasta completar dos barridos. Falla si el consumo supera
+ *    PROCESS_CPU_BUDGET de un núcleo, si un barrido tarda más de BENCH_MAX_SCAN_S o si los procesos activos no
+ *    aparecen primeros en los rankings.
+ */
+
+#include "../include/process_stats.h"
+#include "../include/sampler.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Cantidad de procesos sintéticos.
+ */
+#define BENCH_PROCS 20000
+
+/**
+ * @brief Cantidad de procesos exportados por recurso en el benchmark.
+ */
+#define BENCH_TOP 10
+
+/**
+ * @brief Procesos del árbol generado que consumen CPU e I/O en cada ciclo.
+ */
+#define BENCH_ACTIVE 200
+
+/**
+ * @brief Duración máxima aceptada de un barrido de 20000 procesos, en segundos (antigüedad de los datos exportados).
+ */
+#define BENCH_MAX_SCAN_S 20.0
+
+/**
+ * @brief Ciclos máximos de la medición sobre el árbol generado, por si los barridos no se completan.
+ */
+#define BENCH_MAX_TICKS 90
+
+/**
+ * @brief Contenido sintético de /proc/[pid]/stat y /proc/[pid]/io de un proceso.
+ */
+typedef struct
+{
+    char stat[320];  /**< Contenido de stat. */
+    size_t stat_len; /**< Longitud de stat. */
+    char io[200];    /**< Contenido de io. */
+    size_t io_len;   /**< Longitud de io. */
+} synth_proc_t;
+
+/**
+ * @brief Tiempo de CPU del hilo actual en segundos.
+ * @return Segundos de CPU consumidos por el hilo.
+ */
+static double thread_cpu_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Genera los archivos sintéticos de un proceso para un barrido dado.
+ * @param proc Archivos a completar.
+ * @param pid Identificador del proceso.
+ * @param round Número de barrido (hace avanzar los contadores).
+ */
+static void synth_process(synth_proc_t* proc, int pid, int round)
+{
+    proc->stat_len = (size_t)snprintf(proc->stat, sizeof(proc->stat),
+                                      "%d (worker %d) S 1 %d %d 0 -1 4194560 %d 0 0 0 %d %d 0 0 20 0 1 0 %d "
+                                      "123456789 %d 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n",
+                                      pid, pid, pid, pid, 1000 + round, pid % 97 * round, pid % 13 * round, pid,
+                                      1000 + pid % 5000);
+    proc->io_len = (size_t)snprintf(proc->io, sizeof(proc->io),
+                                    "rchar: %d\nwchar: %d\nsyscr: 10\nsyscw: 10\nread_bytes: %d\nwrite_bytes: %d\n"
+                                    "cancelled_write_bytes: 0\n",
+                                    pid * round, pid * round, pid % 31 * 4096 * round, pid % 17 * 4096 * round);
+}
+
+/**
+ * @brief Tiempo monótono en segundos.
+ * @return Segundos de CLOCK_MONOTONIC.
+ */
+static double monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Ejecuta un barrido sintético completo sobre la tabla.
+ * @param table Tabla de procesos.
+ * @param procs Archivos sintéticos.
+ * @param taken Instante asignado a las lecturas del barrido.
+ * @return Suma de control de los procesos seleccionados.
+ */
+static double synth_scan(process_table_t* table, const synth_proc_t* procs, double taken)
+{
+    const process_entry_t* top[BENCH_TOP];
+    process_sample_t sample;
+    double sum = 0.0;
+
+    process_table_begin(table);
+    for (int i = 0; i < BENCH_PROCS; i++)
+    {
+        if (parse_process_stat(procs[i].stat, procs[i].stat_len, &sample) == 0 &&
+            parse_process_io(procs[i].io, procs[i].io_len, &sample) == 0)
+        {
+            sample.taken = taken;
+            process_table_update(table, i + 1, &sample);
+        }
+    }
+    process_table_sweep(table);
+    compute_process_rates(table);
+    for (int key = PROCESS_TOP_CPU; key <= PROCESS_TOP_IO; key++)
+    {
+        size_t n = process_top_n(table, (process_top_key_t)key, top, BENCH_TOP);
+        for (size_t i = 0; i < n; i++)
+        {
+            sum += top[i]->cpu_percent + top[i]->rss_bytes + top[i]->read_bytes_per_sec;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Escribe un archivo del árbol generado.
+ * @param root Directorio del árbol.
+ * @param pid Proceso.
+ * @param name Nombre del archivo ("stat" o "io").
+ * @param data Contenido.
+ * @param len Longitud del contenido.
+ * @return 0 si se escribió, -1 en caso de error.
+ */
+static int write_proc_file(const char* root, int pid, const char* name, const char* data, size_t len)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%d/%s", root, pid, name);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        perror(path);
+        return -1;
+    }
+    ssize_t n = write(fd, data, len);
+    close(fd);
+    return n == (ssize_t)len ? 0 : -1;
+}
+
+/**
+ * @brief Escribe stat e io de un proceso del árbol generado.
+ * @param root Directorio del árbol.
+ * @param proc Archivos a escribir.
+ * @param pid Proceso.
+ * @return 0 si se escribieron, -1 en caso de error.
+ */
+static int write_process(const char* root, const synth_proc_t* proc, int pid)
+{
+    if (write_proc_file(root, pid, "stat", proc->stat, proc->stat_len) != 0 ||
+        write_proc_file(root, pid, "io", proc->io, proc->io_len) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Borra el árbol generado.
+ * @param root Directorio del árbol.
+ */
+static void remove_proc_tree(const char* root)
+{
+    char path[256];
+    for (int pid = 1; pid <= BENCH_PROCS; pid++)
+    {
+        snprintf(path, sizeof(path), "%s/%d/stat", root, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d/io", root, pid);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/%d", root, pid);
+        rmdir(path);
+    }
+    rmdir(root);
+}
+
+/**
+ * @brief Genera un árbol proc con BENCH_PROCS procesos ociosos.
+ * @param root Directorio del árbol (ya creado).
+ * @param procs Archivos sintéticos de cada proceso.
+ * @return 0 si se generó, -1 en caso de error.
+ */
+static int create_proc_tree(const char* root, synth_proc_t* procs)
+{
+    char path[256];
+    for (int pid = 1; pid <= BENCH_PROCS; pid++)
+    {
+        snprintf(path, sizeof(path), "%s/%d", root, pid);
+        synth_process(&procs[pid - 1], pid, 1);
+        if (mkdir(path, 0755) != 0 || write_process(root, &procs[pid - 1], pid) != 0)
+        {
+            perror(path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Verifica que los procesos activos encabecen el ranking de un criterio.
+ * @param table Tabla de procesos.
+ * @param key Criterio.
+ * @return 1 si el primero del ranking es un proceso activo con tasa positiva, 0 en caso contrario.
+ */
+static int active_on_top(const process_table_t* table, process_top_key_t key)
+{
+    const process_entry_t* top[1];
+    if (process_top_n(table, key, top, 1) != 1)
+    {
+        return 0;
+    }
+    double value = key == PROCESS_TOP_CPU ? top[0]->cpu_percent : top[0]->write_bytes_per_sec;
+    return top[0]->pid <= BENCH_ACTIVE && value > 0.0;
+}
+
+/**
+ * @brief Mide el colector con el período por defecto sobre un árbol proc generado hasta completar dos barridos.
+ * @param root Directorio del árbol.
+ * @param procs Archivos sintéticos de cada proceso.
+ * @return 0 si respeta el presupuesto y la antigüedad máxima, 1 en caso contrario.
+ */
+static int bench_generated_tree(const char* root, synth_proc_t* procs)
+{
+    const process_entry_t* top[BENCH_TOP];
+    process_table_t table;
+    if (process_table_init(&table, root) != 0)
+    {
+        return 1;
+    }
+
+    // Sólo se mide el colector (barrido y selección de los N mayores); la simulación de actividad queda afuera
+    struct timespec tick = {SAMPLER_DEFAULT_INTERVAL_MS / 1000, SAMPLER_DEFAULT_INTERVAL_MS % 1000 * 1000000L};
+    double cpu = 0.0, wall_start = monotonic_seconds();
+    int sweeps = 0, ticks = 0, ranked = 1, round = 1;
+    while (sweeps < 2 && ticks < BENCH_MAX_TICKS)
+    {
+        double start = thread_cpu_seconds();
+        process_table_scan(&table);
+        if (table.scanned)
+        {
+            for (int key = PROCESS_TOP_CPU; key <= PROCESS_TOP_IO; key++)
+            {
+                process_top_n(&table, (process_top_key_t)key, top, BENCH_TOP);
+            }
+        }
+        cpu += thread_cpu_seconds() - start;
+
+        if (table.scanned)
+        {
+            sweeps++;
+            printf("%-44s %10.2f s, %.1f ms de CPU\n", sweeps == 1 ? "barrido 1 (sin lectura anterior)" : "barrido 2",
+                   table.scan_duration, table.last_scan_cpu * 1e3);
+            if (sweeps == 2)
+            {
+                ranked = active_on_top(&table, PROCESS_TOP_CPU) && active_on_top(&table, PROCESS_TOP_IO);
+            }
+        }
+
+        round++;
+        for (int pid = 1; pid <= BENCH_ACTIVE; pid++)
+        {
+            synth_process(&procs[pid - 1], pid, round);
+            if (write_process(root, &procs[pid - 1], pid) != 0)
+            {
+                process_table_destroy(&table);
+                return 1;
+            }
+        }
+        ticks++;
+        nanosleep(&tick, NULL);
+    }
+    double used = cpu / (monotonic_seconds() - wall_start);
+    double duration = table.scan_duration;
+    process_table_destroy(&table);
+
+    printf("%-44s %10.3f %% de un núcleo (%d ciclos de %d ms)\n", "consumo sobre 20000 procesos", used * 100.0, ticks,
+           SAMPLER_DEFAULT_INTERVAL_MS);
+    if (sweeps < 2)
+    {
+        fprintf(stderr, "El colector de procesos no completó dos barridos en %d ciclos\n", BENCH_MAX_TICKS);
+        return 1;
+    }
+    if (used > PROCESS_CPU_BUDGET)
+    {
+        fprintf(stderr, "El colector de procesos supera el presupuesto de CPU\n");
+        return 1;
+    }
+    if (duration > BENCH_MAX_SCAN_S)
+    {
+        fprintf(stderr, "Un barrido de %d procesos tarda más de %.0f s\n", BENCH_PROCS, BENCH_MAX_SCAN_S);
+        return 1;
+    }
+    if (!ranked)
+    {
+        fprintf(stderr, "Los procesos activos no encabezan los rankings de CPU e I/O\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Punto de entrada del benchmark.
+ * @param argc Cantidad de argumentos.
+ * @param argv Argumentos: directorio proc (por defecto /proc).
+ * @return 0 si el colector respeta el presupuesto y la antigüedad máxima sobre el árbol generado, 1 en caso contrario.
+ */
+int main(int argc, char* argv[])
+{
+    const char* proc_root = argc > 1 ? argv[1] : "/proc";
+    process_table_t table;
+
+    // 1. Espacio de usuario con 20000 procesos sintéticos; los contadores avanzan en cada barrido
+    synth_proc_t* procs = malloc(BENCH_PROCS * sizeof(*procs));
+    if (procs == NULL || process_table_init(&table, proc_root) != 0)
+    {
+        return 1;
+    }
+    const int rounds = 20;
+    double sink = 0.0, user_cost = 0.0;
+    for (int round = 1; round <= rounds; round++)
+    {
+        for (int i = 0; i < BENCH_PROCS; i++)
+        {
+            synth_process(&procs[i], i + 1, round);
+        }
+        double start = thread_cpu_seconds();
+        sink += synth_scan(&table, procs, (double)round);
+        user_cost += thread_cpu_seconds() - start;
+    }
+    printf("%-44s %10.2f ms/barrido\n", "parseo + tabla + top-N, 20000 procesos", user_cost / rounds * 1e3);
+
+    // 2. Barrido real de /proc, proyectado a 20000 procesos; el crédito se repone para medir barridos completos
+    process_table_destroy(&table);
+    if (process_table_init(&table, proc_root) != 0)
+    {
+        return 1;
+    }
+    const int scans = 50;
+    double real_cost = 0.0;
+    for (int i = 0; i < scans; i++)
+    {
+        do
+        {
+            table.cpu_credit = PROCESS_CPU_CREDIT_MAX;
+            process_table_scan(&table);
+        } while (!table.scanned);
+        real_cost += table.last_scan_cpu;
+    }
+    double per_process = real_cost / scans / (double)(table.live > 0 ? table.live : 1);
+    double projected = per_process * BENCH_PROCS;
+    printf("%-44s %10.2f us/proceso (%zu procesos)\n", "barrido real de /proc", per_process * 1e6, table.live);
+    printf("%-44s %10.2f ms/barrido, un barrido cada %.1f s\n", "proyección a 20000 procesos", projected * 1e3,
+           projected / PROCESS_CPU_RATE);
+    process_table_destroy(&table);
+    if (sink < 0.0)
+    {
+        free(procs);
+        return 1;
+    }
+
+    // 3. Colector con el período por defecto sobre un árbol generado de 20000 procesos (en memoria si hay /dev/shm)
+    char root[] = "/dev/shm/bench_proc.XXXXXX";
+    char fallback[] = "/tmp/bench_proc.XXXXXX";
+    const char* tree = mkdtemp(root) != NULL ? root : mkdtemp(fallback);
+    if (tree == NULL)
+    {
+        perror("Error al crear el árbol proc");
+        free(procs);
+        return 1;
+    }
+    int status = create_proc_tree(tree, procs) != 0 ? 1 : bench_generated_tree(tree, procs);
+    remove_proc_tree(tree);
+    free(procs);
+    return status;
+}
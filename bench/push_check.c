@@ -0,0 +1,717 @@
+/**
+ * @file push_check.c
+ * @brief Receptores de prueba del envío de métricas: verifican lo que push.c pone en la red.
+ *
+ * Levanta en el mismo proceso un receptor de remote-write (HTTP sobre 127.0.0.1, con descompresión de Snappy y
+ * decodificación del WriteRequest) y uno de line protocol (UDP), y comprueba:
+ *  - que las etiquetas lleguen desescapadas y ordenadas por nombre, con __name__, el valor y el instante;
+ *  - que un 503 se reintente y el lote llegue una sola vez;
+ *  - que con la cola llena se descarten las muestras más viejas y se cuenten en dropped;
+ *  - que push_stop() envíe lo que quedaba en la cola sin esperar el período de envío;
+ *  - que el line protocol escape comas, espacios e iguales.
+ */
+
+#include "../include/push.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Series máximas que guarda el receptor.
+ */
+#define CHECK_MAX_SERIES 64
+
+/**
+ * @brief Bytes máximos de un pedido HTTP recibido.
+ */
+#define CHECK_MAX_REQUEST 65536
+
+/**
+ * @brief Respuestas máximas programadas del receptor HTTP.
+ */
+#define CHECK_MAX_STATUSES 8
+
+/**
+ * @brief Instante de las muestras encoladas por las pruebas (ms desde la época Unix).
+ */
+#define CHECK_MS 1700000000123LL
+
+/**
+ * @brief Serie decodificada de un WriteRequest.
+ */
+typedef struct
+{
+    char labels[512];  /**< Etiquetas en el orden recibido, como "nombre=valor;". */
+    double value;      /**< Valor de la muestra. */
+    int64_t timestamp; /**< Instante de la muestra. */
+} check_series_t;
+
+/**
+ * @brief Receptor de remote-write en un hilo aparte.
+ */
+typedef struct
+{
+    int listen_fd;                           /**< Socket de escucha. */
+    int port;                                /**< Puerto de escucha. */
+    pthread_t thread;                        /**< Hilo que atiende los pedidos. */
+    pthread_mutex_t lock;                    /**< Protege los campos siguientes. */
+    int statuses[CHECK_MAX_STATUSES];        /**< Respuestas a los primeros pedidos (luego 204). */
+    int requests;                            /**< Pedidos atendidos. */
+    int bad_requests;                        /**< Pedidos que no se pudieron decodificar. */
+    check_series_t series[CHECK_MAX_SERIES]; /**< Series de los pedidos aceptados. */
+    int count;                               /**< Series guardadas. */
+} receiver_t;
+
+/**
+ * @brief Cantidad de comprobaciones fallidas.
+ */
+static int failures;
+
+/**
+ * @brief Registra una comprobación.
+ * @param ok Resultado.
+ * @param what Descripción.
+ */
+static void check(int ok, const char* what)
+{
+    printf("%-64s %s\n", what, ok ? "ok" : "FALLA");
+    failures += !ok;
+}
+
+/**
+ * @brief Lee un varint de protobuf o de Snappy.
+ * @param p Posición; avanza.
+ * @param end Fin de los datos.
+ * @param value Valor leído.
+ * @return 0 si se leyó, -1 si los datos terminan antes.
+ */
+static int read_varint(const unsigned char** p, const unsigned char* end, uint64_t* value)
+{
+    *value = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7)
+    {
+        unsigned char byte = *(*p)++;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Descomprime un bloque de Snappy con todos los tipos de elemento (literales y copias de 1, 2 y 4 bytes).
+ * @param in Bloque comprimido.
+ * @param len Longitud del bloque.
+ * @param out Buffer de salida.
+ * @param cap Capacidad del buffer.
+ * @return Bytes descomprimidos, o -1 si el bloque es inválido.
+ */
+static long snappy_decompress(const unsigned char* in, size_t len, unsigned char* out, size_t cap)
+{
+    const unsigned char* p = in;
+    const unsigned char* end = in + len;
+    uint64_t total;
+    if (read_varint(&p, end, &total) != 0 || total > cap)
+    {
+        return -1;
+    }
+
+    size_t pos = 0;
+    while (p < end)
+    {
+        unsigned char tag = *p++;
+        size_t n, offset = 0;
+        switch (tag & 3)
+        {
+        case 0:
+            n = (size_t)(tag >> 2) + 1;
+            if (n > 60)
+            {
+                size_t bytes = n - 60;
+                if ((size_t)(end - p) < bytes)
+                {
+                    return -1;
+                }
+                n = 0;
+                for (size_t i = 0; i < bytes; i++)
+                {
+                    n |= (size_t)p[i] << (8 * i);
+                }
+                n++;
+                p += bytes;
+            }
+            if ((size_t)(end - p) < n || pos + n > total)
+            {
+                return -1;
+            }
+            memcpy(out + pos, p, n);
+            p += n;
+            pos += n;
+            continue;
+        case 1:
+            if (p >= end)
+            {
+                return -1;
+            }
+            n = (size_t)((tag >> 2) & 7) + 4;
+            offset = ((size_t)(tag >> 5) << 8) | *p++;
+            break;
+        case 2:
+            if (end - p < 2)
+            {
+                return -1;
+            }
+            n = (size_t)(tag >> 2) + 1;
+            offset = (size_t)p[0] | (size_t)p[1] << 8;
+            p += 2;
+            break;
+        default:
+            if (end - p < 4)
+            {
+                return -1;
+            }
+            n = (size_t)(tag >> 2) + 1;
+            offset = (size_t)p[0] | (size_t)p[1] << 8 | (size_t)p[2] << 16 | (size_t)p[3] << 24;
+            p += 4;
+            break;
+        }
+        // Las copias pueden solaparse con lo que escriben: se copian de a un byte
+        if (offset == 0 || offset > pos || pos + n > total)
+        {
+            return -1;
+        }
+        for (size_t i = 0; i < n; i++, pos++)
+        {
+            out[pos] = out[pos - offset];
+        }
+    }
+    return pos == total ? (long)pos : -1;
+}
+
+/**
+ * @brief Lee la clave de un campo de protobuf y, si es de longitud variable, delimita su contenido.
+ * @param p Posición; avanza hasta después del campo.
+ * @param end Fin del mensaje.
+ * @param field Número de campo.
+ * @param data Contenido del campo de longitud variable, o NULL.
+ * @param len Longitud del contenido.
+ * @param number Valor de un campo varint o de 64 bits.
+ * @return 0 si se leyó, -1 si el mensaje está mal formado.
+ */
+static int read_field(const unsigned char** p, const unsigned char* end, unsigned int* field,
+                      const unsigned char** data, size_t* len, uint64_t* number)
+{
+    uint64_t key;
+    if (read_varint(p, end, &key) != 0)
+    {
+        return -1;
+    }
+    *field = (unsigned int)(key >> 3);
+    *data = NULL;
+    switch (key & 7)
+    {
+    case 0:
+        return read_varint(p, end, number);
+    case 1:
+        if (end - *p < 8)
+        {
+            return -1;
+        }
+        memcpy(number, *p, 8);
+        *p += 8;
+        return 0;
+    case 2:
+        if (read_varint(p, end, number) != 0 || (uint64_t)(end - *p) < *number)
+        {
+            return -1;
+        }
+        *data = *p;
+        *len = (size_t)*number;
+        *p += *len;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Decodifica un TimeSeries con una sola muestra.
+ * @param p Comienzo del mensaje.
+ * @param end Fin del mensaje.
+ * @param series Serie a completar.
+ * @return 0 si se decodificó, -1 si está mal formado.
+ */
+static int decode_series(const unsigned char* p, const unsigned char* end, check_series_t* series)
+{
+    size_t used = 0;
+    int samples = 0;
+    series->labels[0] = '\0';
+    while (p < end)
+    {
+        unsigned int field;
+        const unsigned char* data;
+        size_t len;
+        uint64_t number;
+        if (read_field(&p, end, &field, &data, &len, &number) != 0 || data == NULL)
+        {
+            return -1;
+        }
+
+        // Label { string name = 1; string value = 2; } o Sample { double value = 1; int64 timestamp = 2; }
+        const unsigned char* q = data;
+        const unsigned char* q_end = data + len;
+        while (q < q_end)
+        {
+            unsigned int sub;
+            const unsigned char* text;
+            size_t text_len;
+            uint64_t value;
+            if (read_field(&q, q_end, &sub, &text, &text_len, &value) != 0)
+            {
+                return -1;
+            }
+            if (field == 1 && text != NULL)
+            {
+                int n = snprintf(series->labels + used, sizeof(series->labels) - used, "%.*s%s", (int)text_len,
+                                 (const char*)text, sub == 1 ? "=" : ";");
+                if (n < 0 || (size_t)n >= sizeof(series->labels) - used)
+                {
+                    return -1;
+                }
+                used += (size_t)n;
+            }
+            else if (field == 2 && sub == 1)
+            {
+                memcpy(&series->value, &value, sizeof(double));
+            }
+            else if (field == 2 && sub == 2)
+            {
+                series->timestamp = (int64_t)value;
+            }
+        }
+        samples += field == 2;
+    }
+    return samples == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Descomprime y decodifica un WriteRequest, guardando sus series en el receptor.
+ * @param receiver Receptor, con el mutex tomado.
+ * @param body Cuerpo del pedido.
+ * @param len Longitud del cuerpo.
+ * @return 0 si se decodificó, -1 si está mal formado.
+ */
+static int decode_write_request(receiver_t* receiver, const unsigned char* body, size_t len)
+{
+    static unsigned char plain[CHECK_MAX_REQUEST];
+    long plain_len = snappy_decompress(body, len, plain, sizeof(plain));
+    if (plain_len < 0)
+    {
+        return -1;
+    }
+
+    const unsigned char* p = plain;
+    const unsigned char* end = plain + plain_len;
+    while (p < end)
+    {
+        unsigned int field;
+        const unsigned char* data;
+        size_t data_len;
+        uint64_t number;
+        if (read_field(&p, end, &field, &data, &data_len, &number) != 0 || field != 1 || data == NULL ||
+            receiver->count == CHECK_MAX_SERIES ||
+            decode_series(data, data + data_len, &receiver->series[receiver->count]) != 0)
+        {
+            return -1;
+        }
+        receiver->count++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Atiende un pedido: lo lee completo, lo decodifica y responde con el estado programado.
+ * @param receiver Receptor.
+ * @param fd Conexión aceptada.
+ */
+static void serve_request(receiver_t* receiver, int fd)
+{
+    static char request[CHECK_MAX_REQUEST];
+    size_t len = 0;
+    char* body = NULL;
+    size_t content_length = 0;
+    while (len < sizeof(request) - 1)
+    {
+        ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        len += (size_t)n;
+        request[len] = '\0';
+        if (body == NULL && (body = strstr(request, "\r\n\r\n")) != NULL)
+        {
+            body += 4;
+            const char* header = strstr(request, "Content-Length: ");
+            content_length = header != NULL ? strtoul(header + 16, NULL, 10) : 0;
+        }
+        if (body != NULL && len - (size_t)(body - request) >= content_length)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&receiver->lock);
+    int index = receiver->requests++;
+    int status = index < CHECK_MAX_STATUSES && receiver->statuses[index] != 0 ? receiver->statuses[index] : 204;
+    int valid = body != NULL && strstr(request, "Content-Encoding: snappy\r\n") != NULL &&
+                strstr(request, "Content-Type: application/x-protobuf\r\n") != NULL;
+
+    // Un pedido rechazado no se guarda: el reintento tiene que traer las mismas series
+    if (!valid || (status < 300 && decode_write_request(receiver, (const unsigned char*)body, content_length) != 0))
+    {
+        receiver->bad_requests++;
+        status = 400;
+    }
+    pthread_mutex_unlock(&receiver->lock);
+
+    char response[128];
+    int n = snprintf(response, sizeof(response), "HTTP/1.1 %d Prueba\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                     status);
+    send(fd, response, (size_t)n, MSG_NOSIGNAL);
+    close(fd);
+}
+
+/**
+ * @brief Hilo del receptor: atiende conexiones hasta que se cierra el socket de escucha.
+ * @param arg Receptor.
+ * @return NULL.
+ */
+static void* receiver_thread(void* arg)
+{
+    receiver_t* receiver = arg;
+    while (1)
+    {
+        int fd = accept(receiver->listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            break;
+        }
+        serve_request(receiver, fd);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Abre un socket en 127.0.0.1 con un puerto elegido por el sistema.
+ * @param type SOCK_STREAM o SOCK_DGRAM.
+ * @param port Puerto asignado.
+ * @return Socket, o -1 en caso de error.
+ */
+static int open_local_socket(int type, int* port)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t addr_len = sizeof(addr);
+    int fd = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        (type == SOCK_STREAM && listen(fd, 16) != 0) || getsockname(fd, (struct sockaddr*)&addr, &addr_len) != 0)
+    {
+        perror("Error al abrir el socket del receptor");
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief Inicia un receptor de remote-write.
+ * @param receiver Receptor a inicializar.
+ * @param statuses Respuestas a los primeros pedidos, terminadas en 0 (NULL: siempre 204).
+ * @return 0 si se inició, -1 en caso de error.
+ */
+static int receiver_start(receiver_t* receiver, const int* statuses)
+{
+    memset(receiver, 0, sizeof(*receiver));
+    for (int i = 0; statuses != NULL && statuses[i] != 0 && i < CHECK_MAX_STATUSES; i++)
+    {
+        receiver->statuses[i] = statuses[i];
+    }
+    receiver->listen_fd = open_local_socket(SOCK_STREAM, &receiver->port);
+    if (receiver->listen_fd < 0)
+    {
+        return -1;
+    }
+    pthread_mutex_init(&receiver->lock, NULL);
+    if (pthread_create(&receiver->thread, NULL, receiver_thread, receiver) != 0)
+    {
+        close(receiver->listen_fd);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Detiene un receptor de remote-write.
+ * @param receiver Receptor iniciado.
+ */
+static void receiver_stop(receiver_t* receiver)
+{
+    shutdown(receiver->listen_fd, SHUT_RDWR);
+    pthread_join(receiver->thread, NULL);
+    close(receiver->listen_fd);
+    pthread_mutex_destroy(&receiver->lock);
+}
+
+/**
+ * @brief Inicia un envío hacia un destino local.
+ * @param pusher Envío a iniciar.
+ * @param url Destino.
+ * @param queue Muestras de la cola.
+ * @param batch Muestras de cada lote.
+ * @param flush_ms Período de envío de un lote incompleto.
+ * @return 0 si se inició, -1 en caso de error.
+ */
+static int start_pusher(pusher_t* pusher, const char* url, size_t queue, size_t batch, unsigned long flush_ms)
+{
+    push_config_t config;
+    push_config_default(&config);
+    if (push_parse_url(&config, url) != 0)
+    {
+        return -1;
+    }
+    config.queue_size = queue;
+    config.batch_size = batch;
+    config.flush_ms = flush_ms;
+    return push_start(pusher, &config);
+}
+
+/**
+ * @brief Espera a que el receptor acumule una cantidad de series, con plazo.
+ * @param receiver Receptor.
+ * @param count Series esperadas.
+ * @param timeout_ms Plazo.
+ * @return 1 si llegaron, 0 si venció el plazo.
+ */
+static int wait_series(receiver_t* receiver, int count, int timeout_ms)
+{
+    struct timespec pause = {0, 10000000L};
+    for (int waited = 0; waited <= timeout_ms; waited += 10)
+    {
+        pthread_mutex_lock(&receiver->lock);
+        int have = receiver->count;
+        pthread_mutex_unlock(&receiver->lock);
+        if (have >= count)
+        {
+            return 1;
+        }
+        nanosleep(&pause, NULL);
+    }
+    return 0;
+}
+
+/**
+ * @brief Remote-write: codificación, escapes de las etiquetas y reintento tras un 503.
+ * @return 0 si se pudo correr la prueba, -1 en caso contrario.
+ */
+static int check_remote_write(void)
+{
+    static const int statuses[] = {503, 0};
+    static const char exposition[] = "# HELP http_requests_total Pedidos\n"
+                                     "# TYPE http_requests_total counter\n"
+                                     "http_requests_total{path=\"/a\\\"b\\\\c\\nd\",code=\"200\"} 3\n"
+                                     "http_requests_total{path=\"} {x=\\\"y\\\"}\",code=\"500\"} 1e+03\n"
+                                     "node_load1 0.25\n";
+    receiver_t receiver;
+    pusher_t pusher;
+    char url[64];
+
+    if (receiver_start(&receiver, statuses) != 0)
+    {
+        return -1;
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/api/v1/write", receiver.port);
+    if (start_pusher(&pusher, url, 100, 3, 60000) != 0)
+    {
+        receiver_stop(&receiver);
+        return -1;
+    }
+    push_enqueue_exposition(&pusher, exposition, sizeof(exposition) - 1, CHECK_MS);
+    int arrived = wait_series(&receiver, 3, 5000);
+    push_stop(&pusher);
+    receiver_stop(&receiver);
+
+    check(arrived && receiver.count == 3, "remote-write: el lote llega una sola vez");
+    check(receiver.requests == 2 && atomic_load(&pusher.retries) == 1, "remote-write: un 503 se reintenta una vez");
+    check(receiver.bad_requests == 0, "remote-write: Snappy y protobuf válidos");
+    check(atomic_load(&pusher.sent) == 3 && atomic_load(&pusher.failed) == 0, "remote-write: sent y failed");
+    if (receiver.count != 3)
+    {
+        return 0;
+    }
+    check(strcmp(receiver.series[0].labels, "__name__=http_requests_total;code=200;path=/a\"b\\c\nd;") == 0,
+          "remote-write: comillas, barras y saltos de línea desescapados");
+    check(strcmp(receiver.series[1].labels, "__name__=http_requests_total;code=500;path=} {x=\"y\"};") == 0,
+          "remote-write: llaves y espacios dentro del valor");
+    check(strcmp(receiver.series[2].labels, "__name__=node_load1;") == 0, "remote-write: serie sin etiquetas");
+    check(receiver.series[0].value == 3.0 && receiver.series[1].value == 1000.0 && receiver.series[2].value == 0.25,
+          "remote-write: valores");
+    check(receiver.series[0].timestamp == CHECK_MS && receiver.series[2].timestamp == CHECK_MS,
+          "remote-write: instantes");
+    return 0;
+}
+
+/**
+ * @brief Cola llena: se descartan las muestras más viejas y se cuentan; el resto se envía al terminar.
+ * @return 0 si se pudo correr la prueba, -1 en caso contrario.
+ */
+static int check_drop_oldest(void)
+{
+    receiver_t receiver;
+    pusher_t pusher;
+    char url[64];
+    char exposition[256];
+    size_t len = 0;
+
+    // Con el lote más grande que la cola se recorta al tamaño de la cola, así que se encola todo en una sola llamada
+    for (int i = 1; i <= 8; i++)
+    {
+        len += (size_t)snprintf(exposition + len, sizeof(exposition) - len, "queue_sample{n=\"%d\"} %d\n", i, i);
+    }
+    if (receiver_start(&receiver, NULL) != 0)
+    {
+        return -1;
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/api/v1/write", receiver.port);
+    if (start_pusher(&pusher, url, 5, 100, 60000) != 0)
+    {
+        receiver_stop(&receiver);
+        return -1;
+    }
+    push_enqueue_exposition(&pusher, exposition, len, CHECK_MS);
+    unsigned long long dropped = atomic_load(&pusher.dropped);
+    wait_series(&receiver, 5, 5000);
+    push_stop(&pusher);
+    receiver_stop(&receiver);
+
+    check(dropped == 3, "cola llena: se cuentan 3 muestras descartadas");
+    int oldest = receiver.count == 5;
+    for (int i = 0; oldest && i < 5; i++)
+    {
+        oldest = receiver.series[i].value == (double)(i + 4);
+    }
+    check(oldest, "cola llena: se descartan las más viejas (llegan de la 4 a la 8)");
+    check(atomic_load(&pusher.sent) == 5, "cola llena: sent");
+    return 0;
+}
+
+/**
+ * @brief push_stop() envía lo que quedaba en la cola sin esperar el período de envío.
+ * @return 0 si se pudo correr la prueba, -1 en caso contrario.
+ */
+static int check_shutdown_flush(void)
+{
+    static const char exposition[] = "flush_sample{n=\"1\"} 1\nflush_sample{n=\"2\"} 2\nflush_sample{n=\"3\"} 3\n";
+    receiver_t receiver;
+    pusher_t pusher;
+    char url[64];
+    struct timespec start, end;
+
+    if (receiver_start(&receiver, NULL) != 0)
+    {
+        return -1;
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/api/v1/write", receiver.port);
+    if (start_pusher(&pusher, url, 100, 100, 60000) != 0)
+    {
+        receiver_stop(&receiver);
+        return -1;
+    }
+    push_enqueue_exposition(&pusher, exposition, sizeof(exposition) - 1, CHECK_MS);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    push_stop(&pusher);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    receiver_stop(&receiver);
+
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    check(receiver.count == 3 && atomic_load(&pusher.sent) == 3, "al terminar: se envía la cola pendiente");
+    check(elapsed < 1.0, "al terminar: no se espera el período de envío");
+    return 0;
+}
+
+/**
+ * @brief Line protocol por UDP: escapes de comas, espacios e iguales.
+ * @return 0 si se pudo correr la prueba, -1 en caso contrario.
+ */
+static int check_line_udp(void)
+{
+    static const char exposition[] = "disk_io{device=\"sda 1\",mount=\"/a,b=c\"} 2.5\n"
+                                     "node_load1 0.25\n"
+                                     "empty_label{x=\"\"} 1\n";
+    static const char expected[] = "disk_io,device=sda\\ 1,mount=/a\\,b\\=c value=2.5 1700000000123000000\n"
+                                   "node_load1 value=0.25 1700000000123000000\n"
+                                   "empty_label value=1 1700000000123000000\n";
+    pusher_t pusher;
+    char url[64];
+    char received[2048];
+    int port;
+
+    int fd = open_local_socket(SOCK_DGRAM, &port);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    snprintf(url, sizeof(url), "udp://127.0.0.1:%d", port);
+    if (start_pusher(&pusher, url, 100, 100, 60000) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    push_enqueue_exposition(&pusher, exposition, sizeof(exposition) - 1, CHECK_MS);
+    push_stop(&pusher);
+
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ssize_t n = recv(fd, received, sizeof(received) - 1, 0);
+    close(fd);
+    received[n > 0 ? n : 0] = '\0';
+    check(strcmp(received, expected) == 0, "line protocol: escapes y etiquetas vacías");
+    return 0;
+}
+
+/**
+ * @brief Punto de entrada de las pruebas del envío.
+ * @return 0 si todas las comprobaciones pasan, 1 en caso contrario.
+ */
+int main(void)
+{
+    if (check_remote_write() != 0 || check_drop_oldest() != 0 || check_shutdown_flush() != 0 ||
+        check_line_udp() != 0)
+    {
+        fprintf(stderr, "No se pudieron correr las pruebas del envío\n");
+        return 1;
+    }
+    if (failures > 0)
+    {
+        fprintf(stderr, "%d comprobaciones del envío fallaron\n", failures);
+        return 1;
+    }
+    return 0;
+}
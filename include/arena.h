@@ -0,0 +1,72 @@
+/**
+ * @file arena.h
+ * @brief Arena de memoria temporal: reservas por desplazamiento y liberación de todo junto.
+ *
+ * Las reservas avanzan un puntero dentro de un bloque y nunca se liberan de a una; arena_reset() vuelve el puntero al
+ * principio. Si en un ciclo no alcanzó el bloque se encadenan bloques nuevos, y al reiniciar se reemplazan todos por
+ * uno solo del tamaño máximo usado, de modo que después de los primeros ciclos la arena deja de reservar memoria y
+ * reiniciarla cuesta O(1).
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief Tamaño mínimo de un bloque de la arena.
+ */
+#define ARENA_MIN_BLOCK (64 * 1024)
+
+/**
+ * @brief Alineación de las reservas de la arena.
+ */
+#define ARENA_ALIGN 16
+
+/**
+ * @brief Bloque de la arena, seguido de sus datos.
+ */
+typedef struct arena_block
+{
+    struct arena_block* prev; /**< Bloque anterior, o NULL si es el primero. */
+    size_t size;              /**< Bytes de datos del bloque. */
+    size_t used;              /**< Bytes de datos reservados. */
+} arena_block_t;
+
+/**
+ * @brief Arena de memoria temporal.
+ */
+typedef struct
+{
+    arena_block_t* head; /**< Bloque en uso (el último encadenado), o NULL si todavía no se reservó. */
+    size_t used;         /**< Bytes reservados desde el último reinicio, sumando todos los bloques. */
+    size_t high_water;   /**< Máximo de bytes reservados entre dos reinicios. */
+    size_t blocks;       /**< Bloques reservados desde la creación (para detectar reservas en régimen). */
+} arena_t;
+
+/**
+ * @brief Reserva memoria en la arena, válida hasta el próximo arena_reset().
+ *
+ * @param arena Arena (inicializada en cero).
+ * @param size Bytes a reservar.
+ * @return Memoria alineada a ARENA_ALIGN, o NULL si falta memoria.
+ */
+void* arena_alloc(arena_t* arena, size_t size);
+
+/**
+ * @brief Libera de una vez todo lo reservado en la arena.
+ *
+ * Si hubo que encadenar bloques, los reemplaza por uno solo que alcance para el máximo usado.
+ *
+ * @param arena Arena.
+ */
+void arena_reset(arena_t* arena);
+
+/**
+ * @brief Libera los bloques de la arena.
+ *
+ * @param arena Arena.
+ */
+void arena_destroy(arena_t* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,209 @@
+/**
+ * @file cgroup_stats.h
+ * @brief Estadísticas por cgroup (cgroup v2): CPU, memoria, I/O y presión (PSI).
+ *
+ * La jerarquía se recorre una sola vez al inicio; a partir de ahí se mantiene con inotify sobre cada directorio
+ * de cgroup, de modo que en cada ciclo sólo se procesan los cgroups creados, renombrados o eliminados en vez de volver
+ * a recorrer el árbol completo (en un nodo de Kubernetes puede haber miles).
+ */
+
+#ifndef CGROUP_STATS_H
+#define CGROUP_STATS_H
+
+#include "arena.h"
+#include "pressure_stats.h"
+#include <stddef.h>
+
+/**
+ * @brief Punto de montaje habitual de la jerarquía cgroup v2.
+ */
+#define CGROUP_DEFAULT_ROOT "/sys/fs/cgroup"
+
+/**
+ * @brief Tamaño del buffer para leer los archivos de un cgroup (memory.stat e io.stat son los más largos).
+ */
+#define CGROUP_FILE_BUF_SIZE 16384
+
+/**
+ * @brief Campos de memory.stat que se exportan.
+ */
+typedef enum
+{
+    CGROUP_MEMSTAT_ANON,           /**< Memoria anónima. */
+    CGROUP_MEMSTAT_FILE,           /**< Caché de archivos. */
+    CGROUP_MEMSTAT_KERNEL_STACK,   /**< Pilas del kernel. */
+    CGROUP_MEMSTAT_SLAB,           /**< Estructuras slab del kernel. */
+    CGROUP_MEMSTAT_SOCK,           /**< Buffers de sockets. */
+    CGROUP_MEMSTAT_SHMEM,          /**< Memoria compartida (tmpfs, shm). */
+    CGROUP_MEMSTAT_FILE_MAPPED,    /**< Caché de archivos mapeada con mmap(). */
+    CGROUP_MEMSTAT_FILE_DIRTY,     /**< Caché de archivos modificada y no escrita. */
+    CGROUP_MEMSTAT_FILE_WRITEBACK, /**< Caché de archivos en escritura. */
+    CGROUP_MEMSTAT_COUNT,          /**< Cantidad de campos. */
+} cgroup_memstat_t;
+
+/**
+ * @brief Bandera de cgroup_sample_t: se leyó cpu.stat.
+ */
+#define CGROUP_HAS_CPU 0x01
+
+/**
+ * @brief Bandera de cgroup_sample_t: cpu.stat incluye los campos de limitación (controlador cpu habilitado).
+ */
+#define CGROUP_HAS_THROTTLING 0x02
+
+/**
+ * @brief Bandera de cgroup_sample_t: se leyó memory.current.
+ */
+#define CGROUP_HAS_MEMORY 0x04
+
+/**
+ * @brief Bandera de cgroup_sample_t: se leyó memory.stat.
+ */
+#define CGROUP_HAS_MEMORY_STAT 0x08
+
+/**
+ * @brief Bandera de cgroup_sample_t: se leyó io.stat.
+ */
+#define CGROUP_HAS_IO 0x10
+
+/**
+ * @brief Valores leídos de los archivos de un cgroup en un ciclo.
+ *
+ * Los contadores se exportan tal como los informa el kernel; sólo son válidos los campos cuya bandera está en flags
+ * (un archivo falta si el controlador correspondiente no está habilitado para el cgroup).
+ */
+typedef struct
+{
+    unsigned int flags;                                   /**< Combinación de CGROUP_HAS_*. */
+    unsigned long long usage_usec;                        /**< Tiempo de CPU total, en microsegundos. */
+    unsigned long long user_usec;                         /**< Tiempo de CPU en modo usuario. */
+    unsigned long long system_usec;                       /**< Tiempo de CPU en modo kernel. */
+    unsigned long long nr_periods;                        /**< Períodos de cuota transcurridos. */
+    unsigned long long nr_throttled;                      /**< Períodos en que se agotó la cuota. */
+    unsigned long long throttled_usec;                    /**< Tiempo total limitado, en microsegundos. */
+    unsigned long long memory_current;                    /**< Memoria usada, en bytes. */
+    unsigned long long memory_stat[CGROUP_MEMSTAT_COUNT]; /**< Campos de memory.stat, en bytes. */
+    unsigned long long pgfault;                           /**< Fallos de página. */
+    unsigned long long pgmajfault;                        /**< Fallos de página mayores. */
+    unsigned long long io_rbytes;                         /**< Bytes leídos, sumando todos los dispositivos. */
+    unsigned long long io_wbytes;                         /**< Bytes escritos, sumando todos los dispositivos. */
+    unsigned long long io_rios;                           /**< Operaciones de lectura. */
+    unsigned long long io_wios;                           /**< Operaciones de escritura. */
+    pressure_sample_t pressure[PRESSURE_RESOURCE_COUNT];  /**< Archivos *.pressure (present en 0 si faltan). */
+} cgroup_sample_t;
+
+/**
+ * @brief Estado de una entrada de la tabla de cgroups.
+ */
+typedef enum
+{
+    CGROUP_SLOT_EMPTY,   /**< Entrada nunca usada. */
+    CGROUP_SLOT_USED,    /**< Entrada con un cgroup presente. */
+    CGROUP_SLOT_DELETED, /**< Entrada de un cgroup eliminado. */
+} cgroup_slot_state_t;
+
+/**
+ * @brief Cgroup vigilado con su última lectura.
+ */
+typedef struct
+{
+    cgroup_slot_state_t state;     /**< Estado de la entrada. */
+    int wd;                        /**< Descriptor de vigilancia de inotify (clave de la tabla). */
+    unsigned int depth;            /**< Profundidad respecto de la raíz (0 para la raíz). */
+    unsigned long long generation; /**< Último recorrido completo en que se vio el cgroup. */
+    char* path;                    /**< Ruta relativa a la raíz ("" para la raíz). */
+    cgroup_sample_t sample;        /**< Última lectura. */
+} cgroup_entry_t;
+
+/**
+ * @brief Jerarquía de cgroups vigilada, como tabla hash con direccionamiento abierto indexada por descriptor de
+ * vigilancia.
+ */
+typedef struct
+{
+    cgroup_entry_t* slots;               /**< Entradas de la tabla. */
+    size_t capacity;                     /**< Cantidad de entradas (potencia de 2). */
+    size_t used;                         /**< Entradas usadas o borradas (ocupan lugar en el sondeo). */
+    size_t live;                         /**< Cgroups presentes. */
+    unsigned long long generation;       /**< Número del último recorrido completo. */
+    char* root;                          /**< Directorio raíz de la jerarquía. */
+    int root_fd;                         /**< Descriptor de la raíz, o -1. */
+    int inotify_fd;                      /**< Descriptor de inotify, o -1. */
+    unsigned int max_depth;              /**< Profundidad máxima exportada (0: sin límite). */
+    int watch_limit_reported;            /**< 1 si ya se informó que se alcanzó el límite de vigilancias. */
+    char file_buf[CGROUP_FILE_BUF_SIZE]; /**< Buffer para leer los archivos de cada cgroup. */
+} cgroup_tree_t;
+
+/**
+ * @brief Inicializa la jerarquía: verifica que sea cgroup v2, la recorre y vigila cada directorio con inotify.
+ *
+ * @param tree Jerarquía a inicializar.
+ * @param root Punto de montaje de cgroup v2 (normalmente CGROUP_DEFAULT_ROOT).
+ * @param max_depth Profundidad máxima de los cgroups exportados (0: sin límite).
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int cgroup_tree_init(cgroup_tree_t* tree, const char* root, unsigned int max_depth);
+
+/**
+ * @brief Deja de vigilar la jerarquía y libera la tabla.
+ *
+ * @param tree Jerarquía a liberar.
+ */
+void cgroup_tree_destroy(cgroup_tree_t* tree);
+
+/**
+ * @brief Aplica los cambios de la jerarquía notificados por inotify desde la última llamada, sin bloquear.
+ *
+ * Si la cola de eventos del kernel desbordó se vuelve a recorrer el árbol completo.
+ *
+ * @param tree Jerarquía.
+ * @param scratch Memoria temporal para recorrer los cgroups nuevos (se puede reiniciar al volver).
+ * @return Cantidad de eventos procesados, o -1 en caso de error.
+ */
+int cgroup_tree_refresh(cgroup_tree_t* tree, arena_t* scratch);
+
+/**
+ * @brief Lee los archivos de estadísticas de todos los cgroups vigilados.
+ *
+ * @param tree Jerarquía.
+ */
+void cgroup_tree_read(cgroup_tree_t* tree);
+
+/**
+ * @brief Obtiene el nombre de un campo de memory.stat.
+ *
+ * @param stat Campo.
+ * @return Nombre del campo tal como aparece en memory.stat (por ejemplo "anon").
+ */
+const char* cgroup_memstat_name(cgroup_memstat_t stat);
+
+/**
+ * @brief Analiza el contenido de cpu.stat.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar (agrega CGROUP_HAS_CPU y, si corresponde, CGROUP_HAS_THROTTLING).
+ * @return 0 si se encontró usage_usec, -1 en caso contrario.
+ */
+int parse_cgroup_cpu_stat(const char* buf, size_t len, cgroup_sample_t* sample);
+
+/**
+ * @brief Analiza el contenido de memory.stat.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar (memory_stat, pgfault y pgmajfault).
+ * @return 0 si se interpretó, -1 si el archivo no tiene ningún campo conocido.
+ */
+int parse_cgroup_memory_stat(const char* buf, size_t len, cgroup_sample_t* sample);
+
+/**
+ * @brief Analiza el contenido de io.stat, sumando los contadores de todos los dispositivos.
+ *
+ * @param buf Contenido del archivo (una línea "MAJ:MIN rbytes=N wbytes=N rios=N wios=N ..." por dispositivo).
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar (io_rbytes, io_wbytes, io_rios e io_wios).
+ */
+void parse_cgroup_io_stat(const char* buf, size_t len, cgroup_sample_t* sample);
+
+#endif // CGROUP_STATS_H
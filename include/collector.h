@@ -0,0 +1,224 @@
+/**
+ * @file collector.h
+ * @brief Registro de colectores y planificación de cada uno con su propio período.
+ *
+ * Cada colector (CPU, memoria, discos, red, etc.) declara cómo inicializarse, recolectar y liberarse, y se ejecuta con
+ * su propio período: las métricas baratas pueden actualizarse seguido y las costosas (el barrido de procesos, los
+ * cgroups de un nodo grande) con menos frecuencia. Los colectores habilitados se ordenan en un montículo (min-heap)
+ * por el instante de su próxima ejecución, de modo que el hilo recolector sólo duerme hasta el más próximo.
+ *
+ * Cada colector usa un sampler_t para mantener su fase: los instantes son absolutos (inicio + n * período) y los
+ * ciclos vencidos se saltean en lugar de ejecutarse seguidos.
+ *
+ * Cada colector recibe en collect su propia arena (arena.h) para la memoria temporal de la ejecución: buffers de
+ * lectura y registros intermedios que se descartan todos juntos cuando el hilo que lo ejecutó la reinicia al terminar.
+ * Los colectores corren en paralelo, así que cada uno tiene la suya en lugar de compartir una arena por ciclo.
+ *
+ * Los colectores que vencen en un mismo instante se reparten entre un grupo fijo de hilos y el hilo recolector espera
+ * a que terminen, pero cada uno sólo hasta su plazo: una lectura que se cuelga (por ejemplo, un dispositivo respaldado
+ * por NFS) no demora la publicación de los demás. El colector que no termina a tiempo conserva sus últimos valores,
+ * queda marcado como desactualizado y no se vuelve a lanzar hasta que termine.
+ */
+
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include "arena.h"
+#include "histogram.h"
+#include "sampler.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Cantidad máxima de colectores registrados.
+ */
+#define COLLECTOR_MAX 16
+
+/**
+ * @brief Cantidad de hilos por defecto que ejecutan los colectores.
+ */
+#define COLLECTOR_DEFAULT_WORKERS 4
+
+/**
+ * @brief Cantidad máxima de hilos que ejecutan los colectores.
+ */
+#define COLLECTOR_MAX_WORKERS COLLECTOR_MAX
+
+/**
+ * @brief Plazo por defecto de cada ejecución de un colector, en milisegundos (nunca mayor que su período).
+ */
+#define COLLECTOR_DEFAULT_DEADLINE_MS 500
+
+/**
+ * @brief Colector de métricas.
+ */
+typedef struct
+{
+    const char* name;             /**< Nombre usado en la línea de comandos (por ejemplo "disk"). */
+    const char* help;             /**< Descripción breve para la ayuda. */
+    int (*init)(void);            /**< Crea y registra sus métricas; 0 si se inicializó, -1 si no. Puede ser NULL. */
+    int (*collect)(arena_t*);     /**< Lee el sistema y actualiza sus métricas; 0 si pudo, -1 si hubo un error. */
+    void (*destroy)(void);        /**< Libera lo reservado por init. Puede ser NULL. */
+    int enabled;                  /**< 1 si el colector se ejecuta. */
+    unsigned long interval_ms;    /**< Período propio en milisegundos, o 0 para usar el período por defecto. */
+    unsigned long deadline_ms;    /**< Plazo propio de cada ejecución, o 0 para usar el plazo por defecto. */
+    int initialized;              /**< 1 si init terminó correctamente (y corresponde llamar a destroy). */
+    sampler_t schedule;           /**< Instante de la próxima ejecución y ciclos salteados. */
+    struct timespec deadline;     /**< Plazo de la ejecución en curso (CLOCK_MONOTONIC). */
+    int busy;                     /**< 1 mientras un hilo ejecuta collect (protegido por el mutex del registro). */
+    int stale;                    /**< 1 si la última ejecución no terminó a tiempo y los valores son de antes. */
+    unsigned long long timeouts;  /**< Ejecuciones que no terminaron a tiempo o no pudieron lanzarse. */
+    histogram_t duration;         /**< Duración de cada ejecución terminada (aunque haya vencido su plazo). */
+    atomic_ullong errors;         /**< Ejecuciones en las que collect devolvió un error. */
+    arena_t scratch;              /**< Memoria temporal que recibe collect; se reinicia al terminar cada ejecución. */
+    atomic_size_t scratch_peak;   /**< Máximo de memoria temporal usada en una ejecución. */
+    atomic_size_t scratch_blocks; /**< Bloques reservados por la memoria temporal desde que se inició. */
+} collector_t;
+
+/**
+ * @brief Colectores registrados y montículo de los habilitados, ordenado por la próxima ejecución.
+ */
+typedef struct
+{
+    collector_t collectors[COLLECTOR_MAX];    /**< Colectores, en el orden en que se registraron. */
+    size_t count;                             /**< Cantidad de colectores registrados. */
+    collector_t* heap[COLLECTOR_MAX];         /**< Montículo de colectores habilitados (el más próximo primero). */
+    size_t heap_len;                          /**< Cantidad de colectores en el montículo. */
+    unsigned int worker_count;                /**< Hilos a crear al iniciar (por defecto COLLECTOR_DEFAULT_WORKERS). */
+    unsigned long deadline_ms;                /**< Plazo por defecto (por defecto COLLECTOR_DEFAULT_DEADLINE_MS). */
+    pthread_t workers[COLLECTOR_MAX_WORKERS]; /**< Hilos que ejecutan los colectores. */
+    unsigned int workers_started;             /**< Cantidad de hilos creados. */
+    pthread_mutex_t lock;                     /**< Protege la cola, busy y stopping. */
+    pthread_cond_t work_ready;                /**< Señala a los hilos que hay colectores en la cola. */
+    pthread_cond_t work_done;                 /**< Señala al hilo recolector que un colector terminó. */
+    collector_t* queue[COLLECTOR_MAX];        /**< Cola circular de colectores a ejecutar. */
+    size_t queue_head;                        /**< Posición del primero de la cola. */
+    size_t queue_len;                         /**< Cantidad de colectores en la cola. */
+    int stopping;                             /**< 1 cuando los hilos deben terminar. */
+} collector_registry_t;
+
+/**
+ * @brief Inicializa un registro vacío, con la cantidad de hilos y el plazo por defecto.
+ *
+ * @param registry Registro a inicializar.
+ */
+void collector_registry_init(collector_registry_t* registry);
+
+/**
+ * @brief Registra un colector.
+ *
+ * @param registry Registro.
+ * @param collector Descripción del colector (se copia; enabled e interval_ms son los valores por defecto).
+ * @return 0 si se registró, -1 si el registro está lleno.
+ */
+int collector_register(collector_registry_t* registry, const collector_t* collector);
+
+/**
+ * @brief Busca un colector por nombre.
+ *
+ * @param registry Registro.
+ * @param name Nombre del colector.
+ * @return Colector, o NULL si no hay ninguno con ese nombre.
+ */
+collector_t* collector_find(collector_registry_t* registry, const char* name);
+
+/**
+ * @brief Aplica una opción "NOMBRE=on", "NOMBRE=off" o "NOMBRE=MS" (habilitar con un período propio).
+ *
+ * @param registry Registro.
+ * @param spec Opción a aplicar.
+ * @return 0 si se aplicó, -1 si el colector no existe o el valor es inválido.
+ */
+int collector_configure(collector_registry_t* registry, const char* spec);
+
+/**
+ * @brief Escribe la lista de colectores con su estado y período.
+ *
+ * @param registry Registro.
+ * @param out Destino.
+ */
+void collector_registry_print(const collector_registry_t* registry, FILE* out);
+
+/**
+ * @brief Inicializa los colectores habilitados, crea los hilos y programa la primera ejecución en el instante actual.
+ *
+ * Los hilos se crean con todas las señales bloqueadas, de modo que las señales del programa sólo interrumpen al hilo
+ * recolector.
+ *
+ * @param registry Registro (worker_count y deadline_ms ya configurados).
+ * @param default_interval_ms Período de los colectores sin período propio.
+ * @return 0 si todos los colectores habilitados se inicializaron, -1 en caso contrario.
+ */
+int collector_registry_start(collector_registry_t* registry, unsigned long default_interval_ms);
+
+/**
+ * @brief Espera hasta la próxima ejecución de algún colector.
+ *
+ * Si una señal interrumpe la espera se devuelve -1 sin perder el instante programado: la siguiente llamada sigue
+ * esperando hasta ese mismo instante. Así el llamador puede atender, por ejemplo, un pedido de terminación.
+ *
+ * @param registry Registro iniciado con collector_registry_start().
+ * @return 0 al llegar el instante, -1 si la espera fue interrumpida por una señal.
+ */
+int collector_registry_wait(collector_registry_t* registry);
+
+/**
+ * @brief Lanza en los hilos los colectores cuya próxima ejecución ya llegó, los reprograma y espera a que terminen.
+ *
+ * La espera por cada colector termina en su plazo; el que no llega se marca como desactualizado (stale) y se cuenta
+ * en timeouts, igual que el que no puede lanzarse porque su ejecución anterior todavía no terminó.
+ *
+ * @param registry Registro iniciado con collector_registry_start().
+ * @return Cantidad de colectores que vencieron (lanzados o no).
+ */
+size_t collector_registry_run_due(collector_registry_t* registry);
+
+/**
+ * @brief Ejecuta todos los colectores habilitados fuera de ciclo, sin cambiar su planificación.
+ *
+ * Como collector_registry_run_due(), espera a cada uno hasta su plazo; los que siguen ocupados no se lanzan.
+ *
+ * @param registry Registro iniciado con collector_registry_start().
+ */
+void collector_registry_run_all(collector_registry_t* registry);
+
+/**
+ * @brief Indica si algún colector está en ejecución (por ejemplo, uno colgado que venció su plazo).
+ *
+ * @param registry Registro iniciado con collector_registry_start().
+ * @return El primer colector en ejecución (su nombre identifica al que demora, por ejemplo, una recarga), o NULL si no
+ * hay ninguno.
+ */
+const collector_t* collector_registry_busy(collector_registry_t* registry);
+
+/**
+ * @brief Aplica a un registro iniciado la configuración (habilitados, períodos y plazos) de otro registro.
+ *
+ * El registro deseado se arma como el original (los mismos colectores en el mismo orden) y se configura con
+ * collector_configure(). La configuración se valida completa y los colectores que se habilitan se inicializan antes de
+ * modificar nada: si algo falla, el registro queda como estaba. Los colectores que no cambian conservan su fase y su
+ * estado (por ejemplo, las lecturas anteriores de las que salen las tasas); los que cambian de período se reprograman
+ * en el instante actual y los que se deshabilitan se liberan con destroy, si lo tienen.
+ *
+ * Debe llamarse desde el hilo recolector sin colectores en ejecución (collector_registry_busy() en NULL).
+ *
+ * @param registry Registro iniciado con collector_registry_start().
+ * @param desired Registro con la configuración nueva (no iniciado).
+ * @param default_interval_ms Período de los colectores sin período propio.
+ * @return Cantidad de colectores que cambiaron, o -1 si la configuración es inválida o un colector no se inicializó.
+ */
+int collector_registry_reload(collector_registry_t* registry, const collector_registry_t* desired,
+                              unsigned long default_interval_ms);
+
+/**
+ * @brief Detiene los hilos y libera los colectores inicializados.
+ *
+ * Un hilo colgado en un colector se espera sólo hasta el plazo por defecto; ese colector no se libera.
+ *
+ * @param registry Registro.
+ * @return 0 si todos los hilos terminaron, -1 si alguno sigue en un colector (y puede usar lo que éste comparte).
+ */
+int collector_registry_destroy(collector_registry_t* registry);
+
+#endif // COLLECTOR_H
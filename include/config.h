@@ -0,0 +1,86 @@
+/**
+ * @file config.h
+ * @brief Archivo de configuración del exportador y vigilancia del archivo para recargarlo.
+ *
+ * El archivo tiene una opción por línea, "clave = valor", con las mismas claves que las opciones largas de la línea
+ * de comandos (sin los guiones): "interval = 500", "collector = disk=off", "net-exclude = ^(lo|veth.*)$". Las líneas
+ * vacías y las que empiezan con '#' se ignoran, y el valor puede ir entre comillas dobles. Cada línea se convierte en
+ * un argumento "--clave=valor", de modo que el archivo se interpreta con el mismo getopt_long() que la línea de
+ * comandos y admite exactamente las mismas opciones.
+ *
+ * La vigilancia observa el directorio del archivo con inotify (los editores suelen reemplazar el archivo en lugar de
+ * escribirlo) y avisa con una señal al hilo recolector, que es quien recarga la configuración entre ciclos.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <limits.h>
+#include <pthread.h>
+
+/**
+ * @brief Cantidad máxima de opciones de un archivo de configuración.
+ */
+#define CONFIG_MAX_OPTIONS 128
+
+/**
+ * @brief Opciones leídas de un archivo de configuración.
+ */
+typedef struct
+{
+    char* args[CONFIG_MAX_OPTIONS + 2]; /**< Nombre del archivo, "--clave=valor" por opción y NULL, como un argv. */
+    int count;                          /**< Cantidad de argumentos, incluido el primero. */
+} config_file_t;
+
+/**
+ * @brief Vigilancia de un archivo de configuración y el hilo que la espera.
+ */
+typedef struct
+{
+    int inotify_fd;          /**< Descriptor de inotify sobre el directorio del archivo, o -1. */
+    int wake_fd;             /**< eventfd para pedirle al hilo que termine, o -1. */
+    char name[NAME_MAX + 1]; /**< Nombre del archivo dentro de su directorio. */
+    pthread_t thread;        /**< Hilo que espera los cambios. */
+    pthread_t target;        /**< Hilo al que se avisa con la señal. */
+    int signo;               /**< Señal con la que se avisa. */
+    int running;             /**< 1 si el hilo está en ejecución. */
+} config_watch_t;
+
+/**
+ * @brief Lee un archivo de configuración.
+ *
+ * @param file Opciones a completar; se liberan con config_file_free() (aun si la lectura falla).
+ * @param path Ruta del archivo.
+ * @return 0 si se leyó, -1 si no se pudo abrir, una línea no tiene la forma "clave = valor" o hay demasiadas opciones.
+ */
+int config_file_load(config_file_t* file, const char* path);
+
+/**
+ * @brief Libera las opciones leídas.
+ *
+ * @param file Opciones leídas con config_file_load(), o inicializadas en cero.
+ */
+void config_file_free(config_file_t* file);
+
+/**
+ * @brief Empieza a vigilar un archivo de configuración.
+ *
+ * El hilo hereda la máscara de señales del hilo que lo crea; conviene crearlo con las señales del programa
+ * bloqueadas para que no las reciba él.
+ *
+ * @param watch Vigilancia a inicializar.
+ * @param path Ruta del archivo.
+ * @param target Hilo al que se envía la señal cuando el archivo cambia.
+ * @param signo Señal a enviar.
+ * @return 0 si se inició, -1 en caso de error.
+ */
+int config_watch_start(config_watch_t* watch, const char* path, pthread_t target, int signo);
+
+/**
+ * @brief Detiene la vigilancia.
+ *
+ * @param watch Vigilancia iniciada con config_watch_start(), o con running en 0.
+ */
+void config_watch_stop(config_watch_t* watch);
+
+#endif // CONFIG_H
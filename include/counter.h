@@ -0,0 +1,60 @@
+/**
+ * @file counter.h
+ * @brief Contadores acumulados de 64 bits con detección de vueltas y reinicios.
+ *
+ * Los contadores del kernel (cambios de contexto, interrupciones, sectores, bytes de red) sólo crecen, salvo en dos
+ * casos: algunos se guardan en 32 bits y dan la vuelta al pasar de 2^32 - 1 (campos de /proc/diskstats en kernels
+ * viejos, contadores de interfaces en algunos drivers), y otros vuelven a empezar de 0 cuando se recrea el objeto
+ * (una interfaz o un dispositivo que desaparece y reaparece). La diferencia entre dos lecturas compensa ambos casos,
+ * y counter_t acumula esas diferencias en un valor que nunca retrocede y se exporta sin pasar por un double.
+ */
+
+#ifndef COUNTER_H
+#define COUNTER_H
+
+/**
+ * @brief Contador acumulado a partir de lecturas sucesivas de un contador del kernel.
+ */
+typedef struct
+{
+    unsigned long long last;  /**< Última lectura del contador del kernel. */
+    unsigned long long value; /**< Valor acumulado: la primera lectura más las diferencias posteriores. */
+    int primed;               /**< 1 si ya hubo una primera lectura. */
+} counter_t;
+
+/**
+ * @brief Diferencia entre dos lecturas de un contador del kernel.
+ *
+ * Si el contador retrocedió desde un valor de 32 bits y la diferencia dando la vuelta en 2^32 es menor que 2^31, se
+ * toma como una vuelta; en cualquier otro caso se toma como un reinicio y la diferencia es la lectura actual (lo
+ * contado desde 0).
+ *
+ * @param cur Lectura actual.
+ * @param prev Lectura anterior.
+ * @return Incremento entre ambas lecturas.
+ */
+unsigned long long counter_delta(unsigned long long cur, unsigned long long prev);
+
+/**
+ * @brief Tasa por segundo de un contador del kernel entre dos lecturas.
+ *
+ * @param cur Lectura actual.
+ * @param prev Lectura anterior.
+ * @param elapsed Segundos entre ambas lecturas (mayor que 0).
+ * @return Incremento por segundo, con vueltas y reinicios compensados como en counter_delta().
+ */
+double counter_rate(unsigned long long cur, unsigned long long prev, double elapsed);
+
+/**
+ * @brief Acumula una lectura de un contador del kernel.
+ *
+ * La primera lectura se toma como valor inicial, de modo que, mientras el contador del kernel no retroceda, el valor
+ * acumulado coincide con él.
+ *
+ * @param counter Contador acumulado (inicializado en cero).
+ * @param raw Lectura del contador del kernel.
+ * @return Incremento respecto de la lectura anterior (0 en la primera lectura).
+ */
+unsigned long long counter_update(counter_t* counter, unsigned long long raw);
+
+#endif // COUNTER_H
@@ -0,0 +1,86 @@
+/**
+ * @file ddsketch.h
+ * @brief Sketch de cuantiles de memoria fija con error relativo acotado (DDSketch, Datadog, VLDB 2019).
+ *
+ * Cada valor positivo cae en el bucket i tal que gamma^(i-1) < valor <= gamma^i, con gamma = (1 + a) / (1 - a):
+ * devolver el punto medio del bucket acota el error relativo de cualquier cuantil en a. Agregar y quitar un valor es
+ * O(1) y la memoria no depende de la cantidad de valores; calcular un cuantil recorre los buckets.
+ *
+ * Los buckets cubren de DDSKETCH_MIN_VALUE a DDSKETCH_MAX_VALUE: los valores menores (incluidos 0 y los negativos)
+ * se cuentan en un bucket de cero y los mayores en el último bucket.
+ */
+
+#ifndef DDSKETCH_H
+#define DDSKETCH_H
+
+#include <stdint.h>
+
+/**
+ * @brief Error relativo de los cuantiles.
+ */
+#define DDSKETCH_RELATIVE_ACCURACY 0.01
+
+/**
+ * @brief Menor valor con bucket propio; los menores se cuentan como 0.
+ */
+#define DDSKETCH_MIN_VALUE 1e-3
+
+/**
+ * @brief Mayor valor con precisión garantizada; los mayores se cuentan en el último bucket.
+ */
+#define DDSKETCH_MAX_VALUE 1e9
+
+/**
+ * @brief Índice del bucket de DDSKETCH_MIN_VALUE: ceil(log(1e-3) / log(gamma)) con a = 0,01.
+ */
+#define DDSKETCH_MIN_INDEX (-345)
+
+/**
+ * @brief Cantidad de buckets: de DDSKETCH_MIN_VALUE a DDSKETCH_MAX_VALUE con a = 0,01.
+ */
+#define DDSKETCH_BUCKETS 1383
+
+/**
+ * @brief Sketch de cuantiles.
+ */
+typedef struct
+{
+    uint32_t zero;                      /**< Valores menores que DDSKETCH_MIN_VALUE. */
+    uint32_t buckets[DDSKETCH_BUCKETS]; /**< Valores de cada bucket, desde DDSKETCH_MIN_INDEX. */
+    uint32_t count;                     /**< Total de valores. */
+} ddsketch_t;
+
+/**
+ * @brief Inicializa un sketch vacío.
+ *
+ * @param sketch Sketch.
+ */
+void ddsketch_init(ddsketch_t* sketch);
+
+/**
+ * @brief Agrega un valor.
+ *
+ * @param sketch Sketch inicializado.
+ * @param value Valor (no NaN).
+ */
+void ddsketch_add(ddsketch_t* sketch, double value);
+
+/**
+ * @brief Quita un valor agregado antes.
+ *
+ * @param sketch Sketch inicializado.
+ * @param value Valor, idéntico al que se agregó.
+ */
+void ddsketch_remove(ddsketch_t* sketch, double value);
+
+/**
+ * @brief Calcula varios cuantiles en un único recorrido de los buckets.
+ *
+ * @param sketch Sketch con al menos un valor.
+ * @param q Cuantiles pedidos, crecientes, entre 0 y 1.
+ * @param out Valor estimado de cada cuantil.
+ * @param count Cantidad de cuantiles.
+ */
+void ddsketch_quantiles(const ddsketch_t* sketch, const double* q, double* out, int count);
+
+#endif // DDSKETCH_H
@@ -0,0 +1,133 @@
+/**
+ * @file disk_stats.h
+ * @brief Estadísticas por dispositivo de bloque a partir de /proc/diskstats.
+ *
+ * Los dispositivos se guardan en una tabla hash indexada por major:minor que se conserva entre ciclos: aparecer o
+ * desaparecer un dispositivo sólo agrega o marca como borrada su entrada, sin reconstruir la tabla completa.
+ */
+
+#ifndef DISK_STATS_H
+#define DISK_STATS_H
+
+#include "counter.h"
+#include <regex.h>
+#include <stddef.h>
+
+/**
+ * @brief Tamaño de un sector en /proc/diskstats, independiente del tamaño físico del dispositivo.
+ */
+#define DISK_SECTOR_SIZE 512
+
+/**
+ * @brief Filtro de exclusión por defecto: particiones, ram, zram, loop y disquetes (evita contar dos veces).
+ */
+#define DISK_DEFAULT_EXCLUDE "^(z?ram|loop|fd|(h|s|v|xv)d[a-z]+|nvme[0-9]+n[0-9]+p|mmcblk[0-9]+p)[0-9]+$"
+
+/**
+ * @brief Contadores acumulados de un dispositivo, tal como aparecen en /proc/diskstats.
+ */
+typedef struct
+{
+    unsigned long long reads;         /**< Lecturas completadas. */
+    unsigned long long read_sectors;  /**< Sectores leídos. */
+    unsigned long long read_ms;       /**< Milisegundos dedicados a lecturas. */
+    unsigned long long writes;        /**< Escrituras completadas. */
+    unsigned long long write_sectors; /**< Sectores escritos. */
+    unsigned long long write_ms;      /**< Milisegundos dedicados a escrituras. */
+    unsigned long long io_ticks;      /**< Milisegundos con al menos una operación en curso. */
+    unsigned long long queue_ms;      /**< Milisegundos ponderados por la cantidad de operaciones en curso. */
+} disk_counters_t;
+
+/**
+ * @brief Estado de una entrada de la tabla de dispositivos.
+ */
+typedef enum
+{
+    DISK_SLOT_EMPTY,   /**< Entrada nunca usada. */
+    DISK_SLOT_USED,    /**< Entrada con un dispositivo presente. */
+    DISK_SLOT_DELETED, /**< Entrada de un dispositivo que desapareció. */
+} disk_slot_state_t;
+
+/**
+ * @brief Dispositivo de bloque con sus contadores y las tasas del último intervalo.
+ */
+typedef struct
+{
+    disk_slot_state_t state;       /**< Estado de la entrada. */
+    unsigned int major;            /**< Número mayor del dispositivo. */
+    unsigned int minor;            /**< Número menor del dispositivo. */
+    char name[32];                 /**< Nombre del dispositivo (etiqueta "device"). */
+    int filtered;                  /**< 1 si el dispositivo quedó excluido por los filtros. */
+    int has_prev;                  /**< 1 si ya hay una lectura anterior con la cual comparar. */
+    int valid;                     /**< 1 si las tasas corresponden a dos lecturas comparables. */
+    unsigned long long generation; /**< Último ciclo en que se vio el dispositivo. */
+    disk_counters_t cur;           /**< Contadores de la lectura actual. */
+    disk_counters_t prev;          /**< Contadores de la lectura anterior. */
+    disk_counters_t total;         /**< Contadores acumulados, sin retroceder ante vueltas ni reinicios. */
+    double read_bytes_per_sec;     /**< Bytes leídos por segundo. */
+    double write_bytes_per_sec;    /**< Bytes escritos por segundo. */
+    double reads_per_sec;          /**< Lecturas completadas por segundo. */
+    double writes_per_sec;         /**< Escrituras completadas por segundo. */
+    double utilization;            /**< Porcentaje del intervalo con operaciones en curso (io_ticks). */
+    double queue_depth;            /**< Cantidad promedio de operaciones en curso. */
+    double await_ms;               /**< Tiempo promedio por operación completada, en milisegundos. */
+    unsigned int labels;           /**< Conjunto de etiquetas del exportador (0: sin resolver). */
+} disk_device_t;
+
+/**
+ * @brief Tabla hash de dispositivos con direccionamiento abierto, indexada por major:minor.
+ */
+typedef struct
+{
+    disk_device_t* slots;          /**< Entradas de la tabla. */
+    size_t capacity;               /**< Cantidad de entradas (potencia de 2). */
+    size_t used;                   /**< Entradas usadas o borradas (ocupan lugar en el sondeo). */
+    size_t live;                   /**< Dispositivos presentes. */
+    unsigned long long generation; /**< Número del ciclo actual. */
+    regex_t include;               /**< Expresión de dispositivos a incluir. */
+    regex_t exclude;               /**< Expresión de dispositivos a excluir. */
+    int has_include;               /**< 1 si hay expresión de inclusión. */
+    int has_exclude;               /**< 1 si hay expresión de exclusión. */
+} disk_table_t;
+
+/**
+ * @brief Inicializa la tabla de dispositivos y sus filtros.
+ *
+ * @param table Tabla a inicializar.
+ * @param include Expresión regular extendida de dispositivos a incluir, o NULL para incluir todos.
+ * @param exclude Expresión regular extendida de dispositivos a excluir, o NULL para no excluir ninguno.
+ * @return 0 si se inicializó correctamente, -1 si alguna expresión es inválida o falta memoria.
+ */
+int disk_table_init(disk_table_t* table, const char* include, const char* exclude);
+
+/**
+ * @brief Libera la tabla de dispositivos y sus filtros.
+ *
+ * @param table Tabla a liberar.
+ */
+void disk_table_destroy(disk_table_t* table);
+
+/**
+ * @brief Analiza /proc/diskstats actualizando los contadores de cada dispositivo.
+ *
+ * Los dispositivos nuevos se agregan a la tabla (evaluando los filtros sólo esa vez) y los que ya no aparecen se
+ * marcan como borrados.
+ *
+ * @param table Tabla de dispositivos.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @return Cantidad de dispositivos presentes.
+ */
+size_t parse_disk_devices(disk_table_t* table, const char* buf, size_t len);
+
+/**
+ * @brief Calcula las tasas de cada dispositivo a partir de la lectura actual y la anterior.
+ *
+ * También acumula la diferencia entre ambas lecturas en los contadores totales de cada dispositivo (counter_delta()).
+ *
+ * @param table Tabla de dispositivos.
+ * @param elapsed Segundos transcurridos entre ambas lecturas.
+ */
+void compute_disk_rates(disk_table_t* table, double elapsed);
+
+#endif // DISK_STATS_H
@@ -3,15 +3,22 @@
  * @brief Programa para leer el uso de CPU y memoria y exponerlos como métricas de Prometheus.
  */
 
+#include "../include/collector.h"
+#include "../include/histogram.h"
+#include "../include/history.h"
 #include "../include/metrics.h"
+#include "../include/metrics_snapshot.h"
+#include "../include/push.h"
+#include "../include/series.h"
+#include "../include/text_buf.h"
+#include "../include/window_stats.h"
 #include "metrics.h"
 #include <errno.h>
-#include <prom.h>
-#include <promhttp.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h> // Para sleep
 
 /**
@@ -20,48 +27,200 @@
 #define BUFFER_SIZE 256
 
 /**
- * @brief Actualiza la métrica de uso de CPU.
+ * @brief Actualiza las métricas derivadas de /proc/stat (CPU, procesos, cambios de contexto, etc.).
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
  */
-void update_cpu_gauge();
+int update_proc_stat_gauges(arena_t* scratch);
 
 /**
- * @brief Actualiza la métrica de uso de memoria.
+ * @brief Actualiza las métricas de memoria: uso, desglose de /proc/meminfo y tasas de /proc/vmstat.
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
  */
-void update_memory_gauge();
+int update_memory_gauge(arena_t* scratch);
 
 /**
- * @brief Actualiza la métrica de uso de I/O del disco.
+ * @brief Actualiza las métricas de I/O de cada disco.
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
  */
-void update_disk_io_gauge();
+int update_disk_io_gauge(arena_t* scratch);
 
 /**
- * @brief Actualiza la métrica de uso de I/O del disco.
+ * @brief Actualiza las métricas de tráfico de cada interfaz de red.
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
  */
-void update_red_gauge();
+int update_red_gauge(arena_t* scratch);
 
 /**
- * @brief Actualiza la métrica de cantidad de procesos en ejecución.
+ * @brief Actualiza las métricas de promedio de carga (/proc/loadavg) y de presión (/proc/pressure).
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
  */
-void update_proc_number();
+int update_pressure_gauges(arena_t* scratch);
 
 /**
- * @brief Actualiza la métrica de cambios de contexto.
+ * @brief Habilita los disparadores de PSI, que fuerzan una recolección fuera de ciclo ante una demora.
+ *
+ * Cuando un disparador se activa se envía la señal indicada al hilo recolector, que debe interrumpir la espera del
+ * muestreador y recolectar y publicar en ese momento.
+ *
+ * @param stall_ms Demora acumulada, dentro de la ventana, que activa un disparador.
+ * @param window_ms Ventana de evaluación en milisegundos.
+ * @param target Hilo recolector.
+ * @param signo Señal con la que se avisa al hilo recolector.
+ * @return 0 si se registró al menos un disparador, -1 en caso contrario.
  */
-void update_context_switches();
+int enable_pressure_triggers(unsigned int stall_ms, unsigned int window_ms, pthread_t target, int signo);
 
 /**
- * @brief Función del hilo para exponer las métricas vía HTTP en el puerto 8000.
- * @param arg Argumento no utilizado.
- * @return NULL
+ * @brief Detiene los disparadores de PSI, si están habilitados.
  */
-void* expose_metrics(void* arg);
+void disable_pressure_triggers();
 
 /**
- * @brief Inicializar mutex y métricas.
+ * @brief Configura el colector de procesos, que exporta los N procesos que más CPU, memoria e I/O consumen.
+ *
+ * El colector ("process") se habilita aparte, en el registro de colectores.
+ *
+ * @param top Cantidad de procesos a exportar por recurso (hasta PROCESS_TOP_MAX).
  */
-void init_metrics();
+void configure_process_metrics(size_t top);
+
+/**
+ * @brief Actualiza la exposición de los procesos que más consumen (si el colector está habilitado).
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
+ */
+int update_process_gauges(arena_t* scratch);
+
+/**
+ * @brief Configura el colector de cgroups, que exporta CPU, memoria, I/O y presión de cada cgroup v2.
+ *
+ * El colector ("cgroup") se habilita aparte, en el registro de colectores; la jerarquía se recorre al iniciarlo.
+ *
+ * @param root Punto de montaje de cgroup v2 (por defecto CGROUP_DEFAULT_ROOT).
+ * @param max_depth Profundidad máxima de los cgroups exportados (0: sin límite).
+ */
+void configure_cgroup_metrics(const char* root, unsigned int max_depth);
+
+/**
+ * @brief Actualiza la exposición de las métricas por cgroup (si el colector está habilitado).
+ *
+ * @param scratch Memoria temporal de la ejecución (se reinicia al terminar).
+ * @return 0 si se actualizaron, -1 si hubo un error (se cuenta en exporter_collector_errors_total).
+ */
+int update_cgroup_gauges(arena_t* scratch);
+
+/**
+ * @brief Habilita o deshabilita las tasas por segundo de los contadores; debe llamarse antes de init_metrics().
+ *
+ * Los contadores de cambios de contexto, interrupciones, softirqs, procesos creados, disco y red se exportan siempre
+ * como NOMBRE_total, enteros de 64 bits con las vueltas y los reinicios del kernel compensados. Habilitadas (por
+ * defecto), también se exportan sus tasas NOMBRE_per_second, calculadas por el exportador sobre el último intervalo.
+ *
+ * @param enabled 1 para exportar las tasas, 0 para exportar sólo los contadores.
+ */
+void configure_rate_metrics(int enabled);
+
+/**
+ * @brief Configura las ventanas deslizantes de las series muestreadas; debe llamarse antes de init_metrics().
+ *
+ * Por cada serie (uso de CPU y memoria, procesos y fallos de página) se exportan NOMBRE_min_window,
+ * NOMBRE_max_window, NOMBRE_avg_window y NOMBRE_quantile_window{quantile="0.5|0.95|0.99"} sobre la ventana.
+ *
+ * @param ms Duración de la ventana en milisegundos (0: deshabilitadas; por defecto WINDOW_STATS_DEFAULT_MS).
+ */
+void configure_window_metrics(unsigned long ms);
+
+/**
+ * @brief Configura la cardinalidad de las métricas etiquetadas por núcleo, disco e interfaz; debe llamarse antes de
+ * init_metrics().
+ *
+ * @param limit Series admitidas por métrica (por defecto SERIES_DEFAULT_LIMIT).
+ * @param max_idle Ciclos sin actualizarse tras los cuales se quita una serie (por defecto SERIES_DEFAULT_MAX_IDLE).
+ */
+void configure_series_limits(size_t limit, unsigned long max_idle);
+
+/**
+ * @brief Habilita el historial de muestras de alta resolución y su consulta en /history.
+ *
+ * Cada muestra del uso de CPU y memoria, los procesos y los fallos de página se agrega al archivo de historial, que
+ * se consulta con /history?metric=NOMBRE&since=S&until=S (segundos desde la época Unix, opcionales).
+ *
+ * @param path Ruta del archivo de historial.
+ * @param size_mb Tamaño del archivo en MiB.
+ * @return 0 si se habilitó, -1 en caso de error.
+ */
+int enable_history(const char* path, unsigned long size_mb);
 
 /**
- * @brief Destructor de mutex
+ * @brief Cierra el historial; debe llamarse con el servidor HTTP y los colectores detenidos.
  */
-void destroy_mutex();
+void disable_history(void);
+
+/**
+ * @brief Habilita el envío de cada publicación a un receptor remoto (remote-write o line protocol por UDP).
+ *
+ * Las muestras se encolan al publicar y un hilo aparte las envía en lotes; el estado del envío se exporta en
+ * exporter_push_samples_total, exporter_push_retries_total y exporter_push_queue_samples.
+ *
+ * @param config Configuración del envío, con el destino ya interpretado (push_parse_url()).
+ * @return 0 si se habilitó, -1 en caso de error.
+ */
+int enable_push(const push_config_t* config);
+
+/**
+ * @brief Envía lo que quede en la cola y detiene el envío; debe llamarse después de la última publicación.
+ */
+void disable_push(void);
+
+/**
+ * @brief Renderiza las métricas actualizadas en el ciclo y las publica para el servidor HTTP.
+ *
+ * La exposición se escribe directamente en el texto de la próxima instantánea (metrics_snapshot_begin()), sin
+ * reservar memoria una vez que los buffers alcanzaron su tamaño. Debe llamarse desde el hilo recolector al terminar
+ * cada ciclo de actualización.
+ *
+ * @param collectors Registro de colectores, del que se exportan los plazos vencidos y los colectores desactualizados.
+ */
+void publish_metrics(const collector_registry_t* collectors);
+
+/**
+ * @brief Cuenta un scrape de /metrics respondido; lo llama el servidor HTTP desde sus hilos.
+ *
+ * @param repeated 1 si la exposición ya se había enviado antes (incluye los 304 Not Modified).
+ * @param body_len Bytes del cuerpo enviado (comprimido si se envió con gzip).
+ */
+void observe_scrape(int repeated, size_t body_len);
+
+/**
+ * @brief Obtiene el historial de muestras que se consulta en /history.
+ *
+ * @return Historial, o NULL si no se habilitó con enable_history().
+ */
+history_t* get_history(void);
+
+/**
+ * @brief Registra los colectores incluidos (cpu, memory, disk, net, pressure, process y cgroup).
+ *
+ * Cada colector renderiza su propia sección de la exposición y la libera al detenerse, por lo que los deshabilitados no
+ * se exponen.
+ *
+ * @param registry Registro de colectores inicializado con collector_registry_init().
+ * @return 0 si se registraron todos, -1 en caso contrario.
+ */
+int register_collectors(collector_registry_t* registry);
+
+/**
+ * @brief Inicializar métricas.
+ */
+void init_metrics();
@@ -0,0 +1,65 @@
+/**
+ * @file histogram.h
+ * @brief Histograma de buckets fijos para instrumentar al propio exportador.
+ *
+ * Cada observación incrementa un bucket y la suma con operaciones atómicas, sin mutex: se puede observar desde los
+ * hilos de los colectores y del servidor HTTP mientras el hilo recolector renderiza. Los valores son enteros en la
+ * unidad base (nanosegundos, bytes) y se escalan sólo al renderizar.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "text_buf.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * @brief Cantidad máxima de buckets de un histograma, sin contar +Inf.
+ */
+#define HISTOGRAM_MAX_BUCKETS 16
+
+/**
+ * @brief Histograma con límites superiores fijos.
+ */
+typedef struct
+{
+    const unsigned long long* bounds;                 /**< Límites superiores, crecientes, en la unidad base. */
+    size_t count;                                     /**< Cantidad de límites (a lo sumo HISTOGRAM_MAX_BUCKETS). */
+    double scale;                                     /**< Factor para pasar a la unidad exportada (1e-9 para s). */
+    atomic_ullong buckets[HISTOGRAM_MAX_BUCKETS + 1]; /**< Observaciones por bucket, sin acumular (+Inf al final). */
+    atomic_ullong sum;                                /**< Suma de las observaciones en la unidad base. */
+} histogram_t;
+
+/**
+ * @brief Inicializa un histograma vacío.
+ *
+ * @param hist Histograma.
+ * @param bounds Límites superiores crecientes en la unidad base (no se copian; deben seguir vivos).
+ * @param count Cantidad de límites; se recorta a HISTOGRAM_MAX_BUCKETS.
+ * @param scale Factor para pasar de la unidad base a la exportada.
+ */
+void histogram_init(histogram_t* hist, const unsigned long long* bounds, size_t count, double scale);
+
+/**
+ * @brief Registra una observación.
+ *
+ * @param hist Histograma inicializado.
+ * @param value Valor en la unidad base.
+ */
+void histogram_observe(histogram_t* hist, unsigned long long value);
+
+/**
+ * @brief Agrega las muestras _bucket, _sum y _count del histograma a una exposición.
+ *
+ * Las líneas HELP y TYPE las escribe quien llama, una vez por familia.
+ *
+ * @param hist Histograma inicializado.
+ * @param out Exposición.
+ * @param name Nombre de la familia.
+ * @param labels Etiquetas ya formateadas ("clave=\"valor\"", separadas por comas) o "".
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int histogram_render(const histogram_t* hist, text_buf_t* out, const char* name, const char* labels);
+
+#endif // HISTOGRAM_H
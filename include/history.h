@@ -0,0 +1,209 @@
+/**
+ * @file history.h
+ * @brief Historial local de muestras de alta resolución en un archivo circular mapeado en memoria.
+ *
+ * Prometheus sólo ve el valor de cada métrica en el instante del scrape; lo que el exportador muestrea entre scrapes
+ * se pierde. El historial guarda cada muestra de un conjunto fijo de series en un archivo de tamaño fijo, mapeado con
+ * mmap(), para poder consultar rangos después de un incidente sin agregar carga a Prometheus.
+ *
+ * El archivo se divide en bloques de HISTORY_BLOCK_SIZE bytes que se usan en forma circular: cuando se llena el
+ * último se vuelve a escribir sobre el más viejo. Cada bloque pertenece a una serie y guarda sus muestras comprimidas
+ * como en Gorilla (Facebook, VLDB 2015):
+ *  - el instante de cada muestra se codifica como la diferencia entre deltas consecutivos (delta-of-delta), que con
+ *    un período fijo casi siempre es 0 y ocupa un bit;
+ *  - cada valor se codifica como el XOR con el anterior, guardando sólo los bits significativos; un valor repetido
+ *    ocupa un bit.
+ *
+ * Las escrituras (desde los hilos de los colectores) y las copias de bloques que hacen los lectores (desde los hilos
+ * del servidor HTTP) se serializan con un mutex; la decodificación se hace fuera de él, sobre la copia.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Tamaño de cada bloque del archivo, en bytes (el primero guarda el encabezado).
+ */
+#define HISTORY_BLOCK_SIZE 4096
+
+/**
+ * @brief Cantidad máxima de series del historial.
+ */
+#define HISTORY_MAX_SERIES 32
+
+/**
+ * @brief Longitud máxima del nombre de una serie, incluyendo el '\0'.
+ */
+#define HISTORY_NAME_SIZE 64
+
+/**
+ * @brief Tamaño por defecto del archivo de historial, en MiB.
+ */
+#define HISTORY_DEFAULT_SIZE_MB 16
+
+/**
+ * @brief Encabezado de un bloque, al comienzo de cada bloque del archivo.
+ */
+typedef struct
+{
+    uint32_t series;      /**< Serie a la que pertenece, o HISTORY_FREE si el bloque está libre. */
+    uint32_t count;       /**< Muestras guardadas. */
+    int64_t start_ms;     /**< Instante de la primera muestra (ms desde la época Unix). */
+    int64_t end_ms;       /**< Instante de la última muestra. */
+    uint64_t first_value; /**< Bits del primer valor (double). */
+    uint32_t bits;        /**< Bits usados del área de datos. */
+    uint32_t reserved;    /**< Sin uso (alineación). */
+} history_block_t;
+
+/**
+ * @brief Valor de history_block_t.series de un bloque libre.
+ */
+#define HISTORY_FREE UINT32_MAX
+
+/**
+ * @brief Bits de datos de un bloque.
+ */
+#define HISTORY_PAYLOAD_BITS ((HISTORY_BLOCK_SIZE - sizeof(history_block_t)) * 8)
+
+/**
+ * @brief Identificador del formato, al comienzo del archivo.
+ */
+#define HISTORY_MAGIC "PMHIST01"
+
+/**
+ * @brief Encabezado del archivo, en su primer bloque.
+ */
+typedef struct
+{
+    char magic[8];                                     /**< HISTORY_MAGIC. */
+    uint32_t block_size;                               /**< HISTORY_BLOCK_SIZE al crear el archivo. */
+    uint32_t block_count;                              /**< Bloques de datos. */
+    uint32_t next_block;                               /**< Próximo bloque a usar (el más viejo del anillo). */
+    uint32_t series_count;                             /**< Series registradas. */
+    char names[HISTORY_MAX_SERIES][HISTORY_NAME_SIZE]; /**< Nombre de cada serie. */
+} history_header_t;
+
+/**
+ * @brief Estado del codificador de una serie, en memoria.
+ */
+typedef struct
+{
+    int64_t block;         /**< Bloque abierto de la serie, o -1 si no tiene. */
+    int64_t prev_ms;       /**< Instante de la última muestra. */
+    int64_t prev_delta;    /**< Delta entre las dos últimas muestras. */
+    uint64_t prev_value;   /**< Bits del último valor. */
+    unsigned int leading;  /**< Ceros a la izquierda del último XOR guardado con ventana nueva. */
+    unsigned int trailing; /**< Ceros a la derecha del último XOR guardado con ventana nueva. */
+} history_encoder_t;
+
+/**
+ * @brief Historial abierto.
+ */
+typedef struct
+{
+    unsigned char* map;                             /**< Archivo mapeado, o NULL si no está abierto. */
+    size_t size;                                    /**< Tamaño del mapeo en bytes. */
+    history_header_t* header;                       /**< Encabezado del archivo (primer bloque). */
+    history_encoder_t encoders[HISTORY_MAX_SERIES]; /**< Codificador de cada serie. */
+    pthread_mutex_t lock;                           /**< Serializa escrituras y copias de bloques. */
+} history_t;
+
+/**
+ * @brief Abre o crea el archivo de historial.
+ *
+ * Si el archivo ya existe con el mismo tamaño y las mismas series se conserva su contenido (el historial sobrevive
+ * a un reinicio); si no, se inicializa vacío.
+ *
+ * @param history Historial a abrir.
+ * @param path Ruta del archivo.
+ * @param size_mb Tamaño del archivo en MiB.
+ * @param names Nombres de las series, en el orden de sus identificadores.
+ * @param count Cantidad de series (a lo sumo HISTORY_MAX_SERIES).
+ * @return 0 si se abrió, -1 en caso de error.
+ */
+int history_open(history_t* history, const char* path, unsigned long size_mb, const char* const* names, size_t count);
+
+/**
+ * @brief Agrega una muestra de una serie con el instante actual.
+ *
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param value Valor de la muestra.
+ */
+void history_append(history_t* history, size_t series, double value);
+
+/**
+ * @brief Agrega una muestra de una serie con un instante dado.
+ *
+ * Las muestras de una serie deben agregarse en orden de tiempo.
+ *
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param ms Instante de la muestra (ms desde la época Unix).
+ * @param value Valor de la muestra.
+ */
+void history_append_at(history_t* history, size_t series, int64_t ms, double value);
+
+/**
+ * @brief Busca una serie por nombre.
+ *
+ * @param history Historial abierto.
+ * @param name Nombre de la serie.
+ * @return Identificador de la serie, o -1 si no existe.
+ */
+int history_find(const history_t* history, const char* name);
+
+/**
+ * @brief Cierra el historial, asegurando que su contenido quede escrito en el archivo.
+ *
+ * @param history Historial.
+ */
+void history_close(history_t* history);
+
+/**
+ * @brief Recorrido de las muestras de una serie dentro de un rango de tiempo.
+ *
+ * Recorre los bloques del más viejo al más nuevo; cada bloque de la serie se copia bajo el mutex y se decodifica
+ * fuera de él, por lo que la memoria usada no depende del tamaño del rango.
+ */
+typedef struct
+{
+    history_t* history;                      /**< Historial. */
+    uint32_t series;                         /**< Serie buscada. */
+    int64_t since_ms;                        /**< Comienzo del rango (inclusive). */
+    int64_t until_ms;                        /**< Fin del rango (inclusive). */
+    uint32_t next_block;                     /**< Próximo bloque a revisar, en el orden del anillo. */
+    uint32_t visited;                        /**< Bloques revisados. */
+    unsigned char block[HISTORY_BLOCK_SIZE]; /**< Copia del bloque que se está decodificando. */
+    uint32_t remaining;                      /**< Muestras del bloque copiado que faltan decodificar. */
+    uint32_t bit;                            /**< Posición de lectura en el área de datos de la copia. */
+    history_encoder_t state;                 /**< Estado del decodificador (mismos campos que el codificador). */
+} history_reader_t;
+
+/**
+ * @brief Prepara un recorrido.
+ *
+ * @param reader Recorrido a preparar.
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param since_ms Comienzo del rango (ms desde la época Unix, inclusive).
+ * @param until_ms Fin del rango (inclusive).
+ */
+void history_reader_init(history_reader_t* reader, history_t* history, size_t series, int64_t since_ms,
+                         int64_t until_ms);
+
+/**
+ * @brief Obtiene la próxima muestra del rango.
+ *
+ * @param reader Recorrido preparado.
+ * @param ms Instante de la muestra.
+ * @param value Valor de la muestra.
+ * @return 1 si hay una muestra, 0 si el recorrido terminó.
+ */
+int history_reader_next(history_reader_t* reader, int64_t* ms, double* value);
+
+#endif // HISTORY_H
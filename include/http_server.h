@@ -0,0 +1,86 @@
+/**
+ * @file http_server.h
+ * @brief Servidor HTTP (libmicrohttpd) que responde /metrics con la última instantánea publicada y /history con el
+ * historial de muestras.
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <microhttpd.h>
+
+/**
+ * @brief Modo de atención de conexiones del servidor HTTP.
+ */
+typedef enum
+{
+    HTTP_MODE_SELECT, /**< select() en hilos internos (limitado a FD_SETSIZE descriptores). */
+    HTTP_MODE_POLL,   /**< poll() en hilos internos. */
+    HTTP_MODE_EPOLL,  /**< epoll en hilos internos (sólo Linux). */
+    HTTP_MODE_AUTO,   /**< El mejor mecanismo disponible según libmicrohttpd. */
+} http_mode_t;
+
+/**
+ * @brief Dirección de escucha por defecto del servidor HTTP.
+ */
+#define HTTP_DEFAULT_ADDRESS "0.0.0.0"
+
+/**
+ * @brief Puerto por defecto del servidor HTTP.
+ */
+#define HTTP_DEFAULT_PORT 8000
+
+/**
+ * @brief Cantidad de hilos por defecto del servidor HTTP.
+ */
+#define HTTP_DEFAULT_THREADS 2
+
+/**
+ * @brief Cantidad máxima de conexiones simultáneas por defecto.
+ */
+#define HTTP_DEFAULT_CONNECTION_LIMIT 256
+
+/**
+ * @brief Segundos de inactividad por defecto tras los cuales se cierra una conexión.
+ */
+#define HTTP_DEFAULT_CONNECTION_TIMEOUT 10
+
+/**
+ * @brief Configuración del servidor HTTP.
+ */
+typedef struct
+{
+    const char* address;             /**< Dirección IPv4 o IPv6 de escucha. */
+    unsigned short port;             /**< Puerto de escucha. */
+    http_mode_t mode;                /**< Modo de atención de conexiones. */
+    unsigned int threads;            /**< Hilos que atienden conexiones (1 = un único hilo interno). */
+    unsigned int connection_limit;   /**< Conexiones simultáneas admitidas. */
+    unsigned int connection_timeout; /**< Segundos de inactividad antes de cerrar una conexión (0 = sin límite). */
+} http_config_t;
+
+/**
+ * @brief Completa la configuración del servidor HTTP con los valores por defecto.
+ * @param config Configuración a completar.
+ */
+void http_config_default(http_config_t* config);
+
+/**
+ * @brief Interpreta el nombre de un modo del servidor HTTP.
+ * @param name Nombre del modo ("select", "poll", "epoll" o "auto").
+ * @param mode Modo resultante.
+ * @return 0 si el nombre es válido, -1 en caso contrario.
+ */
+int parse_http_mode(const char* name, http_mode_t* mode);
+
+/**
+ * @brief Inicia el servidor HTTP que expone las métricas.
+ *
+ * libmicrohttpd atiende las conexiones en sus propios hilos; las respuestas se arman a partir de la última
+ * instantánea publicada por publish_metrics().
+ *
+ * @param config Configuración del servidor.
+ * @return Servidor iniciado, que debe detenerse con MHD_stop_daemon(), o NULL en caso de error.
+ */
+struct MHD_Daemon* expose_metrics(const http_config_t* config);
+
+#endif // HTTP_SERVER_H
@@ -3,6 +3,14 @@
  * @brief Funciones para obtener el uso de CPU y memoria desde el sistema de archivos /proc.
  */
 
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "cgroup_stats.h"
+#include "disk_stats.h"
+#include "net_stats.h"
+#include "pressure_stats.h"
+#include "process_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +21,108 @@
  */
 #define BUFFER_SIZE 256
 
+/**
+ * @brief Raíz de procfs por defecto.
+ */
+#define PROCFS_DEFAULT_ROOT "/proc"
+
+/**
+ * @brief Cambia la raíz de procfs de la que se leen las métricas del sistema.
+ *
+ * Permite reproducir un árbol capturado de otro host (stat, meminfo, vmstat, diskstats, net/dev, loadavg,
+ * pressure/ y los directorios de los procesos) en lugar del kernel en vivo. Debe llamarse antes de
+ * init_proc_files() e init_process_stats(). El consumo del propio exportador y los disparadores de PSI siempre usan
+ * el /proc real.
+ *
+ * @param root Directorio raíz (no se copia; debe seguir vivo).
+ */
+void set_procfs_root(const char* root);
+
+/**
+ * @brief Abre de forma persistente los archivos de /proc que se leen en cada ciclo.
+ *
+ * Los archivos (/proc/stat, /proc/meminfo, /proc/vmstat, /proc/diskstats, /proc/net/dev, /proc/loadavg,
+ * /proc/self/statm y, si existen, los de /proc/pressure) se abren una sola vez y luego se vuelven a leer con pread()
+ * desde el offset 0, evitando un fopen()/fclose() por métrica y por ciclo.
+ *
+ * @return 0 si todos se abrieron correctamente, -1 si alguno falló.
+ */
+int init_proc_files();
+
+/**
+ * @brief Cierra los archivos de /proc abiertos por init_proc_files() y libera el estado asociado.
+ */
+void close_proc_files();
+
+/**
+ * @brief Instantánea de /proc/meminfo.
+ *
+ * Los valores están en kB, como en el archivo, salvo las cantidades de páginas enormes. Los campos que el kernel no
+ * informa (por ejemplo, sin soporte de páginas enormes) quedan en 0.
+ */
+typedef struct
+{
+    unsigned long long mem_total;       /**< Memoria total utilizable. */
+    unsigned long long mem_free;        /**< Memoria sin usar. */
+    unsigned long long mem_available;   /**< Memoria disponible estimada para nuevas aplicaciones, sin usar swap. */
+    unsigned long long buffers;         /**< Buffers de dispositivos de bloque. */
+    unsigned long long cached;          /**< Caché de páginas de archivos (sin swap_cached). */
+    unsigned long long swap_cached;     /**< Páginas en swap que también están en memoria. */
+    unsigned long long active;          /**< Memoria usada recientemente. */
+    unsigned long long inactive;        /**< Memoria candidata a recuperarse. */
+    unsigned long long dirty;           /**< Memoria modificada pendiente de escribirse a disco. */
+    unsigned long long writeback;       /**< Memoria escribiéndose a disco en este momento. */
+    unsigned long long anon_pages;      /**< Páginas anónimas mapeadas en espacio de usuario. */
+    unsigned long long mapped;          /**< Archivos mapeados con mmap(). */
+    unsigned long long shmem;           /**< Memoria compartida y tmpfs. */
+    unsigned long long slab;            /**< Estructuras slab del kernel. */
+    unsigned long long sreclaimable;    /**< Parte de slab que puede recuperarse. */
+    unsigned long long sunreclaim;      /**< Parte de slab que no puede recuperarse. */
+    unsigned long long kernel_stack;    /**< Pilas del kernel. */
+    unsigned long long page_tables;     /**< Tablas de páginas. */
+    unsigned long long swap_total;      /**< Swap total. */
+    unsigned long long swap_free;       /**< Swap sin usar. */
+    unsigned long long commit_limit;    /**< Límite de memoria comprometida (con overcommit estricto). */
+    unsigned long long committed_as;    /**< Memoria comprometida por todos los procesos. */
+    unsigned long long anon_hugepages;  /**< Páginas anónimas respaldadas por páginas enormes transparentes. */
+    unsigned long long hugepages_total; /**< Páginas enormes reservadas (cantidad). */
+    unsigned long long hugepages_free;  /**< Páginas enormes sin asignar (cantidad). */
+    unsigned long long hugepages_rsvd;  /**< Páginas enormes comprometidas pero no asignadas (cantidad). */
+    unsigned long long hugepages_surp;  /**< Páginas enormes excedentes sobre el total (cantidad). */
+    unsigned long long hugepagesize;    /**< Tamaño de una página enorme. */
+} meminfo_snapshot_t;
+
+/**
+ * @brief Analiza el contenido de /proc/meminfo.
+ *
+ * Las funciones parse_* sólo interpretan un buffer ya leído, por lo que también pueden usarse sobre archivos
+ * capturados (por ejemplo, en el benchmark).
+ *
+ * El archivo se recorre una sola vez: la clave de cada línea se busca en una tabla ordenada que indica en qué campo de
+ * la instantánea se guarda el valor.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si se encontraron MemTotal y MemAvailable, -1 en caso contrario.
+ */
+int parse_meminfo(const char* buf, size_t len, meminfo_snapshot_t* snapshot);
+
+/**
+ * @brief Lee /proc/meminfo sobre el descriptor persistente.
+ *
+ * @return Instantánea de /proc/meminfo, o NULL en caso de error.
+ */
+const meminfo_snapshot_t* get_meminfo();
+
+/**
+ * @brief Calcula el porcentaje de uso de memoria a partir de una instantánea de /proc/meminfo.
+ *
+ * @param meminfo Instantánea de /proc/meminfo.
+ * @return Uso de memoria (total menos disponible) como porcentaje (0.0 a 100.0).
+ */
+double compute_memory_usage(const meminfo_snapshot_t* meminfo);
+
 /**
  * @brief Obtiene el porcentaje de uso de memoria desde /proc/meminfo.
  *
@@ -24,45 +134,350 @@
 double get_memory_usage();
 
 /**
- * @brief Obtiene el porcentaje de uso de CPU desde /proc/stat.
+ * @brief Contadores de /proc/vmstat que se exportan como tasas.
+ */
+typedef struct
+{
+    unsigned long long pgfault;    /**< Fallos de página desde el arranque. */
+    unsigned long long pgmajfault; /**< Fallos de página mayores (con lectura de disco) desde el arranque. */
+    unsigned long long pswpin;     /**< Páginas leídas desde swap desde el arranque. */
+    unsigned long long pswpout;    /**< Páginas escritas a swap desde el arranque. */
+    unsigned long long oom_kill;   /**< Procesos terminados por falta de memoria (kernel 4.13 o posterior). */
+} vmstat_snapshot_t;
+
+/**
+ * @brief Tasas por segundo calculadas a partir de dos lecturas de /proc/vmstat.
+ */
+typedef struct
+{
+    int valid;         /**< 1 si las tasas corresponden a dos lecturas comparables. */
+    double pgfault;    /**< Fallos de página por segundo. */
+    double pgmajfault; /**< Fallos de página mayores por segundo. */
+    double pswpin;     /**< Páginas leídas desde swap por segundo. */
+    double pswpout;    /**< Páginas escritas a swap por segundo. */
+    double oom_kill;   /**< Procesos terminados por falta de memoria por segundo. */
+} vmstat_rates_t;
+
+/**
+ * @brief Analiza el contenido de /proc/vmstat.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si se encontró pgfault, -1 en caso contrario.
+ */
+int parse_vmstat(const char* buf, size_t len, vmstat_snapshot_t* snapshot);
+
+/**
+ * @brief Obtiene las tasas de fallos de página, swap y OOM kills desde /proc/vmstat.
+ *
+ * Divide la diferencia con la lectura anterior por el tiempo transcurrido entre ambas; en la primera lectura el campo
+ * valid queda en 0.
+ *
+ * @return Tasas por segundo, o NULL en caso de error.
+ */
+const vmstat_rates_t* get_vmstat_rates();
+
+/**
+ * @brief Instantánea de los contadores de /proc/stat.
+ *
+ * Se completa con una única lectura de /proc/stat por ciclo y de ella se derivan todas las métricas que dependen de
+ * ese archivo (CPU, procesos, cambios de contexto, interrupciones, etc.).
+ */
+typedef struct
+{
+    unsigned long long user;          /**< Tiempo en modo usuario (jiffies). */
+    unsigned long long nice;          /**< Tiempo en modo usuario con prioridad modificada (jiffies). */
+    unsigned long long system;        /**< Tiempo en modo kernel (jiffies). */
+    unsigned long long idle;          /**< Tiempo inactivo (jiffies). */
+    unsigned long long iowait;        /**< Tiempo esperando I/O (jiffies). */
+    unsigned long long irq;           /**< Tiempo atendiendo interrupciones (jiffies). */
+    unsigned long long softirq;       /**< Tiempo atendiendo softirqs (jiffies). */
+    unsigned long long steal;         /**< Tiempo robado por el hipervisor (jiffies). */
+    unsigned long long intr;          /**< Total de interrupciones atendidas desde el arranque. */
+    unsigned long long ctxt;          /**< Total de cambios de contexto desde el arranque. */
+    unsigned long long btime;         /**< Momento de arranque del sistema (segundos desde epoch). */
+    unsigned long long processes;     /**< Total de procesos creados desde el arranque. */
+    unsigned long long procs_running; /**< Procesos en estado ejecutable. */
+    unsigned long long procs_blocked; /**< Procesos bloqueados esperando I/O. */
+    unsigned long long softirqs;      /**< Total de softirqs atendidas desde el arranque. */
+} proc_stat_snapshot_t;
+
+/**
+ * @brief Contadores acumulados de /proc/stat y sus tasas por segundo.
+ *
+ * Los contadores se conservan como enteros de 64 bits: convertidos a double perderían precisión por encima de 2^53.
+ */
+typedef struct
+{
+    int valid;             /**< 1 si las tasas corresponden a dos lecturas comparables. */
+    counter_t ctxt;        /**< Cambios de contexto. */
+    counter_t intr;        /**< Interrupciones atendidas. */
+    counter_t softirqs;    /**< Softirqs atendidas. */
+    counter_t processes;   /**< Procesos creados. */
+    double ctxt_rate;      /**< Cambios de contexto por segundo. */
+    double intr_rate;      /**< Interrupciones por segundo. */
+    double softirqs_rate;  /**< Softirqs por segundo. */
+    double processes_rate; /**< Procesos creados por segundo. */
+} proc_stat_counters_t;
+
+
+/**
+ * @brief Modos de tiempo de CPU informados por cada línea "cpuN" de /proc/stat, en el orden del archivo.
+ */
+typedef enum
+{
+    CPU_MODE_USER,    /**< Modo usuario. */
+    CPU_MODE_NICE,    /**< Modo usuario con prioridad modificada. */
+    CPU_MODE_SYSTEM,  /**< Modo kernel. */
+    CPU_MODE_IDLE,    /**< Inactivo. */
+    CPU_MODE_IOWAIT,  /**< Esperando I/O. */
+    CPU_MODE_IRQ,     /**< Atendiendo interrupciones. */
+    CPU_MODE_SOFTIRQ, /**< Atendiendo softirqs. */
+    CPU_MODE_STEAL,   /**< Tiempo robado por el hipervisor. */
+    CPU_MODE_COUNT    /**< Cantidad de modos. */
+} cpu_mode_t;
+
+/**
+ * @brief Contadores y porcentajes de uso por núcleo.
+ *
+ * Los datos se guardan como estructura de arreglos (un arreglo por modo, indexado por núcleo), de modo que las
+ * diferencias y los porcentajes de todos los núcleos se calculan en un único bucle vectorizable por modo.
+ */
+typedef struct
+{
+    size_t count;                             /**< Cantidad de núcleos presentes en la última lectura. */
+    size_t capacity;                          /**< Capacidad reservada de los arreglos. */
+    int valid;                                /**< 1 si los porcentajes corresponden a dos lecturas comparables. */
+    int changed;                              /**< 1 si el conjunto de núcleos cambió desde la lectura anterior. */
+    unsigned int* id;                         /**< Número de cada núcleo (N en "cpuN"). */
+    unsigned long long* cur[CPU_MODE_COUNT];  /**< Contadores de la lectura actual, por modo. */
+    unsigned long long* prev[CPU_MODE_COUNT]; /**< Contadores de la lectura anterior, por modo. */
+    double* percent[CPU_MODE_COUNT];          /**< Porcentaje de cada modo en el último intervalo, por modo. */
+    double* total;                            /**< Tiempo total transcurrido por núcleo en el último intervalo. */
+} cpu_core_stats_t;
+
+/**
+ * @brief Analiza el contenido de /proc/stat y completa la instantánea.
  *
- * Lee los tiempos de CPU desde /proc/stat y calcula el porcentaje de uso de CPU
- * en un intervalo de tiempo.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @param cores Contadores por núcleo a completar con las líneas "cpuN", o NULL para ignorarlas.
+ * @return 0 si se encontró la línea agregada de CPU, -1 en caso contrario.
+ */
+int parse_proc_stat(const char* buf, size_t len, proc_stat_snapshot_t* snapshot, cpu_core_stats_t* cores);
+
+/**
+ * @brief Devuelve el nombre de un modo de CPU, usado como valor de la etiqueta "mode".
+ *
+ * @param mode Modo de CPU.
+ * @return Nombre del modo.
+ */
+const char* cpu_mode_name(cpu_mode_t mode);
+
+/**
+ * @brief Calcula los porcentajes por núcleo a partir de la lectura actual y la anterior.
  *
+ * @param cores Contadores por núcleo completados por parse_proc_stat().
+ */
+void compute_cpu_core_usage(cpu_core_stats_t* cores);
+
+/**
+ * @brief Obtiene el uso por núcleo correspondiente a la última lectura de /proc/stat.
+ *
+ * Debe llamarse luego de read_proc_stat(). Si el conjunto de núcleos cambió (por ejemplo, por hotplug), el campo
+ * valid queda en 0 durante ese ciclo.
+ *
+ * @return Contadores y porcentajes por núcleo.
+ */
+const cpu_core_stats_t* get_cpu_core_usage();
+
+/**
+ * @brief Lee /proc/stat una única vez y completa la instantánea.
+ *
+ * @param snapshot Instantánea a completar.
+ * @return 0 si la lectura fue correcta, -1 en caso de error.
+ */
+int read_proc_stat(proc_stat_snapshot_t* snapshot);
+
+/**
+ * @brief Instantánea de /proc/loadavg.
+ */
+typedef struct
+{
+    double load1;                /**< Promedio de carga del último minuto. */
+    double load5;                /**< Promedio de carga de los últimos 5 minutos. */
+    double load15;               /**< Promedio de carga de los últimos 15 minutos. */
+    unsigned long long runnable; /**< Entidades de planificación ejecutables en este momento. */
+    unsigned long long entities; /**< Entidades de planificación (procesos e hilos) existentes. */
+} loadavg_snapshot_t;
+
+/**
+ * @brief Analiza el contenido de /proc/loadavg.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si se interpretó correctamente, -1 en caso contrario.
+ */
+int parse_loadavg(const char* buf, size_t len, loadavg_snapshot_t* snapshot);
+
+/**
+ * @brief Lee /proc/loadavg sobre el descriptor persistente.
+ *
+ * @param snapshot Instantánea a completar.
+ * @return 0 si la lectura fue correcta, -1 en caso de error.
+ */
+int read_loadavg(loadavg_snapshot_t* snapshot);
+
+/**
+ * @brief Consumo del propio exportador.
+ */
+typedef struct
+{
+    double user_seconds;                /**< Tiempo de CPU en modo usuario, de todos los hilos. */
+    double system_seconds;              /**< Tiempo de CPU en modo kernel, de todos los hilos. */
+    unsigned long long resident_bytes;  /**< Memoria residente. */
+    unsigned long long virtual_bytes;   /**< Memoria virtual reservada. */
+    unsigned long long open_fds;        /**< Descriptores de archivo abiertos. */
+    unsigned long long voluntary_csw;   /**< Cambios de contexto voluntarios (esperas de I/O, locks, sleeps). */
+    unsigned long long involuntary_csw; /**< Cambios de contexto forzados por el planificador. */
+} self_stats_t;
+
+/**
+ * @brief Obtiene el consumo del propio exportador (getrusage(), /proc/self/statm y /proc/self/fd).
+ *
+ * @param stats Consumo a completar.
+ * @return 0 si la lectura fue correcta, -1 en caso de error.
+ */
+int read_self_stats(self_stats_t* stats);
+
+/**
+ * @brief Obtiene la información de presión (PSI) del sistema para un recurso, desde /proc/pressure.
+ *
+ * @param resource Recurso.
+ * @return Promedios y total de las líneas "some" y "full", o NULL si el kernel no tiene PSI o no se pudo leer.
+ */
+const pressure_sample_t* get_pressure_stats(pressure_resource_t resource);
+
+/**
+ * @brief Obtiene el porcentaje de uso de CPU a partir de una instantánea de /proc/stat.
+ *
+ * Calcula el porcentaje de uso de CPU en el intervalo transcurrido desde la instantánea anterior.
+ *
+ * @param snapshot Instantánea actual de /proc/stat.
  * @return Uso de CPU como porcentaje (0.0 a 100.0), o -1.0 en caso de error.
  */
-double get_cpu_usage();
+double get_cpu_usage(const proc_stat_snapshot_t* snapshot);
 
 /**
- * @brief Obtiene el porcentaje de uso de I/O del disco desde /proc/diskstats.
+ * @brief Configura los filtros de dispositivos de bloque.
  *
- * Lee los porcentajes de uso del disco  desde /proc/diskstats y calcula el porcentaje de uso del disco.
+ * Por defecto se excluyen particiones y dispositivos virtuales (DISK_DEFAULT_EXCLUDE) para no contar dos veces el mismo
+ * tráfico. Reinicia la tabla de dispositivos.
  *
- * @return Uso de disco como porcentaje (0.0 a 100.0), o -1.0 en caso de error.
+ * @param include Expresión regular extendida de dispositivos a incluir, o NULL para incluir todos.
+ * @param exclude Expresión regular extendida de dispositivos a excluir, o NULL para no excluir ninguno.
+ * @return 0 si los filtros son válidos, -1 en caso contrario.
  */
-double get_IO_disco();
+int init_disk_stats(const char* include, const char* exclude);
 
 /**
- * @brief Obtiene el porcentaje de uso de la red desde /proc/net/dev.
+ * @brief Obtiene las estadísticas por dispositivo desde /proc/diskstats.
  *
- * Lee los bytes transmitidos y recibidos y calcula el porcentaje de uso de la red.
+ * Calcula, para cada dispositivo no filtrado, bytes por segundo, operaciones por segundo, utilización (io_ticks),
+ * profundidad promedio de cola y tiempo promedio por operación, dividiendo por el tiempo transcurrido entre lecturas.
  *
- * @return Uso de red como porcentaje (0.0 a 100.0), o -1.0 en caso de error.
+ * @return Tabla de dispositivos, o NULL en caso de error.
  */
-double get_red_usage();
+disk_table_t* get_disk_stats();
 
 /**
- * @brief Obtiene el número de procesos en ejecución.
+ * @brief Configura los filtros de interfaces de red.
+ *
+ * Por defecto se excluye la interfaz de loopback (NET_DEFAULT_EXCLUDE). Reinicia la tabla de interfaces.
+ *
+ * @param include Expresión regular extendida de interfaces a incluir, o NULL para incluir todas.
+ * @param exclude Expresión regular extendida de interfaces a excluir, o NULL para no excluir ninguna.
+ * @return 0 si los filtros son válidos, -1 en caso contrario.
+ */
+int init_net_stats(const char* include, const char* exclude);
+
+/**
+ * @brief Obtiene las estadísticas por interfaz desde /proc/net/dev.
+ *
+ * Calcula, para cada interfaz no filtrada, bytes, paquetes, errores y descartes por segundo en cada dirección, y la
+ * utilización respecto de la velocidad del enlace, dividiendo por el tiempo transcurrido entre lecturas.
+ *
+ * @return Tabla de interfaces, o NULL en caso de error.
+ */
+net_table_t* get_net_stats();
+
+/**
+ * @brief Abre el directorio /proc para el barrido de procesos y reinicia la tabla de procesos.
+ *
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int init_process_stats();
+
+/**
+ * @brief Libera la tabla de procesos inicializada con init_process_stats().
+ */
+void close_process_stats();
+
+/**
+ * @brief Obtiene las estadísticas por proceso desde /proc/[pid].
  *
+ * El barrido se reparte entre ciclos para respetar el presupuesto de CPU PROCESS_CPU_BUDGET: mientras no se complete,
+ * se devuelve la tabla del barrido anterior con table->scanned en 0.
  *
+ * @return Tabla de procesos, o NULL en caso de error o si no se llamó a init_process_stats().
+ */
+const process_table_t* get_process_stats();
+
+/**
+ * @brief Recorre la jerarquía de cgroups y empieza a vigilarla con inotify.
+ *
+ * @param root Punto de montaje de cgroup v2 (normalmente CGROUP_DEFAULT_ROOT).
+ * @param max_depth Profundidad máxima de los cgroups exportados (0: sin límite).
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int init_cgroup_stats(const char* root, unsigned int max_depth);
+
+/**
+ * @brief Deja de vigilar la jerarquía de cgroups inicializada con init_cgroup_stats() y libera la tabla.
+ */
+void close_cgroup_stats();
+
+/**
+ * @brief Obtiene las estadísticas por cgroup.
+ *
+ * Primero aplica los cgroups creados y eliminados desde el ciclo anterior (notificados por inotify) y después lee
+ * cpu.stat, memory.current, memory.stat, io.stat y los archivos de presión de cada cgroup.
+ *
+ * @param scratch Memoria temporal de la ejecución, para recorrer los cgroups nuevos.
+ * @return Jerarquía de cgroups, o NULL en caso de error o si no se llamó a init_cgroup_stats().
+ */
+const cgroup_tree_t* get_cgroup_stats(arena_t* scratch);
+
+/**
+ * @brief Obtiene el número de procesos en ejecución.
+ *
+ * @param snapshot Instantánea actual de /proc/stat.
  * @return Numero con la cantidad de procesos en ejecución.
  */
-double get_proc_number();
+double get_proc_number(const proc_stat_snapshot_t* snapshot);
 
 /**
- * @brief Obtiene la cantidad de cambios de contexto desde /proc/stat.
+ * @brief Acumula los contadores de /proc/stat (cambios de contexto, interrupciones, softirqs y procesos creados).
  *
+ * Debe llamarse una vez por cada lectura de /proc/stat: las tasas dividen el incremento desde la llamada anterior por
+ * el tiempo transcurrido entre las dos últimas lecturas. En la primera llamada el campo valid queda en 0.
  *
- * @return Número con la cantidad de cambios de contexto.
+ * @param snapshot Instantánea actual de /proc/stat.
+ * @return Contadores acumulados y tasas del último intervalo.
  */
-double get_context_switches();
+const proc_stat_counters_t* get_proc_stat_counters(const proc_stat_snapshot_t* snapshot);
+
+#endif // METRICS_H
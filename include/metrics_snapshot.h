@@ -0,0 +1,100 @@
+/**
+ * @file metrics_snapshot.h
+ * @brief Publicación de la exposición de métricas entre el hilo recolector y el servidor HTTP sin bloqueos.
+ *
+ * Al final de cada ciclo el recolector arma una instantánea inmutable con todas las métricas y la publica con un
+ * intercambio atómico de puntero. El servidor HTTP toma una referencia a la última instantánea publicada y responde a
+ * partir de ella, sin compartir ningún mutex con el recolector: la latencia de un scrape y la de la recolección dejan
+ * de depender una de la otra.
+ *
+ * La exposición se renderiza una sola vez por ciclo y se guarda también comprimida con gzip, de modo que los scrapes
+ * (de varias réplicas de Prometheus o de una federación) sólo envían un buffer ya armado.
+ *
+ * La instantánea que deja de usarse no se libera: queda de repuesto y la publicación siguiente reutiliza sus buffers,
+ * por lo que en régimen publicar no reserva memoria (la exposición y su copia comprimida ocupan cientos de KiB en un
+ * host grande, y reservarlas y liberarlas en cada ciclo fragmenta el heap). El recolector escribe la exposición
+ * directamente en el texto de la instantánea de repuesto (metrics_snapshot_begin()) y la publica con
+ * metrics_snapshot_commit(), sin armarla antes en otro buffer.
+ */
+
+#ifndef METRICS_SNAPSHOT_H
+#define METRICS_SNAPSHOT_H
+
+#include "text_buf.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @brief Nivel de compresión de la copia gzip de la exposición.
+ *
+ * La compresión se hace una vez por ciclo y se aprovecha en todos los scrapes, por lo que conviene el nivel por
+ * defecto de zlib antes que el más rápido.
+ */
+#define METRICS_SNAPSHOT_GZIP_LEVEL 6
+
+/**
+ * @brief Longitud máxima del ETag de una instantánea, incluyendo comillas y el '\0'.
+ */
+#define METRICS_SNAPSHOT_ETAG_SIZE 24
+
+/**
+ * @brief Instantánea inmutable de las métricas, con conteo de referencias.
+ */
+typedef struct
+{
+    atomic_uint refs;                      /**< Referencias vivas (la publicación cuenta como una). */
+    atomic_ullong served;                  /**< Scrapes respondidos con esta instantánea. */
+    char* text;                            /**< Exposición en el formato de texto de Prometheus. */
+    size_t len;                            /**< Longitud del texto en bytes. */
+    text_buf_t body;                       /**< Buffer del texto, reutilizado entre publicaciones. */
+    unsigned char* gzip;                   /**< Exposición comprimida con gzip, o NULL si no se pudo comprimir. */
+    size_t gzip_len;                       /**< Longitud de la copia comprimida en bytes. */
+    unsigned char* gzip_buf;               /**< Buffer de la copia comprimida, aunque no se haya podido comprimir. */
+    size_t gzip_cap;                       /**< Capacidad reservada para la copia comprimida. */
+    char etag[METRICS_SNAPSHOT_ETAG_SIZE]; /**< ETag derivado del contenido, entre comillas. */
+    unsigned long long seq;                /**< Número de publicación, creciente. */
+    struct timespec collected_at;          /**< Instante (CLOCK_MONOTONIC) en que se publicó. */
+} metrics_snapshot_t;
+
+/**
+ * @brief Empieza a armar la próxima instantánea sobre los buffers de la de repuesto.
+ *
+ * Sólo debe llamarse desde el hilo recolector. Si la publicación anterior se descartó (metrics_snapshot_commit() no
+ * llegó a llamarse o el contenido no cambió), se reutiliza la misma instantánea.
+ *
+ * @return Texto vacío de la instantánea en armado, donde se escribe la exposición, o NULL si falta memoria.
+ */
+text_buf_t* metrics_snapshot_begin(void);
+
+/**
+ * @brief Publica la instantánea armada desde metrics_snapshot_begin() y libera la anterior cuando deja de estar en uso.
+ *
+ * Si el texto es idéntico al de la instantánea vigente no se publica nada: se conservan su copia comprimida y su ETag,
+ * y los clientes con ese ETag reciben 304 Not Modified.
+ *
+ * @return 0 si se publicó o el contenido no cambió, -1 si no hay una instantánea en armado.
+ */
+int metrics_snapshot_commit(void);
+
+/**
+ * @brief Toma una referencia a la última instantánea publicada.
+ *
+ * @return Instantánea, que debe devolverse con metrics_snapshot_release(), o NULL si todavía no se publicó ninguna.
+ */
+metrics_snapshot_t* metrics_snapshot_acquire(void);
+
+/**
+ * @brief Devuelve una referencia tomada con metrics_snapshot_acquire().
+ *
+ * @param snapshot Instantánea; al soltar la última referencia queda de repuesto para la próxima publicación o se
+ * libera.
+ */
+void metrics_snapshot_release(metrics_snapshot_t* snapshot);
+
+/**
+ * @brief Retira la instantánea publicada. Debe llamarse después de detener el servidor HTTP.
+ */
+void metrics_snapshot_shutdown(void);
+
+#endif // METRICS_SNAPSHOT_H
@@ -0,0 +1,145 @@
+/**
+ * @file net_stats.h
+ * @brief Estadísticas por interfaz de red a partir de /proc/net/dev.
+ *
+ * Las interfaces se guardan en una tabla hash indexada por nombre que se conserva entre ciclos, de modo que en hosts
+ * con miles de interfaces veth la aparición y desaparición de interfaces no obliga a reservar todo de nuevo.
+ */
+
+#ifndef NET_STATS_H
+#define NET_STATS_H
+
+#include "counter.h"
+#include <regex.h>
+#include <stddef.h>
+
+/**
+ * @brief Longitud máxima del nombre de una interfaz, incluyendo el '\0' (IFNAMSIZ).
+ */
+#define NET_IFNAME_SIZE 16
+
+/**
+ * @brief Cada cuántos ciclos se vuelve a leer la velocidad del enlace de una interfaz.
+ */
+#define NET_SPEED_REFRESH_TICKS 60
+
+/**
+ * @brief Filtro de exclusión por defecto: la interfaz de loopback.
+ */
+#define NET_DEFAULT_EXCLUDE "^lo$"
+
+/**
+ * @brief Contadores acumulados de una interfaz, tal como aparecen en /proc/net/dev.
+ */
+typedef struct
+{
+    unsigned long long rx_bytes;   /**< Bytes recibidos. */
+    unsigned long long rx_packets; /**< Paquetes recibidos. */
+    unsigned long long rx_errors;  /**< Errores de recepción. */
+    unsigned long long rx_drops;   /**< Paquetes recibidos descartados. */
+    unsigned long long tx_bytes;   /**< Bytes transmitidos. */
+    unsigned long long tx_packets; /**< Paquetes transmitidos. */
+    unsigned long long tx_errors;  /**< Errores de transmisión. */
+    unsigned long long tx_drops;   /**< Paquetes a transmitir descartados. */
+} net_counters_t;
+
+/**
+ * @brief Estado de una entrada de la tabla de interfaces.
+ */
+typedef enum
+{
+    NET_SLOT_EMPTY,   /**< Entrada nunca usada. */
+    NET_SLOT_USED,    /**< Entrada con una interfaz presente. */
+    NET_SLOT_DELETED, /**< Entrada de una interfaz que desapareció. */
+} net_slot_state_t;
+
+/**
+ * @brief Interfaz de red con sus contadores y las tasas del último intervalo.
+ */
+typedef struct
+{
+    net_slot_state_t state;           /**< Estado de la entrada. */
+    unsigned int hash;                /**< Hash del nombre. */
+    char name[NET_IFNAME_SIZE];       /**< Nombre de la interfaz (etiqueta "interface"). */
+    int filtered;                     /**< 1 si la interfaz quedó excluida por los filtros. */
+    int has_prev;                     /**< 1 si ya hay una lectura anterior con la cual comparar. */
+    int valid;                        /**< 1 si las tasas corresponden a dos lecturas comparables. */
+    unsigned long long generation;    /**< Último ciclo en que se vio la interfaz. */
+    unsigned long long speed_checked; /**< Ciclo en que se leyó la velocidad del enlace por última vez. */
+    double speed_bps;                 /**< Velocidad del enlace en bits por segundo, o 0 si se desconoce. */
+    net_counters_t cur;               /**< Contadores de la lectura actual. */
+    net_counters_t prev;              /**< Contadores de la lectura anterior. */
+    net_counters_t total;             /**< Contadores acumulados, sin retroceder ante vueltas ni reinicios. */
+    double rx_bytes_per_sec;          /**< Bytes recibidos por segundo. */
+    double tx_bytes_per_sec;          /**< Bytes transmitidos por segundo. */
+    double rx_packets_per_sec;        /**< Paquetes recibidos por segundo. */
+    double tx_packets_per_sec;        /**< Paquetes transmitidos por segundo. */
+    double rx_errors_per_sec;         /**< Errores de recepción por segundo. */
+    double tx_errors_per_sec;         /**< Errores de transmisión por segundo. */
+    double rx_drops_per_sec;          /**< Descartes en recepción por segundo. */
+    double tx_drops_per_sec;          /**< Descartes en transmisión por segundo. */
+    double rx_utilization;            /**< Porcentaje de la velocidad del enlace usado en recepción. */
+    double tx_utilization;            /**< Porcentaje de la velocidad del enlace usado en transmisión. */
+    unsigned int labels[3];           /**< Conjuntos de etiquetas del exportador: interfaz, recepción y transmisión. */
+} net_iface_t;
+
+/**
+ * @brief Tabla hash de interfaces con direccionamiento abierto, indexada por nombre.
+ */
+typedef struct
+{
+    net_iface_t* slots;            /**< Entradas de la tabla. */
+    size_t capacity;               /**< Cantidad de entradas (potencia de 2). */
+    size_t used;                   /**< Entradas usadas o borradas (ocupan lugar en el sondeo). */
+    size_t live;                   /**< Interfaces presentes. */
+    unsigned long long generation; /**< Número del ciclo actual. */
+    const char* sysfs_net;         /**< Directorio con la información de las interfaces (/sys/class/net). */
+    regex_t include;               /**< Expresión de interfaces a incluir. */
+    regex_t exclude;               /**< Expresión de interfaces a excluir. */
+    int has_include;               /**< 1 si hay expresión de inclusión. */
+    int has_exclude;               /**< 1 si hay expresión de exclusión. */
+} net_table_t;
+
+/**
+ * @brief Inicializa la tabla de interfaces y sus filtros.
+ *
+ * @param table Tabla a inicializar.
+ * @param include Expresión regular extendida de interfaces a incluir, o NULL para incluir todas.
+ * @param exclude Expresión regular extendida de interfaces a excluir, o NULL para no excluir ninguna.
+ * @return 0 si se inicializó correctamente, -1 si alguna expresión es inválida o falta memoria.
+ */
+int net_table_init(net_table_t* table, const char* include, const char* exclude);
+
+/**
+ * @brief Libera la tabla de interfaces y sus filtros.
+ *
+ * @param table Tabla a liberar.
+ */
+void net_table_destroy(net_table_t* table);
+
+/**
+ * @brief Analiza /proc/net/dev actualizando los contadores de cada interfaz.
+ *
+ * Las interfaces nuevas se agregan a la tabla (evaluando los filtros sólo esa vez) y las que ya no aparecen se marcan
+ * como borradas.
+ *
+ * @param table Tabla de interfaces.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @return Cantidad de interfaces presentes.
+ */
+size_t parse_net_devices(net_table_t* table, const char* buf, size_t len);
+
+/**
+ * @brief Calcula las tasas de cada interfaz a partir de la lectura actual y la anterior.
+ *
+ * La utilización se calcula contra la velocidad informada en /sys/class/net/<interfaz>/speed, que se vuelve a leer
+ * cada NET_SPEED_REFRESH_TICKS ciclos. También acumula la diferencia entre ambas lecturas en los contadores totales
+ * de cada interfaz (counter_delta()).
+ *
+ * @param table Tabla de interfaces.
+ * @param elapsed Segundos transcurridos entre ambas lecturas.
+ */
+void compute_net_rates(net_table_t* table, double elapsed);
+
+#endif // NET_STATS_H
@@ -0,0 +1,147 @@
+/**
+ * @file pressure_stats.h
+ * @brief Información de presión (PSI) de CPU, memoria e I/O, y disparadores de PSI.
+ *
+ * El formato de /proc/pressure/{cpu,memory,io} es el mismo que el de los archivos *.pressure de cada cgroup v2, por
+ * lo que el mismo analizador sirve para ambos.
+ *
+ * Los disparadores se registran escribiendo "some <demora µs> <ventana µs>" en el archivo de presión; el kernel
+ * notifica con POLLPRI cuando, dentro de la ventana, las tareas estuvieron demoradas al menos ese tiempo. Un hilo
+ * espera esas notificaciones con poll() y avisa al hilo recolector con una señal, para que recolecte y publique sin
+ * esperar al próximo ciclo.
+ */
+
+#ifndef PRESSURE_STATS_H
+#define PRESSURE_STATS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * @brief Directorio con la información de presión del sistema.
+ */
+#define PRESSURE_ROOT "/proc/pressure"
+
+/**
+ * @brief Ventana mínima de un disparador admitida por el kernel, en milisegundos.
+ */
+#define PRESSURE_TRIGGER_MIN_WINDOW_MS 500
+
+/**
+ * @brief Ventana máxima de un disparador admitida por el kernel, en milisegundos.
+ */
+#define PRESSURE_TRIGGER_MAX_WINDOW_MS 10000
+
+/**
+ * @brief Ventana por defecto de los disparadores, en milisegundos.
+ *
+ * Sin CAP_SYS_RESOURCE, los kernels recientes sólo aceptan ventanas múltiplo de 2 segundos.
+ */
+#define PRESSURE_TRIGGER_DEFAULT_WINDOW_MS 2000
+
+/**
+ * @brief Recursos con información de presión.
+ */
+typedef enum
+{
+    PRESSURE_RESOURCE_CPU,    /**< Archivo cpu. */
+    PRESSURE_RESOURCE_MEMORY, /**< Archivo memory. */
+    PRESSURE_RESOURCE_IO,     /**< Archivo io. */
+    PRESSURE_RESOURCE_COUNT,  /**< Cantidad de recursos. */
+} pressure_resource_t;
+
+/**
+ * @brief Líneas de un archivo de presión.
+ */
+typedef enum
+{
+    PRESSURE_SOME,       /**< Alguna tarea demorada. */
+    PRESSURE_FULL,       /**< Todas las tareas (no ociosas) demoradas a la vez. */
+    PRESSURE_KIND_COUNT, /**< Cantidad de líneas. */
+} pressure_kind_t;
+
+/**
+ * @brief Valores de una línea de un archivo de presión.
+ */
+typedef struct
+{
+    double avg10;             /**< Porcentaje del tiempo con demoras en los últimos 10 segundos. */
+    double avg60;             /**< Porcentaje del tiempo con demoras en los últimos 60 segundos. */
+    double avg300;            /**< Porcentaje del tiempo con demoras en los últimos 300 segundos. */
+    unsigned long long total; /**< Tiempo total con demoras, en microsegundos. */
+} pressure_line_t;
+
+/**
+ * @brief Contenido de un archivo de presión.
+ */
+typedef struct
+{
+    unsigned int present;                       /**< Bit (1 << pressure_kind_t) de cada línea leída. */
+    pressure_line_t lines[PRESSURE_KIND_COUNT]; /**< Valores de cada línea. */
+} pressure_sample_t;
+
+/**
+ * @brief Disparadores de PSI y el hilo que los espera.
+ */
+typedef struct
+{
+    int fds[PRESSURE_RESOURCE_COUNT]; /**< Archivo de presión de cada recurso con un disparador, o -1. */
+    int wake_fd;                      /**< eventfd para pedirle al hilo que termine, o -1. */
+    pthread_t thread;                 /**< Hilo que espera los disparadores. */
+    pthread_t target;                 /**< Hilo al que se avisa con la señal. */
+    int signo;                        /**< Señal con la que se avisa. */
+    int running;                      /**< 1 si el hilo está en ejecución. */
+    atomic_ullong events;             /**< Cantidad de veces que se activó algún disparador. */
+} pressure_trigger_t;
+
+/**
+ * @brief Obtiene el nombre de un recurso con información de presión.
+ *
+ * @param resource Recurso.
+ * @return Nombre del recurso ("cpu", "memory" o "io").
+ */
+const char* pressure_resource_name(pressure_resource_t resource);
+
+/**
+ * @brief Obtiene el nombre de una línea de un archivo de presión.
+ *
+ * @param kind Línea.
+ * @return "some" o "full".
+ */
+const char* pressure_kind_name(pressure_kind_t kind);
+
+/**
+ * @brief Analiza el contenido de un archivo de presión.
+ *
+ * @param buf Contenido del archivo ("some avg10=N avg60=N avg300=N total=N" y, opcionalmente, la línea "full").
+ * @param len Longitud del contenido.
+ * @param sample Contenido a completar.
+ * @return 0 si se encontró la línea "some", -1 en caso contrario.
+ */
+int parse_pressure(const char* buf, size_t len, pressure_sample_t* sample);
+
+/**
+ * @brief Registra un disparador "some" en cada recurso e inicia el hilo que los espera.
+ *
+ * El hilo hereda la máscara de señales del hilo que lo crea; conviene crearlo con las señales del programa
+ * bloqueadas para que no las reciba él.
+ *
+ * @param trigger Disparadores a inicializar.
+ * @param stall_ms Demora acumulada, dentro de la ventana, que activa el disparador.
+ * @param window_ms Ventana de evaluación (entre PRESSURE_TRIGGER_MIN_WINDOW_MS y PRESSURE_TRIGGER_MAX_WINDOW_MS).
+ * @param target Hilo al que se envía la señal cuando se activa un disparador.
+ * @param signo Señal a enviar.
+ * @return 0 si se registró al menos un disparador, -1 en caso contrario.
+ */
+int pressure_trigger_start(pressure_trigger_t* trigger, unsigned int stall_ms, unsigned int window_ms,
+                           pthread_t target, int signo);
+
+/**
+ * @brief Detiene el hilo y quita los disparadores.
+ *
+ * @param trigger Disparadores iniciados con pressure_trigger_start().
+ */
+void pressure_trigger_stop(pressure_trigger_t* trigger);
+
+#endif // PRESSURE_STATS_H
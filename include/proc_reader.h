@@ -0,0 +1,89 @@
+/**
+ * @file proc_reader.h
+ * @brief Lectura de archivos de /proc con descriptores persistentes y pread().
+ *
+ * Cada archivo se abre una sola vez y en cada ciclo se vuelve a leer desde el offset 0 sobre un buffer
+ * preasignado, que sólo crece cuando el archivo deja de entrar en él.
+ */
+
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief Tamaño inicial del buffer de lectura de cada archivo.
+ */
+#define PROC_FILE_INITIAL_SIZE 4096
+
+/**
+ * @brief Registro devuelto por getdents64(), tal como lo define el kernel.
+ *
+ * Los directorios de /proc que se recorren en cada ciclo se leen con getdents64() sobre un descriptor persistente
+ * reposicionado con lseek(), en lugar de opendir(), que reserva memoria en cada apertura.
+ */
+struct linux_dirent64
+{
+    uint64_t d_ino;          /**< Número de inodo. */
+    int64_t d_off;           /**< Posición del siguiente registro. */
+    unsigned short d_reclen; /**< Longitud de este registro. */
+    unsigned char d_type;    /**< Tipo de archivo. */
+    char d_name[];           /**< Nombre, terminado en '\0'. */
+};
+
+/**
+ * @brief Archivo de /proc abierto de forma persistente.
+ */
+typedef struct
+{
+    char path[PATH_MAX];          /**< Ruta del archivo (copia). */
+    int fd;                       /**< Descriptor abierto, o -1 si no está abierto. */
+    char* buf;                    /**< Buffer con el último contenido leído, terminado en '\0'. */
+    size_t size;                  /**< Capacidad del buffer en bytes. */
+    size_t len;                   /**< Cantidad de bytes válidos en el buffer. */
+    struct timespec read_at;      /**< Instante (CLOCK_MONOTONIC) de la última lectura completa. */
+    struct timespec prev_read_at; /**< Instante de la lectura anterior, o cero si todavía no la hubo. */
+} proc_file_t;
+
+/**
+ * @brief Abre un archivo de /proc y reserva su buffer de lectura.
+ *
+ * @param file Estructura a inicializar.
+ * @param path Ruta del archivo (se copia, por lo que puede armarse en un buffer temporal).
+ * @return 0 si se abrió correctamente, -1 en caso de error.
+ */
+int proc_file_open(proc_file_t* file, const char* path);
+
+/**
+ * @brief Vuelve a leer el contenido completo del archivo con pread() desde el offset 0.
+ *
+ * Si el contenido no entra en el buffer, éste se duplica y se continúa la lectura. Al terminar, el buffer queda
+ * terminado en '\0', file->len contiene la cantidad de bytes leídos y file->read_at el instante de la lectura.
+ *
+ * @param file Archivo abierto con proc_file_open().
+ * @return Puntero al contenido leído, o NULL en caso de error.
+ */
+char* proc_file_read(proc_file_t* file);
+
+/**
+ * @brief Devuelve el tiempo transcurrido entre las dos últimas lecturas del archivo.
+ *
+ * Las tasas se dividen por este valor y no por el período nominal de muestreo, de modo que el tiempo dedicado a la
+ * recolección y las demoras del planificador no desvían los resultados.
+ *
+ * @param file Archivo leído con proc_file_read().
+ * @return Segundos entre ambas lecturas, o 0.0 si todavía no hubo dos lecturas.
+ */
+double proc_file_elapsed(const proc_file_t* file);
+
+/**
+ * @brief Cierra el descriptor y libera el buffer del archivo.
+ *
+ * @param file Archivo abierto con proc_file_open().
+ */
+void proc_file_close(proc_file_t* file);
+
+#endif // PROC_READER_H
@@ -0,0 +1,130 @@
+/**
+ * @file proc_scan.h
+ * @brief Tokenizador sin reservas de memoria para el contenido de /proc.
+ *
+ * Reemplaza a sscanf() en los getters: recorre el buffer leído una sola vez, sin depender del locale ni de cadenas de
+ * formato, y sin modificar el contenido (el mismo buffer puede volver a analizarse).
+ */
+
+#ifndef PROC_SCAN_H
+#define PROC_SCAN_H
+
+#include <stddef.h>
+
+/**
+ * @brief Cursor sobre un rango de texto [pos, end).
+ *
+ * Se usa tanto para recorrer el archivo completo como para recorrer los campos de una línea.
+ */
+typedef struct
+{
+    const char* pos; /**< Posición actual. */
+    const char* end; /**< Fin del rango (no incluido). */
+} proc_scanner_t;
+
+/**
+ * @brief Inicializa un cursor sobre un buffer.
+ *
+ * @param scanner Cursor a inicializar.
+ * @param buf Inicio del buffer.
+ * @param len Cantidad de bytes del buffer.
+ */
+void scan_init(proc_scanner_t* scanner, const char* buf, size_t len);
+
+/**
+ * @brief Obtiene la siguiente línea del buffer.
+ *
+ * @param scanner Cursor sobre el archivo; avanza al inicio de la línea siguiente.
+ * @param line Cursor que queda apuntando a la línea, sin el '\n' final.
+ * @return 1 si se obtuvo una línea, 0 si no quedan más.
+ */
+int scan_next_line(proc_scanner_t* scanner, proc_scanner_t* line);
+
+/**
+ * @brief Lee el siguiente entero decimal sin signo, salteando los espacios previos.
+ *
+ * @param line Cursor sobre la línea; avanza hasta después del número.
+ * @param value Valor leído.
+ * @return 1 si se leyó un número, 0 si el siguiente campo no es numérico o la línea terminó.
+ */
+int scan_u64(proc_scanner_t* line, unsigned long long* value);
+
+/**
+ * @brief Lee el siguiente número decimal sin signo con parte fraccionaria opcional ("12" o "1.25").
+ *
+ * @param line Cursor sobre la línea; avanza hasta después del número.
+ * @param value Valor leído.
+ * @return 1 si se leyó un número, 0 si el siguiente campo no es numérico o la línea terminó.
+ */
+int scan_decimal(proc_scanner_t* line, double* value);
+
+/**
+ * @brief Saltea campos separados por espacios.
+ *
+ * @param line Cursor sobre la línea.
+ * @param count Cantidad de campos a saltear.
+ * @return 1 si se salteó la cantidad pedida, 0 si la línea terminó antes.
+ */
+int scan_skip(proc_scanner_t* line, unsigned count);
+
+/**
+ * @brief Obtiene el siguiente campo, delimitado por espacios o por el separador indicado.
+ *
+ * Si el campo termina en el separador, éste se consume (por ejemplo "eth0:" en /proc/net/dev o "MemTotal:" en
+ * /proc/meminfo, donde el número puede venir pegado al separador).
+ *
+ * @param line Cursor sobre la línea.
+ * @param sep Separador adicional que termina el campo, o '\0' para usar sólo espacios.
+ * @param token Inicio del campo (no está terminado en '\0').
+ * @param len Longitud del campo.
+ * @return 1 si se obtuvo un campo, 0 si la línea terminó.
+ */
+int scan_token(proc_scanner_t* line, char sep, const char** token, size_t* len);
+
+/**
+ * @brief Compara un campo obtenido con scan_token() con una cadena.
+ *
+ * @param token Inicio del campo.
+ * @param len Longitud del campo.
+ * @param str Cadena terminada en '\0'.
+ * @return 1 si son iguales, 0 en caso contrario.
+ */
+int scan_token_equals(const char* token, size_t len, const char* str);
+
+/**
+ * @brief Campo de un archivo "clave valor" (como /proc/meminfo o /proc/vmstat) y su lugar en la estructura destino.
+ */
+typedef struct
+{
+    const char* key; /**< Nombre de la clave tal como aparece en el archivo. */
+    size_t offset;   /**< Posición (offsetof) del unsigned long long que recibe el valor. */
+} scan_field_t;
+
+/**
+ * @brief Busca una clave en una tabla de campos ordenada por strcmp() sobre key.
+ *
+ * @param fields Tabla de campos ordenada.
+ * @param count Cantidad de campos.
+ * @param key Clave obtenida con scan_token() (no está terminada en '\0').
+ * @param len Longitud de la clave.
+ * @return Campo encontrado, o NULL si la clave no está en la tabla.
+ */
+const scan_field_t* scan_field_lookup(const scan_field_t* fields, size_t count, const char* key, size_t len);
+
+/**
+ * @brief Recorre un archivo "clave valor" una sola vez y guarda los valores de las claves de la tabla.
+ *
+ * Cada línea cuesta una búsqueda binaria sobre la tabla en lugar de una comparación por campo buscado. El recorrido
+ * termina apenas se encontraron todos los campos. Los campos ausentes no se modifican.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sep Separador entre la clave y el valor (':' en /proc/meminfo), o '\0' si sólo hay espacios.
+ * @param fields Tabla de campos ordenada por strcmp() sobre key.
+ * @param count Cantidad de campos.
+ * @param out Estructura destino.
+ * @return Cantidad de campos encontrados.
+ */
+size_t scan_fields(const char* buf, size_t len, char sep, const scan_field_t* fields, size_t count, void* out);
+
+#endif // PROC_SCAN_H
@@ -0,0 +1,240 @@
+/**
+ * @file process_stats.h
+ * @brief Estadísticas por proceso (CPU, memoria residente e I/O) a partir de /proc/[pid].
+ *
+ * El directorio /proc se abre una sola vez y se recorre con getdents64(); los archivos de cada proceso se abren con
+ * openat() relativo a ese descriptor. Las lecturas anteriores se guardan en una tabla hash indexada por pid que se
+ * conserva entre barridos, y sólo se exportan los N procesos que más consumen de cada recurso.
+ *
+ * Para acotar el costo en hosts con decenas de miles de procesos, el barrido se reparte entre ciclos: cada llamada
+ * recibe un crédito de CPU de PROCESS_CPU_RATE por segundo transcurrido y sigue recorriendo /proc desde donde quedó
+ * hasta agotarlo, de modo que el consumo se mantiene por debajo de PROCESS_CPU_BUDGET de un núcleo en cualquier
+ * ventana y no sólo en promedio. Las tasas se publican al completar cada barrido. Para que el barrido sea barato,
+ * /proc/[pid]/io sólo se relee si el proceso consumió CPU desde el barrido anterior (sin CPU no pudo hacer I/O propia)
+ * o le toca el refresco periódico cada PROCESS_IO_REFRESH barridos.
+ */
+
+#ifndef PROCESS_STATS_H
+#define PROCESS_STATS_H
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @brief Fracción de un núcleo que puede consumir el barrido de procesos (1%).
+ */
+#define PROCESS_CPU_BUDGET 0.01
+
+/**
+ * @brief Fracción de un núcleo que se acredita al barrido por segundo: un 10% por debajo de PROCESS_CPU_BUDGET para
+ * cubrir la selección de los N mayores y el exceso de medir el consumo sólo cada tanto.
+ */
+#define PROCESS_CPU_RATE (PROCESS_CPU_BUDGET * 0.9)
+
+/**
+ * @brief Crédito máximo acumulable, en segundos de CPU (10 s de crédito), para que una pausa larga no habilite un
+ * barrido entero de golpe.
+ */
+#define PROCESS_CPU_CREDIT_MAX (PROCESS_CPU_RATE * 10.0)
+
+/**
+ * @brief Cada cuántos barridos se relee /proc/[pid]/io de un proceso aunque no haya consumido CPU.
+ */
+#define PROCESS_IO_REFRESH 8
+
+/**
+ * @brief Cantidad máxima de procesos exportados por recurso.
+ */
+#define PROCESS_TOP_MAX 100
+
+/**
+ * @brief Cantidad de procesos exportados por recurso si se habilita el colector sin indicarla.
+ */
+#define PROCESS_TOP_DEFAULT 10
+
+/**
+ * @brief Longitud máxima del nombre de un proceso, incluyendo el '\0' (TASK_COMM_LEN).
+ */
+#define PROCESS_COMM_SIZE 16
+
+/**
+ * @brief Valores leídos de /proc/[pid]/stat y /proc/[pid]/io en un barrido.
+ */
+typedef struct
+{
+    char comm[PROCESS_COMM_SIZE];   /**< Nombre del proceso. */
+    unsigned long long flags;       /**< Banderas del proceso (PF_*). */
+    unsigned long long cpu_ticks;   /**< utime + stime, en ticks de reloj. */
+    unsigned long long starttime;   /**< Momento de creación desde el arranque, en ticks (detecta pids reusados). */
+    unsigned long long rss_pages;   /**< Memoria residente, en páginas. */
+    unsigned long long read_bytes;  /**< Bytes leídos del almacenamiento. */
+    unsigned long long write_bytes; /**< Bytes escritos al almacenamiento. */
+    double taken;                   /**< Instante (CLOCK_MONOTONIC, en segundos) de la lectura. */
+} process_sample_t;
+
+/**
+ * @brief Estado de una entrada de la tabla de procesos.
+ */
+typedef enum
+{
+    PROCESS_SLOT_EMPTY,   /**< Entrada nunca usada. */
+    PROCESS_SLOT_USED,    /**< Entrada con un proceso presente. */
+    PROCESS_SLOT_DELETED, /**< Entrada de un proceso que terminó. */
+} process_slot_state_t;
+
+/**
+ * @brief Proceso con su última lectura y las tasas del último intervalo.
+ */
+typedef struct
+{
+    process_slot_state_t state;    /**< Estado de la entrada. */
+    int pid;                       /**< Identificador del proceso. */
+    int has_prev;                  /**< 1 si ya hay una lectura anterior con la cual comparar. */
+    int valid;                     /**< 1 si las tasas corresponden a dos lecturas comparables. */
+    int io_denied;                 /**< 1 si /proc/[pid]/io no es legible (no se vuelve a intentar). */
+    unsigned long long generation; /**< Último barrido en que se vio el proceso. */
+    process_sample_t cur;          /**< Lectura actual. */
+    process_sample_t prev;         /**< Lectura anterior. */
+    double cpu_percent;            /**< Porcentaje de un núcleo usado en el intervalo. */
+    double rss_bytes;              /**< Memoria residente en bytes. */
+    double read_bytes_per_sec;     /**< Bytes leídos por segundo. */
+    double write_bytes_per_sec;    /**< Bytes escritos por segundo. */
+} process_entry_t;
+
+/**
+ * @brief Tabla hash de procesos con direccionamiento abierto, indexada por pid.
+ */
+typedef struct
+{
+    process_entry_t* slots;        /**< Entradas de la tabla. */
+    size_t capacity;               /**< Cantidad de entradas (potencia de 2). */
+    size_t used;                   /**< Entradas usadas o borradas (ocupan lugar en el sondeo). */
+    size_t live;                   /**< Procesos presentes. */
+    unsigned long long generation; /**< Número del barrido actual. */
+    int proc_fd;                   /**< Descriptor del directorio /proc, o -1. */
+    char* dirents;                 /**< Buffer para getdents64(). */
+    char file_buf[4096];           /**< Buffer para leer los archivos de cada proceso. */
+    long clock_ticks;              /**< Ticks de reloj por segundo (sysconf(_SC_CLK_TCK)). */
+    long page_size;                /**< Tamaño de página en bytes. */
+    long dirents_len;              /**< Bytes válidos en dirents. */
+    long dirents_pos;              /**< Posición del próximo registro a procesar en dirents. */
+    int sweeping;                  /**< 1 si hay un barrido a medio hacer (el descriptor conserva su posición). */
+    double batch_time;             /**< Instante (CLOCK_MONOTONIC, en segundos) de las lecturas del lote en curso. */
+    double cpu_credit;             /**< Segundos de CPU disponibles para seguir barriendo. */
+    struct timespec credited_at;   /**< Instante (CLOCK_MONOTONIC) de la última acreditación. */
+    struct timespec sweep_start;   /**< Instante (CLOCK_MONOTONIC) en que empezó el barrido en curso. */
+    double sweep_cpu;              /**< Segundos de CPU consumidos por el barrido en curso. */
+    double last_scan_cpu;          /**< Segundos de CPU consumidos por el último barrido completo. */
+    double scan_duration;          /**< Segundos que tardó el último barrido completo (antigüedad de sus tasas). */
+    double scanned_wall;           /**< Instante (CLOCK_REALTIME, en segundos) en que se completó el último barrido. */
+    int scanned;                   /**< 1 si la última llamada a process_table_scan() completó un barrido. */
+} process_table_t;
+
+/**
+ * @brief Inicializa la tabla de procesos y abre el directorio /proc indicado.
+ *
+ * @param table Tabla a inicializar.
+ * @param proc_root Directorio del sistema de archivos proc (normalmente "/proc").
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int process_table_init(process_table_t* table, const char* proc_root);
+
+/**
+ * @brief Cierra el directorio /proc y libera la tabla de procesos.
+ *
+ * @param table Tabla a liberar.
+ */
+void process_table_destroy(process_table_t* table);
+
+/**
+ * @brief Analiza el contenido de /proc/[pid]/stat.
+ *
+ * El nombre del proceso puede contener espacios y paréntesis, por lo que los campos numéricos se toman a partir del
+ * último ')'.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar (comm, flags, cpu_ticks, starttime y rss_pages).
+ * @return 0 si se interpretó correctamente, -1 en caso contrario.
+ */
+int parse_process_stat(const char* buf, size_t len, process_sample_t* sample);
+
+/**
+ * @brief Analiza el contenido de /proc/[pid]/io.
+ *
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar (read_bytes y write_bytes).
+ * @return 0 si se encontraron ambos valores, -1 en caso contrario.
+ */
+int parse_process_io(const char* buf, size_t len, process_sample_t* sample);
+
+/**
+ * @brief Guarda la lectura de un proceso en la tabla, agregándolo si es nuevo.
+ *
+ * Si el pid corresponde a un proceso distinto del anterior (otro starttime), la entrada se reinicia.
+ *
+ * @param table Tabla de procesos.
+ * @param pid Identificador del proceso.
+ * @param sample Lectura del proceso.
+ * @return Entrada del proceso, o NULL si falta memoria.
+ */
+process_entry_t* process_table_update(process_table_t* table, int pid, const process_sample_t* sample);
+
+/**
+ * @brief Comienza un barrido: los procesos que no se actualicen hasta process_table_sweep() se dan por terminados.
+ *
+ * @param table Tabla de procesos.
+ */
+void process_table_begin(process_table_t* table);
+
+/**
+ * @brief Marca como borrados los procesos que no aparecieron en el barrido actual.
+ *
+ * @param table Tabla de procesos.
+ * @return Cantidad de procesos presentes.
+ */
+size_t process_table_sweep(process_table_t* table);
+
+/**
+ * @brief Calcula las tasas de cada proceso a partir de la lectura actual y la anterior.
+ *
+ * El intervalo de cada proceso es la diferencia entre los instantes de sus dos lecturas (process_sample_t::taken).
+ *
+ * @param table Tabla de procesos.
+ */
+void compute_process_rates(process_table_t* table);
+
+/**
+ * @brief Avanza el barrido de /proc hasta agotar el crédito de CPU acumulado.
+ *
+ * Si el barrido no llega al final del directorio table->scanned queda en 0 y las tasas del barrido anterior siguen
+ * vigentes; la próxima llamada continúa desde el mismo punto.
+ *
+ * @param table Tabla de procesos.
+ * @return 0 si se barrió o se omitió el barrido, -1 en caso de error.
+ */
+int process_table_scan(process_table_t* table);
+
+/**
+ * @brief Criterio de ordenamiento para seleccionar los procesos que más consumen.
+ */
+typedef enum
+{
+    PROCESS_TOP_CPU, /**< Por porcentaje de CPU. */
+    PROCESS_TOP_RSS, /**< Por memoria residente. */
+    PROCESS_TOP_IO,  /**< Por bytes leídos y escritos por segundo. */
+} process_top_key_t;
+
+/**
+ * @brief Selecciona los N procesos con mayor valor según un criterio.
+ *
+ * @param table Tabla de procesos.
+ * @param key Criterio de ordenamiento.
+ * @param top Arreglo de al menos n punteros, que se completa de mayor a menor.
+ * @param n Cantidad de procesos a seleccionar.
+ * @return Cantidad de procesos seleccionados (menor que n si hay menos procesos con valor positivo).
+ */
+size_t process_top_n(const process_table_t* table, process_top_key_t key, const process_entry_t** top, size_t n);
+
+#endif // PROCESS_STATS_H
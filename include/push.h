@@ -0,0 +1,176 @@
+/**
+ * @file push.h
+ * @brief Envío de las métricas a un receptor remoto, para hosts que Prometheus no puede scrapear (por ejemplo, detrás
+ * de NAT).
+ *
+ * Cada publicación encola las muestras de la exposición en una cola acotada de muestras; un hilo aparte las envía en
+ * lotes cuando se junta un lote completo o vence el período de envío. Con el receptor caído, los lotes se reintentan
+ * con espera exponencial y jitter y, si la cola se llena, se descartan las muestras más viejas: el muestreo nunca se
+ * bloquea por el envío.
+ *
+ * Formatos:
+ *  - http://HOST[:PUERTO]/RUTA: remote-write de Prometheus (protobuf comprimido con Snappy, sin TLS), por ejemplo a
+ *    un Prometheus con --web.enable-remote-write-receiver o a un agente;
+ *  - udp://HOST:PUERTO: line protocol de InfluxDB, una línea por muestra, en datagramas de hasta PUSH_UDP_PAYLOAD
+ *    bytes (Telegraf, InfluxDB o un simple "nc -ul PUERTO" para probar).
+ */
+
+#ifndef PUSH_H
+#define PUSH_H
+
+#include "text_buf.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Muestras que caben por defecto en la cola.
+ */
+#define PUSH_DEFAULT_QUEUE 10000
+
+/**
+ * @brief Muestras por defecto de cada lote.
+ */
+#define PUSH_DEFAULT_BATCH 2000
+
+/**
+ * @brief Período por defecto de envío de un lote incompleto, en milisegundos.
+ */
+#define PUSH_DEFAULT_FLUSH_MS 5000
+
+/**
+ * @brief Reintentos por defecto de un lote antes de descartarlo.
+ */
+#define PUSH_DEFAULT_RETRIES 5
+
+/**
+ * @brief Espera antes del primer reintento, en milisegundos; se duplica en cada uno.
+ */
+#define PUSH_RETRY_BASE_MS 500
+
+/**
+ * @brief Espera máxima entre reintentos, en milisegundos.
+ */
+#define PUSH_RETRY_MAX_MS 30000
+
+/**
+ * @brief Plazo de conexión, envío y respuesta de cada pedido HTTP, en milisegundos.
+ */
+#define PUSH_TIMEOUT_MS 5000
+
+/**
+ * @brief Longitud máxima del nombre y las etiquetas de una muestra ("nombre{etiquetas}"), incluyendo el '\0'.
+ */
+#define PUSH_SERIES_SIZE 256
+
+/**
+ * @brief Bytes máximos de cada datagrama UDP, para no fragmentar con una MTU de 1500.
+ */
+#define PUSH_UDP_PAYLOAD 1400
+
+/**
+ * @brief Formato de envío.
+ */
+typedef enum
+{
+    PUSH_REMOTE_WRITE, /**< Remote-write de Prometheus por HTTP. */
+    PUSH_LINE_UDP,     /**< Line protocol de InfluxDB por UDP. */
+} push_format_t;
+
+/**
+ * @brief Configuración del envío.
+ */
+typedef struct
+{
+    push_format_t format;     /**< Formato, según el esquema del destino. */
+    char host[256];           /**< Host del receptor. */
+    char port[8];             /**< Puerto del receptor. */
+    char path[512];           /**< Ruta del pedido HTTP (remote-write). */
+    size_t queue_size;        /**< Muestras que caben en la cola. */
+    size_t batch_size;        /**< Muestras de cada lote. */
+    unsigned long flush_ms;   /**< Período de envío de un lote incompleto. */
+    unsigned int max_retries; /**< Reintentos de un lote antes de descartarlo. */
+} push_config_t;
+
+/**
+ * @brief Muestra encolada.
+ */
+typedef struct
+{
+    int64_t ms;                    /**< Instante de la publicación (ms desde la época Unix). */
+    double value;                  /**< Valor. */
+    char series[PUSH_SERIES_SIZE]; /**< Nombre y etiquetas tal como aparecen en la exposición. */
+} push_sample_t;
+
+/**
+ * @brief Estado del envío.
+ */
+typedef struct
+{
+    push_config_t config;  /**< Configuración. */
+    push_sample_t* queue;  /**< Cola circular de muestras. */
+    size_t head;           /**< Posición de la muestra más vieja. */
+    size_t len;            /**< Muestras encoladas. */
+    push_sample_t* batch;  /**< Lote que se está enviando, fuera de la cola. */
+    text_buf_t body;       /**< Cuerpo sin comprimir del lote. */
+    text_buf_t packet;     /**< Pedido o datagrama que se envía. */
+    int udp_fd;            /**< Socket UDP conectado al receptor, o -1. */
+    unsigned int seed;     /**< Semilla del jitter de los reintentos. */
+    pthread_t thread;      /**< Hilo de envío. */
+    pthread_mutex_t lock;  /**< Protege la cola y stopping. */
+    pthread_cond_t ready;  /**< Señala un lote completo o el pedido de terminar. */
+    int stopping;          /**< 1 cuando se pidió terminar. */
+    int running;           /**< 1 si el hilo está corriendo. */
+    atomic_ullong sent;    /**< Muestras enviadas. */
+    atomic_ullong dropped; /**< Muestras descartadas por la cola llena o por no entrar en PUSH_SERIES_SIZE. */
+    atomic_ullong failed;  /**< Muestras de lotes descartados tras agotar los reintentos. */
+    atomic_ullong retries; /**< Reintentos de lotes. */
+    atomic_ullong queued;  /**< Muestras en la cola, para exportarlas sin tomar el mutex. */
+} pusher_t;
+
+/**
+ * @brief Completa la configuración con los valores por defecto (sin destino).
+ *
+ * @param config Configuración a completar.
+ */
+void push_config_default(push_config_t* config);
+
+/**
+ * @brief Interpreta el destino del envío: http://HOST[:PUERTO]/RUTA o udp://HOST:PUERTO.
+ *
+ * @param config Configuración a completar con el formato, el host, el puerto y la ruta.
+ * @param url Destino.
+ * @return 0 si el destino es válido, -1 en caso contrario.
+ */
+int push_parse_url(push_config_t* config, const char* url);
+
+/**
+ * @brief Reserva la cola y crea el hilo de envío.
+ *
+ * @param pusher Estado a inicializar.
+ * @param config Configuración, con el destino ya interpretado.
+ * @return 0 si se inició, -1 en caso de error.
+ */
+int push_start(pusher_t* pusher, const push_config_t* config);
+
+/**
+ * @brief Encola las muestras de una exposición en formato de texto.
+ *
+ * Se saltean los comentarios; si la cola se llena se descartan las muestras más viejas.
+ *
+ * @param pusher Envío iniciado.
+ * @param text Exposición.
+ * @param len Longitud de la exposición.
+ * @param ms Instante de las muestras (ms desde la época Unix).
+ */
+void push_enqueue_exposition(pusher_t* pusher, const char* text, size_t len, int64_t ms);
+
+/**
+ * @brief Envía lo que quede en la cola (un intento por lote, sin reintentos), detiene el hilo y libera la cola.
+ *
+ * @param pusher Envío iniciado o no.
+ */
+void push_stop(pusher_t* pusher);
+
+#endif // PUSH_H
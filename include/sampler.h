@@ -0,0 +1,57 @@
+/**
+ * @file sampler.h
+ * @brief Planificación periódica de la recolección de métricas sobre CLOCK_MONOTONIC.
+ *
+ * Cada ciclo se programa en un instante absoluto (inicio + n * período), que quien planifica espera con
+ * clock_nanosleep() y TIMER_ABSTIME, de modo que el tiempo de recolección no se acumula como deriva entre ciclos.
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <time.h>
+
+/**
+ * @brief Período de muestreo por defecto, en milisegundos.
+ */
+#define SAMPLER_DEFAULT_INTERVAL_MS 1000
+
+/**
+ * @brief Período de muestreo mínimo admitido, en milisegundos.
+ */
+#define SAMPLER_MIN_INTERVAL_MS 100
+
+/**
+ * @brief Estado del muestreador periódico.
+ */
+typedef struct
+{
+    long long period_ns;       /**< Período de muestreo en nanosegundos. */
+    struct timespec next;      /**< Instante (CLOCK_MONOTONIC) en que comienza el próximo ciclo. */
+    unsigned long long ticks;  /**< Ciclos completados. */
+    unsigned long long missed; /**< Ciclos salteados porque la recolección demoró más de un período. */
+} sampler_t;
+
+/**
+ * @brief Inicializa el muestreador tomando el instante actual como inicio del primer ciclo.
+ *
+ * @param sampler Muestreador a inicializar.
+ * @param interval_ms Período de muestreo en milisegundos (al menos SAMPLER_MIN_INTERVAL_MS).
+ * @return 0 si se inicializó correctamente, -1 si el período es inválido.
+ */
+int sampler_init(sampler_t* sampler, unsigned long interval_ms);
+
+/**
+ * @brief Pasa al ciclo siguiente sin esperar.
+ *
+ * Si la recolección demoró más de un período, los ciclos vencidos se saltean (y se cuentan en sampler->missed) en
+ * lugar de ejecutarse seguidos para recuperar el atraso.
+ *
+ * Sirve para planificar varios muestreadores desde una sola espera: quien espera es el llamador, y al llegar el
+ * instante sampler->next de un muestreador lo avanza con esta función.
+ *
+ * @param sampler Muestreador inicializado con sampler_init().
+ */
+void sampler_advance(sampler_t* sampler);
+
+#endif // SAMPLER_H
@@ -0,0 +1,219 @@
+/**
+ * @file series.h
+ * @brief Series etiquetadas con conjuntos de etiquetas internados y cardinalidad acotada.
+ *
+ * Las métricas por núcleo, por disco y por interfaz se renderizan fuera del registro de Prometheus: el registro arma
+ * la clave de cada muestra a partir del arreglo de etiquetas en cada actualización y no permite quitar series, por lo
+ * que las interfaces y dispositivos efímeros (contenedores que se crean y destruyen) quedarían para siempre.
+ *
+ * Cada colector tiene su propia tabla de conjuntos de etiquetas (sin locks: la usa un único hilo a la vez). Un
+ * conjunto se interna una sola vez: se renderiza y escapa ('device="sda"'), se guarda en un slab contiguo y se
+ * identifica con un número estable que el colector conserva junto al objeto que describe. Ese número lleva la
+ * generación de la entrada, de modo que uno de un conjunto ya liberado se detecta y se vuelve a internar. Las familias
+ * guardan sus series indexadas por ese número, así que actualizar una serie no busca ni reserva nada.
+ *
+ * Cada familia tiene un límite de series: las series nuevas que lo superan se descartan y se cuentan. Las series que
+ * no se actualizan durante una cantidad de ciclos se quitan al renderizar, y los conjuntos de etiquetas que ninguna
+ * serie usa se liberan al avanzar el ciclo.
+ */
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include "text_buf.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * @brief Series por familia admitidas por defecto.
+ */
+#define SERIES_DEFAULT_LIMIT 1000
+
+/**
+ * @brief Ciclos sin actualizarse tras los cuales se quita una serie por defecto.
+ */
+#define SERIES_DEFAULT_MAX_IDLE 5
+
+/**
+ * @brief Longitud máxima de un conjunto de etiquetas renderizado, sin las llaves.
+ */
+#define SERIES_LABELS_SIZE 192
+
+/**
+ * @brief Bits del número de un conjunto de etiquetas que indican su entrada; el resto es la generación.
+ */
+#define SERIES_INDEX_BITS 20
+
+/**
+ * @brief Número que no identifica ningún conjunto de etiquetas (sin resolver).
+ */
+#define SERIES_NO_LABELS 0U
+
+/**
+ * @brief Conjunto de etiquetas internado.
+ */
+typedef struct
+{
+    char text[SERIES_LABELS_SIZE]; /**< Etiquetas renderizadas y escapadas, sin llaves: cpu="0",mode="user". */
+    unsigned int len;              /**< Longitud del texto. */
+    unsigned int hash;             /**< Hash del texto. */
+    unsigned int generation;       /**< Generación de la entrada; cambia cada vez que se libera. */
+    unsigned int refs;             /**< Series que usan el conjunto. */
+    unsigned int next_free;        /**< Siguiente entrada libre, si esta está libre (0: ninguna). */
+    int used;                      /**< 1 si la entrada tiene un conjunto. */
+    unsigned long long last_tick;  /**< Último ciclo en que se resolvió. */
+} series_label_set_t;
+
+/**
+ * @brief Tabla de conjuntos de etiquetas internados de un colector.
+ */
+typedef struct
+{
+    series_label_set_t* sets;  /**< Slab de conjuntos; la entrada 0 no se usa. */
+    size_t capacity;           /**< Entradas reservadas del slab. */
+    size_t len;                /**< Entradas usadas alguna vez (incluida la 0). */
+    size_t live;               /**< Conjuntos internados. */
+    unsigned int free_head;    /**< Primera entrada libre para reutilizar (0: ninguna). */
+    unsigned int* index;       /**< Tabla hash con direccionamiento abierto de entradas del slab (0: vacía). */
+    size_t index_capacity;     /**< Cantidad de posiciones del índice (potencia de 2). */
+    size_t index_used;         /**< Posiciones usadas o borradas del índice. */
+    unsigned long long tick;   /**< Número del ciclo actual. */
+    unsigned long max_idle;    /**< Ciclos sin actualizarse tras los cuales se quita una serie. */
+    unsigned int epoch;        /**< Generación inicial de las entradas, distinta en cada inicialización. */
+} series_labels_t;
+
+/**
+ * @brief Serie de una familia, indexada por la entrada de su conjunto de etiquetas.
+ */
+typedef struct
+{
+    unsigned int labels;          /**< Conjunto de etiquetas, o SERIES_NO_LABELS si la serie no existe. */
+    unsigned long long last_tick; /**< Último ciclo en que se actualizó. */
+    union
+    {
+        double value;             /**< Valor de un gauge. */
+        unsigned long long count; /**< Valor de un contador, exportado como entero exacto. */
+    };
+} series_t;
+
+/**
+ * @brief Familia de series (una métrica) con su límite de cardinalidad.
+ */
+typedef struct
+{
+    const char* name;         /**< Nombre de la métrica. */
+    const char* help;         /**< Descripción de la métrica. */
+    int counter;              /**< 1 si es un contador entero, 0 si es un gauge. */
+    series_labels_t* labels;  /**< Tabla de conjuntos de etiquetas del colector. */
+    series_t* series;         /**< Series, indexadas por la entrada de su conjunto de etiquetas. */
+    size_t capacity;          /**< Entradas reservadas de series. */
+    size_t count;             /**< Series presentes. */
+    size_t limit;             /**< Series admitidas. */
+    atomic_ullong dropped;    /**< Actualizaciones de series nuevas descartadas por el límite. */
+} series_family_t;
+
+/**
+ * @brief Inicializa una tabla de conjuntos de etiquetas vacía.
+ *
+ * @param labels Tabla a inicializar.
+ * @param max_idle Ciclos sin actualizarse tras los cuales se quita una serie (al menos 1).
+ */
+void series_labels_init(series_labels_t* labels, unsigned long max_idle);
+
+/**
+ * @brief Libera una tabla de conjuntos de etiquetas; sus familias deben haberse liberado antes.
+ *
+ * @param labels Tabla.
+ */
+void series_labels_destroy(series_labels_t* labels);
+
+/**
+ * @brief Avanza el ciclo y libera los conjuntos de etiquetas que ninguna serie usa ni se resolvieron en los últimos
+ * ciclos.
+ *
+ * Se llama al comienzo de cada ejecución del colector.
+ *
+ * @param labels Tabla.
+ */
+void series_labels_tick(series_labels_t* labels);
+
+/**
+ * @brief Comprueba que un número guardado por un colector siga identificando un conjunto de etiquetas.
+ *
+ * Permite evitar armar los valores de las etiquetas (por ejemplo, el número de un núcleo) cuando el conjunto ya está
+ * resuelto.
+ *
+ * @param labels Tabla.
+ * @param id Número guardado.
+ * @return El mismo número, o SERIES_NO_LABELS si el conjunto se liberó o nunca se resolvió.
+ */
+unsigned int series_labels_lookup(series_labels_t* labels, unsigned int id);
+
+/**
+ * @brief Resuelve el número de un conjunto de etiquetas, internándolo si hace falta.
+ *
+ * Si el número guardado todavía identifica un conjunto vigente, se devuelve sin mirar las etiquetas; si no (nunca se
+ * resolvió o el conjunto se liberó), se busca el conjunto por su texto o se agrega, y se guarda el número nuevo.
+ *
+ * @param labels Tabla.
+ * @param cached Número guardado por el colector (SERIES_NO_LABELS al principio); se actualiza.
+ * @param names Nombres de las etiquetas.
+ * @param values Valores de las etiquetas (sin escapar).
+ * @param count Cantidad de etiquetas.
+ * @return Número del conjunto, o SERIES_NO_LABELS si el texto es demasiado largo, la tabla está llena o falta
+ * memoria.
+ */
+unsigned int series_labels_resolve(series_labels_t* labels, unsigned int* cached, const char* const* names,
+                                   const char* const* values, size_t count);
+
+/**
+ * @brief Inicializa una familia sin series.
+ *
+ * @param family Familia a inicializar.
+ * @param labels Tabla de conjuntos de etiquetas del colector.
+ * @param name Nombre de la métrica.
+ * @param help Descripción de la métrica.
+ * @param counter 1 si es un contador entero, 0 si es un gauge.
+ * @param limit Series admitidas.
+ */
+void series_family_init(series_family_t* family, series_labels_t* labels, const char* name, const char* help,
+                        int counter, size_t limit);
+
+/**
+ * @brief Libera las series de una familia.
+ *
+ * @param family Familia.
+ */
+void series_family_destroy(series_family_t* family);
+
+/**
+ * @brief Actualiza el valor de una serie de un gauge, creándola si no existe y el límite lo permite.
+ *
+ * @param family Familia.
+ * @param labels Conjunto de etiquetas devuelto por series_labels_resolve().
+ * @param value Valor.
+ * @return 0 si se actualizó, -1 si la serie se descartó.
+ */
+int series_set(series_family_t* family, unsigned int labels, double value);
+
+/**
+ * @brief Actualiza el valor de una serie de un contador, creándola si no existe y el límite lo permite.
+ *
+ * @param family Familia.
+ * @param labels Conjunto de etiquetas devuelto por series_labels_resolve().
+ * @param count Valor.
+ * @return 0 si se actualizó, -1 si la serie se descartó.
+ */
+int series_set_count(series_family_t* family, unsigned int labels, unsigned long long count);
+
+/**
+ * @brief Quita las series que no se actualizaron en los últimos ciclos y renderiza las demás.
+ *
+ * Una familia sin series no se renderiza.
+ *
+ * @param family Familia.
+ * @param text Sección a la que se agregan la ayuda, el tipo y las muestras.
+ */
+void series_family_render(series_family_t* family, text_buf_t* text);
+
+#endif // SERIES_H
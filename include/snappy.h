@@ -0,0 +1,25 @@
+/**
+ * @file snappy.h
+ * @brief Compresor del formato de bloque de Snappy, el que exige el protocolo remote-write de Prometheus.
+ *
+ * Implementa sólo la compresión, con una búsqueda voraz de coincidencias de 4 bytes en una tabla hash: comprime menos
+ * que la biblioteca de Google pero produce bloques válidos para cualquier descompresor, sin dependencias externas.
+ */
+
+#ifndef SNAPPY_H
+#define SNAPPY_H
+
+#include "text_buf.h"
+#include <stddef.h>
+
+/**
+ * @brief Comprime un bloque y lo agrega a un buffer.
+ *
+ * @param in Datos a comprimir.
+ * @param len Longitud de los datos (menor que 4 GiB).
+ * @param out Buffer al que se agrega el bloque comprimido.
+ * @return 0 si se comprimió, -1 si falta memoria.
+ */
+int snappy_compress(const unsigned char* in, size_t len, text_buf_t* out);
+
+#endif // SNAPPY_H
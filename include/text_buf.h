@@ -0,0 +1,66 @@
+/**
+ * @file text_buf.h
+ * @brief Buffer de texto que crece a demanda, para armar secciones de la exposición de métricas.
+ *
+ * El buffer se reutiliza entre ciclos (text_buf_reset() sólo vuelve la longitud a 0), por lo que después de los
+ * primeros ciclos deja de reservar memoria.
+ */
+
+#ifndef TEXT_BUF_H
+#define TEXT_BUF_H
+
+#include <stddef.h>
+
+/**
+ * @brief Buffer de texto terminado en '\0'.
+ */
+typedef struct
+{
+    char* data; /**< Contenido, o NULL si todavía no se reservó. */
+    size_t len; /**< Longitud del contenido en bytes. */
+    size_t cap; /**< Capacidad reservada en bytes. */
+} text_buf_t;
+
+/**
+ * @brief Vacía el buffer conservando la memoria reservada.
+ *
+ * @param buf Buffer.
+ */
+void text_buf_reset(text_buf_t* buf);
+
+/**
+ * @brief Agrega texto al final del buffer.
+ *
+ * @param buf Buffer.
+ * @param str Texto a agregar.
+ * @param len Longitud del texto.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int text_buf_append(text_buf_t* buf, const char* str, size_t len);
+
+/**
+ * @brief Agrega texto con formato al final del buffer.
+ *
+ * @param buf Buffer.
+ * @param fmt Formato, como en printf().
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int text_buf_printf(text_buf_t* buf, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Agrega el valor de una etiqueta escapado según el formato de exposición (\\, " y salto de línea).
+ *
+ * @param buf Buffer.
+ * @param value Valor de la etiqueta.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int text_buf_append_label_value(text_buf_t* buf, const char* value);
+
+/**
+ * @brief Libera la memoria del buffer.
+ *
+ * @param buf Buffer.
+ */
+void text_buf_free(text_buf_t* buf);
+
+#endif // TEXT_BUF_H
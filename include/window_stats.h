@@ -0,0 +1,117 @@
+/**
+ * @file window_stats.h
+ * @brief Estadísticas de una serie sobre una ventana deslizante de tiempo: mínimo, máximo, promedio y cuantiles.
+ *
+ * Un gauge sólo conserva el último valor, así que un scrape cada 5 o 15 s no ve los picos cortos entre scrapes. La
+ * ventana guarda las muestras de los últimos window_ms milisegundos y mantiene sus estadísticas en forma incremental,
+ * en O(1) amortizado por muestra:
+ *  - la suma, para el promedio;
+ *  - dos colas monótonas de muestras candidatas a mínimo y a máximo;
+ *  - un DDSketch del que se obtienen los cuantiles.
+ *
+ * La memoria es fija: si llegan más de WINDOW_STATS_MAX_SAMPLES muestras dentro de la ventana, se descartan las más
+ * viejas antes de que venzan. Por eso --window no admite ventanas más largas que WINDOW_STATS_MAX_SAMPLES períodos de
+ * los colectores que la alimentan.
+ */
+
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include "ddsketch.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Muestras que caben en una ventana.
+ */
+#define WINDOW_STATS_MAX_SAMPLES 256
+
+/**
+ * @brief Duración por defecto de la ventana, en milisegundos.
+ */
+#define WINDOW_STATS_DEFAULT_MS 15000
+
+/**
+ * @brief Ventana deslizante de una serie.
+ */
+typedef struct
+{
+    unsigned long window_ms;                      /**< Duración de la ventana. */
+    int64_t times[WINDOW_STATS_MAX_SAMPLES];      /**< Instante de cada muestra (ms, reloj monótono). */
+    double values[WINDOW_STATS_MAX_SAMPLES];      /**< Valor de cada muestra. */
+    uint64_t first;                               /**< Número de la muestra más vieja. */
+    uint64_t next;                                /**< Número de la próxima muestra. */
+    uint64_t min_queue[WINDOW_STATS_MAX_SAMPLES]; /**< Muestras con valores crecientes: la primera es el mínimo. */
+    uint64_t max_queue[WINDOW_STATS_MAX_SAMPLES]; /**< Muestras con valores decrecientes: la primera es el máximo. */
+    size_t min_head, min_len;                     /**< Comienzo y largo de min_queue (circular). */
+    size_t max_head, max_len;                     /**< Comienzo y largo de max_queue (circular). */
+    double sum;                                   /**< Suma de los valores de la ventana. */
+    ddsketch_t sketch;                            /**< Distribución de los valores de la ventana. */
+    pthread_mutex_t lock;                         /**< Serializa las muestras del colector y la lectura al publicar. */
+} window_stats_t;
+
+/**
+ * @brief Resumen de una ventana.
+ */
+typedef struct
+{
+    size_t count; /**< Muestras en la ventana. */
+    double min;   /**< Mínimo. */
+    double max;   /**< Máximo. */
+    double mean;  /**< Promedio. */
+    double p50;   /**< Mediana (error relativo DDSKETCH_RELATIVE_ACCURACY). */
+    double p95;   /**< Percentil 95. */
+    double p99;   /**< Percentil 99. */
+} window_summary_t;
+
+/**
+ * @brief Inicializa una ventana vacía.
+ *
+ * @param window Ventana.
+ * @param window_ms Duración de la ventana en milisegundos.
+ */
+void window_stats_init(window_stats_t* window, unsigned long window_ms);
+
+/**
+ * @brief Libera los recursos de una ventana.
+ *
+ * @param window Ventana inicializada.
+ */
+void window_stats_destroy(window_stats_t* window);
+
+/**
+ * @brief Agrega una muestra con el instante actual; los valores NaN se ignoran.
+ *
+ * @param window Ventana inicializada.
+ * @param value Valor de la muestra.
+ */
+void window_stats_add(window_stats_t* window, double value);
+
+/**
+ * @brief Agrega una muestra con un instante dado.
+ *
+ * @param window Ventana inicializada.
+ * @param now_ms Instante de la muestra (ms, reloj monótono, no decreciente).
+ * @param value Valor de la muestra.
+ */
+void window_stats_add_at(window_stats_t* window, int64_t now_ms, double value);
+
+/**
+ * @brief Resume las muestras de la ventana que termina en el instante actual.
+ *
+ * @param window Ventana inicializada.
+ * @param summary Resumen; count es 0 si la ventana está vacía.
+ */
+void window_stats_summary(window_stats_t* window, window_summary_t* summary);
+
+/**
+ * @brief Resume las muestras de la ventana que termina en un instante dado.
+ *
+ * @param window Ventana inicializada.
+ * @param now_ms Fin de la ventana (ms, reloj monótono).
+ * @param summary Resumen; count es 0 si la ventana está vacía.
+ */
+void window_stats_summary_at(window_stats_t* window, int64_t now_ms, window_summary_t* summary);
+
+#endif // WINDOW_STATS_H
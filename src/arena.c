@@ -0,0 +1,139 @@
+#include "../include/arena.h"
+#include <stdlib.h>
+
+/**
+ * @file arena.c
+ * @brief Implementación de la arena de memoria temporal.
+ */
+
+/**
+ * @brief Redondea un tamaño a la alineación de la arena.
+ * @param size Tamaño.
+ * @return Tamaño redondeado hacia arriba.
+ */
+static size_t arena_round(size_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/**
+ * @brief Encadena un bloque nuevo a la arena.
+ * @param arena Arena.
+ * @param size Bytes de datos del bloque.
+ * @return 0 si se reservó, -1 si falta memoria.
+ */
+static int arena_grow(arena_t* arena, size_t size)
+{
+    arena_block_t* block = malloc(arena_round(sizeof(arena_block_t)) + size);
+    if (block == NULL)
+    {
+        return -1;
+    }
+    block->prev = arena->head;
+    block->size = size;
+    block->used = 0;
+    arena->head = block;
+    arena->blocks++;
+    return 0;
+}
+
+/**
+ * @brief Reserva memoria en la arena.
+ * @param arena Arena.
+ * @param size Bytes a reservar.
+ * @return Memoria alineada, o NULL si falta memoria.
+ */
+void* arena_alloc(arena_t* arena, size_t size)
+{
+    size = arena_round(size > 0 ? size : 1);
+    if (arena->head == NULL || arena->head->size - arena->head->used < size)
+    {
+        // Cada bloque nuevo duplica al anterior para que un ciclo grande encadene pocos bloques
+        size_t block = arena->head != NULL ? arena->head->size * 2 : ARENA_MIN_BLOCK;
+        while (block < size)
+        {
+            block *= 2;
+        }
+        if (arena_grow(arena, block) != 0)
+        {
+            return NULL;
+        }
+    }
+
+    char* data = (char*)arena->head + arena_round(sizeof(arena_block_t)) + arena->head->used;
+    arena->head->used += size;
+    arena->used += size;
+    if (arena->used > arena->high_water)
+    {
+        arena->high_water = arena->used;
+    }
+    return data;
+}
+
+/**
+ * @brief Libera los bloques anteriores al que está en uso.
+ * @param arena Arena.
+ */
+static void arena_free_previous(arena_t* arena)
+{
+    arena_block_t* block = arena->head->prev;
+    while (block != NULL)
+    {
+        arena_block_t* prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    arena->head->prev = NULL;
+}
+
+/**
+ * @brief Libera de una vez todo lo reservado en la arena.
+ * @param arena Arena.
+ */
+void arena_reset(arena_t* arena)
+{
+    if (arena->head == NULL)
+    {
+        return;
+    }
+    if (arena->head->prev != NULL)
+    {
+        // El ciclo no entró en un bloque: se deja uno solo que alcance para el máximo, si se puede reservar
+        size_t size = arena->head->size;
+        while (size < arena->high_water)
+        {
+            size *= 2;
+        }
+        arena_free_previous(arena);
+        if (size > arena->head->size)
+        {
+            arena_block_t* old = arena->head;
+            arena->head = NULL;
+            if (arena_grow(arena, size) != 0)
+            {
+                arena->head = old;
+            }
+            else
+            {
+                free(old);
+            }
+        }
+    }
+    arena->head->used = 0;
+    arena->used = 0;
+}
+
+/**
+ * @brief Libera los bloques de la arena.
+ * @param arena Arena.
+ */
+void arena_destroy(arena_t* arena)
+{
+    if (arena->head != NULL)
+    {
+        arena_free_previous(arena);
+        free(arena->head);
+    }
+    arena->head = NULL;
+    arena->used = 0;
+}
@@ -0,0 +1,770 @@
+#include "../include/cgroup_stats.h"
+#include "../include/proc_reader.h"
+#include "../include/proc_scan.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @file cgroup_stats.c
+ * @brief Implementación de las estadísticas por cgroup.
+ */
+
+/**
+ * @brief Capacidad inicial de la tabla de cgroups.
+ */
+#define CGROUP_TABLE_INITIAL_CAPACITY 256
+
+/**
+ * @brief Tamaño del buffer de getdents64() con el que se recorre la jerarquía.
+ */
+#define CGROUP_DIRENTS_SIZE 16384
+
+/**
+ * @brief Eventos vigilados en cada directorio de cgroup.
+ *
+ * IN_CREATE e IN_MOVED_TO avisan de cgroups nuevos o renombrados en el directorio; la eliminación de un cgroup se
+ * detecta con IN_DELETE_SELF (e IN_IGNORED) sobre su propia vigilancia.
+ */
+#define CGROUP_WATCH_MASK (IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+/**
+ * @brief Nombres de los campos de memory.stat, en el orden de cgroup_memstat_t.
+ */
+static const char* const memstat_names[CGROUP_MEMSTAT_COUNT] = {
+    "anon", "file", "kernel_stack", "slab", "sock", "shmem", "file_mapped", "file_dirty", "file_writeback",
+};
+
+/**
+ * @brief Archivos de presión, en el orden de pressure_resource_t.
+ */
+static const char* const pressure_files[PRESSURE_RESOURCE_COUNT] = {"cpu.pressure", "memory.pressure",
+                                                                    "io.pressure"};
+
+/**
+ * @brief Obtiene el nombre de un campo de memory.stat.
+ * @param stat Campo.
+ * @return Nombre del campo.
+ */
+const char* cgroup_memstat_name(cgroup_memstat_t stat)
+{
+    return stat < CGROUP_MEMSTAT_COUNT ? memstat_names[stat] : "unknown";
+}
+
+/**
+ * @brief Calcula la posición inicial de sondeo para un descriptor de vigilancia.
+ * @param tree Jerarquía.
+ * @param wd Descriptor de vigilancia.
+ * @return Índice inicial dentro de la tabla.
+ */
+static size_t cgroup_hash(const cgroup_tree_t* tree, int wd)
+{
+    uint64_t key = (uint64_t)(unsigned int)wd * 0x9E3779B97F4A7C15ULL; // Hash multiplicativo de Fibonacci
+    return (size_t)(key >> 32) & (tree->capacity - 1);
+}
+
+/**
+ * @brief Reserva una tabla vacía de la capacidad indicada.
+ * @param tree Jerarquía.
+ * @param capacity Cantidad de entradas (potencia de 2).
+ * @return 0 si se reservó, -1 si falta memoria.
+ */
+static int cgroup_table_alloc(cgroup_tree_t* tree, size_t capacity)
+{
+    tree->slots = calloc(capacity, sizeof(cgroup_entry_t));
+    if (tree->slots == NULL)
+    {
+        return -1;
+    }
+    tree->capacity = capacity;
+    tree->used = 0;
+    tree->live = 0;
+    return 0;
+}
+
+/**
+ * @brief Reconstruye la tabla descartando las entradas borradas y, si hace falta, duplicando su capacidad.
+ * @param tree Jerarquía.
+ * @return 0 si se reconstruyó, -1 si falta memoria (la tabla anterior queda intacta).
+ */
+static int cgroup_table_rehash(cgroup_tree_t* tree)
+{
+    cgroup_entry_t* old = tree->slots;
+    size_t old_capacity = tree->capacity;
+    size_t capacity = tree->live * 2 >= old_capacity ? old_capacity * 2 : old_capacity;
+
+    if (cgroup_table_alloc(tree, capacity) != 0)
+    {
+        tree->slots = old;
+        tree->capacity = old_capacity;
+        return -1;
+    }
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i].state != CGROUP_SLOT_USED)
+        {
+            continue;
+        }
+        size_t j = cgroup_hash(tree, old[i].wd);
+        while (tree->slots[j].state != CGROUP_SLOT_EMPTY)
+        {
+            j = (j + 1) & (tree->capacity - 1);
+        }
+        tree->slots[j] = old[i];
+        tree->used++;
+        tree->live++;
+    }
+
+    free(old);
+    return 0;
+}
+
+/**
+ * @brief Busca un cgroup por su descriptor de vigilancia.
+ * @param tree Jerarquía.
+ * @param wd Descriptor de vigilancia.
+ * @return Entrada del cgroup, o NULL si no está en la tabla.
+ */
+static cgroup_entry_t* cgroup_lookup(cgroup_tree_t* tree, int wd)
+{
+    size_t i = cgroup_hash(tree, wd);
+    while (tree->slots[i].state != CGROUP_SLOT_EMPTY)
+    {
+        if (tree->slots[i].state == CGROUP_SLOT_USED && tree->slots[i].wd == wd)
+        {
+            return &tree->slots[i];
+        }
+        i = (i + 1) & (tree->capacity - 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Obtiene la entrada de un descriptor de vigilancia, agregándola si es nueva.
+ *
+ * Vigilar dos veces el mismo directorio devuelve el mismo descriptor, por lo que un cgroup descubierto por un evento
+ * y por un recorrido no se duplica.
+ *
+ * @param tree Jerarquía.
+ * @param wd Descriptor de vigilancia.
+ * @return Entrada del cgroup (válida hasta la próxima inserción), o NULL si falta memoria.
+ */
+static cgroup_entry_t* cgroup_insert(cgroup_tree_t* tree, int wd)
+{
+    cgroup_entry_t* entry = cgroup_lookup(tree, wd);
+    if (entry != NULL)
+    {
+        return entry;
+    }
+
+    // Mantenemos el factor de carga (incluyendo borrados) por debajo de 3/4
+    if ((tree->used + 1) * 4 > tree->capacity * 3 && cgroup_table_rehash(tree) != 0)
+    {
+        return NULL;
+    }
+
+    size_t i = cgroup_hash(tree, wd);
+    while (tree->slots[i].state == CGROUP_SLOT_USED)
+    {
+        i = (i + 1) & (tree->capacity - 1);
+    }
+    entry = &tree->slots[i];
+    if (entry->state == CGROUP_SLOT_EMPTY)
+    {
+        tree->used++;
+    }
+    memset(entry, 0, sizeof(*entry));
+    entry->state = CGROUP_SLOT_USED;
+    entry->wd = wd;
+    tree->live++;
+    return entry;
+}
+
+/**
+ * @brief Quita un cgroup de la tabla.
+ * @param tree Jerarquía.
+ * @param entry Entrada a quitar.
+ */
+static void cgroup_remove(cgroup_tree_t* tree, cgroup_entry_t* entry)
+{
+    free(entry->path);
+    entry->path = NULL;
+    entry->state = CGROUP_SLOT_DELETED;
+    tree->live--;
+}
+
+/**
+ * @brief Directorio pendiente del recorrido de la jerarquía, reservado en la memoria temporal.
+ */
+typedef struct cgroup_walk_node
+{
+    struct cgroup_walk_node* next; /**< Siguiente directorio de la cola. */
+    unsigned int depth;            /**< Profundidad del directorio. */
+    char rel[];                    /**< Ruta relativa a la raíz ("" para la raíz). */
+} cgroup_walk_node_t;
+
+/**
+ * @brief Reserva un directorio pendiente con la ruta de un hijo.
+ * @param scratch Memoria temporal.
+ * @param parent Ruta relativa del padre.
+ * @param name Nombre del hijo ("" para el propio padre).
+ * @param depth Profundidad del directorio.
+ * @return Directorio pendiente, o NULL si falta memoria.
+ */
+static cgroup_walk_node_t* cgroup_walk_node(arena_t* scratch, const char* parent, const char* name,
+                                            unsigned int depth)
+{
+    size_t parent_len = strlen(parent), name_len = strlen(name);
+    size_t sep = parent_len > 0 && name_len > 0 ? 1 : 0;
+    cgroup_walk_node_t* node = arena_alloc(scratch, sizeof(*node) + parent_len + sep + name_len + 1);
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    node->next = NULL;
+    node->depth = depth;
+    memcpy(node->rel, parent, parent_len);
+    node->rel[parent_len] = '/';
+    memcpy(node->rel + parent_len + sep, name, name_len + 1);
+    return node;
+}
+
+/**
+ * @brief Vigila un directorio de cgroup y lo agrega a la tabla (o actualiza su ruta si se renombró).
+ * @param tree Jerarquía.
+ * @param rel Ruta relativa a la raíz ("" para la raíz).
+ * @param depth Profundidad del directorio.
+ * @return 1 si se agregó y corresponde recorrer sus subdirectorios, 0 si ya no existe o no se pudo vigilar, -1 si
+ * falta memoria.
+ */
+static int cgroup_watch(cgroup_tree_t* tree, const char* rel, unsigned int depth)
+{
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", tree->root, rel) >= (int)sizeof(path))
+    {
+        return 0;
+    }
+
+    int wd = inotify_add_watch(tree->inotify_fd, path, CGROUP_WATCH_MASK);
+    if (wd < 0)
+    {
+        // ENOENT: el cgroup se eliminó antes de vigilarlo. ENOSPC: se agotó fs.inotify.max_user_watches
+        if (errno == ENOSPC && !tree->watch_limit_reported)
+        {
+            fprintf(stderr, "Límite de vigilancias de inotify alcanzado: no se exportarán todos los cgroups\n");
+            tree->watch_limit_reported = 1;
+        }
+        return 0;
+    }
+
+    cgroup_entry_t* entry = cgroup_insert(tree, wd);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+    if (entry->path == NULL || strcmp(entry->path, rel) != 0)
+    {
+        // Cgroup nuevo, o renombrado (la vigilancia sigue al directorio y conserva el descriptor)
+        char* copy = strdup(rel);
+        if (copy == NULL)
+        {
+            return -1;
+        }
+        free(entry->path);
+        entry->path = copy;
+    }
+    entry->depth = depth;
+    entry->generation = tree->generation;
+    return tree->max_depth == 0 || depth < tree->max_depth;
+}
+
+/**
+ * @brief Vigila un directorio de cgroup y todos sus subdirectorios.
+ *
+ * El árbol se recorre a lo ancho con una cola en la memoria temporal (las rutas pendientes y el buffer de
+ * getdents64()), sin recursión ni un buffer de PATH_MAX por nivel.
+ *
+ * @param tree Jerarquía.
+ * @param rel Ruta relativa a la raíz ("" para la raíz).
+ * @param depth Profundidad del directorio.
+ * @param scratch Memoria temporal del recorrido.
+ * @return 0 si se agregó o el directorio ya no existe, -1 si falta memoria.
+ */
+static int cgroup_add_subtree(cgroup_tree_t* tree, const char* rel, unsigned int depth, arena_t* scratch)
+{
+    char* dirents = arena_alloc(scratch, CGROUP_DIRENTS_SIZE);
+    cgroup_walk_node_t* tail = cgroup_walk_node(scratch, rel, "", depth);
+    if (dirents == NULL || tail == NULL)
+    {
+        return -1;
+    }
+
+    for (cgroup_walk_node_t* node = tail; node != NULL; node = node->next)
+    {
+        int ret = cgroup_watch(tree, node->rel, node->depth);
+        if (ret <= 0)
+        {
+            if (ret < 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        // Los subdirectorios pudieron crearse antes de que empezáramos a vigilar éste, así que se recorren siempre
+        int fd = openat(tree->root_fd, node->rel[0] != '\0' ? node->rel : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            continue;
+        }
+        size_t rel_len = strlen(node->rel);
+        long n;
+        while ((n = syscall(SYS_getdents64, fd, dirents, CGROUP_DIRENTS_SIZE)) > 0)
+        {
+            for (long pos = 0; pos < n;)
+            {
+                const struct linux_dirent64* dirent = (const struct linux_dirent64*)(dirents + pos);
+                pos += dirent->d_reclen;
+                if ((dirent->d_type != DT_DIR && dirent->d_type != DT_UNKNOWN) || strcmp(dirent->d_name, ".") == 0 ||
+                    strcmp(dirent->d_name, "..") == 0 || rel_len + 1 + strlen(dirent->d_name) >= PATH_MAX)
+                {
+                    continue;
+                }
+                cgroup_walk_node_t* child = cgroup_walk_node(scratch, node->rel, dirent->d_name, node->depth + 1);
+                if (child == NULL)
+                {
+                    close(fd);
+                    return -1;
+                }
+                tail->next = child;
+                tail = child;
+            }
+        }
+        close(fd);
+    }
+    return 0;
+}
+
+/**
+ * @brief Recorre la jerarquía completa y quita los cgroups que ya no existen.
+ * @param tree Jerarquía.
+ * @param scratch Memoria temporal del recorrido.
+ * @return 0 si se recorrió, -1 si falta memoria.
+ */
+static int cgroup_tree_resync(cgroup_tree_t* tree, arena_t* scratch)
+{
+    tree->generation++;
+    if (cgroup_add_subtree(tree, "", 0, scratch) != 0)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < tree->capacity; i++)
+    {
+        cgroup_entry_t* entry = &tree->slots[i];
+        if (entry->state == CGROUP_SLOT_USED && entry->generation != tree->generation)
+        {
+            inotify_rm_watch(tree->inotify_fd, entry->wd);
+            cgroup_remove(tree, entry);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Inicializa la jerarquía y vigila cada directorio con inotify.
+ * @param tree Jerarquía a inicializar.
+ * @param root Punto de montaje de cgroup v2.
+ * @param max_depth Profundidad máxima de los cgroups exportados (0: sin límite).
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int cgroup_tree_init(cgroup_tree_t* tree, const char* root, unsigned int max_depth)
+{
+    memset(tree, 0, sizeof(*tree));
+    tree->root_fd = -1;
+    tree->inotify_fd = -1;
+    tree->max_depth = max_depth;
+
+    tree->root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (tree->root_fd < 0)
+    {
+        fprintf(stderr, "Error al abrir %s: %s\n", root, strerror(errno));
+        return -1;
+    }
+    // Sólo la jerarquía unificada (cgroup v2) tiene cgroup.controllers en la raíz
+    if (faccessat(tree->root_fd, "cgroup.controllers", R_OK, 0) != 0)
+    {
+        fprintf(stderr, "%s no es una jerarquía cgroup v2\n", root);
+        cgroup_tree_destroy(tree);
+        return -1;
+    }
+
+    tree->root = strdup(root);
+    tree->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (tree->inotify_fd < 0)
+    {
+        perror("Error al inicializar inotify");
+    }
+    if (tree->root == NULL || tree->inotify_fd < 0 || cgroup_table_alloc(tree, CGROUP_TABLE_INITIAL_CAPACITY) != 0)
+    {
+        cgroup_tree_destroy(tree);
+        return -1;
+    }
+
+    // El primer recorrido no ocurre dentro de una ejecución del colector: usa su propia memoria temporal
+    arena_t scratch = {0};
+    int ret = cgroup_tree_resync(tree, &scratch);
+    arena_destroy(&scratch);
+    if (ret != 0)
+    {
+        cgroup_tree_destroy(tree);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Deja de vigilar la jerarquía y libera la tabla.
+ * @param tree Jerarquía a liberar.
+ */
+void cgroup_tree_destroy(cgroup_tree_t* tree)
+{
+    for (size_t i = 0; i < tree->capacity; i++)
+    {
+        free(tree->slots[i].path);
+    }
+    free(tree->slots);
+    free(tree->root);
+
+    // Cerrar el descriptor de inotify quita todas las vigilancias
+    if (tree->inotify_fd >= 0)
+    {
+        close(tree->inotify_fd);
+    }
+    if (tree->root_fd >= 0)
+    {
+        close(tree->root_fd);
+    }
+    memset(tree, 0, sizeof(*tree));
+    tree->root_fd = -1;
+    tree->inotify_fd = -1;
+}
+
+/**
+ * @brief Aplica un evento de inotify a la tabla.
+ * @param tree Jerarquía.
+ * @param event Evento leído.
+ * @param scratch Memoria temporal del recorrido.
+ * @return 0 si se aplicó, -1 si falta memoria.
+ */
+static int cgroup_apply_event(cgroup_tree_t* tree, const struct inotify_event* event, arena_t* scratch)
+{
+    if (event->mask & (IN_DELETE_SELF | IN_IGNORED))
+    {
+        // El cgroup se eliminó; IN_IGNORED llega después de IN_DELETE_SELF y ya no encuentra la entrada
+        cgroup_entry_t* entry = cgroup_lookup(tree, event->wd);
+        if (entry != NULL)
+        {
+            cgroup_remove(tree, entry);
+        }
+        return 0;
+    }
+    if (!(event->mask & IN_ISDIR) || event->len == 0)
+    {
+        return 0;
+    }
+
+    // Cgroup creado (o renombrado) dentro de un directorio vigilado
+    const cgroup_entry_t* parent = cgroup_lookup(tree, event->wd);
+    if (parent == NULL || (tree->max_depth != 0 && parent->depth >= tree->max_depth))
+    {
+        return 0;
+    }
+    if (strlen(parent->path) + 1 + strlen(event->name) >= PATH_MAX)
+    {
+        return 0;
+    }
+    cgroup_walk_node_t* child = cgroup_walk_node(scratch, parent->path, event->name, parent->depth + 1);
+    if (child == NULL)
+    {
+        return -1;
+    }
+    return cgroup_add_subtree(tree, child->rel, child->depth, scratch);
+}
+
+/**
+ * @brief Aplica los cambios de la jerarquía notificados por inotify desde la última llamada.
+ * @param tree Jerarquía.
+ * @param scratch Memoria temporal de los recorridos.
+ * @return Cantidad de eventos procesados, o -1 en caso de error.
+ */
+int cgroup_tree_refresh(cgroup_tree_t* tree, arena_t* scratch)
+{
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int processed = 0, overflow = 0;
+
+    while (1)
+    {
+        ssize_t n = read(tree->inotify_fd, events, sizeof(events));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN)
+            {
+                break;
+            }
+            perror("Error al leer los eventos de inotify");
+            return -1;
+        }
+        for (char* pos = events; pos < events + n;)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)pos;
+            pos += sizeof(struct inotify_event) + event->len;
+            processed++;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = 1;
+            }
+            else if (cgroup_apply_event(tree, event, scratch) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    // Si se perdieron eventos no sabemos qué cambió: volvemos a recorrer el árbol completo
+    if (overflow && cgroup_tree_resync(tree, scratch) != 0)
+    {
+        return -1;
+    }
+    return processed;
+}
+
+/**
+ * @brief Lee un archivo de un cgroup.
+ * @param tree Jerarquía (aporta el descriptor de la raíz y el buffer).
+ * @param entry Cgroup.
+ * @param name Nombre del archivo.
+ * @param len Cantidad de bytes leídos.
+ * @return 0 si se leyó (aunque esté vacío), -1 si el archivo no existe (controlador deshabilitado) o no se pudo leer.
+ */
+static int read_cgroup_file(cgroup_tree_t* tree, const cgroup_entry_t* entry, const char* name, size_t* len)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s%s", entry->path, entry->path[0] != '\0' ? "/" : "", name);
+    int fd = openat(tree->root_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    // io.stat queda vacío mientras el cgroup no haga I/O, así que un archivo vacío también es una lectura válida
+    ssize_t n = 0;
+    *len = 0;
+    while (*len < sizeof(tree->file_buf) - 1 &&
+           (n = read(fd, tree->file_buf + *len, sizeof(tree->file_buf) - 1 - *len)) > 0)
+    {
+        *len += (size_t)n;
+    }
+    close(fd);
+    tree->file_buf[*len] = '\0';
+    return n < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Analiza el contenido de cpu.stat.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar.
+ * @return 0 si se encontró usage_usec, -1 en caso contrario.
+ */
+int parse_cgroup_cpu_stat(const char* buf, size_t len, cgroup_sample_t* sample)
+{
+    const struct
+    {
+        const char* key;
+        unsigned long long* value;
+        unsigned int flag;
+    } fields[] = {
+        {"usage_usec", &sample->usage_usec, CGROUP_HAS_CPU},
+        {"user_usec", &sample->user_usec, 0},
+        {"system_usec", &sample->system_usec, 0},
+        {"nr_periods", &sample->nr_periods, CGROUP_HAS_THROTTLING},
+        {"nr_throttled", &sample->nr_throttled, 0},
+        {"throttled_usec", &sample->throttled_usec, 0},
+    };
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        if (!scan_token(&line, '\0', &key, &key_len))
+        {
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        {
+            if (scan_token_equals(key, key_len, fields[i].key) && scan_u64(&line, fields[i].value))
+            {
+                sample->flags |= fields[i].flag;
+                break;
+            }
+        }
+    }
+    return (sample->flags & CGROUP_HAS_CPU) ? 0 : -1;
+}
+
+/**
+ * @brief Analiza el contenido de memory.stat.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar.
+ * @return 0 si se interpretó, -1 si el archivo no tiene ningún campo conocido.
+ */
+int parse_cgroup_memory_stat(const char* buf, size_t len, cgroup_sample_t* sample)
+{
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+    int found = 0;
+
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        if (!scan_token(&line, '\0', &key, &key_len))
+        {
+            continue;
+        }
+        if (scan_token_equals(key, key_len, "pgfault"))
+        {
+            found += scan_u64(&line, &sample->pgfault);
+            continue;
+        }
+        if (scan_token_equals(key, key_len, "pgmajfault"))
+        {
+            found += scan_u64(&line, &sample->pgmajfault);
+            continue;
+        }
+        for (int i = 0; i < CGROUP_MEMSTAT_COUNT; i++)
+        {
+            if (scan_token_equals(key, key_len, memstat_names[i]))
+            {
+                found += scan_u64(&line, &sample->memory_stat[i]);
+                break;
+            }
+        }
+    }
+    return found > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Analiza el contenido de io.stat, sumando los contadores de todos los dispositivos.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar.
+ */
+void parse_cgroup_io_stat(const char* buf, size_t len, cgroup_sample_t* sample)
+{
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+    unsigned long long value;
+
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        // El primer campo es el dispositivo ("8:0"); el resto son pares clave=valor
+        if (!scan_token(&line, '\0', &key, &key_len))
+        {
+            continue;
+        }
+        while (scan_token(&line, '=', &key, &key_len))
+        {
+            if (!scan_u64(&line, &value))
+            {
+                continue;
+            }
+            if (scan_token_equals(key, key_len, "rbytes"))
+            {
+                sample->io_rbytes += value;
+            }
+            else if (scan_token_equals(key, key_len, "wbytes"))
+            {
+                sample->io_wbytes += value;
+            }
+            else if (scan_token_equals(key, key_len, "rios"))
+            {
+                sample->io_rios += value;
+            }
+            else if (scan_token_equals(key, key_len, "wios"))
+            {
+                sample->io_wios += value;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Lee los archivos de estadísticas de todos los cgroups vigilados.
+ * @param tree Jerarquía.
+ */
+void cgroup_tree_read(cgroup_tree_t* tree)
+{
+    size_t len;
+
+    for (size_t i = 0; i < tree->capacity; i++)
+    {
+        cgroup_entry_t* entry = &tree->slots[i];
+        if (entry->state != CGROUP_SLOT_USED)
+        {
+            continue;
+        }
+
+        // Cada archivo falta si su controlador no está habilitado en el cgroup (o, en la raíz, si no existe)
+        cgroup_sample_t* sample = &entry->sample;
+        memset(sample, 0, sizeof(*sample));
+        if (read_cgroup_file(tree, entry, "cpu.stat", &len) == 0)
+        {
+            parse_cgroup_cpu_stat(tree->file_buf, len, sample);
+        }
+        if (read_cgroup_file(tree, entry, "memory.current", &len) == 0)
+        {
+            proc_scanner_t line;
+            scan_init(&line, tree->file_buf, len);
+            if (scan_u64(&line, &sample->memory_current))
+            {
+                sample->flags |= CGROUP_HAS_MEMORY;
+            }
+        }
+        if (read_cgroup_file(tree, entry, "memory.stat", &len) == 0 &&
+            parse_cgroup_memory_stat(tree->file_buf, len, sample) == 0)
+        {
+            sample->flags |= CGROUP_HAS_MEMORY_STAT;
+        }
+        if (read_cgroup_file(tree, entry, "io.stat", &len) == 0)
+        {
+            parse_cgroup_io_stat(tree->file_buf, len, sample);
+            sample->flags |= CGROUP_HAS_IO;
+        }
+        for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+        {
+            if (read_cgroup_file(tree, entry, pressure_files[r], &len) == 0)
+            {
+                parse_pressure(tree->file_buf, len, &sample->pressure[r]);
+            }
+        }
+    }
+}
@@ -0,0 +1,767 @@
+#include "../include/collector.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @file collector.c
+ * @brief Implementación del registro y la planificación de colectores.
+ */
+
+/**
+ * @brief Límites de los histogramas de duración de los colectores, en nanosegundos (de 100 µs a 2,5 s).
+ */
+static const unsigned long long collector_duration_bounds_ns[] = {
+    100000ULL,   250000ULL,   500000ULL,    1000000ULL,   2500000ULL,   5000000ULL,    10000000ULL,
+    25000000ULL, 50000000ULL, 100000000ULL, 250000000ULL, 500000000ULL, 1000000000ULL, 2500000000ULL,
+};
+
+/**
+ * @brief Indica si un instante es anterior a otro.
+ * @param a Instante.
+ * @param b Instante.
+ * @return 1 si a es anterior a b, 0 en caso contrario.
+ */
+static int timespec_before(const struct timespec* a, const struct timespec* b)
+{
+    return a->tv_sec != b->tv_sec ? a->tv_sec < b->tv_sec : a->tv_nsec < b->tv_nsec;
+}
+
+/**
+ * @brief Suma milisegundos a un instante.
+ * @param ts Instante; se actualiza.
+ * @param ms Milisegundos a sumar.
+ */
+static void timespec_add_ms(struct timespec* ts, unsigned long ms)
+{
+    ts->tv_sec += (time_t)(ms / 1000);
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Calcula el tiempo transcurrido entre dos instantes.
+ * @param start Instante inicial.
+ * @param end Instante final.
+ * @return Nanosegundos transcurridos (0 si end es anterior a start).
+ */
+static unsigned long long timespec_diff_ns(const struct timespec* start, const struct timespec* end)
+{
+    long long ns = (long long)(end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+    return ns > 0 ? (unsigned long long)ns : 0;
+}
+
+/**
+ * @brief Indica si un colector debe ejecutarse antes que otro.
+ * @param a Colector.
+ * @param b Colector.
+ * @return 1 si la próxima ejecución de a es anterior a la de b, 0 en caso contrario.
+ */
+static int collector_before(const collector_t* a, const collector_t* b)
+{
+    return timespec_before(&a->schedule.next, &b->schedule.next);
+}
+
+/**
+ * @brief Hace subir una entrada del montículo hasta su posición.
+ * @param registry Registro.
+ * @param i Posición de la entrada.
+ */
+static void heap_sift_up(collector_registry_t* registry, size_t i)
+{
+    collector_t* item = registry->heap[i];
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if (!collector_before(item, registry->heap[parent]))
+        {
+            break;
+        }
+        registry->heap[i] = registry->heap[parent];
+        i = parent;
+    }
+    registry->heap[i] = item;
+}
+
+/**
+ * @brief Hace bajar una entrada del montículo hasta su posición.
+ * @param registry Registro.
+ * @param i Posición de la entrada.
+ */
+static void heap_sift_down(collector_registry_t* registry, size_t i)
+{
+    collector_t* item = registry->heap[i];
+    while (1)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= registry->heap_len)
+        {
+            break;
+        }
+        if (child + 1 < registry->heap_len && collector_before(registry->heap[child + 1], registry->heap[child]))
+        {
+            child++;
+        }
+        if (!collector_before(registry->heap[child], item))
+        {
+            break;
+        }
+        registry->heap[i] = registry->heap[child];
+        i = child;
+    }
+    registry->heap[i] = item;
+}
+
+/**
+ * @brief Inicializa un registro vacío.
+ * @param registry Registro a inicializar.
+ */
+void collector_registry_init(collector_registry_t* registry)
+{
+    memset(registry, 0, sizeof(*registry));
+    registry->worker_count = COLLECTOR_DEFAULT_WORKERS;
+    registry->deadline_ms = COLLECTOR_DEFAULT_DEADLINE_MS;
+}
+
+/**
+ * @brief Registra un colector.
+ * @param registry Registro.
+ * @param collector Descripción del colector.
+ * @return 0 si se registró, -1 si el registro está lleno.
+ */
+int collector_register(collector_registry_t* registry, const collector_t* collector)
+{
+    if (registry->count == COLLECTOR_MAX)
+    {
+        fprintf(stderr, "No hay lugar para registrar el colector %s\n", collector->name);
+        return -1;
+    }
+    collector_t* slot = &registry->collectors[registry->count++];
+    *slot = *collector;
+    slot->initialized = 0;
+
+    // El histograma, los errores y la memoria temporal se inicializan acá y no al iniciar: un colector habilitado al
+    // recargar la configuración también los necesita
+    histogram_init(&slot->duration, collector_duration_bounds_ns,
+                   sizeof(collector_duration_bounds_ns) / sizeof(collector_duration_bounds_ns[0]), 1e-9);
+    atomic_init(&slot->errors, 0);
+    memset(&slot->scratch, 0, sizeof(slot->scratch));
+    atomic_init(&slot->scratch_peak, 0);
+    atomic_init(&slot->scratch_blocks, 0);
+    return 0;
+}
+
+/**
+ * @brief Busca un colector por nombre.
+ * @param registry Registro.
+ * @param name Nombre del colector.
+ * @return Colector, o NULL si no existe.
+ */
+collector_t* collector_find(collector_registry_t* registry, const char* name)
+{
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        if (strcmp(registry->collectors[i].name, name) == 0)
+        {
+            return &registry->collectors[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Aplica una opción "NOMBRE=on", "NOMBRE=off" o "NOMBRE=MS".
+ * @param registry Registro.
+ * @param spec Opción a aplicar.
+ * @return 0 si se aplicó, -1 en caso contrario.
+ */
+int collector_configure(collector_registry_t* registry, const char* spec)
+{
+    char name[32];
+    const char* value = strchr(spec, '=');
+    size_t name_len = value != NULL ? (size_t)(value - spec) : 0;
+    if (value == NULL || name_len == 0 || name_len >= sizeof(name))
+    {
+        fprintf(stderr, "Opción de colector inválida (se espera NOMBRE=on|off|MS): %s\n", spec);
+        return -1;
+    }
+    memcpy(name, spec, name_len);
+    name[name_len] = '\0';
+    value++;
+
+    collector_t* collector = collector_find(registry, name);
+    if (collector == NULL)
+    {
+        fprintf(stderr, "Colector desconocido: %s\n", name);
+        return -1;
+    }
+    if (strcmp(value, "on") == 0)
+    {
+        collector->enabled = 1;
+        return 0;
+    }
+    if (strcmp(value, "off") == 0)
+    {
+        collector->enabled = 0;
+        return 0;
+    }
+
+    char* end;
+    errno = 0;
+    unsigned long interval_ms = strtoul(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || errno != 0 || interval_ms < SAMPLER_MIN_INTERVAL_MS)
+    {
+        fprintf(stderr, "Período inválido para el colector %s: %s (mínimo: %d ms)\n", name, value,
+                SAMPLER_MIN_INTERVAL_MS);
+        return -1;
+    }
+    collector->enabled = 1;
+    collector->interval_ms = interval_ms;
+    return 0;
+}
+
+/**
+ * @brief Escribe la lista de colectores.
+ * @param registry Registro.
+ * @param out Destino.
+ */
+void collector_registry_print(const collector_registry_t* registry, FILE* out)
+{
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        const collector_t* collector = &registry->collectors[i];
+        fprintf(out, "  %-10s %-4s %s\n", collector->name, collector->enabled ? "on" : "off", collector->help);
+    }
+}
+
+/**
+ * @brief Cuerpo de los hilos que ejecutan los colectores.
+ * @param arg Registro (collector_registry_t*).
+ * @return NULL.
+ */
+static void* collector_worker(void* arg)
+{
+    collector_registry_t* registry = arg;
+
+    pthread_mutex_lock(&registry->lock);
+    while (1)
+    {
+        while (registry->queue_len == 0 && !registry->stopping)
+        {
+            pthread_cond_wait(&registry->work_ready, &registry->lock);
+        }
+        if (registry->queue_len == 0)
+        {
+            break;
+        }
+        collector_t* collector = registry->queue[registry->queue_head];
+        registry->queue_head = (registry->queue_head + 1) % COLLECTOR_MAX;
+        registry->queue_len--;
+        pthread_mutex_unlock(&registry->lock);
+
+        // Se mide con el reloj monotónico, fuera del mutex, y se registra con operaciones atómicas
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int err = collector->collect(&collector->scratch);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        histogram_observe(&collector->duration, timespec_diff_ns(&start, &end));
+        if (err != 0)
+        {
+            atomic_fetch_add_explicit(&collector->errors, 1, memory_order_relaxed);
+        }
+
+        // La memoria temporal se descarta antes de marcar el colector como libre; el hilo recolector lee los máximos
+        arena_reset(&collector->scratch);
+        atomic_store_explicit(&collector->scratch_peak, collector->scratch.high_water, memory_order_relaxed);
+        atomic_store_explicit(&collector->scratch_blocks, collector->scratch.blocks, memory_order_relaxed);
+
+        pthread_mutex_lock(&registry->lock);
+        collector->busy = 0;
+        pthread_cond_broadcast(&registry->work_done);
+    }
+    pthread_mutex_unlock(&registry->lock);
+    return NULL;
+}
+
+/**
+ * @brief Crea el mutex, las condiciones y los hilos del registro.
+ * @param registry Registro.
+ * @return 0 si se creó al menos un hilo, -1 en caso contrario.
+ */
+static int collector_pool_start(collector_registry_t* registry)
+{
+    pthread_condattr_t attr;
+
+    // work_done se espera con un plazo absoluto sobre el mismo reloj que la planificación
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&registry->lock, NULL);
+    pthread_cond_init(&registry->work_ready, NULL);
+    pthread_cond_init(&registry->work_done, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // Los hilos heredan la máscara: con todas las señales bloqueadas, las del programa sólo llegan al recolector
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    unsigned int count = registry->worker_count < COLLECTOR_MAX_WORKERS ? registry->worker_count
+                                                                         : COLLECTOR_MAX_WORKERS;
+    for (registry->workers_started = 0; registry->workers_started < count; registry->workers_started++)
+    {
+        if (pthread_create(&registry->workers[registry->workers_started], NULL, collector_worker, registry) != 0)
+        {
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (registry->workers_started == 0)
+    {
+        fprintf(stderr, "Error al crear los hilos de los colectores\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Inicializa los colectores habilitados, crea los hilos y programa la primera ejecución.
+ * @param registry Registro.
+ * @param default_interval_ms Período de los colectores sin período propio.
+ * @return 0 si todos se inicializaron, -1 en caso contrario.
+ */
+int collector_registry_start(collector_registry_t* registry, unsigned long default_interval_ms)
+{
+    registry->heap_len = 0;
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        collector_t* collector = &registry->collectors[i];
+        if (!collector->enabled)
+        {
+            continue;
+        }
+        unsigned long interval_ms = collector->interval_ms != 0 ? collector->interval_ms : default_interval_ms;
+        if (sampler_init(&collector->schedule, interval_ms) != 0)
+        {
+            return -1;
+        }
+
+        // Un plazo mayor que el período dejaría al colector ocupado cuando vuelve a vencer
+        if (collector->deadline_ms == 0)
+        {
+            collector->deadline_ms = registry->deadline_ms;
+        }
+        if (collector->deadline_ms > interval_ms)
+        {
+            collector->deadline_ms = interval_ms;
+        }
+        if (collector->init != NULL && collector->init() != 0)
+        {
+            fprintf(stderr, "Error al inicializar el colector %s\n", collector->name);
+            return -1;
+        }
+        collector->initialized = 1;
+
+        // Todos empiezan en el instante actual: el primer ciclo recolecta todo
+        registry->heap[registry->heap_len] = collector;
+        heap_sift_up(registry, registry->heap_len++);
+    }
+    if (registry->heap_len == 0)
+    {
+        fprintf(stderr, "No hay colectores habilitados\n");
+        return -1;
+    }
+    return collector_pool_start(registry);
+}
+
+/**
+ * @brief Espera hasta la próxima ejecución de algún colector.
+ * @param registry Registro iniciado.
+ * @return 0 al llegar el instante, -1 si la espera fue interrumpida por una señal.
+ */
+int collector_registry_wait(collector_registry_t* registry)
+{
+    // Con TIMER_ABSTIME, volver a esperar tras una señal no alarga la espera
+    int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &registry->heap[0]->schedule.next, NULL);
+    if (err == EINTR)
+    {
+        return -1;
+    }
+    if (err != 0)
+    {
+        fprintf(stderr, "Error en clock_nanosleep: %s\n", strerror(err));
+    }
+    return 0;
+}
+
+/**
+ * @brief Marca un colector como vencido sin resultado nuevo.
+ * @param collector Colector.
+ */
+static void collector_timed_out(collector_t* collector)
+{
+    collector->stale = 1;
+    collector->timeouts++;
+}
+
+/**
+ * @brief Lanza un grupo de colectores en los hilos y espera a cada uno hasta su plazo.
+ * @param registry Registro iniciado.
+ * @param batch Colectores a lanzar.
+ * @param count Cantidad de colectores.
+ * @param count_busy 1 si un colector todavía ocupado con la ejecución anterior cuenta como vencido.
+ */
+static void collector_dispatch(collector_registry_t* registry, collector_t** batch, size_t count, int count_busy)
+{
+    collector_t* pending[COLLECTOR_MAX];
+    size_t waiting = 0;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    pthread_mutex_lock(&registry->lock);
+    for (size_t i = 0; i < count; i++)
+    {
+        collector_t* collector = batch[i];
+        if (collector->busy)
+        {
+            // La ejecución anterior sigue colgada: no se encola otra encima
+            if (count_busy)
+            {
+                collector_timed_out(collector);
+            }
+            continue;
+        }
+        collector->busy = 1;
+        collector->deadline = now;
+        timespec_add_ms(&collector->deadline, collector->deadline_ms);
+        registry->queue[(registry->queue_head + registry->queue_len) % COLLECTOR_MAX] = collector;
+        registry->queue_len++;
+        pending[waiting++] = collector;
+    }
+    pthread_cond_broadcast(&registry->work_ready);
+
+    while (waiting > 0)
+    {
+        // Quitamos los terminados y los vencidos, y esperamos hasta el plazo más próximo de los restantes
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const struct timespec* nearest = NULL;
+        size_t kept = 0;
+        for (size_t i = 0; i < waiting; i++)
+        {
+            collector_t* collector = pending[i];
+            if (!collector->busy)
+            {
+                collector->stale = 0;
+            }
+            else if (!timespec_before(&now, &collector->deadline))
+            {
+                collector_timed_out(collector);
+            }
+            else
+            {
+                if (nearest == NULL || timespec_before(&collector->deadline, nearest))
+                {
+                    nearest = &collector->deadline;
+                }
+                pending[kept++] = collector;
+            }
+        }
+        waiting = kept;
+        if (waiting > 0)
+        {
+            pthread_cond_timedwait(&registry->work_done, &registry->lock, nearest);
+        }
+    }
+    pthread_mutex_unlock(&registry->lock);
+}
+
+/**
+ * @brief Lanza los colectores cuya próxima ejecución ya llegó, los reprograma y espera a que terminen.
+ * @param registry Registro iniciado.
+ * @return Cantidad de colectores que vencieron.
+ */
+size_t collector_registry_run_due(collector_registry_t* registry)
+{
+    collector_t* due[COLLECTOR_MAX];
+    struct timespec now;
+    size_t count = 0;
+
+    // Se compara contra un único instante: un colector reprogramado queda siempre después de él, así que cada uno se
+    // toma una sola vez
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    while (registry->heap_len > 0 && !timespec_before(&now, &registry->heap[0]->schedule.next))
+    {
+        collector_t* collector = registry->heap[0];
+        due[count++] = collector;
+        sampler_advance(&collector->schedule);
+        heap_sift_down(registry, 0);
+    }
+    if (count > 0)
+    {
+        collector_dispatch(registry, due, count, 1);
+    }
+    return count;
+}
+
+/**
+ * @brief Ejecuta todos los colectores habilitados fuera de ciclo.
+ * @param registry Registro iniciado.
+ */
+void collector_registry_run_all(collector_registry_t* registry)
+{
+    collector_t* all[COLLECTOR_MAX];
+    size_t count = 0;
+
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        // Un colector deshabilitado al recargar puede seguir inicializado (si no tiene destroy)
+        if (registry->collectors[i].enabled && registry->collectors[i].initialized)
+        {
+            all[count++] = &registry->collectors[i];
+        }
+    }
+    collector_dispatch(registry, all, count, 0);
+}
+
+/**
+ * @brief Indica si algún colector está en ejecución.
+ * @param registry Registro iniciado.
+ * @return El primer colector en ejecución, o NULL si no hay ninguno.
+ */
+const collector_t* collector_registry_busy(collector_registry_t* registry)
+{
+    const collector_t* busy = NULL;
+    pthread_mutex_lock(&registry->lock);
+    for (size_t i = 0; i < registry->count && busy == NULL; i++)
+    {
+        if (registry->collectors[i].busy)
+        {
+            busy = &registry->collectors[i];
+        }
+    }
+    pthread_mutex_unlock(&registry->lock);
+    return busy;
+}
+
+/**
+ * @brief Calcula el período y el plazo efectivos de un colector según una configuración.
+ * @param desired Registro con la configuración.
+ * @param collector Colector de ese registro.
+ * @param default_interval_ms Período de los colectores sin período propio.
+ * @param deadline_ms Plazo efectivo (nunca mayor que el período).
+ * @return Período efectivo en milisegundos.
+ */
+static unsigned long collector_effective_interval(const collector_registry_t* desired, const collector_t* collector,
+                                                  unsigned long default_interval_ms, unsigned long* deadline_ms)
+{
+    unsigned long interval_ms = collector->interval_ms != 0 ? collector->interval_ms : default_interval_ms;
+    *deadline_ms = collector->deadline_ms != 0 ? collector->deadline_ms : desired->deadline_ms;
+    if (*deadline_ms > interval_ms)
+    {
+        *deadline_ms = interval_ms;
+    }
+    return interval_ms;
+}
+
+/**
+ * @brief Aplica a un registro iniciado la configuración de otro con los mismos colectores.
+ * @param registry Registro iniciado, sin colectores en ejecución.
+ * @param desired Registro con la configuración nueva.
+ * @param default_interval_ms Período de los colectores sin período propio.
+ * @return Cantidad de colectores que cambiaron, o -1 si la configuración no se aplicó.
+ */
+int collector_registry_reload(collector_registry_t* registry, const collector_registry_t* desired,
+                              unsigned long default_interval_ms)
+{
+    size_t enabled = 0;
+    unsigned long deadline_ms;
+
+    // Primero se valida todo: ante un error, el registro queda como estaba
+    if (desired->count != registry->count)
+    {
+        fprintf(stderr, "La configuración nueva no tiene los mismos colectores\n");
+        return -1;
+    }
+    for (size_t i = 0; i < desired->count; i++)
+    {
+        const collector_t* want = &desired->collectors[i];
+        if (strcmp(want->name, registry->collectors[i].name) != 0)
+        {
+            fprintf(stderr, "La configuración nueva no tiene los mismos colectores\n");
+            return -1;
+        }
+        if (!want->enabled)
+        {
+            continue;
+        }
+        if (collector_effective_interval(desired, want, default_interval_ms, &deadline_ms) < SAMPLER_MIN_INTERVAL_MS)
+        {
+            fprintf(stderr, "Período inválido para el colector %s (mínimo: %d ms)\n", want->name,
+                    SAMPLER_MIN_INTERVAL_MS);
+            return -1;
+        }
+        enabled++;
+    }
+    if (enabled == 0)
+    {
+        fprintf(stderr, "No hay colectores habilitados\n");
+        return -1;
+    }
+
+    // Los colectores que se habilitan se inicializan antes de tocar los demás; si alguno falla, se liberan los
+    // inicializados en esta recarga
+    int fresh[COLLECTOR_MAX] = {0};
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        collector_t* collector = &registry->collectors[i];
+        if (!desired->collectors[i].enabled || collector->initialized)
+        {
+            continue;
+        }
+        if (collector->init != NULL && collector->init() != 0)
+        {
+            fprintf(stderr, "Error al inicializar el colector %s\n", collector->name);
+            for (size_t j = 0; j < i; j++)
+            {
+                if (fresh[j] && registry->collectors[j].destroy != NULL)
+                {
+                    registry->collectors[j].destroy();
+                    registry->collectors[j].initialized = 0;
+                }
+            }
+            return -1;
+        }
+        collector->initialized = 1;
+        fresh[i] = 1;
+    }
+
+    // Los colectores sin cambios conservan su fase y su estado; los que cambian de período empiezan ahora
+    int changed = 0;
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        collector_t* collector = &registry->collectors[i];
+        const collector_t* want = &desired->collectors[i];
+        if (!want->enabled)
+        {
+            if (collector->enabled)
+            {
+                collector->enabled = 0;
+                collector->stale = 0;
+                if (collector->initialized && collector->destroy != NULL)
+                {
+                    collector->destroy();
+                    collector->initialized = 0;
+                }
+                arena_destroy(&collector->scratch);
+                changed++;
+            }
+            continue;
+        }
+        unsigned long interval_ms = collector_effective_interval(desired, want, default_interval_ms, &deadline_ms);
+        if (!collector->enabled || collector->schedule.period_ns != (long long)interval_ms * 1000000LL)
+        {
+            sampler_init(&collector->schedule, interval_ms);
+            changed++;
+        }
+        collector->enabled = 1;
+        collector->interval_ms = want->interval_ms;
+        collector->deadline_ms = deadline_ms;
+    }
+    registry->deadline_ms = desired->deadline_ms;
+
+    registry->heap_len = 0;
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        if (registry->collectors[i].enabled)
+        {
+            registry->heap[registry->heap_len] = &registry->collectors[i];
+            heap_sift_up(registry, registry->heap_len++);
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Detiene los hilos y libera los colectores inicializados.
+ * @param registry Registro.
+ * @return 0 si todos los hilos terminaron, -1 si alguno sigue en un colector.
+ */
+int collector_registry_destroy(collector_registry_t* registry)
+{
+    int hung = 0;
+
+    if (registry->workers_started > 0)
+    {
+        // Un hilo colgado en un colector no debe impedir terminar: se lo espera sólo hasta el plazo por defecto
+        struct timespec limit;
+        clock_gettime(CLOCK_MONOTONIC, &limit);
+        timespec_add_ms(&limit, registry->deadline_ms);
+
+        pthread_mutex_lock(&registry->lock);
+        registry->stopping = 1;
+        pthread_cond_broadcast(&registry->work_ready);
+        do
+        {
+            hung = 0;
+            for (size_t i = 0; i < registry->count; i++)
+            {
+                hung |= registry->collectors[i].busy;
+            }
+        } while (hung && pthread_cond_timedwait(&registry->work_done, &registry->lock, &limit) == 0);
+        for (size_t i = 0; i < registry->count; i++)
+        {
+            collector_t* collector = &registry->collectors[i];
+            if (collector->busy)
+            {
+                // Su hilo todavía puede tocar lo que reservó init: no se libera
+                fprintf(stderr, "El colector %s no terminó; no se libera\n", collector->name);
+                collector->initialized = 0;
+            }
+        }
+        pthread_mutex_unlock(&registry->lock);
+
+        // Sin colectores en curso los hilos terminan enseguida; si alguno sigue colgado se los abandona
+        for (unsigned int i = 0; i < registry->workers_started; i++)
+        {
+            if (hung)
+            {
+                pthread_detach(registry->workers[i]);
+            }
+            else
+            {
+                pthread_join(registry->workers[i], NULL);
+            }
+        }
+        registry->workers_started = 0;
+    }
+
+    for (size_t i = 0; i < registry->count; i++)
+    {
+        collector_t* collector = &registry->collectors[i];
+        if (collector->initialized)
+        {
+            // Los colgados quedaron sin initialized: su hilo todavía puede estar usando la memoria temporal
+            if (collector->destroy != NULL)
+            {
+                collector->destroy();
+            }
+            arena_destroy(&collector->scratch);
+        }
+        collector->initialized = 0;
+    }
+    registry->heap_len = 0;
+
+    // Con un hilo abandonado, el mutex y las condiciones siguen en uso
+    if (!hung && registry->stopping)
+    {
+        pthread_cond_destroy(&registry->work_done);
+        pthread_cond_destroy(&registry->work_ready);
+        pthread_mutex_destroy(&registry->lock);
+    }
+    return hung ? -1 : 0;
+}
@@ -0,0 +1,267 @@
+#include "../include/config.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/**
+ * @file config.c
+ * @brief Implementación del archivo de configuración y su vigilancia.
+ */
+
+/**
+ * @brief Entrada que reemplaza Kubernetes al actualizar un ConfigMap montado (el archivo es un enlace a través suyo).
+ */
+#define CONFIG_CONFIGMAP_DATA "..data"
+
+/**
+ * @brief Quita los espacios del principio y del final de un texto.
+ * @param start Comienzo del texto.
+ * @param end Fin del texto; se actualiza.
+ * @return Comienzo del texto sin espacios.
+ */
+static char* config_trim(char* start, char** end)
+{
+    while (start < *end && (*start == ' ' || *start == '\t'))
+    {
+        start++;
+    }
+    while (*end > start && ((*end)[-1] == ' ' || (*end)[-1] == '\t' || (*end)[-1] == '\r' || (*end)[-1] == '\n'))
+    {
+        (*end)--;
+    }
+    return start;
+}
+
+/**
+ * @brief Lee un archivo de configuración.
+ * @param file Opciones a completar.
+ * @param path Ruta del archivo.
+ * @return 0 si se leyó, -1 en caso de error.
+ */
+int config_file_load(config_file_t* file, const char* path)
+{
+    memset(file, 0, sizeof(*file));
+    FILE* in = fopen(path, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "Error al abrir el archivo de configuración %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    file->args[file->count++] = strdup(path);
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    unsigned int number = 0;
+    int ret = file->args[0] != NULL ? 0 : -1;
+    while (ret == 0 && (len = getline(&line, &cap, in)) >= 0)
+    {
+        number++;
+        char* end = line + len;
+        char* key = config_trim(line, &end);
+        if (key == end || *key == '#')
+        {
+            continue;
+        }
+
+        char* equals = memchr(key, '=', (size_t)(end - key));
+        if (equals == NULL || equals == key)
+        {
+            fprintf(stderr, "%s:%u: se espera \"clave = valor\"\n", path, number);
+            ret = -1;
+            break;
+        }
+        char* key_end = equals;
+        key = config_trim(key, &key_end);
+        char* value = config_trim(equals + 1, &end);
+        if (end - value >= 2 && *value == '"' && end[-1] == '"')
+        {
+            value++;
+            end--;
+        }
+        if (file->count > CONFIG_MAX_OPTIONS)
+        {
+            fprintf(stderr, "%s:%u: demasiadas opciones (máximo: %d)\n", path, number, CONFIG_MAX_OPTIONS);
+            ret = -1;
+            break;
+        }
+
+        // "--clave=valor", tal como lo espera getopt_long()
+        size_t key_len = (size_t)(key_end - key), value_len = (size_t)(end - value);
+        char* arg = malloc(key_len + value_len + 4);
+        if (arg == NULL)
+        {
+            ret = -1;
+            break;
+        }
+        memcpy(arg, "--", 2);
+        memcpy(arg + 2, key, key_len);
+        arg[2 + key_len] = '=';
+        memcpy(arg + 3 + key_len, value, value_len);
+        arg[3 + key_len + value_len] = '\0';
+        file->args[file->count++] = arg;
+    }
+    free(line);
+    fclose(in);
+    return ret;
+}
+
+/**
+ * @brief Libera las opciones leídas.
+ * @param file Opciones.
+ */
+void config_file_free(config_file_t* file)
+{
+    for (int i = 0; i < file->count; i++)
+    {
+        free(file->args[i]);
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+/**
+ * @brief Cuerpo del hilo que espera los cambios del archivo.
+ * @param arg Vigilancia (config_watch_t*).
+ * @return NULL.
+ */
+static void* config_watch_loop(void* arg)
+{
+    config_watch_t* watch = arg;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2] = {{.fd = watch->inotify_fd, .events = POLLIN}, {.fd = watch->wake_fd, .events = POLLIN}};
+
+    while (1)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("Error al esperar los cambios del archivo de configuración");
+            return NULL;
+        }
+        if (fds[1].revents != 0)
+        {
+            return NULL;
+        }
+
+        ssize_t len = read(watch->inotify_fd, buf, sizeof(buf));
+        if (len <= 0)
+        {
+            continue;
+        }
+
+        // Una sola señal por lectura: guardar el archivo suele generar varios eventos seguidos
+        int changed = 0;
+        for (char* p = buf; p < buf + len;)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            if (event->len > 0 &&
+                (strcmp(event->name, watch->name) == 0 || strcmp(event->name, CONFIG_CONFIGMAP_DATA) == 0))
+            {
+                changed = 1;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+        if (changed)
+        {
+            pthread_kill(watch->target, watch->signo);
+        }
+    }
+}
+
+/**
+ * @brief Cierra los descriptores de la vigilancia.
+ * @param watch Vigilancia.
+ */
+static void config_watch_close(config_watch_t* watch)
+{
+    if (watch->inotify_fd >= 0)
+    {
+        close(watch->inotify_fd);
+        watch->inotify_fd = -1;
+    }
+    if (watch->wake_fd >= 0)
+    {
+        close(watch->wake_fd);
+        watch->wake_fd = -1;
+    }
+}
+
+/**
+ * @brief Empieza a vigilar un archivo de configuración.
+ * @param watch Vigilancia a inicializar.
+ * @param path Ruta del archivo.
+ * @param target Hilo al que se avisa.
+ * @param signo Señal con la que se avisa.
+ * @return 0 si se inició, -1 en caso de error.
+ */
+int config_watch_start(config_watch_t* watch, const char* path, pthread_t target, int signo)
+{
+    char dir[PATH_MAX];
+
+    watch->inotify_fd = -1;
+    watch->wake_fd = -1;
+    watch->running = 0;
+    watch->target = target;
+    watch->signo = signo;
+
+    // Se vigila el directorio: un archivo reemplazado con rename() deja de ser el que se vigilaba
+    const char* slash = strrchr(path, '/');
+    const char* name = slash != NULL ? slash + 1 : path;
+    size_t dir_len = slash == NULL ? 1 : slash == path ? 1 : (size_t)(slash - path);
+    if (*name == '\0' || strlen(name) >= sizeof(watch->name) || dir_len >= sizeof(dir))
+    {
+        fprintf(stderr, "Ruta de configuración inválida: %s\n", path);
+        return -1;
+    }
+    memcpy(dir, slash == NULL ? "." : path, dir_len);
+    dir[dir_len] = '\0';
+    strcpy(watch->name, name);
+
+    watch->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watch->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (watch->inotify_fd < 0 || watch->wake_fd < 0 ||
+        inotify_add_watch(watch->inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        fprintf(stderr, "Error al vigilar el directorio %s: %s\n", dir, strerror(errno));
+        config_watch_close(watch);
+        return -1;
+    }
+    if (pthread_create(&watch->thread, NULL, config_watch_loop, watch) != 0)
+    {
+        fprintf(stderr, "Error al crear el hilo de vigilancia de la configuración\n");
+        config_watch_close(watch);
+        return -1;
+    }
+    watch->running = 1;
+    return 0;
+}
+
+/**
+ * @brief Detiene la vigilancia.
+ * @param watch Vigilancia.
+ */
+void config_watch_stop(config_watch_t* watch)
+{
+    if (!watch->running)
+    {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(watch->wake_fd, &one, sizeof(one)) != (ssize_t)sizeof(one))
+    {
+        pthread_cancel(watch->thread);
+    }
+    pthread_join(watch->thread, NULL);
+    watch->running = 0;
+    config_watch_close(watch);
+}
@@ -0,0 +1,67 @@
+#include "../include/counter.h"
+#include <stdint.h>
+
+/**
+ * @file counter.c
+ * @brief Implementación de los contadores acumulados.
+ */
+
+/**
+ * @brief Diferencia entre dos lecturas de un contador, compensando vueltas de 32 bits y reinicios.
+ * @param cur Lectura actual.
+ * @param prev Lectura anterior.
+ * @return Incremento entre ambas lecturas.
+ */
+unsigned long long counter_delta(unsigned long long cur, unsigned long long prev)
+{
+    if (cur >= prev)
+    {
+        return cur - prev;
+    }
+
+    // Un contador de 32 bits que dio la vuelta queda cerca de 0 viniendo de cerca de 2^32
+    if (prev <= UINT32_MAX)
+    {
+        unsigned long long wrapped = cur + (UINT32_MAX - prev) + 1;
+        if (wrapped <= INT32_MAX)
+        {
+            return wrapped;
+        }
+    }
+    return cur;
+}
+
+/**
+ * @brief Tasa por segundo de un contador entre dos lecturas.
+ * @param cur Lectura actual.
+ * @param prev Lectura anterior.
+ * @param elapsed Segundos entre ambas lecturas.
+ * @return Incremento por segundo.
+ */
+double counter_rate(unsigned long long cur, unsigned long long prev, double elapsed)
+{
+    return (double)counter_delta(cur, prev) / elapsed;
+}
+
+/**
+ * @brief Acumula una lectura de un contador.
+ * @param counter Contador acumulado.
+ * @param raw Lectura del contador del kernel.
+ * @return Incremento respecto de la lectura anterior.
+ */
+unsigned long long counter_update(counter_t* counter, unsigned long long raw)
+{
+    unsigned long long delta = 0;
+    if (!counter->primed)
+    {
+        counter->value = raw;
+        counter->primed = 1;
+    }
+    else
+    {
+        delta = counter_delta(raw, counter->last);
+        counter->value += delta;
+    }
+    counter->last = raw;
+    return delta;
+}
@@ -0,0 +1,108 @@
+#include "../include/ddsketch.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @file ddsketch.c
+ * @brief Implementación del sketch de cuantiles DDSketch.
+ */
+
+/**
+ * @brief gamma = (1 + a) / (1 - a).
+ */
+#define DDSKETCH_GAMMA ((1.0 + DDSKETCH_RELATIVE_ACCURACY) / (1.0 - DDSKETCH_RELATIVE_ACCURACY))
+
+/**
+ * @brief log(gamma) con a = 0,01.
+ */
+#define DDSKETCH_LOG_GAMMA 0.020000666706669435
+
+/**
+ * @brief Inicializa un sketch vacío.
+ * @param sketch Sketch.
+ */
+void ddsketch_init(ddsketch_t* sketch)
+{
+    memset(sketch, 0, sizeof(*sketch));
+}
+
+/**
+ * @brief Devuelve el contador de un valor.
+ * @param sketch Sketch inicializado.
+ * @param value Valor.
+ * @return Puntero al bucket de cero o al bucket del valor.
+ */
+static uint32_t* ddsketch_bucket(ddsketch_t* sketch, double value)
+{
+    if (!(value >= DDSKETCH_MIN_VALUE))
+    {
+        return &sketch->zero;
+    }
+    int index = (int)ceil(log(value) / DDSKETCH_LOG_GAMMA) - DDSKETCH_MIN_INDEX;
+    if (index < 0)
+    {
+        index = 0;
+    }
+    else if (index >= DDSKETCH_BUCKETS)
+    {
+        index = DDSKETCH_BUCKETS - 1;
+    }
+    return &sketch->buckets[index];
+}
+
+/**
+ * @brief Agrega un valor.
+ * @param sketch Sketch inicializado.
+ * @param value Valor.
+ */
+void ddsketch_add(ddsketch_t* sketch, double value)
+{
+    (*ddsketch_bucket(sketch, value))++;
+    sketch->count++;
+}
+
+/**
+ * @brief Quita un valor agregado antes.
+ * @param sketch Sketch inicializado.
+ * @param value Valor, idéntico al que se agregó.
+ */
+void ddsketch_remove(ddsketch_t* sketch, double value)
+{
+    uint32_t* bucket = ddsketch_bucket(sketch, value);
+    if (*bucket > 0)
+    {
+        (*bucket)--;
+        sketch->count--;
+    }
+}
+
+/**
+ * @brief Calcula varios cuantiles en un único recorrido de los buckets.
+ * @param sketch Sketch con al menos un valor.
+ * @param q Cuantiles pedidos, crecientes.
+ * @param out Valor estimado de cada cuantil.
+ * @param count Cantidad de cuantiles.
+ */
+void ddsketch_quantiles(const ddsketch_t* sketch, const double* q, double* out, int count)
+{
+    int next = 0;
+    // Rango (desde 0) del valor de cada cuantil, como en la definición "lower" de DDSketch
+    uint64_t seen = sketch->zero;
+    while (next < count && (double)seen > q[next] * (double)(sketch->count - 1))
+    {
+        out[next++] = 0;
+    }
+    for (int i = 0; i < DDSKETCH_BUCKETS && next < count; i++)
+    {
+        seen += sketch->buckets[i];
+        while (next < count && (double)seen > q[next] * (double)(sketch->count - 1))
+        {
+            // Punto medio del bucket, que acota el error relativo en DDSKETCH_RELATIVE_ACCURACY
+            out[next++] = 2.0 * pow(DDSKETCH_GAMMA, i + DDSKETCH_MIN_INDEX) / (DDSKETCH_GAMMA + 1.0);
+        }
+    }
+    while (next < count)
+    {
+        out[next++] = DDSKETCH_MAX_VALUE;
+    }
+}
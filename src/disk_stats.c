@@ -0,0 +1,350 @@
+#include "../include/disk_stats.h"
+#include "../include/proc_scan.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file disk_stats.c
+ * @brief Implementación de las estadísticas por dispositivo de bloque.
+ */
+
+/**
+ * @brief Capacidad inicial de la tabla de dispositivos.
+ */
+#define DISK_TABLE_INITIAL_CAPACITY 64
+
+/**
+ * @brief Calcula la posición inicial de sondeo para un major:minor.
+ * @param table Tabla de dispositivos.
+ * @param major Número mayor.
+ * @param minor Número menor.
+ * @return Índice inicial dentro de la tabla.
+ */
+static size_t disk_hash(const disk_table_t* table, unsigned int major, unsigned int minor)
+{
+    uint64_t key = ((uint64_t)major << 32) | minor;
+    key *= 0x9E3779B97F4A7C15ULL; // Hash multiplicativo de Fibonacci
+    return (size_t)(key >> 32) & (table->capacity - 1);
+}
+
+/**
+ * @brief Reserva una tabla vacía de la capacidad indicada.
+ * @param table Tabla de dispositivos.
+ * @param capacity Cantidad de entradas (potencia de 2).
+ * @return 0 si se reservó, -1 si falta memoria.
+ */
+static int disk_table_alloc(disk_table_t* table, size_t capacity)
+{
+    table->slots = calloc(capacity, sizeof(disk_device_t));
+    if (table->slots == NULL)
+    {
+        return -1;
+    }
+    table->capacity = capacity;
+    table->used = 0;
+    table->live = 0;
+    return 0;
+}
+
+/**
+ * @brief Reconstruye la tabla descartando las entradas borradas y, si hace falta, duplicando su capacidad.
+ * @param table Tabla de dispositivos.
+ * @return 0 si se reconstruyó, -1 si falta memoria (la tabla anterior queda intacta).
+ */
+static int disk_table_rehash(disk_table_t* table)
+{
+    disk_device_t* old = table->slots;
+    size_t old_capacity = table->capacity;
+    size_t capacity = table->live * 2 >= old_capacity ? old_capacity * 2 : old_capacity;
+    if (capacity < DISK_TABLE_INITIAL_CAPACITY)
+    {
+        capacity = DISK_TABLE_INITIAL_CAPACITY;
+    }
+
+    if (disk_table_alloc(table, capacity) != 0)
+    {
+        table->slots = old;
+        table->capacity = old_capacity;
+        return -1;
+    }
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i].state != DISK_SLOT_USED)
+        {
+            continue;
+        }
+        size_t j = disk_hash(table, old[i].major, old[i].minor);
+        while (table->slots[j].state != DISK_SLOT_EMPTY)
+        {
+            j = (j + 1) & (table->capacity - 1);
+        }
+        table->slots[j] = old[i];
+        table->used++;
+        table->live++;
+    }
+
+    free(old);
+    return 0;
+}
+
+/**
+ * @brief Indica si un dispositivo queda excluido por los filtros.
+ * @param table Tabla de dispositivos.
+ * @param name Nombre del dispositivo.
+ * @return 1 si se excluye, 0 si se incluye.
+ */
+static int disk_is_filtered(const disk_table_t* table, const char* name)
+{
+    if (table->has_include && regexec(&table->include, name, 0, NULL, 0) != 0)
+    {
+        return 1;
+    }
+    if (table->has_exclude && regexec(&table->exclude, name, 0, NULL, 0) == 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Busca un dispositivo en la tabla y, si no está, lo agrega.
+ * @param table Tabla de dispositivos.
+ * @param major Número mayor.
+ * @param minor Número menor.
+ * @param name Nombre del dispositivo (no terminado en '\0').
+ * @param name_len Longitud del nombre.
+ * @return Entrada del dispositivo, o NULL si falta memoria.
+ */
+static disk_device_t* disk_table_lookup(disk_table_t* table, unsigned int major, unsigned int minor,
+                                        const char* name, size_t name_len)
+{
+    // Mantenemos el factor de carga (incluyendo borrados) por debajo de 3/4
+    if ((table->used + 1) * 4 > table->capacity * 3 && disk_table_rehash(table) != 0)
+    {
+        return NULL;
+    }
+
+    size_t i = disk_hash(table, major, minor);
+    disk_device_t* free_slot = NULL;
+    while (table->slots[i].state != DISK_SLOT_EMPTY)
+    {
+        disk_device_t* slot = &table->slots[i];
+        if (slot->state == DISK_SLOT_USED && slot->major == major && slot->minor == minor)
+        {
+            return slot;
+        }
+        if (slot->state == DISK_SLOT_DELETED && free_slot == NULL)
+        {
+            free_slot = slot;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+
+    // Dispositivo nuevo: reutilizamos una entrada borrada del sondeo si la hubo
+    disk_device_t* slot = free_slot;
+    if (slot == NULL)
+    {
+        slot = &table->slots[i];
+        table->used++;
+    }
+    memset(slot, 0, sizeof(*slot));
+    slot->state = DISK_SLOT_USED;
+    slot->major = major;
+    slot->minor = minor;
+    if (name_len >= sizeof(slot->name))
+    {
+        name_len = sizeof(slot->name) - 1;
+    }
+    memcpy(slot->name, name, name_len);
+    slot->name[name_len] = '\0';
+    slot->filtered = disk_is_filtered(table, slot->name);
+    table->live++;
+    return slot;
+}
+
+/**
+ * @brief Inicializa la tabla de dispositivos y sus filtros.
+ * @param table Tabla a inicializar.
+ * @param include Expresión de dispositivos a incluir, o NULL.
+ * @param exclude Expresión de dispositivos a excluir, o NULL.
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int disk_table_init(disk_table_t* table, const char* include, const char* exclude)
+{
+    memset(table, 0, sizeof(*table));
+
+    if (include != NULL && *include != '\0')
+    {
+        if (regcomp(&table->include, include, REG_EXTENDED | REG_NOSUB) != 0)
+        {
+            fprintf(stderr, "Expresión de inclusión de discos inválida: %s\n", include);
+            return -1;
+        }
+        table->has_include = 1;
+    }
+    if (exclude != NULL && *exclude != '\0')
+    {
+        if (regcomp(&table->exclude, exclude, REG_EXTENDED | REG_NOSUB) != 0)
+        {
+            fprintf(stderr, "Expresión de exclusión de discos inválida: %s\n", exclude);
+            disk_table_destroy(table);
+            return -1;
+        }
+        table->has_exclude = 1;
+    }
+
+    if (disk_table_alloc(table, DISK_TABLE_INITIAL_CAPACITY) != 0)
+    {
+        disk_table_destroy(table);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Libera la tabla de dispositivos y sus filtros.
+ * @param table Tabla a liberar.
+ */
+void disk_table_destroy(disk_table_t* table)
+{
+    if (table->has_include)
+    {
+        regfree(&table->include);
+    }
+    if (table->has_exclude)
+    {
+        regfree(&table->exclude);
+    }
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @brief Analiza /proc/diskstats actualizando los contadores de cada dispositivo.
+ * @param table Tabla de dispositivos.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @return Cantidad de dispositivos presentes.
+ */
+size_t parse_disk_devices(disk_table_t* table, const char* buf, size_t len)
+{
+    proc_scanner_t file, line;
+    const char* name;
+    size_t name_len;
+
+    table->generation++;
+
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        unsigned long long major, minor, in_flight;
+        disk_counters_t c;
+
+        // major minor nombre lecturas lecturas_combinadas sectores_leídos ms_lectura escrituras escrituras_combinadas
+        // sectores_escritos ms_escritura en_curso io_ticks ms_ponderados ...
+        if (!scan_u64(&line, &major) || !scan_u64(&line, &minor) || !scan_token(&line, '\0', &name, &name_len) ||
+            !scan_u64(&line, &c.reads) || !scan_skip(&line, 1) || !scan_u64(&line, &c.read_sectors) ||
+            !scan_u64(&line, &c.read_ms) || !scan_u64(&line, &c.writes) || !scan_skip(&line, 1) ||
+            !scan_u64(&line, &c.write_sectors) || !scan_u64(&line, &c.write_ms) || !scan_u64(&line, &in_flight) ||
+            !scan_u64(&line, &c.io_ticks) || !scan_u64(&line, &c.queue_ms))
+        {
+            continue;
+        }
+
+        disk_device_t* dev = disk_table_lookup(table, (unsigned int)major, (unsigned int)minor, name, name_len);
+        if (dev == NULL)
+        {
+            continue;
+        }
+        dev->cur = c;
+        dev->generation = table->generation;
+    }
+
+    // Los dispositivos que no aparecieron en este ciclo fueron quitados del sistema
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        disk_device_t* dev = &table->slots[i];
+        if (dev->state == DISK_SLOT_USED && dev->generation != table->generation)
+        {
+            dev->state = DISK_SLOT_DELETED;
+            table->live--;
+        }
+    }
+
+    return table->live;
+}
+
+/**
+ * @brief Acumula en los contadores totales de un dispositivo el incremento desde la lectura anterior.
+ * @param dev Dispositivo con una lectura anterior.
+ */
+static void disk_accumulate(disk_device_t* dev)
+{
+    dev->total.reads += counter_delta(dev->cur.reads, dev->prev.reads);
+    dev->total.read_sectors += counter_delta(dev->cur.read_sectors, dev->prev.read_sectors);
+    dev->total.read_ms += counter_delta(dev->cur.read_ms, dev->prev.read_ms);
+    dev->total.writes += counter_delta(dev->cur.writes, dev->prev.writes);
+    dev->total.write_sectors += counter_delta(dev->cur.write_sectors, dev->prev.write_sectors);
+    dev->total.write_ms += counter_delta(dev->cur.write_ms, dev->prev.write_ms);
+    dev->total.io_ticks += counter_delta(dev->cur.io_ticks, dev->prev.io_ticks);
+    dev->total.queue_ms += counter_delta(dev->cur.queue_ms, dev->prev.queue_ms);
+}
+
+/**
+ * @brief Calcula las tasas de cada dispositivo a partir de la lectura actual y la anterior.
+ * @param table Tabla de dispositivos.
+ * @param elapsed Segundos transcurridos entre ambas lecturas.
+ */
+void compute_disk_rates(disk_table_t* table, double elapsed)
+{
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        disk_device_t* dev = &table->slots[i];
+        if (dev->state != DISK_SLOT_USED || dev->filtered)
+        {
+            continue;
+        }
+
+        // Un dispositivo recién aparecido no tiene lectura anterior con la cual comparar
+        if (!dev->has_prev)
+        {
+            dev->total = dev->cur;
+        }
+        else
+        {
+            disk_accumulate(dev);
+        }
+        if (!dev->has_prev || elapsed <= 0.0)
+        {
+            dev->prev = dev->cur;
+            dev->has_prev = 1;
+            dev->valid = 0;
+            continue;
+        }
+
+        double elapsed_ms = elapsed * 1000.0;
+        double reads = (double)counter_delta(dev->cur.reads, dev->prev.reads);
+        double writes = (double)counter_delta(dev->cur.writes, dev->prev.writes);
+        double io_ms = (double)counter_delta(dev->cur.read_ms, dev->prev.read_ms) +
+                       (double)counter_delta(dev->cur.write_ms, dev->prev.write_ms);
+
+        dev->read_bytes_per_sec =
+            (double)counter_delta(dev->cur.read_sectors, dev->prev.read_sectors) * DISK_SECTOR_SIZE / elapsed;
+        dev->write_bytes_per_sec =
+            (double)counter_delta(dev->cur.write_sectors, dev->prev.write_sectors) * DISK_SECTOR_SIZE / elapsed;
+        dev->reads_per_sec = reads / elapsed;
+        dev->writes_per_sec = writes / elapsed;
+        dev->utilization = (double)counter_delta(dev->cur.io_ticks, dev->prev.io_ticks) * 100.0 / elapsed_ms;
+        if (dev->utilization > 100.0)
+        {
+            dev->utilization = 100.0;
+        }
+        dev->queue_depth = (double)counter_delta(dev->cur.queue_ms, dev->prev.queue_ms) / elapsed_ms;
+        dev->await_ms = reads + writes > 0.0 ? io_ms / (reads + writes) : 0.0;
+        dev->prev = dev->cur;
+        dev->valid = 1;
+    }
+}
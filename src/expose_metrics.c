@@ -3,288 +3,1766 @@
 /**
  * @file expose_metrics.c
  * @brief Implementación de las funciones para exponer métricas a Prometheus.
+ *
+ * Cada colector renderiza su propia sección en el formato de texto de exposición, con buffers que se reutilizan entre
+ * ciclos, y publish_metrics() las escribe junto con las métricas del propio exportador directamente en la instantánea
+ * que responde el servidor HTTP (http_server.c). Ninguna métrica pasa por un registro que reserve memoria al
+ * actualizarla o al renderizarla, así que en régimen un ciclo completo no reserva memoria.
+ */
+
+/**
+ * @brief Scrapes de /metrics respondidos, contados por el hilo HTTP.
+ */
+static atomic_ullong scrapes_served;
+
+/**
+ * @brief Scrapes de /metrics respondidos con una exposición ya enviada antes (incluye los 304 Not Modified).
+ */
+static atomic_ullong scrape_cache_hits;
+
+/**
+ * @brief Cantidad de procesos exportados por recurso, o 0 si el colector de procesos no está iniciado ni configurado.
+ */
+static size_t process_top;
+
+/**
+ * @brief Exposición de los procesos que más consumen, renderizada en el último barrido.
+ *
+ * El conjunto de procesos cambia entre barridos: sólo se exportan los N procesos actuales, así que las series de los
+ * que dejan de estar entre ellos desaparecen y la cardinalidad queda acotada.
+ */
+static text_buf_t process_text;
+
+/**
+ * @brief 1 si el colector de cgroups está habilitado.
+ */
+static int cgroups_enabled;
+
+/**
+ * @brief Punto de montaje de cgroup v2 que recorre el colector de cgroups.
+ */
+static const char* cgroup_root = CGROUP_DEFAULT_ROOT;
+
+/**
+ * @brief Profundidad máxima de los cgroups exportados (0: sin límite).
+ */
+static unsigned int cgroup_max_depth;
+
+/**
+ * @brief Exposición de las métricas por cgroup, renderizada en cada ciclo.
+ *
+ * Como con los procesos, las series de los cgroups eliminados desaparecen en el ciclo siguiente.
  */
+static text_buf_t cgroup_text;
 
-/** Mutex para sincronización de hilos */
-pthread_mutex_t lock;
+/**
+ * @brief Exposición de /proc/stat (uso de CPU total y por núcleo, procesos y contadores), de la memoria, de la carga y
+ * la presión, y de cada disco y cada interfaz, renderizadas en cada ciclo.
+ *
+ * Los contadores se exportan como enteros de 64 bits exactos, que no pierden precisión por encima de 2^53, y las
+ * series de los núcleos, discos e interfaces que desaparecen dejan de exportarse.
+ */
+static text_buf_t stat_text, memory_text, pressure_text, disk_text, net_text;
+
+/**
+ * @brief Últimas secciones terminadas de /proc/stat, la memoria, la presión, los discos, las interfaces, los procesos
+ * y los cgroups, que son las que se publican.
+ *
+ * Los colectores corren en otros hilos y uno demorado puede seguir renderizando mientras se publica: cada uno arma su
+ * sección aparte y, al terminar, la intercambia con la publicada bajo sections_lock.
+ */
+static text_buf_t stat_section, memory_section, pressure_section, disk_section, net_section, process_section,
+    cgroup_section;
 
 /**
- * @brief Métrica de Prometheus para el uso de la CPU
+ * @brief Series admitidas por familia en las métricas por núcleo, disco e interfaz.
  */
-static prom_gauge_t* cpu_usage_metric;
+static size_t series_limit = SERIES_DEFAULT_LIMIT;
 
 /**
- * @brief Métrica de Prometheus para el uso de memoria
+ * @brief Ciclos sin actualizarse tras los cuales se quita una serie por núcleo, disco o interfaz.
  */
-static prom_gauge_t* memory_usage_metric;
+static unsigned long series_max_idle = SERIES_DEFAULT_MAX_IDLE;
 
 /**
- * @brief Métrica de Prometheus para el uso de I/O del disco
+ * @brief Conjuntos de etiquetas de cada colector con series propias.
  */
-static prom_gauge_t* io_disk_usage_metric;
+static series_labels_t cpu_labels, disk_labels, net_labels;
 
 /**
- * @brief Métrica de Prometheus para el uso de la red
+ * @brief Uso de CPU por núcleo y modo.
  */
-static prom_gauge_t* red_usage_metric;
+static series_family_t cpu_core_series;
+
+/**
+ * @brief Conjunto de etiquetas de cada núcleo y modo, indexado por posición del núcleo y modo.
+ */
+static unsigned int* cpu_core_label_ids;
+
+/**
+ * @brief Núcleos para los que hay lugar en cpu_core_label_ids.
+ */
+static size_t cpu_core_label_capacity;
+
+/**
+ * @brief 1 si se exportan también las tasas por segundo de los contadores, calculadas por el exportador.
+ */
+static int rates_enabled = 1;
+
+/**
+ * @brief Protege las secciones publicadas.
+ */
+static pthread_mutex_t sections_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Series cuyas muestras se guardan en el historial y se resumen en ventanas deslizantes.
+ */
+typedef enum
+{
+    SAMPLED_CPU_USAGE,
+    SAMPLED_MEMORY_USAGE,
+    SAMPLED_PROCESSES,
+    SAMPLED_BLOCKED_PROCESSES,
+    SAMPLED_PAGE_FAULTS,
+    SAMPLED_MAJOR_PAGE_FAULTS,
+    SAMPLED_SERIES_COUNT,
+} sampled_series_t;
+
+/**
+ * @brief Nombres de las series muestreadas: los de las métricas que registran.
+ */
+static const char* const sampled_names[SAMPLED_SERIES_COUNT] = {
+    [SAMPLED_CPU_USAGE] = "cpu_usage_percentage",
+    [SAMPLED_MEMORY_USAGE] = "memory_usage_percentage",
+    [SAMPLED_PROCESSES] = "execution_process_number",
+    [SAMPLED_BLOCKED_PROCESSES] = "blocked_process_number",
+    [SAMPLED_PAGE_FAULTS] = "page_faults_per_second",
+    [SAMPLED_MAJOR_PAGE_FAULTS] = "major_page_faults_per_second",
+};
+
+/**
+ * @brief Historial de muestras; sin mapear (map == NULL) si no se habilitó.
+ */
+static history_t history;
+
+/**
+ * @brief Duración de las ventanas deslizantes en milisegundos (0: deshabilitadas).
+ */
+static unsigned long window_ms = WINDOW_STATS_DEFAULT_MS;
+
+/**
+ * @brief Ventana deslizante de cada serie muestreada, inicializadas en init_metrics().
+ *
+ * Un gauge sólo expone el último valor: el mínimo, el máximo, el promedio y los cuantiles de la ventana muestran los
+ * picos que ocurren entre scrapes.
+ */
+static window_stats_t windows[SAMPLED_SERIES_COUNT];
+
+/**
+ * @brief 1 si las ventanas están inicializadas.
+ */
+static int windows_enabled;
+
+/**
+ * @brief Envío de las métricas a un receptor remoto; detenido (running == 0) si no se habilitó.
+ */
+static pusher_t pusher;
+
+/**
+ * @brief Registra una muestra de una serie en el historial y en su ventana.
+ * @param series Serie muestreada.
+ * @param value Valor de la muestra.
+ */
+static void record_sample(sampled_series_t series, double value)
+{
+    history_append(&history, series, value);
+    if (windows_enabled)
+    {
+        window_stats_add(&windows[series], value);
+    }
+}
+
+/**
+ * @brief Publica una sección recién renderizada, conservando la anterior para reutilizar su memoria.
+ * @param rendered Sección renderizada; queda con el contenido anterior de la publicada.
+ * @param published Sección publicada.
+ */
+static void publish_section(text_buf_t* rendered, text_buf_t* published)
+{
+    pthread_mutex_lock(&sections_lock);
+    text_buf_t previous = *published;
+    *published = *rendered;
+    *rendered = previous;
+    pthread_mutex_unlock(&sections_lock);
+}
+
+/**
+ * @brief Límites del histograma de duración del renderizado, en nanosegundos (de 100 µs a 1 s).
+ */
+static const unsigned long long render_duration_bounds_ns[] = {
+    100000ULL,  250000ULL,  500000ULL,   1000000ULL,   2500000ULL,   5000000ULL,
+    10000000ULL, 25000000ULL, 50000000ULL, 100000000ULL, 250000000ULL, 1000000000ULL,
+};
+
+/**
+ * @brief Límites del histograma de bytes enviados por scrape (de 1 KiB a 16 MiB).
+ */
+static const unsigned long long response_size_bounds[] = {
+    1024ULL, 4096ULL, 16384ULL, 65536ULL, 262144ULL, 1048576ULL, 4194304ULL, 16777216ULL,
+};
+
+/**
+ * @brief Duración de cada renderizado y publicación de la exposición, observada por el hilo recolector.
+ */
+static histogram_t render_duration;
+
+/**
+ * @brief Bytes del cuerpo de cada respuesta a /metrics (comprimido si se envió con gzip), observados por el hilo HTTP.
+ */
+static histogram_t response_size;
+
+/**
+ * @brief Disparadores de PSI (running en 0 si están deshabilitados).
+ */
+static pressure_trigger_t pressure_trigger;
+
+/**
+ * @brief Actualiza las series de uso de CPU de cada núcleo y modo.
+ *
+ * Los conjuntos de etiquetas se guardan por posición del núcleo, de modo que en cada ciclo no se arma ninguna
+ * etiqueta.
+ *
+ * @param cores Porcentajes por núcleo.
+ */
+static void update_cpu_core_series(const cpu_core_stats_t* cores)
+{
+    static const char* const names[] = {"cpu", "mode"};
+
+    series_labels_tick(&cpu_labels);
+    if (cores->count > cpu_core_label_capacity)
+    {
+        unsigned int* ids = realloc(cpu_core_label_ids, cores->capacity * CPU_MODE_COUNT * sizeof(unsigned int));
+        if (ids == NULL)
+        {
+            return;
+        }
+        cpu_core_label_ids = ids;
+        cpu_core_label_capacity = cores->capacity;
+    }
+
+    // Sin porcentajes válidos (primera lectura o cambio de núcleos por hotplug) las posiciones pueden corresponder a
+    // otros núcleos: se vuelven a resolver en el próximo ciclo, encontrando los conjuntos ya internados
+    if (!cores->valid)
+    {
+        if (cpu_core_label_capacity > 0)
+        {
+            memset(cpu_core_label_ids, 0, cpu_core_label_capacity * CPU_MODE_COUNT * sizeof(unsigned int));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < cores->count; i++)
+    {
+        for (int m = 0; m < CPU_MODE_COUNT; m++)
+        {
+            unsigned int* cached = &cpu_core_label_ids[i * CPU_MODE_COUNT + m];
+            unsigned int labels = series_labels_lookup(&cpu_labels, *cached);
+            if (labels == SERIES_NO_LABELS)
+            {
+                char cpu[16];
+                snprintf(cpu, sizeof(cpu), "%u", cores->id[i]);
+                const char* values[] = {cpu, cpu_mode_name(m)};
+                labels = series_labels_resolve(&cpu_labels, cached, names, values, 2);
+            }
+            series_set(&cpu_core_series, labels, cores->percent[m][i]);
+        }
+    }
+}
 
 /**
- * @brief Métrica de Prometheus para el número de procesos
+ * @brief Agrega a una sección el encabezado de una familia de métricas.
+ * @param out Sección.
+ * @param name Nombre de la métrica.
+ * @param type Tipo de la métrica ("gauge" o "counter").
+ * @param help Descripción de la métrica.
  */
-static prom_gauge_t* proc_number_metric;
+static void render_family_header(text_buf_t* out, const char* name, const char* type, const char* help)
+{
+    text_buf_printf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
 
 /**
- * @brief Métrica de Prometheus para los cambios de contexto
+ * @brief Agrega a una sección un gauge sin etiquetas.
+ * @param out Sección.
+ * @param name Nombre de la métrica.
+ * @param help Descripción de la métrica.
+ * @param value Valor.
  */
-static prom_gauge_t* context_switches_metric;
+static void render_gauge(text_buf_t* out, const char* name, const char* help, double value)
+{
+    render_family_header(out, name, "gauge", help);
+    text_buf_printf(out, "%s %.17g\n", name, value);
+}
 
 /**
- * @brief Actualiza la métrica de uso de CPU.
+ * @brief Actualiza las métricas derivadas de /proc/stat.
  *
- * Obtiene el uso de CPU y actualiza la métrica correspondiente en Prometheus.
- * Si no se puede obtener el uso de CPU, se imprime un mensaje de error.
+ * Lee /proc/stat una única vez y, a partir de esa instantánea, renderiza el uso de CPU (total y por núcleo y modo),
+ * los procesos en ejecución y bloqueados, el momento de arranque y los contadores de cambios de contexto,
+ * interrupciones, softirqs y procesos creados (con sus tasas, si están habilitadas).
+ * Si no se puede leer /proc/stat, se imprime un mensaje de error.
+ *
+ * @param scratch Memoria temporal de la ejecución (no utilizada).
+ * @return 0 si se actualizaron, -1 si hubo un error.
  */
-void update_cpu_gauge()
+int update_proc_stat_gauges(arena_t* scratch)
 {
-    double usage = get_cpu_usage();
+    (void)scratch;
+    proc_stat_snapshot_t snapshot;
+    if (read_proc_stat(&snapshot) != 0)
+    {
+        fprintf(stderr, "Error al leer /proc/stat\n");
+        return -1;
+    }
+
+    double usage = get_cpu_usage(&snapshot);
+    const cpu_core_stats_t* cores = get_cpu_core_usage();
+    double procs = get_proc_number(&snapshot);
     if (usage >= 0)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(cpu_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        record_sample(SAMPLED_CPU_USAGE, usage);
     }
-    else
+    record_sample(SAMPLED_PROCESSES, procs);
+    record_sample(SAMPLED_BLOCKED_PROCESSES, (double)snapshot.procs_blocked);
+
+    // Sin un intervalo previo (primera lectura) no hay uso de CPU que informar
+    text_buf_reset(&stat_text);
+    if (usage >= 0)
+    {
+        render_gauge(&stat_text, "cpu_usage_percentage", "Porcentaje de uso de CPU", usage);
+    }
+    render_gauge(&stat_text, "execution_process_number", "Cantidad de procesos en ejecución", procs);
+    render_gauge(&stat_text, "boot_time_seconds", "Momento de arranque del sistema (epoch)", (double)snapshot.btime);
+    render_gauge(&stat_text, "blocked_process_number", "Cantidad de procesos bloqueados esperando I/O",
+                 (double)snapshot.procs_blocked);
+
+    // Los contadores se exportan como enteros exactos
+    const proc_stat_counters_t* counters = get_proc_stat_counters(&snapshot);
+    text_buf_printf(&stat_text,
+                    "# HELP context_switches_total Cambios de contexto desde el arranque\n"
+                    "# TYPE context_switches_total counter\ncontext_switches_total %llu\n"
+                    "# HELP interrupts_total Interrupciones atendidas desde el arranque\n"
+                    "# TYPE interrupts_total counter\ninterrupts_total %llu\n"
+                    "# HELP softirqs_total Softirqs atendidas desde el arranque\n"
+                    "# TYPE softirqs_total counter\nsoftirqs_total %llu\n"
+                    "# HELP processes_created_total Procesos creados desde el arranque\n"
+                    "# TYPE processes_created_total counter\nprocesses_created_total %llu\n",
+                    counters->ctxt.value, counters->intr.value, counters->softirqs.value, counters->processes.value);
+    if (rates_enabled && counters->valid)
+    {
+        render_gauge(&stat_text, "context_switches_per_second", "Cambios de contexto por segundo", counters->ctxt_rate);
+        render_gauge(&stat_text, "interrupts_per_second", "Interrupciones atendidas por segundo",
+                     counters->intr_rate);
+        render_gauge(&stat_text, "softirqs_per_second", "Softirqs atendidas por segundo", counters->softirqs_rate);
+        render_gauge(&stat_text, "processes_created_per_second", "Procesos creados por segundo",
+                     counters->processes_rate);
+    }
+    update_cpu_core_series(cores);
+    series_family_render(&cpu_core_series, &stat_text);
+    publish_section(&stat_text, &stat_section);
+
+    if (usage < 0)
     {
         fprintf(stderr, "Error al obtener el uso de CPU\n");
+        return -1;
     }
+    return 0;
 }
 
 /**
- * @brief Actualiza la métrica de uso de memoria.
+ * @brief Actualiza las métricas de memoria.
  *
- * Obtiene el uso de memoria y actualiza la métrica correspondiente en Prometheus.
+ * Obtiene el uso y el desglose de memoria (/proc/meminfo) y las tasas de fallos de página, swap y OOM kills
+ * (/proc/vmstat), y renderiza la sección de memoria.
  * Si no se puede obtener el uso de memoria, se imprime un mensaje de error.
+ *
+ * @param scratch Memoria temporal de la ejecución (no utilizada).
+ * @return 0 si se actualizaron, -1 si hubo un error.
  */
-void update_memory_gauge()
+int update_memory_gauge(arena_t* scratch)
 {
-    double usage = get_memory_usage();
-    if (usage >= 0)
+    (void)scratch;
+    int ret = 0;
+    text_buf_reset(&memory_text);
+    const meminfo_snapshot_t* mem = get_meminfo();
+    if (mem != NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(memory_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        double usage = compute_memory_usage(mem);
+        render_gauge(&memory_text, "memory_usage_percentage", "Porcentaje de uso de memoria", usage);
+        record_sample(SAMPLED_MEMORY_USAGE, usage);
+
+        // Valores en kB, salvo las cantidades de páginas enormes
+        const struct
+        {
+            const char* type;
+            unsigned long long kb;
+        } breakdown[] = {
+            {"total", mem->mem_total},
+            {"free", mem->mem_free},
+            {"available", mem->mem_available},
+            {"buffers", mem->buffers},
+            {"cached", mem->cached},
+            {"swap_cached", mem->swap_cached},
+            {"active", mem->active},
+            {"inactive", mem->inactive},
+            {"dirty", mem->dirty},
+            {"writeback", mem->writeback},
+            {"anon", mem->anon_pages},
+            {"mapped", mem->mapped},
+            {"shmem", mem->shmem},
+            {"slab", mem->slab},
+            {"slab_reclaimable", mem->sreclaimable},
+            {"slab_unreclaimable", mem->sunreclaim},
+            {"kernel_stack", mem->kernel_stack},
+            {"page_tables", mem->page_tables},
+            {"swap_total", mem->swap_total},
+            {"swap_free", mem->swap_free},
+            {"commit_limit", mem->commit_limit},
+            {"committed", mem->committed_as},
+            {"anon_hugepages", mem->anon_hugepages},
+            {"hugepage_size", mem->hugepagesize},
+        };
+        render_family_header(&memory_text, "memory_bytes", "gauge",
+                             "Desglose de la memoria del sistema (/proc/meminfo)");
+        for (size_t i = 0; i < sizeof(breakdown) / sizeof(breakdown[0]); i++)
+        {
+            text_buf_printf(&memory_text, "memory_bytes{type=\"%s\"} %llu\n", breakdown[i].type,
+                            breakdown[i].kb * 1024ULL);
+        }
+
+        const char* states[] = {"total", "free", "reserved", "surplus"};
+        unsigned long long pages[] = {mem->hugepages_total, mem->hugepages_free, mem->hugepages_rsvd,
+                                      mem->hugepages_surp};
+        render_family_header(&memory_text, "memory_hugepages", "gauge", "Cantidad de páginas enormes por estado");
+        for (int i = 0; i < 4; i++)
+        {
+            text_buf_printf(&memory_text, "memory_hugepages{state=\"%s\"} %llu\n", states[i], pages[i]);
+        }
     }
     else
     {
         fprintf(stderr, "Error al obtener el uso de memoria\n");
+        ret = -1;
+    }
+
+    // Primera lectura de /proc/vmstat: todavía no hay intervalo para las tasas
+    const vmstat_rates_t* rates = get_vmstat_rates();
+    if (rates == NULL)
+    {
+        fprintf(stderr, "Error al obtener las estadísticas de memoria virtual\n");
+        ret = -1;
+    }
+    else if (rates->valid)
+    {
+        record_sample(SAMPLED_PAGE_FAULTS, rates->pgfault);
+        record_sample(SAMPLED_MAJOR_PAGE_FAULTS, rates->pgmajfault);
+        render_gauge(&memory_text, "page_faults_per_second", "Fallos de página por segundo", rates->pgfault);
+        render_gauge(&memory_text, "major_page_faults_per_second",
+                     "Fallos de página que requirieron leer de disco por segundo", rates->pgmajfault);
+        render_family_header(&memory_text, "swap_pages_per_second", "gauge",
+                             "Páginas leídas desde swap y escritas a swap por segundo");
+        text_buf_printf(&memory_text,
+                        "swap_pages_per_second{direction=\"in\"} %.17g\n"
+                        "swap_pages_per_second{direction=\"out\"} %.17g\n",
+                        rates->pswpin, rates->pswpout);
+        render_gauge(&memory_text, "oom_kills_per_second", "Procesos terminados por falta de memoria por segundo",
+                     rates->oom_kill);
     }
+    publish_section(&memory_text, &memory_section);
+    return ret;
 }
 
 /**
- * @brief Actualiza la métrica de uso de I/O del disco.
+ * @brief Actualiza el promedio de carga y la información de presión del sistema.
  *
- * Obtiene el uso de I/O del disco y actualiza la métrica correspondiente en Prometheus.
- * Si no se puede obtener el uso de I/O del disco, se imprime un mensaje de error.
+ * Los recursos sin información de presión (kernel sin PSI) simplemente no se exportan.
+ *
+ * @param scratch Memoria temporal de la ejecución (no utilizada).
+ * @return 0 si se actualizaron, -1 si hubo un error.
  */
-
-void update_disk_io_gauge()
+int update_pressure_gauges(arena_t* scratch)
 {
-    double usage = get_IO_disco();
-    if (usage >= 0)
+    (void)scratch;
+    int ret = 0;
+    text_buf_reset(&pressure_text);
+    loadavg_snapshot_t load;
+    if (read_loadavg(&load) == 0)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(io_disk_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        render_family_header(&pressure_text, "load_average", "gauge", "Promedio de carga del sistema por período");
+        text_buf_printf(&pressure_text,
+                        "load_average{period=\"1m\"} %.17g\nload_average{period=\"5m\"} %.17g\n"
+                        "load_average{period=\"15m\"} %.17g\n",
+                        load.load1, load.load5, load.load15);
     }
     else
     {
-        fprintf(stderr, "Error al obtener el uso de memoria\n");
+        fprintf(stderr, "Error al obtener el promedio de carga\n");
+        ret = -1;
+    }
+
+    const pressure_sample_t* pressure[PRESSURE_RESOURCE_COUNT];
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        pressure[r] = get_pressure_stats((pressure_resource_t)r);
     }
+    render_family_header(&pressure_text, "pressure_stall_percentage", "gauge",
+                         "Porcentaje del tiempo con alguna (some) o todas (full) las tareas demoradas por falta del "
+                         "recurso, promediado en la ventana");
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        for (int k = 0; pressure[r] != NULL && k < PRESSURE_KIND_COUNT; k++)
+        {
+            if (!(pressure[r]->present & (1u << k)))
+            {
+                continue;
+            }
+            const pressure_line_t* line = &pressure[r]->lines[k];
+            const char* resource = pressure_resource_name((pressure_resource_t)r);
+            const char* kind = pressure_kind_name((pressure_kind_t)k);
+            const char* windows[] = {"10s", "60s", "300s"};
+            double values[] = {line->avg10, line->avg60, line->avg300};
+            for (int w = 0; w < 3; w++)
+            {
+                text_buf_printf(&pressure_text,
+                                "pressure_stall_percentage{resource=\"%s\",kind=\"%s\",window=\"%s\"} %.17g\n",
+                                resource, kind, windows[w], values[w]);
+            }
+        }
+    }
+    render_family_header(&pressure_text, "pressure_stall_time_seconds", "gauge",
+                         "Tiempo total con tareas demoradas por falta del recurso");
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        for (int k = 0; pressure[r] != NULL && k < PRESSURE_KIND_COUNT; k++)
+        {
+            if (pressure[r]->present & (1u << k))
+            {
+                text_buf_printf(&pressure_text, "pressure_stall_time_seconds{resource=\"%s\",kind=\"%s\"} %.17g\n",
+                                pressure_resource_name((pressure_resource_t)r),
+                                pressure_kind_name((pressure_kind_t)k), (double)pressure[r]->lines[k].total / 1e6);
+            }
+        }
+    }
+    publish_section(&pressure_text, &pressure_section);
+    return ret;
 }
 
-void update_red_gauge()
+/**
+ * @brief Habilita los disparadores de PSI.
+ * @param stall_ms Demora acumulada, dentro de la ventana, que activa un disparador.
+ * @param window_ms Ventana de evaluación en milisegundos.
+ * @param target Hilo recolector, al que se avisa con la señal.
+ * @param signo Señal con la que se avisa.
+ * @return 0 si se registró al menos un disparador, -1 en caso contrario.
+ */
+int enable_pressure_triggers(unsigned int stall_ms, unsigned int window_ms, pthread_t target, int signo)
 {
-    double usage = get_red_usage();
-    if (usage >= 0)
+    return pressure_trigger_start(&pressure_trigger, stall_ms, window_ms, target, signo);
+}
+
+/**
+ * @brief Detiene los disparadores de PSI, si están habilitados.
+ */
+void disable_pressure_triggers()
+{
+    pressure_trigger_stop(&pressure_trigger);
+}
+
+/**
+ * @brief Habilita o deshabilita las tasas por segundo de los contadores.
+ * @param enabled 1 para exportarlas, 0 para exportar sólo los contadores.
+ */
+void configure_rate_metrics(int enabled)
+{
+    rates_enabled = enabled;
+}
+
+/**
+ * @brief Gauges exportados por disco: nombre, descripción, campo de disk_device_t y si es la tasa de un contador.
+ */
+static const struct
+{
+    const char* name;
+    const char* help;
+    size_t offset;
+    int rate;
+} disk_gauge_families[] = {
+    {"disk_read_bytes_per_second", "Bytes leídos por segundo por disco", offsetof(disk_device_t, read_bytes_per_sec),
+     1},
+    {"disk_write_bytes_per_second", "Bytes escritos por segundo por disco",
+     offsetof(disk_device_t, write_bytes_per_sec), 1},
+    {"disk_reads_per_second", "Lecturas completadas por segundo por disco", offsetof(disk_device_t, reads_per_sec), 1},
+    {"disk_writes_per_second", "Escrituras completadas por segundo por disco", offsetof(disk_device_t, writes_per_sec),
+     1},
+    {"disk_utilization_percentage", "Porcentaje del tiempo con operaciones en curso por disco",
+     offsetof(disk_device_t, utilization), 0},
+    {"disk_queue_depth", "Cantidad promedio de operaciones en curso por disco", offsetof(disk_device_t, queue_depth),
+     0},
+    {"disk_await_milliseconds", "Tiempo promedio por operación por disco", offsetof(disk_device_t, await_ms), 0},
+};
+
+/**
+ * @brief Contadores exportados por disco: nombre, descripción, campo de disk_counters_t y factor de conversión.
+ */
+static const struct
+{
+    const char* name;
+    const char* help;
+    size_t offset;
+    unsigned long long scale;
+} disk_counter_families[] = {
+    {"disk_read_bytes_total", "Bytes leídos por disco", offsetof(disk_counters_t, read_sectors), DISK_SECTOR_SIZE},
+    {"disk_written_bytes_total", "Bytes escritos por disco", offsetof(disk_counters_t, write_sectors),
+     DISK_SECTOR_SIZE},
+    {"disk_reads_completed_total", "Lecturas completadas por disco", offsetof(disk_counters_t, reads), 1},
+    {"disk_writes_completed_total", "Escrituras completadas por disco", offsetof(disk_counters_t, writes), 1},
+};
+
+/**
+ * @brief Tasas exportadas por interfaz: nombre, descripción y campo de net_iface_t.
+ */
+static const struct
+{
+    const char* name;
+    const char* help;
+    size_t offset;
+} net_gauge_families[] = {
+    {"network_receive_bytes_per_second", "Bytes recibidos por segundo por interfaz",
+     offsetof(net_iface_t, rx_bytes_per_sec)},
+    {"network_transmit_bytes_per_second", "Bytes transmitidos por segundo por interfaz",
+     offsetof(net_iface_t, tx_bytes_per_sec)},
+    {"network_receive_packets_per_second", "Paquetes recibidos por segundo por interfaz",
+     offsetof(net_iface_t, rx_packets_per_sec)},
+    {"network_transmit_packets_per_second", "Paquetes transmitidos por segundo por interfaz",
+     offsetof(net_iface_t, tx_packets_per_sec)},
+    {"network_receive_errors_per_second", "Errores de recepción por segundo por interfaz",
+     offsetof(net_iface_t, rx_errors_per_sec)},
+    {"network_transmit_errors_per_second", "Errores de transmisión por segundo por interfaz",
+     offsetof(net_iface_t, tx_errors_per_sec)},
+    {"network_receive_drops_per_second", "Paquetes recibidos descartados por segundo por interfaz",
+     offsetof(net_iface_t, rx_drops_per_sec)},
+    {"network_transmit_drops_per_second", "Paquetes a transmitir descartados por segundo por interfaz",
+     offsetof(net_iface_t, tx_drops_per_sec)},
+};
+
+/**
+ * @brief Contadores exportados por interfaz: nombre, descripción y campo de net_counters_t.
+ */
+static const struct
+{
+    const char* name;
+    const char* help;
+    size_t offset;
+} net_counter_families[] = {
+    {"network_receive_bytes_total", "Bytes recibidos por interfaz", offsetof(net_counters_t, rx_bytes)},
+    {"network_transmit_bytes_total", "Bytes transmitidos por interfaz", offsetof(net_counters_t, tx_bytes)},
+    {"network_receive_packets_total", "Paquetes recibidos por interfaz", offsetof(net_counters_t, rx_packets)},
+    {"network_transmit_packets_total", "Paquetes transmitidos por interfaz", offsetof(net_counters_t, tx_packets)},
+    {"network_receive_errors_total", "Errores de recepción por interfaz", offsetof(net_counters_t, rx_errors)},
+    {"network_transmit_errors_total", "Errores de transmisión por interfaz", offsetof(net_counters_t, tx_errors)},
+    {"network_receive_drops_total", "Paquetes recibidos descartados por interfaz", offsetof(net_counters_t, rx_drops)},
+    {"network_transmit_drops_total", "Paquetes a transmitir descartados por interfaz",
+     offsetof(net_counters_t, tx_drops)},
+};
+
+/**
+ * @brief Series de los gauges y contadores de cada disco, en el orden de sus tablas.
+ */
+static series_family_t disk_gauge_series[sizeof(disk_gauge_families) / sizeof(disk_gauge_families[0])],
+    disk_counter_series[sizeof(disk_counter_families) / sizeof(disk_counter_families[0])];
+
+/**
+ * @brief Series de las tasas y contadores de cada interfaz, en el orden de sus tablas, y de su utilización.
+ */
+static series_family_t net_gauge_series[sizeof(net_gauge_families) / sizeof(net_gauge_families[0])],
+    net_counter_series[sizeof(net_counter_families) / sizeof(net_counter_families[0])], net_utilization_series;
+
+/**
+ * @brief Familias etiquetadas de todos los colectores, para exportar sus series descartadas.
+ */
+static const struct
+{
+    series_family_t* families;
+    size_t count;
+} labeled_series[] = {
+    {&cpu_core_series, 1},
+    {disk_gauge_series, sizeof(disk_gauge_series) / sizeof(disk_gauge_series[0])},
+    {disk_counter_series, sizeof(disk_counter_series) / sizeof(disk_counter_series[0])},
+    {net_gauge_series, sizeof(net_gauge_series) / sizeof(net_gauge_series[0])},
+    {&net_utilization_series, 1},
+    {net_counter_series, sizeof(net_counter_series) / sizeof(net_counter_series[0])},
+};
+
+/**
+ * @brief Actualiza las métricas de I/O de cada disco.
+ *
+ * Obtiene los contadores y las tasas por dispositivo desde /proc/diskstats y actualiza y renderiza las series
+ * etiquetadas por dispositivo. Si no se pueden obtener, se imprime un mensaje de error.
+ *
+ * @param scratch Memoria temporal de la ejecución (no utilizada).
+ * @return 0 si se actualizaron, -1 si hubo un error.
+ */
+int update_disk_io_gauge(arena_t* scratch)
+{
+    (void)scratch;
+    static const char* const names[] = {"device"};
+    disk_table_t* disks = get_disk_stats();
+    if (disks == NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(red_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        fprintf(stderr, "Error al obtener el uso de I/O de disco\n");
+        return -1;
     }
-    else
+
+    series_labels_tick(&disk_labels);
+    for (size_t i = 0; i < disks->capacity; i++)
+    {
+        disk_device_t* dev = &disks->slots[i];
+        if (dev->state != DISK_SLOT_USED || dev->filtered || !dev->has_prev)
+        {
+            continue;
+        }
+        const char* values[] = {dev->name};
+        unsigned int labels = series_labels_resolve(&disk_labels, &dev->labels, names, values, 1);
+
+        // Los contadores están desde la primera lectura de cada dispositivo, sin esperar a tener tasas
+        for (size_t f = 0; f < sizeof(disk_counter_families) / sizeof(disk_counter_families[0]); f++)
+        {
+            const unsigned long long* total =
+                (const unsigned long long*)((const char*)&dev->total + disk_counter_families[f].offset);
+            series_set_count(&disk_counter_series[f], labels, *total * disk_counter_families[f].scale);
+        }
+        if (!dev->valid)
+        {
+            continue;
+        }
+        for (size_t f = 0; f < sizeof(disk_gauge_families) / sizeof(disk_gauge_families[0]); f++)
+        {
+            if (rates_enabled || !disk_gauge_families[f].rate)
+            {
+                series_set(&disk_gauge_series[f], labels,
+                           *(const double*)((const char*)dev + disk_gauge_families[f].offset));
+            }
+        }
+    }
+
+    text_buf_reset(&disk_text);
+    for (size_t f = 0; f < sizeof(disk_gauge_series) / sizeof(disk_gauge_series[0]); f++)
+    {
+        series_family_render(&disk_gauge_series[f], &disk_text);
+    }
+    for (size_t f = 0; f < sizeof(disk_counter_series) / sizeof(disk_counter_series[0]); f++)
+    {
+        series_family_render(&disk_counter_series[f], &disk_text);
+    }
+    publish_section(&disk_text, &disk_section);
+    return 0;
+}
+
+/**
+ * @brief Actualiza las métricas de tráfico de cada interfaz de red.
+ *
+ * Obtiene los contadores y las tasas por interfaz desde /proc/net/dev y actualiza y renderiza las series etiquetadas
+ * por interfaz. Si no se pueden obtener, se imprime un mensaje de error.
+ *
+ * @param scratch Memoria temporal de la ejecución (no utilizada).
+ * @return 0 si se actualizaron, -1 si hubo un error.
+ */
+int update_red_gauge(arena_t* scratch)
+{
+    (void)scratch;
+    static const char* const names[] = {"interface", "direction"};
+    net_table_t* ifaces = get_net_stats();
+    if (ifaces == NULL)
     {
         fprintf(stderr, "Error al obtener el uso de red\n");
+        return -1;
     }
+
+    series_labels_tick(&net_labels);
+    for (size_t i = 0; i < ifaces->capacity; i++)
+    {
+        net_iface_t* iface = &ifaces->slots[i];
+        if (iface->state != NET_SLOT_USED || iface->filtered || !iface->has_prev)
+        {
+            continue;
+        }
+        const char* values[] = {iface->name};
+        unsigned int labels = series_labels_resolve(&net_labels, &iface->labels[0], names, values, 1);
+        for (size_t f = 0; f < sizeof(net_counter_families) / sizeof(net_counter_families[0]); f++)
+        {
+            const unsigned long long* total =
+                (const unsigned long long*)((const char*)&iface->total + net_counter_families[f].offset);
+            series_set_count(&net_counter_series[f], labels, *total);
+        }
+        if (!iface->valid)
+        {
+            continue;
+        }
+        for (size_t f = 0; rates_enabled && f < sizeof(net_gauge_families) / sizeof(net_gauge_families[0]); f++)
+        {
+            series_set(&net_gauge_series[f], labels,
+                       *(const double*)((const char*)iface + net_gauge_families[f].offset));
+        }
+
+        // Sin velocidad conocida (interfaces virtuales) no hay utilización que informar
+        if (iface->speed_bps > 0.0)
+        {
+            const char* rx_values[] = {iface->name, "receive"};
+            const char* tx_values[] = {iface->name, "transmit"};
+            unsigned int rx_labels = series_labels_resolve(&net_labels, &iface->labels[1], names, rx_values, 2);
+            unsigned int tx_labels = series_labels_resolve(&net_labels, &iface->labels[2], names, tx_values, 2);
+            series_set(&net_utilization_series, rx_labels, iface->rx_utilization);
+            series_set(&net_utilization_series, tx_labels, iface->tx_utilization);
+        }
+    }
+
+    text_buf_reset(&net_text);
+    for (size_t f = 0; f < sizeof(net_gauge_series) / sizeof(net_gauge_series[0]); f++)
+    {
+        series_family_render(&net_gauge_series[f], &net_text);
+    }
+    series_family_render(&net_utilization_series, &net_text);
+    for (size_t f = 0; f < sizeof(net_counter_series) / sizeof(net_counter_series[0]); f++)
+    {
+        series_family_render(&net_counter_series[f], &net_text);
+    }
+    publish_section(&net_text, &net_section);
+    return 0;
 }
 
 /**
- * @brief Actualiza la métrica de procesos en ejecución.
+ * @brief Configura el colector de procesos.
+ * @param top Cantidad de procesos a exportar por recurso (CPU, memoria residente e I/O).
+ */
+void configure_process_metrics(size_t top)
+{
+    process_top = top < PROCESS_TOP_MAX ? top : PROCESS_TOP_MAX;
+}
+
+/**
+ * @brief Agrega a la exposición de procesos una familia con los N procesos que más consumen según un criterio.
+ * @param table Tabla de procesos.
+ * @param key Criterio de selección.
+ * @param name Nombre de la métrica.
+ * @param help Descripción de la métrica.
+ */
+static void render_process_family(const process_table_t* table, process_top_key_t key, const char* name,
+                                  const char* help)
+{
+    const process_entry_t* top[PROCESS_TOP_MAX];
+    size_t count = process_top_n(table, key, top, process_top);
+
+    text_buf_printf(&process_text, "# HELP %s %s\n# TYPE %s gauge\n", name, help, name);
+    for (size_t i = 0; i < count; i++)
+    {
+        const process_entry_t* entry = top[i];
+        if (key == PROCESS_TOP_IO)
+        {
+            // La I/O se selecciona por el total pero se informa por dirección
+            const char* directions[] = {"read", "write"};
+            double values[] = {entry->read_bytes_per_sec, entry->write_bytes_per_sec};
+            for (int d = 0; d < 2; d++)
+            {
+                text_buf_printf(&process_text, "%s{pid=\"%d\",comm=\"", name, entry->pid);
+                text_buf_append_label_value(&process_text, entry->cur.comm);
+                text_buf_printf(&process_text, "\",direction=\"%s\"} %.17g\n", directions[d], values[d]);
+            }
+            continue;
+        }
+        double value = key == PROCESS_TOP_CPU ? entry->cpu_percent : entry->rss_bytes;
+        text_buf_printf(&process_text, "%s{pid=\"%d\",comm=\"", name, entry->pid);
+        text_buf_append_label_value(&process_text, entry->cur.comm);
+        text_buf_printf(&process_text, "\"} %.17g\n", value);
+    }
+}
+
+/**
+ * @brief Actualiza la exposición de los procesos que más CPU, memoria residente e I/O consumen.
+ *
+ * Sólo se vuelve a renderizar cuando se completó un barrido; mientras el barrido avanza repartido entre ciclos se
+ * sigue exponiendo el anterior, junto con el instante en que terminó y lo que tardó, para que la antigüedad de los
+ * datos sea visible (time() - top_process_last_scan_timestamp_seconds).
  *
- * Obtiene la cantidad de procesos ejecutandose y actualiza la métrica correspondiente en Prometheus.
- * Si no se puede obtener la cantidad de procesos, se imprime un mensaje de error.
+ * @param scratch Memoria temporal de la ejecución (no utilizada).
+ * @return 0 si se actualizaron, -1 si hubo un error.
+ */
+int update_process_gauges(arena_t* scratch)
+{
+    (void)scratch;
+    if (process_top == 0)
+    {
+        return 0;
+    }
+
+    const process_table_t* table = get_process_stats();
+    if (table == NULL)
+    {
+        fprintf(stderr, "Error al obtener las estadísticas de procesos\n");
+        return -1;
+    }
+    if (!table->scanned)
+    {
+        return 0;
+    }
+
+    text_buf_reset(&process_text);
+    render_process_family(table, PROCESS_TOP_CPU, "top_process_cpu_usage_percentage",
+                          "Porcentaje de un núcleo usado por los procesos que más CPU consumen");
+    render_process_family(table, PROCESS_TOP_RSS, "top_process_resident_memory_bytes",
+                          "Memoria residente de los procesos que más memoria ocupan");
+    render_process_family(table, PROCESS_TOP_IO, "top_process_io_bytes_per_second",
+                          "Bytes por segundo leídos y escritos del almacenamiento por los procesos con más I/O");
+    text_buf_printf(&process_text,
+                    "# HELP top_process_last_scan_timestamp_seconds Instante en que se completó el último barrido de "
+                    "procesos\n# TYPE top_process_last_scan_timestamp_seconds gauge\n"
+                    "top_process_last_scan_timestamp_seconds %.17g\n",
+                    table->scanned_wall);
+    text_buf_printf(&process_text,
+                    "# HELP top_process_scan_duration_seconds Segundos que tardó el último barrido de procesos, "
+                    "repartido entre ciclos para no superar el presupuesto de CPU\n"
+                    "# TYPE top_process_scan_duration_seconds gauge\ntop_process_scan_duration_seconds %.17g\n",
+                    table->scan_duration);
+    text_buf_printf(&process_text,
+                    "# HELP top_process_scan_cpu_seconds Segundos de CPU consumidos por el último barrido de procesos\n"
+                    "# TYPE top_process_scan_cpu_seconds gauge\ntop_process_scan_cpu_seconds %.17g\n",
+                    table->last_scan_cpu);
+    publish_section(&process_text, &process_section);
+    return 0;
+}
+
+/**
+ * @brief Configura el colector de cgroups.
+ * @param root Punto de montaje de cgroup v2.
+ * @param max_depth Profundidad máxima de los cgroups exportados (0: sin límite).
  */
+void configure_cgroup_metrics(const char* root, unsigned int max_depth)
+{
+    cgroup_root = root;
+    cgroup_max_depth = max_depth;
+}
 
-void update_proc_number()
+/**
+ * @brief Familias de métricas por cgroup, en el orden en que se exponen.
+ */
+typedef enum
 {
-    double number = get_proc_number();
-    if (number >= 0)
+    CGROUP_FAMILY_CPU_USAGE,
+    CGROUP_FAMILY_CPU_PERIODS,
+    CGROUP_FAMILY_CPU_THROTTLED_PERIODS,
+    CGROUP_FAMILY_CPU_THROTTLED,
+    CGROUP_FAMILY_MEMORY_USAGE,
+    CGROUP_FAMILY_MEMORY_STAT,
+    CGROUP_FAMILY_PAGE_FAULTS,
+    CGROUP_FAMILY_IO_BYTES,
+    CGROUP_FAMILY_IO_OPERATIONS,
+    CGROUP_FAMILY_PRESSURE,
+    CGROUP_FAMILY_COUNT,
+} cgroup_family_t;
+
+/**
+ * @brief Nombre, tipo y descripción de cada familia de métricas por cgroup, en el orden de cgroup_family_t.
+ */
+static const struct
+{
+    const char* name;
+    const char* type;
+    const char* help;
+} cgroup_families[CGROUP_FAMILY_COUNT] = {
+    {"cgroup_cpu_usage_seconds_total", "counter", "Tiempo de CPU consumido por el cgroup, por modo"},
+    {"cgroup_cpu_periods_total", "counter", "Períodos de cuota de CPU transcurridos"},
+    {"cgroup_cpu_throttled_periods_total", "counter", "Períodos en que el cgroup agotó su cuota de CPU"},
+    {"cgroup_cpu_throttled_seconds_total", "counter", "Tiempo total en que el cgroup estuvo limitado por su cuota"},
+    {"cgroup_memory_usage_bytes", "gauge", "Memoria usada por el cgroup (memory.current)"},
+    {"cgroup_memory_stat_bytes", "gauge", "Desglose de la memoria del cgroup (memory.stat)"},
+    {"cgroup_memory_page_faults_total", "counter", "Fallos de página del cgroup, por tipo"},
+    {"cgroup_io_bytes_total", "counter", "Bytes leídos y escritos por el cgroup en todos los discos"},
+    {"cgroup_io_operations_total", "counter", "Operaciones de lectura y escritura del cgroup en todos los discos"},
+    {"cgroup_pressure_stall_seconds_total", "counter",
+     "Tiempo con alguna (some) o todas (full) las tareas del cgroup demoradas por falta del recurso"},
+};
+
+/**
+ * @brief Agrega a la exposición de cgroups una muestra de un cgroup.
+ * @param family Familia de la métrica.
+ * @param entry Cgroup.
+ * @param labels Etiquetas adicionales ya formateadas (",clave=\"valor\"...") o "".
+ * @param value Valor de la muestra.
+ */
+static void render_cgroup_sample(cgroup_family_t family, const cgroup_entry_t* entry, const char* labels,
+                                 double value)
+{
+    text_buf_printf(&cgroup_text, "%s{cgroup=\"/", cgroup_families[family].name);
+    text_buf_append_label_value(&cgroup_text, entry->path);
+    text_buf_printf(&cgroup_text, "\"%s} %.17g\n", labels, value);
+}
+
+/**
+ * @brief Agrega a la exposición de cgroups las muestras de una familia para un cgroup.
+ * @param family Familia de la métrica.
+ * @param entry Cgroup (sólo se exportan los valores cuyos archivos se pudieron leer).
+ */
+static void render_cgroup_family(cgroup_family_t family, const cgroup_entry_t* entry)
+{
+    const cgroup_sample_t* sample = &entry->sample;
+    char labels[64];
+
+    switch (family)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(proc_number_metric, number, NULL);
-        pthread_mutex_unlock(&lock);
+    case CGROUP_FAMILY_CPU_USAGE:
+        if (sample->flags & CGROUP_HAS_CPU)
+        {
+            render_cgroup_sample(family, entry, ",mode=\"user\"", (double)sample->user_usec / 1e6);
+            render_cgroup_sample(family, entry, ",mode=\"system\"", (double)sample->system_usec / 1e6);
+        }
+        break;
+    case CGROUP_FAMILY_CPU_PERIODS:
+        if (sample->flags & CGROUP_HAS_THROTTLING)
+        {
+            render_cgroup_sample(family, entry, "", (double)sample->nr_periods);
+        }
+        break;
+    case CGROUP_FAMILY_CPU_THROTTLED_PERIODS:
+        if (sample->flags & CGROUP_HAS_THROTTLING)
+        {
+            render_cgroup_sample(family, entry, "", (double)sample->nr_throttled);
+        }
+        break;
+    case CGROUP_FAMILY_CPU_THROTTLED:
+        if (sample->flags & CGROUP_HAS_THROTTLING)
+        {
+            render_cgroup_sample(family, entry, "", (double)sample->throttled_usec / 1e6);
+        }
+        break;
+    case CGROUP_FAMILY_MEMORY_USAGE:
+        if (sample->flags & CGROUP_HAS_MEMORY)
+        {
+            render_cgroup_sample(family, entry, "", (double)sample->memory_current);
+        }
+        break;
+    case CGROUP_FAMILY_MEMORY_STAT:
+        for (int i = 0; i < CGROUP_MEMSTAT_COUNT && (sample->flags & CGROUP_HAS_MEMORY_STAT); i++)
+        {
+            snprintf(labels, sizeof(labels), ",type=\"%s\"", cgroup_memstat_name((cgroup_memstat_t)i));
+            render_cgroup_sample(family, entry, labels, (double)sample->memory_stat[i]);
+        }
+        break;
+    case CGROUP_FAMILY_PAGE_FAULTS:
+        if (sample->flags & CGROUP_HAS_MEMORY_STAT)
+        {
+            // pgfault incluye a los fallos mayores
+            unsigned long long minor =
+                sample->pgfault >= sample->pgmajfault ? sample->pgfault - sample->pgmajfault : 0;
+            render_cgroup_sample(family, entry, ",type=\"minor\"", (double)minor);
+            render_cgroup_sample(family, entry, ",type=\"major\"", (double)sample->pgmajfault);
+        }
+        break;
+    case CGROUP_FAMILY_IO_BYTES:
+        if (sample->flags & CGROUP_HAS_IO)
+        {
+            render_cgroup_sample(family, entry, ",direction=\"read\"", (double)sample->io_rbytes);
+            render_cgroup_sample(family, entry, ",direction=\"write\"", (double)sample->io_wbytes);
+        }
+        break;
+    case CGROUP_FAMILY_IO_OPERATIONS:
+        if (sample->flags & CGROUP_HAS_IO)
+        {
+            render_cgroup_sample(family, entry, ",direction=\"read\"", (double)sample->io_rios);
+            render_cgroup_sample(family, entry, ",direction=\"write\"", (double)sample->io_wios);
+        }
+        break;
+    case CGROUP_FAMILY_PRESSURE:
+        for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+        {
+            for (int k = 0; k < PRESSURE_KIND_COUNT; k++)
+            {
+                if (sample->pressure[r].present & (1u << k))
+                {
+                    snprintf(labels, sizeof(labels), ",resource=\"%s\",kind=\"%s\"",
+                             pressure_resource_name((pressure_resource_t)r), pressure_kind_name((pressure_kind_t)k));
+                    render_cgroup_sample(family, entry, labels, (double)sample->pressure[r].lines[k].total / 1e6);
+                }
+            }
+        }
+        break;
+    default:
+        break;
     }
-    else
+}
+
+/**
+ * @brief Actualiza la exposición de las métricas por cgroup.
+ *
+ * Los contadores se exportan tal como los informa el kernel (las tasas se calculan en Prometheus con rate()).
+ *
+ * @param scratch Memoria temporal de la ejecución (para el recorrido de la jerarquía).
+ * @return 0 si se actualizaron, -1 si hubo un error.
+ */
+int update_cgroup_gauges(arena_t* scratch)
+{
+    if (!cgroups_enabled)
+    {
+        return 0;
+    }
+
+    const cgroup_tree_t* tree = get_cgroup_stats(scratch);
+    if (tree == NULL)
     {
-        fprintf(stderr, "Error al obtener la cantidad de procesos\n");
+        fprintf(stderr, "Error al obtener las estadísticas de cgroups\n");
+        return -1;
     }
+
+    text_buf_reset(&cgroup_text);
+    for (int family = 0; family < CGROUP_FAMILY_COUNT; family++)
+    {
+        text_buf_printf(&cgroup_text, "# HELP %s %s\n# TYPE %s %s\n", cgroup_families[family].name,
+                        cgroup_families[family].help, cgroup_families[family].name, cgroup_families[family].type);
+        for (size_t i = 0; i < tree->capacity; i++)
+        {
+            if (tree->slots[i].state == CGROUP_SLOT_USED)
+            {
+                render_cgroup_family((cgroup_family_t)family, &tree->slots[i]);
+            }
+        }
+    }
+    publish_section(&cgroup_text, &cgroup_section);
+    return 0;
 }
+
 /**
- * @brief Actualiza la métrica de cambios de contexto.
+ * @brief Configura la duración de las ventanas deslizantes.
+ * @param ms Duración en milisegundos (0: deshabilitadas).
+ */
+void configure_window_metrics(unsigned long ms)
+{
+    window_ms = ms;
+}
+
+/**
+ * @brief Configura la cardinalidad de las métricas etiquetadas.
+ * @param limit Series admitidas por métrica.
+ * @param max_idle Ciclos sin actualizarse tras los cuales se quita una serie.
+ */
+void configure_series_limits(size_t limit, unsigned long max_idle)
+{
+    series_limit = limit;
+    series_max_idle = max_idle;
+}
+
+/**
+ * @brief Renderiza el mínimo, el máximo, el promedio y los cuantiles de la ventana de cada serie muestreada.
+ *
+ * Las series sin muestras en la ventana (colector deshabilitado o demorado) no se exportan.
  *
- * Obtiene los cambios de contexto que se están dando y actualiza la métrica correspondiente en Prometheus.
- * Si no se puede obtener la cantidad de cambios de contexto, se imprime un mensaje de error.
+ * @param out Exposición en armado.
  */
+static void render_window_metrics(text_buf_t* out)
+{
+    double seconds = (double)window_ms / 1000.0;
 
-void update_context_switches()
+    if (!windows_enabled)
+    {
+        return;
+    }
+    for (int i = 0; i < SAMPLED_SERIES_COUNT; i++)
+    {
+        window_summary_t summary;
+        window_stats_summary(&windows[i], &summary);
+        if (summary.count == 0)
+        {
+            continue;
+        }
+        const char* name = sampled_names[i];
+        text_buf_printf(out,
+                        "# HELP %s_min_window Mínimo de %s en los últimos %g s\n# TYPE %s_min_window gauge\n"
+                        "%s_min_window %.17g\n",
+                        name, name, seconds, name, name, summary.min);
+        text_buf_printf(out,
+                        "# HELP %s_max_window Máximo de %s en los últimos %g s\n# TYPE %s_max_window gauge\n"
+                        "%s_max_window %.17g\n",
+                        name, name, seconds, name, name, summary.max);
+        text_buf_printf(out,
+                        "# HELP %s_avg_window Promedio de %s en los últimos %g s\n# TYPE %s_avg_window gauge\n"
+                        "%s_avg_window %.17g\n",
+                        name, name, seconds, name, name, summary.mean);
+        text_buf_printf(out,
+                        "# HELP %s_quantile_window Cuantiles de %s en los últimos %g s (error relativo del 1%%)\n"
+                        "# TYPE %s_quantile_window gauge\n"
+                        "%s_quantile_window{quantile=\"0.5\"} %.17g\n"
+                        "%s_quantile_window{quantile=\"0.95\"} %.17g\n"
+                        "%s_quantile_window{quantile=\"0.99\"} %.17g\n",
+                        name, name, seconds, name, name, summary.p50, name, summary.p95, name, summary.p99);
+    }
+}
+
+/**
+ * @brief Habilita el historial de muestras de alta resolución.
+ * @param path Ruta del archivo de historial.
+ * @param size_mb Tamaño del archivo en MiB.
+ * @return 0 si se habilitó, -1 en caso de error.
+ */
+int enable_history(const char* path, unsigned long size_mb)
+{
+    return history_open(&history, path, size_mb, sampled_names, SAMPLED_SERIES_COUNT);
+}
+
+/**
+ * @brief Cierra el historial.
+ */
+void disable_history(void)
+{
+    history_close(&history);
+}
+
+/**
+ * @brief Habilita el envío de cada publicación a un receptor remoto.
+ * @param config Configuración del envío, con el destino ya interpretado.
+ * @return 0 si se habilitó, -1 en caso de error.
+ */
+int enable_push(const push_config_t* config)
+{
+    return push_start(&pusher, config);
+}
+
+/**
+ * @brief Envía lo pendiente y detiene el envío.
+ */
+void disable_push(void)
+{
+    push_stop(&pusher);
+}
+
+/**
+ * @brief Cuenta un scrape de /metrics respondido.
+ * @param repeated 1 si la exposición ya se había enviado antes.
+ * @param body_len Bytes del cuerpo enviado.
+ */
+void observe_scrape(int repeated, size_t body_len)
 {
-    double number = get_context_switches();
-    if (number >= 0)
+    atomic_fetch_add(&scrapes_served, 1);
+    if (repeated)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(context_switches_metric, number, NULL);
-        pthread_mutex_unlock(&lock);
+        atomic_fetch_add(&scrape_cache_hits, 1);
     }
-    else
+    histogram_observe(&response_size, body_len);
+}
+
+/**
+ * @brief Obtiene el historial de muestras.
+ * @return Historial, o NULL si no se habilitó.
+ */
+history_t* get_history(void)
+{
+    return history.map != NULL ? &history : NULL;
+}
+
+/**
+ * @brief Renderiza los plazos vencidos y el estado de cada colector.
+ * @param out Exposición en armado.
+ * @param collectors Registro de colectores.
+ */
+static void render_collector_metrics(text_buf_t* out, const collector_registry_t* collectors)
+{
+    render_family_header(out, "collector_timeout_total", "counter",
+                         "Ejecuciones de cada colector que no terminaron dentro de su plazo");
+    for (size_t i = 0; i < collectors->count; i++)
     {
-        fprintf(stderr, "Error al obtener la cantidad de cambios de contexto\n");
+        const collector_t* collector = &collectors->collectors[i];
+        if (collector->enabled)
+        {
+            text_buf_printf(out, "collector_timeout_total{collector=\"%s\"} %llu\n", collector->name,
+                            collector->timeouts);
+        }
+    }
+    render_family_header(out, "collector_stale", "gauge",
+                         "1 si los valores del colector son de una ejecución anterior porque la última no terminó");
+    for (size_t i = 0; i < collectors->count; i++)
+    {
+        const collector_t* collector = &collectors->collectors[i];
+        if (collector->enabled)
+        {
+            text_buf_printf(out, "collector_stale{collector=\"%s\"} %d\n", collector->name, collector->stale);
+        }
     }
 }
 
 /**
- * @brief Expone las métricas vía HTTP en el puerto 8000.
- *
- * Obtiene todas las metricas y las actualiza en Prometheus.
- * Si no se puede iniciar el servidor, se imprime un mensaje de error.
+ * @brief Renderiza las métricas del propio exportador: duración y errores de cada colector, duración del
+ * renderizado, bytes enviados y consumo del proceso.
+ * @param out Exposición en armado.
+ * @param collectors Registro de colectores.
  */
-void* expose_metrics(void* arg)
+static void render_self_metrics(text_buf_t* out, const collector_registry_t* collectors)
 {
-    (void)arg; // Argumento no utilizado
+    char labels[64];
 
-    // Aseguramos que el manejador HTTP esté adjunto al registro por defecto
-    promhttp_set_active_collector_registry(NULL);
+    text_buf_printf(out,
+                    "# HELP exporter_scrapes_total Cantidad de scrapes de /metrics respondidos\n"
+                    "# TYPE exporter_scrapes_total counter\nexporter_scrapes_total %llu\n"
+                    "# HELP exporter_scrape_cache_hits_total Cantidad de scrapes respondidos con una exposición en "
+                    "caché ya enviada antes\n# TYPE exporter_scrape_cache_hits_total counter\n"
+                    "exporter_scrape_cache_hits_total %llu\n",
+                    atomic_load(&scrapes_served), atomic_load(&scrape_cache_hits));
+    text_buf_printf(out, "# HELP exporter_collector_duration_seconds Duración de cada ejecución de un colector\n"
+                         "# TYPE exporter_collector_duration_seconds histogram\n");
+    for (size_t i = 0; i < collectors->count; i++)
+    {
+        const collector_t* collector = &collectors->collectors[i];
+        if (collector->enabled)
+        {
+            snprintf(labels, sizeof(labels), "collector=\"%s\"", collector->name);
+            histogram_render(&collector->duration, out, "exporter_collector_duration_seconds", labels);
+        }
+    }
+    text_buf_printf(out, "# HELP exporter_collector_errors_total Ejecuciones de un colector que fallaron\n"
+                         "# TYPE exporter_collector_errors_total counter\n");
+    for (size_t i = 0; i < collectors->count; i++)
+    {
+        const collector_t* collector = &collectors->collectors[i];
+        if (collector->enabled)
+        {
+            text_buf_printf(out, "exporter_collector_errors_total{collector=\"%s\"} %llu\n", collector->name,
+                            atomic_load_explicit(&collector->errors, memory_order_relaxed));
+        }
+    }
+    text_buf_printf(out, "# HELP exporter_series_dropped_total Actualizaciones de series nuevas descartadas por "
+                         "superar el límite de series de la métrica\n"
+                         "# TYPE exporter_series_dropped_total counter\n");
+    for (size_t g = 0; g < sizeof(labeled_series) / sizeof(labeled_series[0]); g++)
+    {
+        for (size_t f = 0; f < labeled_series[g].count; f++)
+        {
+            const series_family_t* family = &labeled_series[g].families[f];
+            if (family->name != NULL)
+            {
+                text_buf_printf(out, "exporter_series_dropped_total{metric=\"%s\"} %llu\n", family->name,
+                                atomic_load_explicit(&family->dropped, memory_order_relaxed));
+            }
+        }
+    }
 
-    // Iniciamos el servidor HTTP en el puerto 8000
-    struct MHD_Daemon* daemon = promhttp_start_daemon(MHD_USE_SELECT_INTERNALLY, 8000, NULL, NULL);
-    if (daemon == NULL)
+    text_buf_printf(out, "# HELP exporter_collector_scratch_high_water_bytes Máximo de memoria temporal usada en una "
+                         "ejecución de un colector\n# TYPE exporter_collector_scratch_high_water_bytes gauge\n");
+    for (size_t i = 0; i < collectors->count; i++)
     {
-        fprintf(stderr, "Error al iniciar el servidor HTTP\n");
-        return NULL;
+        const collector_t* collector = &collectors->collectors[i];
+        if (collector->enabled)
+        {
+            text_buf_printf(out, "exporter_collector_scratch_high_water_bytes{collector=\"%s\"} %zu\n", collector->name,
+                            atomic_load_explicit(&collector->scratch_peak, memory_order_relaxed));
+        }
     }
+    text_buf_printf(out, "# HELP exporter_collector_scratch_blocks_total Bloques reservados por la memoria temporal de "
+                         "un colector (no crece en régimen)\n"
+                         "# TYPE exporter_collector_scratch_blocks_total counter\n");
+    for (size_t i = 0; i < collectors->count; i++)
+    {
+        const collector_t* collector = &collectors->collectors[i];
+        if (collector->enabled)
+        {
+            text_buf_printf(out, "exporter_collector_scratch_blocks_total{collector=\"%s\"} %zu\n", collector->name,
+                            atomic_load_explicit(&collector->scratch_blocks, memory_order_relaxed));
+        }
+    }
+    text_buf_printf(out, "# HELP exporter_render_duration_seconds Duración de cada renderizado y publicación "
+                         "de la exposición\n# TYPE exporter_render_duration_seconds histogram\n");
+    histogram_render(&render_duration, out, "exporter_render_duration_seconds", "");
+    text_buf_printf(out, "# HELP exporter_response_size_bytes Bytes del cuerpo de cada respuesta a /metrics\n"
+                         "# TYPE exporter_response_size_bytes histogram\n");
+    histogram_render(&response_size, out, "exporter_response_size_bytes", "");
 
-    // Mantenemos el servidor en ejecución
-    while (1)
+    self_stats_t self;
+    if (read_self_stats(&self) != 0)
     {
-        sleep(1);
+        fprintf(stderr, "Error al obtener el consumo del exportador\n");
+        return;
     }
+    text_buf_printf(out,
+                    "# HELP exporter_cpu_seconds_total Tiempo de CPU consumido por el exportador, por modo\n"
+                    "# TYPE exporter_cpu_seconds_total counter\n"
+                    "exporter_cpu_seconds_total{mode=\"user\"} %.17g\n"
+                    "exporter_cpu_seconds_total{mode=\"system\"} %.17g\n"
+                    "# HELP exporter_resident_memory_bytes Memoria residente del exportador\n"
+                    "# TYPE exporter_resident_memory_bytes gauge\n"
+                    "exporter_resident_memory_bytes %llu\n"
+                    "# HELP exporter_virtual_memory_bytes Memoria virtual del exportador\n"
+                    "# TYPE exporter_virtual_memory_bytes gauge\n"
+                    "exporter_virtual_memory_bytes %llu\n"
+                    "# HELP exporter_open_fds Descriptores de archivo abiertos por el exportador\n"
+                    "# TYPE exporter_open_fds gauge\n"
+                    "exporter_open_fds %llu\n"
+                    "# HELP exporter_context_switches_total Cambios de contexto de los hilos del exportador\n"
+                    "# TYPE exporter_context_switches_total counter\n"
+                    "exporter_context_switches_total{type=\"voluntary\"} %llu\n"
+                    "exporter_context_switches_total{type=\"involuntary\"} %llu\n",
+                    self.user_seconds, self.system_seconds, self.resident_bytes, self.virtual_bytes, self.open_fds,
+                    self.voluntary_csw, self.involuntary_csw);
 
-    // Nunca debería llegar aquí
-    MHD_stop_daemon(daemon);
-    return NULL;
+    if (pusher.running)
+    {
+        text_buf_printf(out,
+                        "# HELP exporter_push_samples_total Muestras del envío remoto, por resultado\n"
+                        "# TYPE exporter_push_samples_total counter\n"
+                        "exporter_push_samples_total{result=\"sent\"} %llu\n"
+                        "exporter_push_samples_total{result=\"dropped\"} %llu\n"
+                        "exporter_push_samples_total{result=\"failed\"} %llu\n"
+                        "# HELP exporter_push_retries_total Reintentos de lotes del envío remoto\n"
+                        "# TYPE exporter_push_retries_total counter\n"
+                        "exporter_push_retries_total %llu\n"
+                        "# HELP exporter_push_queue_samples Muestras esperando en la cola del envío remoto\n"
+                        "# TYPE exporter_push_queue_samples gauge\n"
+                        "exporter_push_queue_samples %llu\n",
+                        atomic_load_explicit(&pusher.sent, memory_order_relaxed),
+                        atomic_load_explicit(&pusher.dropped, memory_order_relaxed),
+                        atomic_load_explicit(&pusher.failed, memory_order_relaxed),
+                        atomic_load_explicit(&pusher.retries, memory_order_relaxed),
+                        atomic_load_explicit(&pusher.queued, memory_order_relaxed));
+    }
 }
 
 /**
- * @brief Inicializa el mutex y las métricas de Prometheus.
+ * @brief Publica las métricas actualizadas en este ciclo para el servidor HTTP.
  *
- * Inicializa el mutex y las métricas de Prometheus para el uso de CPU y memoria.
- * Si no se pueden inicializar, se imprime un mensaje de error.
+ * Escribe la exposición una sola vez, desde el hilo recolector, directamente en el texto de la instantánea de
+ * repuesto: las secciones terminadas de los colectores seguidas de las ventanas y las métricas del propio exportador.
+ * Después la publica como instantánea inmutable (con su copia gzip). Si no se puede armar, el servidor sigue
+ * respondiendo con la instantánea anterior.
+ *
+ * @param collectors Registro de colectores, del que se exportan los plazos vencidos y los colectores desactualizados.
  */
-void init_metrics()
+void publish_metrics(const collector_registry_t* collectors)
 {
-    // Inicializamos el mutex
-    if (pthread_mutex_init(&lock, NULL) != 0)
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    text_buf_t* text = metrics_snapshot_begin();
+    if (text == NULL)
     {
-        fprintf(stderr, "Error al inicializar el mutex\n");
+        return;
     }
-
-    // Inicializamos el registro de coleccionistas de Prometheus
-    if (prom_collector_registry_default_init() != 0)
+    const text_buf_t* sections[] = {&stat_section, &memory_section,  &pressure_section, &disk_section,
+                                    &net_section,  &process_section, &cgroup_section};
+    int ret = 0;
+    pthread_mutex_lock(&sections_lock);
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++)
     {
-        fprintf(stderr, "Error al inicializar el registro de Prometheus\n");
+        ret |= text_buf_append(text, sections[i]->data, sections[i]->len);
     }
+    pthread_mutex_unlock(&sections_lock);
 
-    // Creamos la métrica para el uso de CPU
-    cpu_usage_metric = prom_gauge_new("cpu_usage_percentage", "Porcentaje de uso de CPU", 0, NULL);
-    if (cpu_usage_metric == NULL)
+    // Los contadores del hilo HTTP reflejan los scrapes respondidos hasta este momento
+    render_family_header(text, "pressure_trigger_events_total", "counter",
+                         "Recolecciones fuera de ciclo forzadas por los disparadores de PSI");
+    ret |= text_buf_printf(text, "pressure_trigger_events_total %llu\n", atomic_load(&pressure_trigger.events));
+    render_collector_metrics(text, collectors);
+    render_window_metrics(text);
+    render_self_metrics(text, collectors);
+    if (ret != 0 || text->data == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de CPU\n");
+        fprintf(stderr, "Error al reservar la exposición de métricas\n");
+        return;
     }
 
-    // Creamos la métrica para el uso de memoria
-    memory_usage_metric = prom_gauge_new("memory_usage_percentage", "Porcentaje de uso de memoria", 0, NULL);
-    if (memory_usage_metric == NULL)
+    // El envío remoto copia las muestras a su cola: la exposición pasa a la instantánea sin cambios
+    if (pusher.running)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de memoria\n");
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        push_enqueue_exposition(&pusher, text->data, text->len, (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
     }
+    metrics_snapshot_commit();
+
+    // La duración incluye la compresión; se exporta en la publicación siguiente
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long ns = (long long)(end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+    histogram_observe(&render_duration, ns > 0 ? (unsigned long long)ns : 0);
+}
+
+/**
+ * @brief Inicializa las series de uso por núcleo y modo.
+ * @return 0.
+ */
+static int init_cpu_collector(void)
+{
+    series_labels_init(&cpu_labels, series_max_idle);
+    series_family_init(&cpu_core_series, &cpu_labels, "cpu_core_usage_percentage",
+                       "Porcentaje de uso de CPU por núcleo y modo", 0, series_limit);
+    return 0;
+}
+
+/**
+ * @brief Libera las series y la exposición del colector de CPU.
+ */
+static void destroy_cpu_collector(void)
+{
+    series_family_destroy(&cpu_core_series);
+    series_labels_destroy(&cpu_labels);
+    text_buf_free(&stat_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&stat_section);
+    pthread_mutex_unlock(&sections_lock);
+}
 
-    // Creamos la métrica para el uso de I/O de disco
-    io_disk_usage_metric = prom_gauge_new("io_disk_usage_percentage", "Porcentaje de uso de I/O de disco", 0, NULL);
-    if (io_disk_usage_metric == NULL)
+/**
+ * @brief Libera la exposición del colector de memoria.
+ */
+static void destroy_memory_collector(void)
+{
+    text_buf_free(&memory_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&memory_section);
+    pthread_mutex_unlock(&sections_lock);
+}
+
+/**
+ * @brief Inicializa las series de I/O por disco, etiquetadas por dispositivo.
+ * @return 0.
+ */
+static int init_disk_collector(void)
+{
+    series_labels_init(&disk_labels, series_max_idle);
+    for (size_t f = 0; f < sizeof(disk_gauge_families) / sizeof(disk_gauge_families[0]); f++)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de I/O de disco\n");
+        series_family_init(&disk_gauge_series[f], &disk_labels, disk_gauge_families[f].name,
+                           disk_gauge_families[f].help, 0, series_limit);
     }
-
-    // Creamos la métrica para el uso de red
-    red_usage_metric = prom_gauge_new("red_usage_percentage", "Porcentaje de uso de red", 0, NULL);
-    if (red_usage_metric == NULL)
+    for (size_t f = 0; f < sizeof(disk_counter_families) / sizeof(disk_counter_families[0]); f++)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de Red\n");
+        series_family_init(&disk_counter_series[f], &disk_labels, disk_counter_families[f].name,
+                           disk_counter_families[f].help, 1, series_limit);
     }
+    return 0;
+}
 
-    // Creamos la métrica para la cantidad de procesos en ejecución
-    proc_number_metric = prom_gauge_new("execution_process_number", "Cantidad de procesos en ejecución", 0, NULL);
-    if (proc_number_metric == NULL)
+/**
+ * @brief Libera las series y la exposición del colector de discos.
+ */
+static void destroy_disk_collector(void)
+{
+    for (size_t f = 0; f < sizeof(disk_gauge_series) / sizeof(disk_gauge_series[0]); f++)
     {
-        fprintf(stderr, "Error al crear la métrica de cantidad de procesos en ejecución\n");
+        series_family_destroy(&disk_gauge_series[f]);
     }
+    for (size_t f = 0; f < sizeof(disk_counter_series) / sizeof(disk_counter_series[0]); f++)
+    {
+        series_family_destroy(&disk_counter_series[f]);
+    }
+    series_labels_destroy(&disk_labels);
+    text_buf_free(&disk_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&disk_section);
+    pthread_mutex_unlock(&sections_lock);
+}
 
-    // Creamos la métrica para la cantidad de procesos en ejecución
-    context_switches_metric = prom_gauge_new("context_switches", "Cantidad de cambios de contexto", 0, NULL);
-    if (context_switches_metric == NULL)
+/**
+ * @brief Inicializa las series de tráfico, etiquetadas por interfaz (y dirección, la utilización).
+ * @return 0.
+ */
+static int init_net_collector(void)
+{
+    series_labels_init(&net_labels, series_max_idle);
+    for (size_t f = 0; f < sizeof(net_gauge_families) / sizeof(net_gauge_families[0]); f++)
+    {
+        series_family_init(&net_gauge_series[f], &net_labels, net_gauge_families[f].name, net_gauge_families[f].help,
+                           0, series_limit);
+    }
+    series_family_init(&net_utilization_series, &net_labels, "network_utilization_percentage",
+                       "Porcentaje de la velocidad del enlace usado por interfaz y dirección", 0, series_limit);
+    for (size_t f = 0; f < sizeof(net_counter_families) / sizeof(net_counter_families[0]); f++)
     {
-        fprintf(stderr, "Error al crear la métrica de cambios de contexto\n");
+        series_family_init(&net_counter_series[f], &net_labels, net_counter_families[f].name,
+                           net_counter_families[f].help, 1, series_limit);
     }
+    return 0;
+}
 
-    // Registramos las métricas en el registro por defecto
-    if (prom_collector_registry_must_register_metric(memory_usage_metric) == NULL)
+/**
+ * @brief Libera las series y la exposición del colector de red.
+ */
+static void destroy_net_collector(void)
+{
+    for (size_t f = 0; f < sizeof(net_gauge_series) / sizeof(net_gauge_series[0]); f++)
     {
-        fprintf(stderr, "Error al registrar las métricas - memoria\n");
+        series_family_destroy(&net_gauge_series[f]);
     }
-    if (prom_collector_registry_must_register_metric(cpu_usage_metric) == NULL)
+    series_family_destroy(&net_utilization_series);
+    for (size_t f = 0; f < sizeof(net_counter_series) / sizeof(net_counter_series[0]); f++)
     {
-        fprintf(stderr, "Error al registrar las métricas - cpu\n");
+        series_family_destroy(&net_counter_series[f]);
     }
-    if (prom_collector_registry_must_register_metric(io_disk_usage_metric) == NULL)
+    series_labels_destroy(&net_labels);
+    text_buf_free(&net_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&net_section);
+    pthread_mutex_unlock(&sections_lock);
+}
+
+/**
+ * @brief Libera la exposición del colector de carga y presión.
+ */
+static void destroy_pressure_collector(void)
+{
+    text_buf_free(&pressure_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&pressure_section);
+    pthread_mutex_unlock(&sections_lock);
+}
+
+/**
+ * @brief Inicializa el colector de procesos.
+ * @return 0 si se inicializó, -1 si no se pudo abrir /proc.
+ */
+static int init_process_collector(void)
+{
+    if (init_process_stats() != 0)
     {
-        fprintf(stderr, "Error al registrar las métricas - IO\n");
+        return -1;
     }
-    if (prom_collector_registry_must_register_metric(red_usage_metric) == NULL)
+    if (process_top == 0)
     {
-        fprintf(stderr, "Error al registrar las métricas de uso de red\n");
+        process_top = PROCESS_TOP_DEFAULT;
     }
-    if (prom_collector_registry_must_register_metric(proc_number_metric) == NULL)
+    return 0;
+}
+
+/**
+ * @brief Libera la tabla y la exposición del colector de procesos.
+ */
+static void destroy_process_collector(void)
+{
+    close_process_stats();
+    text_buf_free(&process_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&process_section);
+    pthread_mutex_unlock(&sections_lock);
+    process_top = 0;
+}
+
+/**
+ * @brief Inicializa el colector de cgroups.
+ * @return 0 si se inicializó, -1 si la jerarquía no es cgroup v2 o no se pudo vigilar.
+ */
+static int init_cgroup_collector(void)
+{
+    if (init_cgroup_stats(cgroup_root, cgroup_max_depth) != 0)
     {
-        fprintf(stderr, "Error al registrar las métricas de cantidad de procesos en ejecución\n");
+        return -1;
     }
-    if (prom_collector_registry_must_register_metric(context_switches_metric) == NULL)
+    cgroups_enabled = 1;
+    return 0;
+}
+
+/**
+ * @brief Deja de vigilar la jerarquía de cgroups y libera la exposición del colector.
+ */
+static void destroy_cgroup_collector(void)
+{
+    close_cgroup_stats();
+    text_buf_free(&cgroup_text);
+    pthread_mutex_lock(&sections_lock);
+    text_buf_free(&cgroup_section);
+    pthread_mutex_unlock(&sections_lock);
+    cgroups_enabled = 0;
+}
+
+/**
+ * @brief Colectores incluidos, en el orden en que se ejecutan dentro de un mismo instante.
+ */
+static const collector_t builtin_collectors[] = {
+    {.name = "cpu",
+     .help = "Uso de CPU total y por núcleo, procesos, interrupciones (/proc/stat)",
+     .init = init_cpu_collector,
+     .collect = update_proc_stat_gauges,
+     .destroy = destroy_cpu_collector,
+     .enabled = 1},
+    {.name = "memory",
+     .help = "Uso y desglose de memoria, fallos de página y swap (/proc/meminfo, /proc/vmstat)",
+     .collect = update_memory_gauge,
+     .destroy = destroy_memory_collector,
+     .enabled = 1},
+    {.name = "disk",
+     .help = "I/O por disco (/proc/diskstats)",
+     .init = init_disk_collector,
+     .collect = update_disk_io_gauge,
+     .destroy = destroy_disk_collector,
+     .enabled = 1},
+    {.name = "net",
+     .help = "Tráfico por interfaz (/proc/net/dev)",
+     .init = init_net_collector,
+     .collect = update_red_gauge,
+     .destroy = destroy_net_collector,
+     .enabled = 1},
+    {.name = "pressure",
+     .help = "Promedio de carga y presión (/proc/loadavg, /proc/pressure)",
+     .collect = update_pressure_gauges,
+     .destroy = destroy_pressure_collector,
+     .enabled = 1},
+    {.name = "process",
+     .help = "Procesos que más CPU, memoria e I/O consumen (/proc/[pid])",
+     .init = init_process_collector,
+     .collect = update_process_gauges,
+     .destroy = destroy_process_collector},
+    {.name = "cgroup",
+     .help = "CPU, memoria, I/O y presión por cgroup v2",
+     .init = init_cgroup_collector,
+     .collect = update_cgroup_gauges,
+     .destroy = destroy_cgroup_collector},
+};
+
+/**
+ * @brief Registra los colectores incluidos.
+ * @param registry Registro de colectores.
+ * @return 0 si se registraron todos, -1 en caso contrario.
+ */
+int register_collectors(collector_registry_t* registry)
+{
+    for (size_t i = 0; i < sizeof(builtin_collectors) / sizeof(builtin_collectors[0]); i++)
     {
-        fprintf(stderr, "Error al registrar las métricas de cambio de contexto\n");
+        if (collector_register(registry, &builtin_collectors[i]) != 0)
+        {
+            return -1;
+        }
     }
+    return 0;
 }
 
 /**
- * @brief Destruye el mutex.
+ * @brief Inicializa las métricas del exportador.
+ *
+ * Abre los archivos de /proc y prepara los histogramas y las ventanas del propio exportador; las series de cada
+ * colector se preparan al iniciarlo.
+ * Si no se pueden abrir los archivos, se imprime un mensaje de error.
  */
-void destroy_mutex()
+void init_metrics()
 {
-    pthread_mutex_destroy(&lock);
+    // Abrimos los archivos de /proc que se releen en cada ciclo
+    if (init_proc_files() != 0)
+    {
+        fprintf(stderr, "Error al abrir los archivos de /proc\n");
+    }
+
+    // Histogramas del propio exportador
+    histogram_init(&render_duration, render_duration_bounds_ns,
+                   sizeof(render_duration_bounds_ns) / sizeof(render_duration_bounds_ns[0]), 1e-9);
+    histogram_init(&response_size, response_size_bounds, sizeof(response_size_bounds) / sizeof(response_size_bounds[0]),
+                   1.0);
+
+    // Ventanas deslizantes de las series muestreadas
+    if (window_ms > 0)
+    {
+        for (int i = 0; i < SAMPLED_SERIES_COUNT; i++)
+        {
+            window_stats_init(&windows[i], window_ms);
+        }
+        windows_enabled = 1;
+    }
 }
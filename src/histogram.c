@@ -0,0 +1,75 @@
+#include "../include/histogram.h"
+
+/**
+ * @file histogram.c
+ * @brief Implementación del histograma de buckets fijos.
+ */
+
+/**
+ * @brief Inicializa un histograma vacío.
+ * @param hist Histograma.
+ * @param bounds Límites superiores crecientes en la unidad base.
+ * @param count Cantidad de límites.
+ * @param scale Factor para pasar de la unidad base a la exportada.
+ */
+void histogram_init(histogram_t* hist, const unsigned long long* bounds, size_t count, double scale)
+{
+    hist->bounds = bounds;
+    hist->count = count < HISTOGRAM_MAX_BUCKETS ? count : HISTOGRAM_MAX_BUCKETS;
+    hist->scale = scale;
+    for (size_t i = 0; i <= HISTOGRAM_MAX_BUCKETS; i++)
+    {
+        atomic_init(&hist->buckets[i], 0);
+    }
+    atomic_init(&hist->sum, 0);
+}
+
+/**
+ * @brief Registra una observación.
+ * @param hist Histograma inicializado.
+ * @param value Valor en la unidad base.
+ */
+void histogram_observe(histogram_t* hist, unsigned long long value)
+{
+    // Con pocos buckets, la búsqueda lineal es más barata que la binaria
+    size_t i = 0;
+    while (i < hist->count && value > hist->bounds[i])
+    {
+        i++;
+    }
+    atomic_fetch_add_explicit(&hist->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Agrega las muestras _bucket, _sum y _count del histograma a una exposición.
+ * @param hist Histograma inicializado.
+ * @param out Exposición.
+ * @param name Nombre de la familia.
+ * @param labels Etiquetas ya formateadas o "".
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int histogram_render(const histogram_t* hist, text_buf_t* out, const char* name, const char* labels)
+{
+    const char* sep = labels[0] != '\0' ? "," : "";
+    unsigned long long cumulative = 0;
+    int ret = 0;
+
+    // Una observación concurrente puede quedar en un bucket y no en la suma: la diferencia se corrige en el ciclo
+    // siguiente y los buckets siguen siendo monótonos
+    for (size_t i = 0; i < hist->count; i++)
+    {
+        cumulative += atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+        ret |= text_buf_printf(out, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels, sep,
+                               (double)hist->bounds[i] * hist->scale, cumulative);
+    }
+    cumulative += atomic_load_explicit(&hist->buckets[hist->count], memory_order_relaxed);
+    ret |= text_buf_printf(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, cumulative);
+
+    double sum = (double)atomic_load_explicit(&hist->sum, memory_order_relaxed) * hist->scale;
+    const char* open = labels[0] != '\0' ? "{" : "";
+    const char* close = labels[0] != '\0' ? "}" : "";
+    ret |= text_buf_printf(out, "%s_sum%s%s%s %.17g\n", name, open, labels, close, sum);
+    ret |= text_buf_printf(out, "%s_count%s%s%s %llu\n", name, open, labels, close, cumulative);
+    return ret;
+}
@@ -0,0 +1,646 @@
+#include "../include/history.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file history.c
+ * @brief Implementación del historial circular mapeado en memoria.
+ *
+ * Formato del área de datos de un bloque (bits en orden MSB primero), para cada muestra después de la primera, que
+ * se guarda completa en el encabezado del bloque:
+ *  - delta-of-delta del instante en ms: '0' si es 0; '10' + 7 bits; '110' + 9 bits; '1110' + 12 bits; '1111' +
+ *    32 bits (en complemento a dos);
+ *  - XOR del valor con el anterior: '0' si es 0; '10' + los bits significativos dentro de la ventana de ceros de la
+ *    última muestra con ventana nueva; '11' + 5 bits de ceros a la izquierda + 6 bits de longitud - 1 + los bits.
+ */
+
+/**
+ * @brief Bits máximos que ocupa una muestra: 4 + 32 del instante y 2 + 5 + 6 + 64 del valor.
+ */
+#define HISTORY_MAX_SAMPLE_BITS 113
+
+/**
+ * @brief Valor de ceros a la izquierda que indica que el bloque todavía no tiene una ventana de XOR.
+ */
+#define HISTORY_NO_WINDOW 65
+
+/**
+ * @brief Devuelve el encabezado de un bloque de datos del mapeo.
+ * @param history Historial abierto.
+ * @param index Índice del bloque de datos.
+ * @return Puntero al bloque.
+ */
+static history_block_t* history_block(const history_t* history, uint32_t index)
+{
+    return (history_block_t*)(history->map + (size_t)(index + 1) * HISTORY_BLOCK_SIZE);
+}
+
+/**
+ * @brief Escribe los n bits menos significativos de un valor, del más significativo al menos.
+ * @param data Área de datos del bloque.
+ * @param bit Posición de escritura; se avanza n bits.
+ * @param value Valor a escribir.
+ * @param n Cantidad de bits (a lo sumo 64).
+ */
+static void put_bits(unsigned char* data, uint32_t* bit, uint64_t value, unsigned int n)
+{
+    for (unsigned int i = n; i > 0; i--)
+    {
+        unsigned char mask = (unsigned char)(0x80 >> (*bit & 7));
+        // Los bloques se reutilizan sin limpiarlos, así que también hay que escribir los ceros
+        if ((value >> (i - 1)) & 1)
+        {
+            data[*bit >> 3] |= mask;
+        }
+        else
+        {
+            data[*bit >> 3] &= (unsigned char)~mask;
+        }
+        (*bit)++;
+    }
+}
+
+/**
+ * @brief Lee n bits, del más significativo al menos.
+ * @param data Área de datos del bloque.
+ * @param bit Posición de lectura; se avanza n bits.
+ * @param limit Bits válidos del área de datos.
+ * @param value Valor leído.
+ * @param n Cantidad de bits (a lo sumo 64).
+ * @return 0 si se leyó, -1 si el bloque no tiene tantos bits.
+ */
+static int get_bits(const unsigned char* data, uint32_t* bit, uint32_t limit, uint64_t* value, unsigned int n)
+{
+    if (*bit + n > limit)
+    {
+        return -1;
+    }
+    uint64_t out = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        out = (out << 1) | ((data[*bit >> 3] >> (7 - (*bit & 7))) & 1);
+        (*bit)++;
+    }
+    *value = out;
+    return 0;
+}
+
+/**
+ * @brief Extiende el signo de un entero en complemento a dos de n bits.
+ * @param value Valor leído.
+ * @param n Cantidad de bits.
+ * @return Valor con signo.
+ */
+static int64_t sign_extend(uint64_t value, unsigned int n)
+{
+    uint64_t sign = 1ULL << (n - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+/**
+ * @brief Bits de un double.
+ * @param value Valor.
+ * @return Sus bits como entero.
+ */
+static uint64_t double_bits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Double a partir de sus bits.
+ * @param bits Bits del valor.
+ * @return El valor.
+ */
+static double bits_double(uint64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Marca todos los bloques de datos como libres y reinicia el anillo.
+ * @param history Historial mapeado.
+ * @param names Nombres de las series.
+ * @param count Cantidad de series.
+ * @param block_count Bloques de datos.
+ */
+static void history_format(history_t* history, const char* const* names, size_t count, uint32_t block_count)
+{
+    history_header_t* header = history->header;
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, HISTORY_MAGIC, sizeof(header->magic));
+    header->block_size = HISTORY_BLOCK_SIZE;
+    header->block_count = block_count;
+    header->next_block = 0;
+    header->series_count = (uint32_t)count;
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(header->names[i], HISTORY_NAME_SIZE, "%s", names[i]);
+    }
+    for (uint32_t i = 0; i < block_count; i++)
+    {
+        history_block_t* block = history_block(history, i);
+        block->series = HISTORY_FREE;
+        block->count = 0;
+    }
+}
+
+/**
+ * @brief Indica si el encabezado de un archivo existente corresponde a las series pedidas.
+ * @param header Encabezado del archivo.
+ * @param names Nombres de las series.
+ * @param count Cantidad de series.
+ * @param block_count Bloques de datos esperados.
+ * @return 1 si se puede reutilizar, 0 si no.
+ */
+static int history_header_matches(const history_header_t* header, const char* const* names, size_t count,
+                                  uint32_t block_count)
+{
+    if (memcmp(header->magic, HISTORY_MAGIC, sizeof(header->magic)) != 0 ||
+        header->block_size != HISTORY_BLOCK_SIZE || header->block_count != block_count ||
+        header->next_block >= block_count || header->series_count != count)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strncmp(header->names[i], names[i], HISTORY_NAME_SIZE) != 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Abre o crea el archivo de historial.
+ * @param history Historial a abrir.
+ * @param path Ruta del archivo.
+ * @param size_mb Tamaño del archivo en MiB.
+ * @param names Nombres de las series.
+ * @param count Cantidad de series.
+ * @return 0 si se abrió, -1 en caso de error.
+ */
+int history_open(history_t* history, const char* path, unsigned long size_mb, const char* const* names, size_t count)
+{
+    history->map = NULL;
+    if (count > HISTORY_MAX_SERIES)
+    {
+        fprintf(stderr, "El historial admite a lo sumo %d series\n", HISTORY_MAX_SERIES);
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strlen(names[i]) >= HISTORY_NAME_SIZE)
+        {
+            fprintf(stderr, "Nombre de serie demasiado largo para el historial: %s\n", names[i]);
+            return -1;
+        }
+    }
+
+    size_t size = (size_t)size_mb * 1024 * 1024;
+    if (size_mb == 0 || size / HISTORY_BLOCK_SIZE < 2 || size / HISTORY_BLOCK_SIZE - 1 >= UINT32_MAX)
+    {
+        fprintf(stderr, "Tamaño de historial inválido: %lu MiB\n", size_mb);
+        return -1;
+    }
+    uint32_t block_count = (uint32_t)(size / HISTORY_BLOCK_SIZE - 1);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error al abrir %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "Error al consultar %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    int reuse = (size_t)st.st_size == size;
+
+    // Se reserva el espacio completo: escribir en un archivo disperso sin lugar en el disco termina en SIGBUS
+    if (!reuse && (ftruncate(fd, 0) != 0 || (errno = posix_fallocate(fd, 0, (off_t)size)) != 0))
+    {
+        fprintf(stderr, "Error al reservar %lu MiB para %s: %s\n", size_mb, path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "Error al mapear %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    history->map = map;
+    history->size = size;
+    history->header = map;
+    if (!reuse || !history_header_matches(history->header, names, count, block_count))
+    {
+        history_format(history, names, count, block_count);
+    }
+    for (size_t i = 0; i < HISTORY_MAX_SERIES; i++)
+    {
+        // Después de reabrir, las muestras nuevas empiezan un bloque propio: el estado del codificador del bloque
+        // que quedó abierto no se guarda en el archivo
+        history->encoders[i].block = -1;
+    }
+    pthread_mutex_init(&history->lock, NULL);
+    return 0;
+}
+
+/**
+ * @brief Empieza un bloque nuevo para una serie con su primera muestra, pisando el bloque más viejo del anillo.
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param ms Instante de la muestra.
+ * @param value Bits del valor.
+ */
+static void history_start_block(history_t* history, size_t series, int64_t ms, uint64_t value)
+{
+    history_header_t* header = history->header;
+    uint32_t index = header->next_block;
+    header->next_block = (index + 1) % header->block_count;
+
+    // Si el anillo alcanzó el bloque abierto de otra serie, esa serie tiene que empezar uno nuevo
+    for (size_t i = 0; i < header->series_count; i++)
+    {
+        if (history->encoders[i].block == (int64_t)index)
+        {
+            history->encoders[i].block = -1;
+        }
+    }
+
+    history_block_t* block = history_block(history, index);
+    block->series = (uint32_t)series;
+    block->count = 1;
+    block->start_ms = ms;
+    block->end_ms = ms;
+    block->first_value = value;
+    block->bits = 0;
+
+    history_encoder_t* enc = &history->encoders[series];
+    enc->block = index;
+    enc->prev_ms = ms;
+    enc->prev_delta = 0;
+    enc->prev_value = value;
+    enc->leading = HISTORY_NO_WINDOW;
+    enc->trailing = 0;
+}
+
+/**
+ * @brief Agrega una muestra de una serie con el instante actual.
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param value Valor de la muestra.
+ */
+void history_append(history_t* history, size_t series, double value)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    history_append_at(history, series, (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000, value);
+}
+
+/**
+ * @brief Agrega una muestra de una serie con un instante dado.
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param ms Instante de la muestra.
+ * @param value Valor de la muestra.
+ */
+void history_append_at(history_t* history, size_t series, int64_t ms, double value)
+{
+    if (history->map == NULL || series >= history->header->series_count)
+    {
+        return;
+    }
+
+    uint64_t bits = double_bits(value);
+    pthread_mutex_lock(&history->lock);
+
+    history_encoder_t* enc = &history->encoders[series];
+    int64_t delta = ms - enc->prev_ms;
+    int64_t dod = delta - enc->prev_delta;
+    history_block_t* block = enc->block >= 0 ? history_block(history, (uint32_t)enc->block) : NULL;
+
+    // Un bloque lleno, un salto de reloj hacia atrás o un delta-of-delta que no entra en 32 bits empiezan un bloque
+    if (block == NULL || block->bits + HISTORY_MAX_SAMPLE_BITS > HISTORY_PAYLOAD_BITS || delta < 0 ||
+        dod < INT32_MIN || dod > INT32_MAX)
+    {
+        history_start_block(history, series, ms, bits);
+        pthread_mutex_unlock(&history->lock);
+        return;
+    }
+
+    unsigned char* data = (unsigned char*)(block + 1);
+    uint32_t pos = block->bits;
+
+    if (dod == 0)
+    {
+        put_bits(data, &pos, 0, 1);
+    }
+    else if (dod >= -64 && dod <= 63)
+    {
+        put_bits(data, &pos, 0x2, 2);
+        put_bits(data, &pos, (uint64_t)dod, 7);
+    }
+    else if (dod >= -256 && dod <= 255)
+    {
+        put_bits(data, &pos, 0x6, 3);
+        put_bits(data, &pos, (uint64_t)dod, 9);
+    }
+    else if (dod >= -2048 && dod <= 2047)
+    {
+        put_bits(data, &pos, 0xe, 4);
+        put_bits(data, &pos, (uint64_t)dod, 12);
+    }
+    else
+    {
+        put_bits(data, &pos, 0xf, 4);
+        put_bits(data, &pos, (uint64_t)dod, 32);
+    }
+
+    uint64_t xor = bits ^ enc->prev_value;
+    if (xor == 0)
+    {
+        put_bits(data, &pos, 0, 1);
+    }
+    else
+    {
+        unsigned int leading = (unsigned int)__builtin_clzll(xor);
+        unsigned int trailing = (unsigned int)__builtin_ctzll(xor);
+        // Los ceros a la izquierda se guardan en 5 bits
+        if (leading > 31)
+        {
+            leading = 31;
+        }
+        if (leading >= enc->leading && trailing >= enc->trailing)
+        {
+            put_bits(data, &pos, 0x2, 2);
+            put_bits(data, &pos, xor >> enc->trailing, 64 - enc->leading - enc->trailing);
+        }
+        else
+        {
+            unsigned int length = 64 - leading - trailing;
+            put_bits(data, &pos, 0x3, 2);
+            put_bits(data, &pos, leading, 5);
+            put_bits(data, &pos, length - 1, 6);
+            put_bits(data, &pos, xor >> trailing, length);
+            enc->leading = leading;
+            enc->trailing = trailing;
+        }
+    }
+
+    block->bits = pos;
+    block->end_ms = ms;
+    block->count++;
+    enc->prev_ms = ms;
+    enc->prev_delta = delta;
+    enc->prev_value = bits;
+
+    pthread_mutex_unlock(&history->lock);
+}
+
+/**
+ * @brief Busca una serie por nombre.
+ * @param history Historial abierto.
+ * @param name Nombre de la serie.
+ * @return Identificador de la serie, o -1 si no existe.
+ */
+int history_find(const history_t* history, const char* name)
+{
+    if (history->map == NULL)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < history->header->series_count; i++)
+    {
+        if (strcmp(history->header->names[i], name) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Cierra el historial, asegurando que su contenido quede escrito en el archivo.
+ * @param history Historial.
+ */
+void history_close(history_t* history)
+{
+    if (history->map == NULL)
+    {
+        return;
+    }
+    if (msync(history->map, history->size, MS_SYNC) != 0)
+    {
+        fprintf(stderr, "Error al sincronizar el historial: %s\n", strerror(errno));
+    }
+    munmap(history->map, history->size);
+    history->map = NULL;
+    pthread_mutex_destroy(&history->lock);
+}
+
+/**
+ * @brief Prepara un recorrido.
+ * @param reader Recorrido a preparar.
+ * @param history Historial abierto.
+ * @param series Identificador de la serie.
+ * @param since_ms Comienzo del rango.
+ * @param until_ms Fin del rango.
+ */
+void history_reader_init(history_reader_t* reader, history_t* history, size_t series, int64_t since_ms,
+                         int64_t until_ms)
+{
+    reader->history = history;
+    reader->series = (uint32_t)series;
+    reader->since_ms = since_ms;
+    reader->until_ms = until_ms;
+    reader->visited = 0;
+    reader->remaining = 0;
+    reader->next_block = 0;
+    if (history->map != NULL)
+    {
+        pthread_mutex_lock(&history->lock);
+        reader->next_block = history->header->next_block;
+        pthread_mutex_unlock(&history->lock);
+    }
+}
+
+/**
+ * @brief Copia el próximo bloque de la serie que se superpone con el rango.
+ * @param reader Recorrido preparado.
+ * @return 0 si se copió un bloque, -1 si no quedan.
+ */
+static int history_reader_load(history_reader_t* reader)
+{
+    history_t* history = reader->history;
+    if (history->map == NULL)
+    {
+        return -1;
+    }
+
+    while (reader->visited < history->header->block_count)
+    {
+        uint32_t index = reader->next_block;
+        reader->next_block = (index + 1) % history->header->block_count;
+        reader->visited++;
+
+        pthread_mutex_lock(&history->lock);
+        const history_block_t* block = history_block(history, index);
+        int match = block->series == reader->series && block->count > 0 && block->end_ms >= reader->since_ms &&
+                    block->start_ms <= reader->until_ms && block->bits <= HISTORY_PAYLOAD_BITS;
+        if (match)
+        {
+            // Sólo se copian los bytes usados: el bloque abierto puede seguir creciendo después de soltar el mutex
+            memcpy(reader->block, block, sizeof(*block) + (block->bits + 7) / 8);
+        }
+        pthread_mutex_unlock(&history->lock);
+
+        if (match)
+        {
+            const history_block_t* copy = (const history_block_t*)reader->block;
+            reader->remaining = copy->count;
+            reader->bit = 0;
+            reader->state.prev_ms = copy->start_ms;
+            reader->state.prev_delta = 0;
+            reader->state.prev_value = copy->first_value;
+            reader->state.leading = HISTORY_NO_WINDOW;
+            reader->state.trailing = 0;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Decodifica la próxima muestra del bloque copiado.
+ * @param reader Recorrido con un bloque copiado y muestras pendientes.
+ * @return 0 si se decodificó, -1 si el bloque está dañado.
+ */
+static int history_reader_decode(history_reader_t* reader)
+{
+    const history_block_t* copy = (const history_block_t*)reader->block;
+    const unsigned char* data = (const unsigned char*)(copy + 1);
+    history_encoder_t* state = &reader->state;
+    uint32_t limit = copy->bits;
+    uint64_t flag;
+    uint64_t raw;
+
+    // Prefijo del delta-of-delta: hasta cuatro unos seguidos
+    unsigned int ones = 0;
+    while (ones < 4)
+    {
+        if (get_bits(data, &reader->bit, limit, &flag, 1) != 0)
+        {
+            return -1;
+        }
+        if (flag == 0)
+        {
+            break;
+        }
+        ones++;
+    }
+    static const unsigned int dod_bits[] = {0, 7, 9, 12, 32};
+    int64_t dod = 0;
+    if (ones > 0)
+    {
+        if (get_bits(data, &reader->bit, limit, &raw, dod_bits[ones]) != 0)
+        {
+            return -1;
+        }
+        dod = sign_extend(raw, dod_bits[ones]);
+    }
+    state->prev_delta += dod;
+    state->prev_ms += state->prev_delta;
+
+    if (get_bits(data, &reader->bit, limit, &flag, 1) != 0)
+    {
+        return -1;
+    }
+    if (flag == 0)
+    {
+        return 0;
+    }
+    if (get_bits(data, &reader->bit, limit, &flag, 1) != 0)
+    {
+        return -1;
+    }
+    if (flag == 1)
+    {
+        uint64_t leading;
+        uint64_t length;
+        if (get_bits(data, &reader->bit, limit, &leading, 5) != 0 ||
+            get_bits(data, &reader->bit, limit, &length, 6) != 0 || leading + length + 1 > 64)
+        {
+            return -1;
+        }
+        state->leading = (unsigned int)leading;
+        state->trailing = (unsigned int)(64 - leading - length - 1);
+    }
+    else if (state->leading == HISTORY_NO_WINDOW)
+    {
+        return -1;
+    }
+    if (get_bits(data, &reader->bit, limit, &raw, 64 - state->leading - state->trailing) != 0)
+    {
+        return -1;
+    }
+    state->prev_value ^= raw << state->trailing;
+    return 0;
+}
+
+/**
+ * @brief Obtiene la próxima muestra del rango.
+ * @param reader Recorrido preparado.
+ * @param ms Instante de la muestra.
+ * @param value Valor de la muestra.
+ * @return 1 si hay una muestra, 0 si el recorrido terminó.
+ */
+int history_reader_next(history_reader_t* reader, int64_t* ms, double* value)
+{
+    while (1)
+    {
+        if (reader->remaining == 0 && history_reader_load(reader) != 0)
+        {
+            return 0;
+        }
+
+        const history_block_t* copy = (const history_block_t*)reader->block;
+        // La primera muestra está completa en el encabezado del bloque
+        if (reader->remaining != copy->count && history_reader_decode(reader) != 0)
+        {
+            reader->remaining = 0;
+            continue;
+        }
+        reader->remaining--;
+
+        if (reader->state.prev_ms > reader->until_ms)
+        {
+            reader->remaining = 0;
+            continue;
+        }
+        if (reader->state.prev_ms >= reader->since_ms)
+        {
+            *ms = reader->state.prev_ms;
+            *value = bits_double(reader->state.prev_value);
+            return 1;
+        }
+    }
+}
@@ -0,0 +1,516 @@
+#include "../include/http_server.h"
+#include "../include/expose_metrics.h"
+#include "../include/metrics_snapshot.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * @file http_server.c
+ * @brief Implementación del servidor HTTP que responde los scrapes con la última instantánea publicada.
+ */
+
+/**
+ * @brief Tipo de retorno de los manejadores de libmicrohttpd (enum MHD_Result desde la versión 0.9.71).
+ */
+#if MHD_VERSION >= 0x00097002
+typedef enum MHD_Result mhd_result_t;
+#else
+typedef int mhd_result_t;
+#endif
+
+/**
+ * @brief Tipo de contenido del formato de texto de exposición de Prometheus.
+ */
+#define EXPOSITION_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+/**
+ * @brief Sufijo del ETag de la copia gzip: un validador fuerte debe distinguir las codificaciones del contenido.
+ */
+#define GZIP_ETAG_SUFFIX "-gz"
+
+/**
+ * @brief Encola una respuesta de texto fijo.
+ * @param connection Conexión HTTP.
+ * @param status Código de estado HTTP.
+ * @param body Cuerpo de la respuesta (constante).
+ * @return MHD_YES si la respuesta se encoló, MHD_NO en caso contrario.
+ */
+static mhd_result_t queue_static_response(struct MHD_Connection* connection, unsigned int status, const char* body)
+{
+    struct MHD_Response* response = MHD_create_response_from_buffer(strlen(body), (void*)body, MHD_RESPMEM_PERSISTENT);
+    if (response == NULL)
+    {
+        return MHD_NO;
+    }
+    if (status == MHD_HTTP_METHOD_NOT_ALLOWED)
+    {
+        MHD_add_response_header(response, MHD_HTTP_HEADER_ALLOW, "GET, HEAD");
+    }
+    mhd_result_t ret = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+/**
+ * @brief Indica si el cliente acepta respuestas comprimidas con gzip.
+ *
+ * Recorre los elementos de Accept-Encoding buscando "gzip" (o "*") sin un peso q=0.
+ *
+ * @param connection Conexión HTTP.
+ * @return 1 si acepta gzip, 0 en caso contrario.
+ */
+static int accepts_gzip(struct MHD_Connection* connection)
+{
+    const char* header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+    if (header == NULL)
+    {
+        return 0;
+    }
+
+    const char* p = header;
+    while (*p != '\0')
+    {
+        while (*p == ' ' || *p == '\t' || *p == ',')
+        {
+            p++;
+        }
+        const char* coding = p;
+        while (*p != '\0' && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+        size_t coding_len = (size_t)(p - coding);
+
+        // Parámetros del elemento: sólo nos interesa q=0 (codificación rechazada)
+        int rejected = 0;
+        while (*p != '\0' && *p != ',')
+        {
+            if (*p == 'q' && p[1] == '=')
+            {
+                rejected = strtod(p + 2, NULL) <= 0.0;
+            }
+            p++;
+        }
+
+        if (!rejected && ((coding_len == 4 && strncasecmp(coding, "gzip", 4) == 0) ||
+                          (coding_len == 1 && *coding == '*')))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Indica si el cliente ya tiene la exposición de la instantánea (If-None-Match), en cualquier codificación.
+ * @param connection Conexión HTTP.
+ * @param etag ETag del texto.
+ * @param gzip_etag ETag de la copia gzip.
+ * @return 1 si alguno de los ETags del cliente coincide, 0 en caso contrario.
+ */
+static int etag_matches(struct MHD_Connection* connection, const char* etag, const char* gzip_etag)
+{
+    const char* header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+    if (header == NULL)
+    {
+        return 0;
+    }
+    if (strcmp(header, "*") == 0)
+    {
+        return 1;
+    }
+    return strstr(header, etag) != NULL || strstr(header, gzip_etag) != NULL;
+}
+
+/**
+ * @brief Devuelve la referencia a la instantánea cuando libmicrohttpd termina de enviar la respuesta.
+ * @param cls Instantánea referenciada por la respuesta.
+ */
+static void release_snapshot_response(void* cls)
+{
+    metrics_snapshot_release(cls);
+}
+
+/**
+ * @brief Arma una respuesta sobre un buffer de la instantánea sin copiarlo.
+ *
+ * La respuesta conserva la referencia a la instantánea y la devuelve al destruirse. Con versiones de libmicrohttpd
+ * anteriores a 0.9.73, que no permiten asociar un argumento a la liberación, el buffer se copia y la referencia se
+ * devuelve enseguida: en ambos casos el llamador no debe volver a usar la instantánea.
+ *
+ * @param snapshot Instantánea referenciada; la respuesta pasa a ser dueña de la referencia.
+ * @param data Buffer dentro de la instantánea.
+ * @param len Longitud del buffer.
+ * @return Respuesta, o NULL en caso de error (la referencia se devuelve igual).
+ */
+static struct MHD_Response* snapshot_response(metrics_snapshot_t* snapshot, const void* data, size_t len)
+{
+#if MHD_VERSION >= 0x00097300
+    struct MHD_Response* response =
+        MHD_create_response_from_buffer_with_free_callback_cls(len, data, release_snapshot_response, snapshot);
+    if (response == NULL)
+    {
+        metrics_snapshot_release(snapshot);
+    }
+    return response;
+#else
+    struct MHD_Response* response = MHD_create_response_from_buffer(len, (void*)data, MHD_RESPMEM_MUST_COPY);
+    release_snapshot_response(snapshot);
+    return response;
+#endif
+}
+
+/**
+ * @brief Responde un scrape a partir de la última instantánea publicada.
+ *
+ * El cuerpo es el texto (o su copia gzip, si el cliente la acepta) renderizado por el recolector, enviado sin copias.
+ * Si el cliente ya tiene esa exposición (If-None-Match) se responde 304 sin cuerpo.
+ *
+ * @param connection Conexión HTTP.
+ * @return MHD_YES si la respuesta se encoló, MHD_NO en caso contrario.
+ */
+static mhd_result_t queue_metrics_response(struct MHD_Connection* connection)
+{
+    metrics_snapshot_t* snapshot = metrics_snapshot_acquire();
+    if (snapshot == NULL)
+    {
+        return queue_static_response(connection, MHD_HTTP_SERVICE_UNAVAILABLE, "Métricas todavía no disponibles\n");
+    }
+
+    int repeated = atomic_fetch_add(&snapshot->served, 1) > 0;
+
+    // Con libmicrohttpd anterior a 0.9.73 la respuesta no conserva la referencia: los ETags se copian antes de armarla.
+    // El de la copia gzip es el del texto con un sufijo dentro de las comillas
+    char etag[METRICS_SNAPSHOT_ETAG_SIZE], gzip_etag[METRICS_SNAPSHOT_ETAG_SIZE + sizeof(GZIP_ETAG_SUFFIX) - 1];
+    memcpy(etag, snapshot->etag, sizeof(etag));
+    snprintf(gzip_etag, sizeof(gzip_etag), "%.*s" GZIP_ETAG_SUFFIX "\"", (int)strlen(etag) - 1, etag);
+
+    unsigned int status = MHD_HTTP_OK;
+    int gzip = snapshot->gzip != NULL && accepts_gzip(connection);
+    size_t body_len = 0;
+    struct MHD_Response* response;
+    if (etag_matches(connection, etag, gzip_etag))
+    {
+        status = MHD_HTTP_NOT_MODIFIED;
+        response = snapshot_response(snapshot, "", 0);
+    }
+    else if (gzip)
+    {
+        body_len = snapshot->gzip_len;
+        response = snapshot_response(snapshot, snapshot->gzip, snapshot->gzip_len);
+    }
+    else
+    {
+        body_len = snapshot->len;
+        response = snapshot_response(snapshot, snapshot->text, snapshot->len);
+    }
+    if (response == NULL)
+    {
+        return MHD_NO;
+    }
+    observe_scrape(repeated, body_len);
+
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG, gzip ? gzip_etag : etag);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_VARY, MHD_HTTP_HEADER_ACCEPT_ENCODING);
+    if (status == MHD_HTTP_OK)
+    {
+        MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, EXPOSITION_CONTENT_TYPE);
+    }
+    if (gzip && status == MHD_HTTP_OK)
+    {
+        MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_ENCODING, "gzip");
+    }
+    mhd_result_t ret = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+/**
+ * @brief Estado de una respuesta de /history, que se genera a medida que libmicrohttpd la envía.
+ */
+typedef struct
+{
+    history_reader_t reader; /**< Recorrido de las muestras pedidas. */
+    char line[64];           /**< Última línea formateada. */
+    size_t line_len;         /**< Longitud de la línea. */
+    size_t line_sent;        /**< Bytes de la línea ya entregados. */
+} history_stream_t;
+
+/**
+ * @brief Entrega el próximo tramo de una respuesta de /history, una línea "segundos valor" por muestra.
+ * @param cls Estado de la respuesta (history_stream_t).
+ * @param pos Bytes ya entregados (no utilizado).
+ * @param buf Buffer a completar.
+ * @param max Tamaño del buffer.
+ * @return Bytes escritos, o MHD_CONTENT_READER_END_OF_STREAM al terminar.
+ */
+static ssize_t history_stream_read(void* cls, uint64_t pos, char* buf, size_t max)
+{
+    (void)pos;
+    history_stream_t* stream = cls;
+    size_t written = 0;
+
+    while (written < max)
+    {
+        if (stream->line_sent == stream->line_len)
+        {
+            int64_t ms;
+            double value;
+            if (!history_reader_next(&stream->reader, &ms, &value))
+            {
+                break;
+            }
+            int len = snprintf(stream->line, sizeof(stream->line), "%lld.%03d %.17g\n", (long long)(ms / 1000),
+                               (int)(ms % 1000), value);
+            stream->line_len = len > 0 ? (size_t)len : 0;
+            stream->line_sent = 0;
+        }
+        // Una línea que no entra en el buffer se completa en la llamada siguiente
+        size_t chunk = stream->line_len - stream->line_sent;
+        if (chunk > max - written)
+        {
+            chunk = max - written;
+        }
+        memcpy(buf + written, stream->line + stream->line_sent, chunk);
+        stream->line_sent += chunk;
+        written += chunk;
+    }
+    return written > 0 ? (ssize_t)written : MHD_CONTENT_READER_END_OF_STREAM;
+}
+
+/**
+ * @brief Interpreta un parámetro de tiempo de /history (segundos desde la época Unix, con decimales).
+ * @param connection Conexión HTTP.
+ * @param name Nombre del parámetro.
+ * @param fallback Valor si el parámetro no está.
+ * @param ms Instante en ms.
+ * @return 0 si el parámetro falta o es válido, -1 si es inválido.
+ */
+static int history_time_argument(struct MHD_Connection* connection, const char* name, int64_t fallback, int64_t* ms)
+{
+    const char* text = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, name);
+    if (text == NULL)
+    {
+        *ms = fallback;
+        return 0;
+    }
+    char* end;
+    errno = 0;
+    double seconds = strtod(text, &end);
+    if (*text == '\0' || *end != '\0' || errno != 0 || !(seconds >= 0) || seconds > 1e15)
+    {
+        return -1;
+    }
+    *ms = (int64_t)(seconds * 1000.0);
+    return 0;
+}
+
+/**
+ * @brief Responde una consulta de /history con las muestras de una serie dentro de un rango.
+ *
+ * Las muestras se decodifican del archivo mapeado a medida que se envían, así que la respuesta no se arma en memoria.
+ *
+ * @param connection Conexión HTTP.
+ * @return MHD_YES si la respuesta se encoló, MHD_NO en caso contrario.
+ */
+static mhd_result_t queue_history_response(struct MHD_Connection* connection)
+{
+    history_t* history = get_history();
+    if (history == NULL)
+    {
+        return queue_static_response(connection, MHD_HTTP_NOT_FOUND, "Historial deshabilitado (--history)\n");
+    }
+    const char* metric = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "metric");
+    int series = metric != NULL ? history_find(history, metric) : -1;
+    if (series < 0)
+    {
+        return queue_static_response(connection, MHD_HTTP_NOT_FOUND, "Métrica sin historial\n");
+    }
+    int64_t since_ms;
+    int64_t until_ms;
+    if (history_time_argument(connection, "since", 0, &since_ms) != 0 ||
+        history_time_argument(connection, "until", INT64_MAX, &until_ms) != 0)
+    {
+        return queue_static_response(connection, MHD_HTTP_BAD_REQUEST, "Parámetro since o until inválido\n");
+    }
+
+    history_stream_t* stream = malloc(sizeof(*stream));
+    if (stream == NULL)
+    {
+        return MHD_NO;
+    }
+    history_reader_init(&stream->reader, history, (size_t)series, since_ms, until_ms);
+    stream->line_len = 0;
+    stream->line_sent = 0;
+
+    struct MHD_Response* response =
+        MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, HISTORY_BLOCK_SIZE, history_stream_read, stream, free);
+    if (response == NULL)
+    {
+        free(stream);
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, "text/plain; charset=utf-8");
+    mhd_result_t ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+/**
+ * @brief Atiende cada pedido HTTP.
+ * @param cls Argumento no utilizado.
+ * @param connection Conexión HTTP.
+ * @param url Ruta pedida.
+ * @param method Método HTTP.
+ * @param version Versión de HTTP (no utilizada).
+ * @param upload_data Cuerpo del pedido (no utilizado).
+ * @param upload_data_size Longitud del cuerpo (no utilizada).
+ * @param con_cls Estado por conexión (no utilizado).
+ * @return MHD_YES si la respuesta se encoló, MHD_NO en caso contrario.
+ */
+static mhd_result_t handle_request(void* cls, struct MHD_Connection* connection, const char* url, const char* method,
+                                   const char* version, const char* upload_data, size_t* upload_data_size,
+                                   void** con_cls)
+{
+    (void)cls;
+    (void)version;
+    (void)upload_data;
+    (void)upload_data_size;
+    (void)con_cls;
+
+    if (strcmp(method, MHD_HTTP_METHOD_GET) != 0 && strcmp(method, MHD_HTTP_METHOD_HEAD) != 0)
+    {
+        return queue_static_response(connection, MHD_HTTP_METHOD_NOT_ALLOWED, "Método no permitido\n");
+    }
+    if (strcmp(url, "/metrics") == 0)
+    {
+        return queue_metrics_response(connection);
+    }
+    if (strcmp(url, "/history") == 0)
+    {
+        return queue_history_response(connection);
+    }
+    if (strcmp(url, "/") == 0)
+    {
+        return queue_static_response(connection, MHD_HTTP_OK, "OK\n");
+    }
+    return queue_static_response(connection, MHD_HTTP_NOT_FOUND, "No encontrado\n");
+}
+
+/**
+ * @brief Completa la configuración del servidor HTTP con los valores por defecto.
+ * @param config Configuración a completar.
+ */
+void http_config_default(http_config_t* config)
+{
+    config->address = HTTP_DEFAULT_ADDRESS;
+    config->port = HTTP_DEFAULT_PORT;
+    config->mode = HTTP_MODE_EPOLL;
+    config->threads = HTTP_DEFAULT_THREADS;
+    config->connection_limit = HTTP_DEFAULT_CONNECTION_LIMIT;
+    config->connection_timeout = HTTP_DEFAULT_CONNECTION_TIMEOUT;
+}
+
+/**
+ * @brief Interpreta el nombre de un modo del servidor HTTP.
+ * @param name Nombre del modo.
+ * @param mode Modo resultante.
+ * @return 0 si el nombre es válido, -1 en caso contrario.
+ */
+int parse_http_mode(const char* name, http_mode_t* mode)
+{
+    const struct
+    {
+        const char* name;
+        http_mode_t mode;
+    } modes[] = {
+        {"select", HTTP_MODE_SELECT},
+        {"poll", HTTP_MODE_POLL},
+        {"epoll", HTTP_MODE_EPOLL},
+        {"auto", HTTP_MODE_AUTO},
+    };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        if (strcmp(name, modes[i].name) == 0)
+        {
+            *mode = modes[i].mode;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Traduce el modo del servidor a las banderas de libmicrohttpd.
+ * @param mode Modo del servidor.
+ * @return Banderas para MHD_start_daemon().
+ */
+static unsigned int http_mode_flags(http_mode_t mode)
+{
+    switch (mode)
+    {
+    case HTTP_MODE_POLL:
+        return MHD_USE_POLL_INTERNALLY;
+    case HTTP_MODE_EPOLL:
+        return MHD_USE_EPOLL_INTERNALLY;
+    case HTTP_MODE_AUTO:
+        return MHD_USE_AUTO | MHD_USE_INTERNAL_POLLING_THREAD;
+    case HTTP_MODE_SELECT:
+    default:
+        return MHD_USE_SELECT_INTERNALLY;
+    }
+}
+
+/**
+ * @brief Inicia el servidor HTTP que expone las métricas.
+ *
+ * Los pedidos se responden a partir de la última instantánea publicada por publish_metrics(), sin tomar ningún lock
+ * que use el hilo recolector.
+ * Si no se puede iniciar el servidor, se imprime un mensaje de error.
+ *
+ * @param config Configuración del servidor.
+ * @return Servidor iniciado, o NULL en caso de error.
+ */
+struct MHD_Daemon* expose_metrics(const http_config_t* config)
+{
+    struct sockaddr_storage addr;
+    unsigned int flags = http_mode_flags(config->mode) | MHD_USE_ERROR_LOG;
+
+    // La dirección de escucha puede ser IPv4 o IPv6
+    memset(&addr, 0, sizeof(addr));
+    struct sockaddr_in* addr4 = (struct sockaddr_in*)&addr;
+    struct sockaddr_in6* addr6 = (struct sockaddr_in6*)&addr;
+    if (inet_pton(AF_INET, config->address, &addr4->sin_addr) == 1)
+    {
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(config->port);
+    }
+    else if (inet_pton(AF_INET6, config->address, &addr6->sin6_addr) == 1)
+    {
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(config->port);
+        flags |= MHD_USE_IPv6;
+    }
+    else
+    {
+        fprintf(stderr, "Dirección de escucha inválida: %s\n", config->address);
+        return NULL;
+    }
+
+    // Con más de un hilo, libmicrohttpd reparte las conexiones entre un pool de hilos que comparten el socket
+    struct MHD_Daemon* daemon = MHD_start_daemon(
+        flags, config->port, NULL, NULL, handle_request, NULL, MHD_OPTION_SOCK_ADDR, (struct sockaddr*)&addr,
+        MHD_OPTION_THREAD_POOL_SIZE, config->threads > 1 ? config->threads : 0, MHD_OPTION_CONNECTION_LIMIT,
+        config->connection_limit, MHD_OPTION_CONNECTION_TIMEOUT, config->connection_timeout, MHD_OPTION_END);
+    if (daemon == NULL)
+    {
+        fprintf(stderr, "Error al iniciar el servidor HTTP en %s:%u\n", config->address, config->port);
+        return NULL;
+    }
+
+    return daemon;
+}
@@ -3,14 +3,751 @@
  * @brief Entry point of the system
  */
 
+#include "../include/collector.h"
+#include "../include/config.h"
 #include "../include/expose_metrics.h"
+#include "../include/http_server.h"
 #include "../include/metrics.h"
+#include "../include/sampler.h"
+#include <getopt.h>
+#include <limits.h>
+#include <regex.h>
+#include <signal.h>
 #include <stdbool.h>
+#include <string.h>
 
 /**
- * @brief Tiempo de espera entre actualizaciones de métricas en segundos.
+ * @brief Se pone en 1 al recibir SIGTERM o SIGINT para terminar el bucle principal.
  */
-#define SLEEP_TIME 1
+static volatile sig_atomic_t stop_requested = 0;
+
+/**
+ * @brief Se pone en 1 al recibir SIGUSR1 (un disparador de PSI) para recolectar sin esperar al próximo ciclo.
+ */
+static volatile sig_atomic_t collect_requested = 0;
+
+/**
+ * @brief Se pone en 1 al recibir SIGHUP (o un aviso de la vigilancia del archivo) para recargar la configuración.
+ */
+static volatile sig_atomic_t reload_requested = 0;
+
+/**
+ * @brief Opciones del programa, de la línea de comandos y del archivo de configuración.
+ *
+ * La cantidad de hilos y el plazo de los colectores se guardan directamente en el registro de colectores.
+ */
+typedef struct
+{
+    const char* config_path;       /**< Archivo de configuración, o NULL. */
+    const char* disk_include;      /**< Expresión de discos a incluir, o NULL. */
+    const char* disk_exclude;      /**< Expresión de discos a excluir, o NULL. */
+    const char* net_include;       /**< Expresión de interfaces a incluir, o NULL. */
+    const char* net_exclude;       /**< Expresión de interfaces a excluir, o NULL. */
+    const char* procfs_root;       /**< Raíz de procfs. */
+    unsigned long interval_ms;     /**< Período de muestreo por defecto. */
+    unsigned long proc_top;        /**< Procesos exportados por recurso (0: según el colector). */
+    const char* cgroup_root;       /**< Punto de montaje de cgroup v2. */
+    unsigned long cgroup_depth;    /**< Profundidad máxima de los cgroups exportados. */
+    unsigned long psi_stall_ms;    /**< Demora que dispara una recolección (0: sin disparadores). */
+    unsigned long psi_window_ms;   /**< Ventana de los disparadores de PSI. */
+    int rates;                     /**< 1 si se exportan las tasas calculadas. */
+    unsigned long window_ms;       /**< Ventana de las estadísticas móviles (0: deshabilitadas). */
+    unsigned long series_limit;    /**< Series admitidas por métrica etiquetada. */
+    unsigned long series_idle;     /**< Ciclos sin actualizarse tras los cuales se quita una serie. */
+    const char* history_path;      /**< Archivo de historial, o NULL. */
+    unsigned long history_size_mb; /**< Tamaño del archivo de historial. */
+    push_config_t push;            /**< Configuración del envío. */
+    int push_enabled;              /**< 1 si se envían las publicaciones. */
+    http_config_t http;            /**< Configuración del servidor HTTP. */
+} options_t;
+
+/**
+ * @brief Opciones largas, compartidas por la línea de comandos y el archivo de configuración.
+ */
+static const struct option long_options[] = {
+    {"config", required_argument, NULL, 'f'},
+    {"disk-include", required_argument, NULL, 'i'},
+    {"disk-exclude", required_argument, NULL, 'x'},
+    {"net-include", required_argument, NULL, 'I'},
+    {"net-exclude", required_argument, NULL, 'X'},
+    {"procfs", required_argument, NULL, 'r'},
+    {"interval", required_argument, NULL, 't'},
+    {"collector", required_argument, NULL, 'C'},
+    {"collector-threads", required_argument, NULL, 'T'},
+    {"collector-deadline", required_argument, NULL, 'D'},
+    {"proc-top", required_argument, NULL, 'P'},
+    {"cgroup-root", required_argument, NULL, 'g'},
+    {"cgroup-depth", required_argument, NULL, 'd'},
+    {"psi-trigger", required_argument, NULL, 's'},
+    {"psi-window", required_argument, NULL, 'w'},
+    {"rates", required_argument, NULL, 'a'},
+    {"window", required_argument, NULL, 'W'},
+    {"series-limit", required_argument, NULL, 'L'},
+    {"series-idle", required_argument, NULL, 'e'},
+    {"history", required_argument, NULL, 'H'},
+    {"history-size", required_argument, NULL, 'S'},
+    {"push", required_argument, NULL, 'u'},
+    {"push-interval", required_argument, NULL, 'F'},
+    {"push-batch", required_argument, NULL, 'B'},
+    {"push-queue", required_argument, NULL, 'Q'},
+    {"push-retries", required_argument, NULL, 'R'},
+    {"listen", required_argument, NULL, 'l'},
+    {"port", required_argument, NULL, 'p'},
+    {"http-mode", required_argument, NULL, 'm'},
+    {"http-threads", required_argument, NULL, 'n'},
+    {"max-connections", required_argument, NULL, 'c'},
+    {"connection-timeout", required_argument, NULL, 'o'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+};
+
+/**
+ * @brief Manejador de SIGUSR1: pide una recolección fuera de ciclo.
+ * @param sig Señal recibida.
+ */
+static void handle_collect_signal(int sig)
+{
+    (void)sig;
+    collect_requested = 1;
+}
+
+/**
+ * @brief Manejador de SIGHUP: pide recargar el archivo de configuración.
+ * @param sig Señal recibida.
+ */
+static void handle_reload_signal(int sig)
+{
+    (void)sig;
+    reload_requested = 1;
+}
+
+/**
+ * @brief Manejador de SIGTERM y SIGINT: pide terminar el programa.
+ * @param sig Señal recibida.
+ */
+static void handle_stop_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+/**
+ * @brief Muestra las opciones de línea de comandos y los colectores disponibles.
+ * @param prog Nombre del programa.
+ * @param collectors Registro de colectores.
+ */
+static void usage(const char* prog, const collector_registry_t* collectors)
+{
+    fprintf(stderr,
+            "Uso: %s [opciones]\n"
+            "  --config=FILE         Leer las opciones de FILE, una \"clave = valor\" por línea con los nombres\n"
+            "                        de las opciones largas; las de la línea de comandos prevalecen. Se recarga al\n"
+            "                        cambiar el archivo o al recibir SIGHUP\n"
+            "  --disk-include=REGEX  Sólo exponer los discos cuyo nombre coincida con REGEX\n"
+            "  --disk-exclude=REGEX  No exponer los discos cuyo nombre coincida con REGEX\n"
+            "                        (por defecto: particiones, ram, zram, loop y fd)\n"
+            "  --net-include=REGEX   Sólo exponer las interfaces cuyo nombre coincida con REGEX\n"
+            "  --net-exclude=REGEX   No exponer las interfaces cuyo nombre coincida con REGEX\n"
+            "                        (por defecto: lo)\n"
+            "  --procfs=DIR          Leer las métricas del sistema de DIR en lugar de %s (por ejemplo, un árbol\n"
+            "                        capturado de otro host)\n"
+            "  --interval=MS         Período de muestreo en milisegundos (por defecto: %d, mínimo: %d)\n"
+            "  --collector=NOMBRE=on|off|MS\n"
+            "                        Habilitar o deshabilitar un colector, o habilitarlo con su propio período\n"
+            "  --collector-threads=N Hilos que ejecutan los colectores (por defecto: %d, máximo: %d)\n"
+            "  --collector-deadline=MS\n"
+            "                        Plazo de cada ejecución de un colector; el que no termina conserva sus valores\n"
+            "                        anteriores y se informa como desactualizado (por defecto: %d, nunca mayor que\n"
+            "                        el período)\n"
+            "  --proc-top=N          Exportar los N procesos que más CPU, memoria e I/O consumen (0: deshabilitado;\n"
+            "                        con --collector=process=on sin --proc-top: %d). El barrido de /proc se\n"
+            "                        reparte entre ciclos sin superar el 1%% de un núcleo, así que los valores se\n"
+            "                        renuevan con menos frecuencia que el período cuando hay muchos procesos (unos\n"
+            "                        10 s con 20000); ver top_process_scan_duration_seconds\n"
+            "  --cgroup-root=DIR     Exportar CPU, memoria, I/O y presión de cada cgroup v2 montado en DIR\n"
+            "                        (por defecto %s; deshabilitado salvo con esta opción o --collector=cgroup=on)\n"
+            "  --cgroup-depth=N      Profundidad máxima de los cgroups exportados (por defecto: 0, sin límite)\n"
+            "  --psi-trigger=MS      Recolectar y publicar de inmediato cuando las tareas acumulen MS ms de demora\n"
+            "                        por CPU, memoria o I/O dentro de la ventana (0: deshabilitado)\n"
+            "  --psi-window=MS       Ventana de los disparadores de PSI (por defecto: %d, entre %d y %d)\n"
+            "  --rates=on|off        Exportar, además de los contadores NOMBRE_total, sus tasas NOMBRE_per_second\n"
+            "                        calculadas por el exportador (por defecto: on)\n"
+            "  --window=MS           Exportar mínimo, máximo, promedio y cuantiles de CPU, memoria, procesos y fallos\n"
+            "                        de página sobre los últimos MS ms (por defecto: %d; 0: deshabilitado; como\n"
+            "                        máximo %d veces el período de los colectores cpu y memory)\n"
+            "  --series-limit=N      Series admitidas por métrica etiquetada por núcleo, disco o interfaz; las\n"
+            "                        nuevas que lo superan se descartan y se cuentan en\n"
+            "                        exporter_series_dropped_total (por defecto: %d)\n"
+            "  --series-idle=N       Ciclos sin actualizarse tras los cuales se quita una serie (por defecto: %d)\n"
+            "  --history=FILE        Guardar cada muestra de CPU, memoria, procesos y fallos de página en FILE, un\n"
+            "                        archivo circular consultable en /history?metric=NOMBRE&since=S&until=S\n"
+            "  --history-size=MB     Tamaño del archivo de historial (por defecto: %d)\n"
+            "  --push=URL            Enviar además cada publicación a URL: http://HOST[:PUERTO]/RUTA (remote-write\n"
+            "                        de Prometheus) o udp://HOST:PUERTO (line protocol de InfluxDB)\n"
+            "  --push-interval=MS    Período de envío de un lote incompleto (por defecto: %d)\n"
+            "  --push-batch=N        Muestras por lote (por defecto: %d)\n"
+            "  --push-queue=N        Muestras en espera; al llenarse se descartan las más viejas (por defecto: %d)\n"
+            "  --push-retries=N      Reintentos de un lote antes de descartarlo (por defecto: %d)\n"
+            "  --listen=ADDR         Dirección IPv4 o IPv6 de escucha (por defecto: %s)\n"
+            "  --port=PORT           Puerto de escucha (por defecto: %d)\n"
+            "  --http-mode=MODE      select, poll, epoll o auto (por defecto: epoll)\n"
+            "  --http-threads=N      Hilos que atienden conexiones (por defecto: %d)\n"
+            "  --max-connections=N   Conexiones simultáneas admitidas (por defecto: %d)\n"
+            "  --connection-timeout=S\n"
+            "                        Segundos de inactividad antes de cerrar una conexión (por defecto: %d)\n"
+            "  --help                Mostrar esta ayuda\n"
+            "\nAl recargar el archivo se aplican los colectores, sus períodos y plazos, los filtros de discos e\n"
+            "interfaces, --proc-top, --cgroup-root, --cgroup-depth, --listen y --port; el resto de las opciones sólo\n"
+            "se aplica al reiniciar. Los colectores que no cambian conservan su estado.\n"
+            "\nColectores:\n",
+            prog, PROCFS_DEFAULT_ROOT, SAMPLER_DEFAULT_INTERVAL_MS, SAMPLER_MIN_INTERVAL_MS, COLLECTOR_DEFAULT_WORKERS,
+            COLLECTOR_MAX_WORKERS, COLLECTOR_DEFAULT_DEADLINE_MS, PROCESS_TOP_DEFAULT, CGROUP_DEFAULT_ROOT,
+            PRESSURE_TRIGGER_DEFAULT_WINDOW_MS, PRESSURE_TRIGGER_MIN_WINDOW_MS, PRESSURE_TRIGGER_MAX_WINDOW_MS,
+            WINDOW_STATS_DEFAULT_MS, WINDOW_STATS_MAX_SAMPLES, SERIES_DEFAULT_LIMIT, SERIES_DEFAULT_MAX_IDLE,
+            HISTORY_DEFAULT_SIZE_MB, PUSH_DEFAULT_FLUSH_MS, PUSH_DEFAULT_BATCH, PUSH_DEFAULT_QUEUE,
+            PUSH_DEFAULT_RETRIES, HTTP_DEFAULT_ADDRESS, HTTP_DEFAULT_PORT, HTTP_DEFAULT_THREADS,
+            HTTP_DEFAULT_CONNECTION_LIMIT, HTTP_DEFAULT_CONNECTION_TIMEOUT);
+    collector_registry_print(collectors, stderr);
+}
+
+/**
+ * @brief Interpreta el valor numérico de una opción.
+ * @param name Nombre de la opción (para el mensaje de error).
+ * @param value Texto del valor.
+ * @param min Valor mínimo admitido.
+ * @param max Valor máximo admitido.
+ * @param out Valor interpretado.
+ * @return 0 si el valor es válido, -1 en caso contrario.
+ */
+static int parse_number_option(const char* name, const char* value, unsigned long min, unsigned long max,
+                               unsigned long* out)
+{
+    char* end;
+    errno = 0;
+    unsigned long n = strtoul(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || errno != 0 || n < min || n > max)
+    {
+        fprintf(stderr, "Valor inválido para --%s: %s\n", name, value);
+        return -1;
+    }
+    *out = n;
+    return 0;
+}
+
+/**
+ * @brief Carga los valores por defecto de las opciones.
+ * @param opts Opciones.
+ */
+static void options_default(options_t* opts)
+{
+    memset(opts, 0, sizeof(*opts));
+    opts->disk_exclude = DISK_DEFAULT_EXCLUDE;
+    opts->net_exclude = NET_DEFAULT_EXCLUDE;
+    opts->procfs_root = PROCFS_DEFAULT_ROOT;
+    opts->interval_ms = SAMPLER_DEFAULT_INTERVAL_MS;
+    opts->cgroup_root = CGROUP_DEFAULT_ROOT;
+    opts->psi_window_ms = PRESSURE_TRIGGER_DEFAULT_WINDOW_MS;
+    opts->rates = 1;
+    opts->window_ms = WINDOW_STATS_DEFAULT_MS;
+    opts->series_limit = SERIES_DEFAULT_LIMIT;
+    opts->series_idle = SERIES_DEFAULT_MAX_IDLE;
+    opts->history_size_mb = HISTORY_DEFAULT_SIZE_MB;
+    push_config_default(&opts->push);
+    http_config_default(&opts->http);
+}
+
+/**
+ * @brief Interpreta una lista de argumentos sobre las opciones y el registro de colectores.
+ *
+ * Las opciones que no aparecen conservan su valor, de modo que una segunda lista se aplica sobre la primera.
+ *
+ * @param opts Opciones.
+ * @param collectors Registro de colectores (no iniciado).
+ * @param argc Cantidad de argumentos.
+ * @param argv Argumentos; el primero es el nombre del programa o del archivo.
+ * @return 0 si son válidos, 1 si se pidió la ayuda, 2 si hay una opción desconocida, -1 si un valor es inválido.
+ */
+static int parse_options(options_t* opts, collector_registry_t* collectors, int argc, char* argv[])
+{
+    unsigned long value;
+    int opt;
+
+    // optind en 0 reinicia getopt_long() por completo, para poder interpretar varias listas
+    optind = 0;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            opts->config_path = optarg;
+            break;
+        case 'i':
+            opts->disk_include = optarg;
+            break;
+        case 'x':
+            opts->disk_exclude = optarg;
+            break;
+        case 'I':
+            opts->net_include = optarg;
+            break;
+        case 'X':
+            opts->net_exclude = optarg;
+            break;
+        case 'r':
+            opts->procfs_root = optarg;
+            break;
+        case 't':
+            if (parse_number_option("interval", optarg, 0, ULONG_MAX, &opts->interval_ms) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'C':
+            if (collector_configure(collectors, optarg) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'T':
+            if (parse_number_option("collector-threads", optarg, 1, COLLECTOR_MAX_WORKERS, &value) != 0)
+            {
+                return -1;
+            }
+            collectors->worker_count = (unsigned int)value;
+            break;
+        case 'D':
+            if (parse_number_option("collector-deadline", optarg, 1, ULONG_MAX, &collectors->deadline_ms) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'P':
+            if (parse_number_option("proc-top", optarg, 0, PROCESS_TOP_MAX, &opts->proc_top) != 0)
+            {
+                return -1;
+            }
+            collector_configure(collectors, opts->proc_top > 0 ? "process=on" : "process=off");
+            break;
+        case 'g':
+            opts->cgroup_root = optarg;
+            collector_configure(collectors, "cgroup=on");
+            break;
+        case 'd':
+            if (parse_number_option("cgroup-depth", optarg, 0, UINT_MAX, &opts->cgroup_depth) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 's':
+            if (parse_number_option("psi-trigger", optarg, 0, PRESSURE_TRIGGER_MAX_WINDOW_MS, &opts->psi_stall_ms) !=
+                0)
+            {
+                return -1;
+            }
+            break;
+        case 'w':
+            if (parse_number_option("psi-window", optarg, PRESSURE_TRIGGER_MIN_WINDOW_MS,
+                                    PRESSURE_TRIGGER_MAX_WINDOW_MS, &opts->psi_window_ms) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'a':
+            if (strcmp(optarg, "on") != 0 && strcmp(optarg, "off") != 0)
+            {
+                fprintf(stderr, "Valor inválido para --rates: %s\n", optarg);
+                return -1;
+            }
+            opts->rates = strcmp(optarg, "on") == 0;
+            break;
+        case 'W':
+            if (parse_number_option("window", optarg, 0, 3600000, &opts->window_ms) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'L':
+            if (parse_number_option("series-limit", optarg, 1, 1UL << SERIES_INDEX_BITS, &opts->series_limit) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'e':
+            if (parse_number_option("series-idle", optarg, 1, ULONG_MAX, &opts->series_idle) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'H':
+            opts->history_path = optarg;
+            break;
+        case 'S':
+            if (parse_number_option("history-size", optarg, 1, 65536, &opts->history_size_mb) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'u':
+            if (push_parse_url(&opts->push, optarg) != 0)
+            {
+                return -1;
+            }
+            opts->push_enabled = 1;
+            break;
+        case 'F':
+            if (parse_number_option("push-interval", optarg, 1, ULONG_MAX, &opts->push.flush_ms) != 0)
+            {
+                return -1;
+            }
+            break;
+        case 'B':
+            if (parse_number_option("push-batch", optarg, 1, 1000000, &value) != 0)
+            {
+                return -1;
+            }
+            opts->push.batch_size = value;
+            break;
+        case 'Q':
+            if (parse_number_option("push-queue", optarg, 1, 10000000, &value) != 0)
+            {
+                return -1;
+            }
+            opts->push.queue_size = value;
+            break;
+        case 'R':
+            if (parse_number_option("push-retries", optarg, 0, 100, &value) != 0)
+            {
+                return -1;
+            }
+            opts->push.max_retries = (unsigned int)value;
+            break;
+        case 'l':
+            opts->http.address = optarg;
+            break;
+        case 'p':
+            if (parse_number_option("port", optarg, 1, 65535, &value) != 0)
+            {
+                return -1;
+            }
+            opts->http.port = (unsigned short)value;
+            break;
+        case 'm':
+            if (parse_http_mode(optarg, &opts->http.mode) != 0)
+            {
+                fprintf(stderr, "Modo de servidor HTTP inválido: %s\n", optarg);
+                return -1;
+            }
+            break;
+        case 'n':
+            if (parse_number_option("http-threads", optarg, 1, 1024, &value) != 0)
+            {
+                return -1;
+            }
+            opts->http.threads = (unsigned int)value;
+            break;
+        case 'c':
+            if (parse_number_option("max-connections", optarg, 1, UINT_MAX, &value) != 0)
+            {
+                return -1;
+            }
+            opts->http.connection_limit = (unsigned int)value;
+            break;
+        case 'o':
+            if (parse_number_option("connection-timeout", optarg, 0, UINT_MAX, &value) != 0)
+            {
+                return -1;
+            }
+            opts->http.connection_timeout = (unsigned int)value;
+            break;
+        case 'h':
+            return 1;
+        default:
+            return 2;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Arma las opciones y el registro de colectores a partir de la línea de comandos y del archivo de
+ * configuración, si la línea de comandos indica uno.
+ * @param opts Opciones.
+ * @param collectors Registro de colectores a inicializar.
+ * @param file Opciones leídas del archivo; sus textos deben vivir mientras se usen las opciones.
+ * @param argc Cantidad de argumentos de la línea de comandos.
+ * @param argv Argumentos de la línea de comandos.
+ * @return Lo mismo que parse_options(), o -1 si no se pudo leer el archivo.
+ */
+static int load_options(options_t* opts, collector_registry_t* collectors, config_file_t* file, int argc,
+                        char* argv[])
+{
+    memset(file, 0, sizeof(*file));
+    options_default(opts);
+    collector_registry_init(collectors);
+    if (register_collectors(collectors) != 0)
+    {
+        return -1;
+    }
+    int ret = parse_options(opts, collectors, argc, argv);
+    if (ret != 0 || opts->config_path == NULL)
+    {
+        return ret;
+    }
+
+    // Primero el archivo y después otra vez la línea de comandos, para que sus opciones prevalezcan
+    const char* path = opts->config_path;
+    options_default(opts);
+    collector_registry_init(collectors);
+    if (register_collectors(collectors) != 0 || config_file_load(file, path) != 0)
+    {
+        return -1;
+    }
+    ret = parse_options(opts, collectors, file->count, file->args);
+    if (ret == 0)
+    {
+        ret = parse_options(opts, collectors, argc, argv);
+    }
+    return ret;
+}
+
+/**
+ * @brief Verifica una expresión de filtro sin aplicarla.
+ * @param regex Expresión, o NULL.
+ * @return 0 si es válida o no hay expresión, -1 en caso contrario.
+ */
+static int check_filter(const char* regex)
+{
+    regex_t compiled;
+    if (regex == NULL || *regex == '\0')
+    {
+        return 0;
+    }
+    if (regcomp(&compiled, regex, REG_EXTENDED | REG_NOSUB) != 0)
+    {
+        fprintf(stderr, "Expresión de filtro inválida: %s\n", regex);
+        return -1;
+    }
+    regfree(&compiled);
+    return 0;
+}
+
+/**
+ * @brief Verifica que la ventana de las estadísticas móviles quepa en WINDOW_STATS_MAX_SAMPLES muestras de los
+ * colectores que la alimentan (cpu y memory); si no, las series *_window cubrirían menos tiempo del configurado.
+ * @param window_ms Ventana, o 0 si está deshabilitada.
+ * @param default_interval_ms Período de los colectores sin período propio.
+ * @param collectors Registro de colectores.
+ * @return 0 si la ventana cabe, -1 en caso contrario.
+ */
+static int check_window(unsigned long window_ms, unsigned long default_interval_ms, collector_registry_t* collectors)
+{
+    static const char* const sources[] = {"cpu", "memory"};
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+    {
+        collector_t* collector = collector_find(collectors, sources[i]);
+        if (collector == NULL || !collector->enabled)
+        {
+            continue;
+        }
+        unsigned long interval = collector->interval_ms != 0 ? collector->interval_ms : default_interval_ms;
+        if (interval <= ULONG_MAX / WINDOW_STATS_MAX_SAMPLES && window_ms > interval * WINDOW_STATS_MAX_SAMPLES)
+        {
+            fprintf(stderr,
+                    "La ventana de %lu ms no cabe en %d muestras del colector %s cada %lu ms (máximo: %lu ms)\n",
+                    window_ms, WINDOW_STATS_MAX_SAMPLES, sources[i], interval, interval * WINDOW_STATS_MAX_SAMPLES);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Compara dos textos opcionales.
+ * @param a Primer texto, o NULL.
+ * @param b Segundo texto, o NULL.
+ * @return 1 si son distintos, 0 si son iguales.
+ */
+static int option_changed(const char* a, const char* b)
+{
+    if (a == NULL || b == NULL)
+    {
+        return a != b;
+    }
+    return strcmp(a, b) != 0;
+}
+
+/**
+ * @brief Avisa de las opciones que cambiaron en el archivo pero sólo se aplican al reiniciar.
+ * @param cur Opciones en uso.
+ * @param next Opciones leídas.
+ * @param collectors Registro en uso.
+ * @param desired Registro leído.
+ */
+static void warn_restart_options(const options_t* cur, const options_t* next, const collector_registry_t* collectors,
+                                 const collector_registry_t* desired)
+{
+    const push_config_t* a = &cur->push;
+    const push_config_t* b = &next->push;
+    int push_changed = cur->push_enabled != next->push_enabled || a->format != b->format ||
+                       strcmp(a->host, b->host) != 0 || strcmp(a->port, b->port) != 0 ||
+                       strcmp(a->path, b->path) != 0 || a->queue_size != b->queue_size ||
+                       a->batch_size != b->batch_size || a->flush_ms != b->flush_ms || a->max_retries != b->max_retries;
+    const struct
+    {
+        const char* name;
+        int changed;
+    } options[] = {
+        {"procfs", option_changed(cur->procfs_root, next->procfs_root)},
+        {"collector-threads", collectors->worker_count != desired->worker_count},
+        {"psi-trigger/psi-window",
+         cur->psi_stall_ms != next->psi_stall_ms || cur->psi_window_ms != next->psi_window_ms},
+        {"rates", cur->rates != next->rates},
+        {"window", cur->window_ms != next->window_ms},
+        {"series-limit/series-idle",
+         cur->series_limit != next->series_limit || cur->series_idle != next->series_idle},
+        {"history/history-size", option_changed(cur->history_path, next->history_path) ||
+                                     cur->history_size_mb != next->history_size_mb},
+        {"push*", push_changed},
+        {"http-mode/http-threads/max-connections/connection-timeout",
+         cur->http.mode != next->http.mode || cur->http.threads != next->http.threads ||
+             cur->http.connection_limit != next->http.connection_limit ||
+             cur->http.connection_timeout != next->http.connection_timeout},
+    };
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++)
+    {
+        if (options[i].changed)
+        {
+            fprintf(stderr, "El cambio de --%s sólo se aplica al reiniciar\n", options[i].name);
+        }
+    }
+}
+
+/**
+ * @brief Recarga el archivo de configuración y aplica lo que cambió.
+ *
+ * Todo lo que puede fallar (leer el archivo, validar las opciones, abrir el nuevo puerto e inicializar los colectores
+ * que se habilitan) ocurre antes de modificar nada, de modo que una configuración inválida deja todo como estaba.
+ *
+ * @param opts Opciones en uso; se actualizan las que se aplicaron.
+ * @param file Archivo del que salen las opciones en uso; se reemplaza por el nuevo.
+ * @param collectors Registro de colectores iniciado.
+ * @param daemon Servidor HTTP en uso; se reemplaza si cambió la dirección o el puerto.
+ * @param argc Cantidad de argumentos de la línea de comandos.
+ * @param argv Argumentos de la línea de comandos.
+ * @return 0 si se aplicó, -1 si la configuración es inválida.
+ */
+static int reload_options(options_t* opts, config_file_t* file, collector_registry_t* collectors,
+                          struct MHD_Daemon** daemon, int argc, char* argv[])
+{
+    options_t next;
+    collector_registry_t desired;
+    config_file_t next_file;
+
+    // La ventana no se recarga: la que sigue vigente tiene que caber con los períodos nuevos de los colectores
+    int ret = load_options(&next, &desired, &next_file, argc, argv);
+    if (ret != 0 || check_filter(next.disk_include) != 0 || check_filter(next.disk_exclude) != 0 ||
+        check_filter(next.net_include) != 0 || check_filter(next.net_exclude) != 0 ||
+        check_window(opts->window_ms, next.interval_ms, &desired) != 0)
+    {
+        if (ret == 2)
+        {
+            fprintf(stderr, "Opción desconocida en %s\n", opts->config_path);
+        }
+        config_file_free(&next_file);
+        return -1;
+    }
+    warn_restart_options(opts, &next, collectors, &desired);
+
+    // El puerto nuevo se abre antes de cerrar el anterior: si está ocupado, se sigue escuchando donde se escuchaba
+    struct MHD_Daemon* next_daemon = NULL;
+    int listen_changed = option_changed(opts->http.address, next.http.address) || opts->http.port != next.http.port;
+    if (listen_changed)
+    {
+        http_config_t http = opts->http;
+        http.address = next.http.address;
+        http.port = next.http.port;
+
+        sigset_t signals, old;
+        sigfillset(&signals);
+        pthread_sigmask(SIG_BLOCK, &signals, &old);
+        next_daemon = expose_metrics(&http);
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+        if (next_daemon == NULL)
+        {
+            config_file_free(&next_file);
+            return -1;
+        }
+    }
+
+    int changed = collector_registry_reload(collectors, &desired, next.interval_ms);
+    if (changed < 0)
+    {
+        if (next_daemon != NULL)
+        {
+            MHD_stop_daemon(next_daemon);
+        }
+        config_file_free(&next_file);
+        return -1;
+    }
+
+    // Los filtros ya se validaron: reiniciar la tabla sólo pierde las lecturas anteriores del colector afectado
+    if (option_changed(opts->disk_include, next.disk_include) || option_changed(opts->disk_exclude, next.disk_exclude))
+    {
+        init_disk_stats(next.disk_include, next.disk_exclude);
+    }
+    if (option_changed(opts->net_include, next.net_include) || option_changed(opts->net_exclude, next.net_exclude))
+    {
+        init_net_stats(next.net_include, next.net_exclude);
+    }
+
+    collector_t* process = collector_find(collectors, "process");
+    if (next.proc_top != opts->proc_top && process != NULL && process->initialized)
+    {
+        configure_process_metrics(next.proc_top > 0 ? next.proc_top : PROCESS_TOP_DEFAULT);
+    }
+
+    // El colector de cgroups vigila la jerarquía desde su inicialización: si cambia la raíz, se reinicia
+    collector_t* cgroup = collector_find(collectors, "cgroup");
+    if (option_changed(opts->cgroup_root, next.cgroup_root) || opts->cgroup_depth != next.cgroup_depth)
+    {
+        configure_cgroup_metrics(next.cgroup_root, (unsigned int)next.cgroup_depth);
+        if (cgroup != NULL && cgroup->initialized)
+        {
+            cgroup->destroy();
+            if (cgroup->init() != 0)
+            {
+                // Sin inicializar, el colector no exporta nada; la próxima recarga vuelve a intentarlo
+                fprintf(stderr, "Error al reiniciar el colector cgroup con la raíz %s\n", next.cgroup_root);
+                cgroup->initialized = 0;
+            }
+        }
+    }
+
+    if (next_daemon != NULL)
+    {
+        MHD_stop_daemon(*daemon);
+        *daemon = next_daemon;
+        fprintf(stderr, "Escuchando en %s:%u\n", next.http.address, next.http.port);
+    }
+
+    // Las opciones que se aplicaron pasan a apuntar al archivo nuevo; el resto sigue apuntando al de inicio
+    opts->disk_include = next.disk_include;
+    opts->disk_exclude = next.disk_exclude;
+    opts->net_include = next.net_include;
+    opts->net_exclude = next.net_exclude;
+    opts->interval_ms = next.interval_ms;
+    opts->proc_top = next.proc_top;
+    opts->cgroup_root = next.cgroup_root;
+    opts->cgroup_depth = next.cgroup_depth;
+    opts->http.address = next.http.address;
+    opts->http.port = next.http.port;
+    config_file_free(file);
+    *file = next_file;
+
+    fprintf(stderr, "Configuración recargada de %s (%d colectores cambiaron)\n", opts->config_path, changed);
+    return 0;
+}
+
 /**
  * @brief Ejecuta el programa principal.
  * @param argc Cantidad de argumentos.
@@ -20,26 +757,144 @@
 
 int main(int argc, char* argv[])
 {
+    options_t opts;
+    collector_registry_t collectors;
+
+    // Las opciones de inicio que no se recargan apuntan a startup_file durante toda la ejecución; las que se recargan
+    // pasan a apuntar a reload_file
+    static config_file_t startup_file;
+    static config_file_t reload_file;
+    int ret = load_options(&opts, &collectors, &startup_file, argc, argv);
+    if (ret == 0 && check_window(opts.window_ms, opts.interval_ms, &collectors) != 0)
+    {
+        ret = -1;
+    }
+    if (ret != 0)
+    {
+        if (ret > 0)
+        {
+            usage(argv[0], &collectors);
+        }
+        config_file_free(&startup_file);
+        return ret == 1 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    set_procfs_root(opts.procfs_root);
+    configure_process_metrics(opts.proc_top);
+    configure_rate_metrics(opts.rates);
+    configure_cgroup_metrics(opts.cgroup_root, (unsigned int)opts.cgroup_depth);
+    configure_window_metrics(opts.window_ms);
+    configure_series_limits(opts.series_limit, opts.series_idle);
     init_metrics();
-    // Creamos un hilo para exponer las métricas vía HTTP
-    pthread_t tid;
-    if (pthread_create(&tid, NULL, expose_metrics, NULL) != 0)
+    if (init_disk_stats(opts.disk_include, opts.disk_exclude) != 0 ||
+        init_net_stats(opts.net_include, opts.net_exclude) != 0 ||
+        (opts.history_path != NULL && enable_history(opts.history_path, opts.history_size_mb) != 0) ||
+        (opts.push_enabled && enable_push(&opts.push) != 0) ||
+        collector_registry_start(&collectors, opts.interval_ms) != 0)
     {
-        fprintf(stderr, "Error al crear el hilo del servidor HTTP\n");
+        collector_registry_destroy(&collectors);
+        disable_push();
+        disable_history();
+        close_proc_files();
         return EXIT_FAILURE;
     }
 
-    // Bucle principal para actualizar las métricas cada segundo
-    while (true)
+    // SIGTERM, SIGINT, SIGUSR1 y SIGHUP se bloquean mientras se crean los hilos del servidor HTTP, de los
+    // disparadores de PSI y de la vigilancia del archivo, que heredan la máscara, para que siempre los reciba este
+    // hilo e interrumpan la espera del muestreador
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    sa.sa_handler = handle_collect_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+    sa.sa_handler = handle_reload_signal;
+    sigaction(SIGHUP, &sa, NULL);
+
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGTERM);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGUSR1);
+    sigaddset(&stop_signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+    config_watch_t watch = {.running = 0};
+    struct MHD_Daemon* daemon = expose_metrics(&opts.http);
+    int triggers_failed = daemon != NULL && opts.psi_stall_ms > 0 &&
+                          enable_pressure_triggers((unsigned int)opts.psi_stall_ms, (unsigned int)opts.psi_window_ms,
+                                                   pthread_self(), SIGUSR1) != 0;
+    int watch_failed = daemon != NULL && !triggers_failed && opts.config_path != NULL &&
+                       config_watch_start(&watch, opts.config_path, pthread_self(), SIGHUP) != 0;
+    pthread_sigmask(SIG_UNBLOCK, &stop_signals, NULL);
+    if (daemon == NULL || triggers_failed || watch_failed)
+    {
+        disable_pressure_triggers();
+        if (daemon != NULL)
+        {
+            MHD_stop_daemon(daemon);
+        }
+        collector_registry_destroy(&collectors);
+        disable_push();
+        disable_history();
+        close_proc_files();
+        return EXIT_FAILURE;
+    }
+
+    // Bucle principal: cada colector se ejecuta al llegar su instante y se publica si alguno actualizó sus métricas
+    int reload_pending = 0;
+    while (!stop_requested)
+    {
+        if (reload_requested || reload_pending)
+        {
+            // La recarga espera a que no haya colectores en ejecución (por ejemplo, uno colgado que venció su
+            // plazo); se avisa una vez por recarga demorada, con el colector que la demora, para que un colgado no
+            // pase inadvertido
+            reload_requested = 0;
+            const collector_t* busy = collector_registry_busy(&collectors);
+            if (busy != NULL && !reload_pending)
+            {
+                fprintf(stderr, "La recarga de la configuración espera a que termine el colector %s\n", busy->name);
+            }
+            reload_pending = busy != NULL;
+            if (!reload_pending && opts.config_path != NULL)
+            {
+                reload_options(&opts, &reload_file, &collectors, &daemon, argc, argv);
+            }
+        }
+        if (collect_requested)
+        {
+            // Recolección fuera de ciclo pedida por un disparador de PSI: todos los colectores, sin reprogramarlos
+            collect_requested = 0;
+            collector_registry_run_all(&collectors);
+            publish_metrics(&collectors);
+        }
+        else if (collector_registry_run_due(&collectors) > 0)
+        {
+            publish_metrics(&collectors);
+        }
+        while (!stop_requested && !collect_requested && !reload_requested &&
+               collector_registry_wait(&collectors) != 0)
+        {
+            // Una señal que no pide terminar, recolectar ni recargar sólo interrumpe la espera: volvemos a esperar el
+            // mismo instante. Tras una recolección fuera de ciclo, cada colector sigue en su fase original
+        }
+    }
+
+    // Dejamos de aceptar conexiones y esperamos las respuestas en curso antes de liberar las instantáneas
+    config_watch_stop(&watch);
+    disable_pressure_triggers();
+    MHD_stop_daemon(daemon);
+    metrics_snapshot_shutdown();
+    disable_push();
+    if (collector_registry_destroy(&collectors) == 0)
     {
-        update_cpu_gauge();
-        update_memory_gauge();
-        update_disk_io_gauge();
-        update_red_gauge();
-        update_proc_number();
-        update_context_switches();
-        sleep(SLEEP_TIME);
+        // Con un colector colgado, su hilo todavía puede usar los archivos y el historial: los cierra el sistema al
+        // salir (las páginas del historial ya escritas llegan igual al archivo)
+        disable_history();
+        close_proc_files();
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -1,4 +1,330 @@
 #include "../include/metrics.h"
+#include "../include/proc_reader.h"
+#include "../include/proc_scan.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Raíz de procfs de la que se leen las métricas del sistema.
+ */
+static const char* procfs_root = PROCFS_DEFAULT_ROOT;
+
+/**
+ * @brief Archivo /proc/stat abierto de forma persistente.
+ */
+static proc_file_t stat_file = {.fd = -1};
+
+/**
+ * @brief Directorio /proc/self/fd abierto de forma persistente para contar los descriptores propios, o -1.
+ */
+static int self_fd_dir = -1;
+
+/**
+ * @brief Tamaño del buffer de getdents64() para contar los descriptores propios.
+ */
+#define SELF_FD_DIRENTS_SIZE 4096
+
+/**
+ * @brief Buffer de getdents64() para contar los descriptores propios.
+ */
+static char self_fd_dirents[SELF_FD_DIRENTS_SIZE] __attribute__((aligned(8)));
+
+/**
+ * @brief Archivo /proc/meminfo abierto de forma persistente.
+ */
+static proc_file_t meminfo_file = {.fd = -1};
+
+/**
+ * @brief Archivo /proc/vmstat abierto de forma persistente.
+ */
+static proc_file_t vmstat_file = {.fd = -1};
+
+/**
+ * @brief Archivo /proc/diskstats abierto de forma persistente.
+ */
+static proc_file_t diskstats_file = {.fd = -1};
+
+/**
+ * @brief Archivo /proc/net/dev abierto de forma persistente.
+ */
+static proc_file_t netdev_file = {.fd = -1};
+
+/**
+ * @brief Archivo /proc/loadavg abierto de forma persistente.
+ */
+static proc_file_t loadavg_file = {.fd = -1};
+
+/**
+ * @brief Archivo /proc/self/statm abierto de forma persistente.
+ */
+static proc_file_t statm_file = {.fd = -1};
+
+/**
+ * @brief Archivos de /proc/pressure abiertos de forma persistente (fd en -1 si el kernel no tiene PSI).
+ */
+static proc_file_t pressure_files[PRESSURE_RESOURCE_COUNT] = {{.fd = -1}, {.fd = -1}, {.fd = -1}};
+
+/**
+ * @brief Rutas de los archivos de /proc/pressure relativas a la raíz de procfs, en el orden de pressure_resource_t.
+ */
+static const char* const pressure_paths[PRESSURE_RESOURCE_COUNT] = {
+    "pressure/cpu",
+    "pressure/memory",
+    "pressure/io",
+};
+
+/**
+ * @brief Último contenido leído de cada archivo de /proc/pressure.
+ */
+static pressure_sample_t pressure_stats[PRESSURE_RESOURCE_COUNT];
+
+/**
+ * @brief Última lectura de /proc/meminfo.
+ */
+static meminfo_snapshot_t meminfo;
+
+/**
+ * @brief Lectura anterior de /proc/vmstat.
+ */
+static vmstat_snapshot_t vmstat_prev;
+
+/**
+ * @brief Tasas de /proc/vmstat del último intervalo.
+ */
+static vmstat_rates_t vmstat_rates;
+
+/**
+ * @brief Campos de /proc/meminfo, ordenados por clave para la búsqueda binaria de scan_fields().
+ */
+static const scan_field_t meminfo_fields[] = {
+    {"Active", offsetof(meminfo_snapshot_t, active)},
+    {"AnonHugePages", offsetof(meminfo_snapshot_t, anon_hugepages)},
+    {"AnonPages", offsetof(meminfo_snapshot_t, anon_pages)},
+    {"Buffers", offsetof(meminfo_snapshot_t, buffers)},
+    {"Cached", offsetof(meminfo_snapshot_t, cached)},
+    {"CommitLimit", offsetof(meminfo_snapshot_t, commit_limit)},
+    {"Committed_AS", offsetof(meminfo_snapshot_t, committed_as)},
+    {"Dirty", offsetof(meminfo_snapshot_t, dirty)},
+    {"HugePages_Free", offsetof(meminfo_snapshot_t, hugepages_free)},
+    {"HugePages_Rsvd", offsetof(meminfo_snapshot_t, hugepages_rsvd)},
+    {"HugePages_Surp", offsetof(meminfo_snapshot_t, hugepages_surp)},
+    {"HugePages_Total", offsetof(meminfo_snapshot_t, hugepages_total)},
+    {"Hugepagesize", offsetof(meminfo_snapshot_t, hugepagesize)},
+    {"Inactive", offsetof(meminfo_snapshot_t, inactive)},
+    {"KernelStack", offsetof(meminfo_snapshot_t, kernel_stack)},
+    {"Mapped", offsetof(meminfo_snapshot_t, mapped)},
+    {"MemAvailable", offsetof(meminfo_snapshot_t, mem_available)},
+    {"MemFree", offsetof(meminfo_snapshot_t, mem_free)},
+    {"MemTotal", offsetof(meminfo_snapshot_t, mem_total)},
+    {"PageTables", offsetof(meminfo_snapshot_t, page_tables)},
+    {"SReclaimable", offsetof(meminfo_snapshot_t, sreclaimable)},
+    {"SUnreclaim", offsetof(meminfo_snapshot_t, sunreclaim)},
+    {"Shmem", offsetof(meminfo_snapshot_t, shmem)},
+    {"Slab", offsetof(meminfo_snapshot_t, slab)},
+    {"SwapCached", offsetof(meminfo_snapshot_t, swap_cached)},
+    {"SwapFree", offsetof(meminfo_snapshot_t, swap_free)},
+    {"SwapTotal", offsetof(meminfo_snapshot_t, swap_total)},
+    {"Writeback", offsetof(meminfo_snapshot_t, writeback)},
+};
+
+/**
+ * @brief Campos de /proc/vmstat, ordenados por clave para la búsqueda binaria de scan_fields().
+ */
+static const scan_field_t vmstat_fields[] = {
+    {"oom_kill", offsetof(vmstat_snapshot_t, oom_kill)},
+    {"pgfault", offsetof(vmstat_snapshot_t, pgfault)},
+    {"pgmajfault", offsetof(vmstat_snapshot_t, pgmajfault)},
+    {"pswpin", offsetof(vmstat_snapshot_t, pswpin)},
+    {"pswpout", offsetof(vmstat_snapshot_t, pswpout)},
+};
+
+/**
+ * @brief Contadores acumulados de /proc/stat y sus tasas del último intervalo.
+ */
+static proc_stat_counters_t proc_stat_counters;
+
+/**
+ * @brief Contadores por núcleo completados en cada lectura de /proc/stat.
+ */
+static cpu_core_stats_t core_stats;
+
+/**
+ * @brief Tabla de dispositivos de bloque, conservada entre ciclos.
+ */
+static disk_table_t disk_table;
+
+/**
+ * @brief Tabla de interfaces de red, conservada entre ciclos.
+ */
+static net_table_t net_table;
+
+/**
+ * @brief Tabla de procesos, conservada entre barridos (sin inicializar si el colector está deshabilitado).
+ */
+static process_table_t process_table = {.proc_fd = -1};
+
+/**
+ * @brief Jerarquía de cgroups vigilada (sin inicializar si el colector está deshabilitado).
+ */
+static cgroup_tree_t cgroup_tree = {.root_fd = -1, .inotify_fd = -1};
+
+/**
+ * @brief Nombres de los modos de CPU, en el orden de cpu_mode_t.
+ */
+static const char* const cpu_mode_names[CPU_MODE_COUNT] = {
+    "user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal",
+};
+
+/**
+ * @brief Cambia la raíz de procfs de la que se leen las métricas del sistema.
+ * @param root Directorio raíz.
+ */
+void set_procfs_root(const char* root)
+{
+    procfs_root = root;
+}
+
+/**
+ * @brief Arma la ruta de un archivo bajo la raíz de procfs.
+ * @param name Ruta relativa a la raíz (por ejemplo "net/dev").
+ * @param path Buffer de destino, de PATH_MAX bytes.
+ * @return path.
+ */
+static const char* procfs_path(const char* name, char* path)
+{
+    snprintf(path, PATH_MAX, "%s/%s", procfs_root, name);
+    return path;
+}
+
+/**
+ * @brief Abre los archivos de /proc que se leen en cada ciclo.
+ * @return 0 si todos se abrieron correctamente, -1 si alguno falló.
+ */
+int init_proc_files()
+{
+    char path[PATH_MAX];
+    int ret = 0;
+    ret |= proc_file_open(&stat_file, procfs_path("stat", path));
+    ret |= proc_file_open(&meminfo_file, procfs_path("meminfo", path));
+    ret |= proc_file_open(&vmstat_file, procfs_path("vmstat", path));
+    ret |= proc_file_open(&diskstats_file, procfs_path("diskstats", path));
+    ret |= proc_file_open(&netdev_file, procfs_path("net/dev", path));
+    ret |= proc_file_open(&loadavg_file, procfs_path("loadavg", path));
+
+    // El consumo propio es siempre el de este proceso, aunque se lea otra raíz de procfs
+    ret |= proc_file_open(&statm_file, "/proc/self/statm");
+    if (self_fd_dir < 0)
+    {
+        self_fd_dir = open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+
+    // PSI es opcional (CONFIG_PSI, o psi=0 en la línea de comandos del kernel): si falta no se exporta
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        if (access(procfs_path(pressure_paths[r], path), R_OK) == 0)
+        {
+            ret |= proc_file_open(&pressure_files[r], path);
+        }
+    }
+    if (disk_table.slots == NULL)
+    {
+        ret |= disk_table_init(&disk_table, NULL, DISK_DEFAULT_EXCLUDE);
+    }
+    if (net_table.slots == NULL)
+    {
+        ret |= net_table_init(&net_table, NULL, NET_DEFAULT_EXCLUDE);
+    }
+    return ret;
+}
+
+/**
+ * @brief Cierra los archivos de /proc abiertos por init_proc_files().
+ */
+void close_proc_files()
+{
+    proc_file_close(&stat_file);
+    proc_file_close(&meminfo_file);
+    proc_file_close(&vmstat_file);
+    proc_file_close(&diskstats_file);
+    proc_file_close(&netdev_file);
+    proc_file_close(&loadavg_file);
+    proc_file_close(&statm_file);
+    if (self_fd_dir >= 0)
+    {
+        close(self_fd_dir);
+        self_fd_dir = -1;
+    }
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        if (pressure_files[r].fd >= 0)
+        {
+            proc_file_close(&pressure_files[r]);
+        }
+    }
+
+    // Liberamos también los arreglos por núcleo que se completan a partir de /proc/stat
+    free(core_stats.id);
+    free(core_stats.total);
+    for (int m = 0; m < CPU_MODE_COUNT; m++)
+    {
+        free(core_stats.cur[m]);
+        free(core_stats.prev[m]);
+        free(core_stats.percent[m]);
+    }
+    memset(&core_stats, 0, sizeof(core_stats));
+    disk_table_destroy(&disk_table);
+    net_table_destroy(&net_table);
+    close_process_stats();
+    close_cgroup_stats();
+}
+
+/**
+ * @brief Analiza el contenido de /proc/meminfo.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si se encontraron MemTotal y MemAvailable, -1 en caso contrario.
+ */
+int parse_meminfo(const char* buf, size_t len, meminfo_snapshot_t* snapshot)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    scan_fields(buf, len, ':', meminfo_fields, sizeof(meminfo_fields) / sizeof(meminfo_fields[0]), snapshot);
+    return (snapshot->mem_total == 0 || snapshot->mem_available == 0) ? -1 : 0;
+}
+
+/**
+ * @brief Lee /proc/meminfo.
+ * @return Instantánea de /proc/meminfo, o NULL en caso de error.
+ */
+const meminfo_snapshot_t* get_meminfo()
+{
+    // Releer /proc/meminfo sobre el descriptor persistente
+    if (proc_file_read(&meminfo_file) == NULL)
+    {
+        return NULL;
+    }
+    if (parse_meminfo(meminfo_file.buf, meminfo_file.len, &meminfo) != 0)
+    {
+        fprintf(stderr, "Error al leer la información de memoria desde /proc/meminfo\n");
+        return NULL;
+    }
+    return &meminfo;
+}
+
+/**
+ * @brief Calcula el porcentaje de uso de memoria.
+ * @param meminfo Instantánea de /proc/meminfo.
+ * @return Porcentaje de uso de memoria.
+ */
+double compute_memory_usage(const meminfo_snapshot_t* meminfo)
+{
+    double used_mem = (double)(meminfo->mem_total - meminfo->mem_available);
+    return used_mem / (double)meminfo->mem_total * 100.0;
+}
 
 /**
  * @brief Obtiene el porcentaje de uso de memoria.
@@ -6,85 +332,512 @@
  */
 double get_memory_usage()
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long total_mem = 0, free_mem = 0;
+    const meminfo_snapshot_t* snapshot = get_meminfo();
+    return snapshot != NULL ? compute_memory_usage(snapshot) : -1.0;
+}
+
+/**
+ * @brief Analiza el contenido de /proc/vmstat.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si se encontró pgfault, -1 en caso contrario.
+ */
+int parse_vmstat(const char* buf, size_t len, vmstat_snapshot_t* snapshot)
+{
+    // Valor que no puede leerse de una línea, para distinguir un pgfault ausente de uno en 0
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->pgfault = ~0ULL;
+    scan_fields(buf, len, '\0', vmstat_fields, sizeof(vmstat_fields) / sizeof(vmstat_fields[0]), snapshot);
+    return snapshot->pgfault == ~0ULL ? -1 : 0;
+}
+
+/**
+ * @brief Obtiene las tasas de /proc/vmstat.
+ * @return Tasas por segundo, o NULL en caso de error.
+ */
+const vmstat_rates_t* get_vmstat_rates()
+{
+    vmstat_snapshot_t cur;
 
-    // Abrir el archivo /proc/meminfo
-    fp = fopen("/proc/meminfo", "r");
-    if (fp == NULL)
+    if (proc_file_read(&vmstat_file) == NULL)
     {
-        perror("Error al abrir /proc/meminfo");
-        return -1.0;
+        return NULL;
+    }
+    if (parse_vmstat(vmstat_file.buf, vmstat_file.len, &cur) != 0)
+    {
+        fprintf(stderr, "Error al parsear /proc/vmstat\n");
+        return NULL;
     }
 
-    // Leer los valores de memoria total y disponible
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    double elapsed = proc_file_elapsed(&vmstat_file);
+    vmstat_rates.valid = elapsed > 0.0;
+    if (vmstat_rates.valid)
+    {
+        vmstat_rates.pgfault = counter_rate(cur.pgfault, vmstat_prev.pgfault, elapsed);
+        vmstat_rates.pgmajfault = counter_rate(cur.pgmajfault, vmstat_prev.pgmajfault, elapsed);
+        vmstat_rates.pswpin = counter_rate(cur.pswpin, vmstat_prev.pswpin, elapsed);
+        vmstat_rates.pswpout = counter_rate(cur.pswpout, vmstat_prev.pswpout, elapsed);
+        vmstat_rates.oom_kill = counter_rate(cur.oom_kill, vmstat_prev.oom_kill, elapsed);
+    }
+    vmstat_prev = cur;
+    return &vmstat_rates;
+}
+
+/**
+ * @brief Asegura que los arreglos por núcleo tengan lugar para al menos n núcleos.
+ * @param cores Contadores por núcleo.
+ * @param n Cantidad de núcleos requerida.
+ * @return 0 si hay lugar, -1 si no se pudo reservar memoria.
+ */
+static int cpu_core_stats_reserve(cpu_core_stats_t* cores, size_t n)
+{
+    if (n <= cores->capacity)
+    {
+        return 0;
+    }
+
+    // Sólo se agranda cuando aparecen más núcleos de los vistos hasta ahora
+    size_t capacity = cores->capacity == 0 ? 64 : cores->capacity;
+    while (capacity < n)
+    {
+        capacity *= 2;
+    }
+
+    unsigned int* id = realloc(cores->id, capacity * sizeof(*id));
+    double* total = realloc(cores->total, capacity * sizeof(*total));
+    if (id != NULL)
+    {
+        cores->id = id;
+    }
+    if (total != NULL)
+    {
+        cores->total = total;
+    }
+    if (id == NULL || total == NULL)
+    {
+        return -1;
+    }
+    for (int m = 0; m < CPU_MODE_COUNT; m++)
     {
-        if (sscanf(buffer, "MemTotal: %llu kB", &total_mem) == 1)
+        unsigned long long* cur = realloc(cores->cur[m], capacity * sizeof(*cur));
+        unsigned long long* prev = realloc(cores->prev[m], capacity * sizeof(*prev));
+        double* percent = realloc(cores->percent[m], capacity * sizeof(*percent));
+        if (cur != NULL)
         {
-            continue; // MemTotal encontrado
+            cores->cur[m] = cur;
         }
-        if (sscanf(buffer, "MemAvailable: %llu kB", &free_mem) == 1)
+        if (prev != NULL)
         {
-            break; // MemAvailable encontrado, podemos dejar de leer
+            cores->prev[m] = prev;
+        }
+        if (percent != NULL)
+        {
+            cores->percent[m] = percent;
+        }
+        if (cur == NULL || prev == NULL || percent == NULL)
+        {
+            return -1;
         }
     }
 
-    fclose(fp);
+    cores->capacity = capacity;
+    return 0;
+}
 
-    // Verificar si se encontraron ambos valores
-    if (total_mem == 0 || free_mem == 0)
+/**
+ * @brief Guarda los contadores de una línea "cpuN" en la posición indicada.
+ * @param cores Contadores por núcleo.
+ * @param index Posición del núcleo dentro de los arreglos.
+ * @param id Número del núcleo.
+ * @param line Cursor sobre la línea, ubicado después de "cpuN".
+ */
+static void parse_cpu_core_line(cpu_core_stats_t* cores, size_t index, unsigned int id, proc_scanner_t* line)
+{
+    if (cpu_core_stats_reserve(cores, index + 1) != 0)
     {
-        fprintf(stderr, "Error al leer la información de memoria desde /proc/meminfo\n");
-        return -1.0;
+        return;
     }
 
-    // Calcular el porcentaje de uso de memoria
-    double used_mem = total_mem - free_mem;
-    double mem_usage_percent = (used_mem / total_mem) * 100.0;
+    // Un núcleo distinto en la misma posición (hotplug) invalida la comparación con la lectura anterior
+    if (index >= cores->count || cores->id[index] != id)
+    {
+        cores->changed = 1;
+        cores->id[index] = id;
+    }
 
-    return mem_usage_percent;
+    for (int m = 0; m < CPU_MODE_COUNT; m++)
+    {
+        unsigned long long value = 0;
+        scan_u64(line, &value);
+        cores->cur[m][index] = value;
+    }
 }
 
 /**
- * @brief Obtiene el porcentaje de uso del cpu.
- * @return Porcentaje de uso del cpu.
+ * @brief Analiza el contenido de /proc/stat y completa la instantánea.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @param cores Contadores por núcleo, o NULL para ignorar las líneas "cpuN".
+ * @return 0 si se encontró la línea agregada de CPU, -1 en caso contrario.
  */
-double get_cpu_usage()
+int parse_proc_stat(const char* buf, size_t len, proc_stat_snapshot_t* snapshot, cpu_core_stats_t* cores)
 {
-    static unsigned long long prev_user = 0, prev_nice = 0, prev_system = 0, prev_idle = 0, prev_iowait = 0,
-                              prev_irq = 0, prev_softirq = 0, prev_steal = 0;
-    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-    unsigned long long totald, idled;
-    double cpu_usage_percent;
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+    size_t core_count = 0;
+    int found_cpu = 0;
+
+    memset(snapshot, 0, sizeof(*snapshot));
 
-    // Abrir el archivo /proc/stat
-    FILE* fp = fopen("/proc/stat", "r");
-    if (fp == NULL)
+    // Campos de una sola columna que nos interesan, identificados por su nombre
+    const struct
     {
-        perror("Error al abrir /proc/stat");
-        return -1.0;
+        const char* key;
+        unsigned long long* value;
+    } fields[] = {
+        {"intr", &snapshot->intr},
+        {"ctxt", &snapshot->ctxt},
+        {"btime", &snapshot->btime},
+        {"processes", &snapshot->processes},
+        {"procs_running", &snapshot->procs_running},
+        {"procs_blocked", &snapshot->procs_blocked},
+        {"softirq", &snapshot->softirqs},
+    };
+
+    // Recorremos el archivo una sola vez tomando todos los campos de interés
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        if (!scan_token(&line, '\0', &key, &key_len))
+        {
+            continue;
+        }
+        if (scan_token_equals(key, key_len, "cpu"))
+        {
+            found_cpu = scan_u64(&line, &snapshot->user) && scan_u64(&line, &snapshot->nice) &&
+                        scan_u64(&line, &snapshot->system) && scan_u64(&line, &snapshot->idle) &&
+                        scan_u64(&line, &snapshot->iowait) && scan_u64(&line, &snapshot->irq) &&
+                        scan_u64(&line, &snapshot->softirq) && scan_u64(&line, &snapshot->steal);
+            continue;
+        }
+        if (key_len > 3 && strncmp(key, "cpu", 3) == 0)
+        {
+            if (cores != NULL)
+            {
+                proc_scanner_t id_field = {key + 3, key + key_len};
+                unsigned long long id = 0;
+                scan_u64(&id_field, &id);
+                parse_cpu_core_line(cores, core_count, (unsigned int)id, &line);
+                core_count++;
+            }
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        {
+            if (scan_token_equals(key, key_len, fields[i].key))
+            {
+                scan_u64(&line, fields[i].value);
+                break;
+            }
+        }
     }
 
-    char buffer[BUFFER_SIZE * 4];
-    if (fgets(buffer, sizeof(buffer), fp) == NULL)
+    if (cores != NULL)
     {
-        perror("Error al leer /proc/stat");
-        fclose(fp);
-        return -1.0;
+        if (core_count != cores->count)
+        {
+            cores->changed = 1;
+        }
+        cores->count = core_count < cores->capacity ? core_count : cores->capacity;
+    }
+
+    return found_cpu ? 0 : -1;
+}
+
+/**
+ * @brief Devuelve el nombre de un modo de CPU.
+ * @param mode Modo de CPU.
+ * @return Nombre del modo.
+ */
+const char* cpu_mode_name(cpu_mode_t mode)
+{
+    return cpu_mode_names[mode];
+}
+
+/**
+ * @brief Diferencia entre dos lecturas de un contador de un modo, o 0 si retrocedió.
+ *
+ * Los contadores de iowait e idle por núcleo pueden retroceder (proc(5)); restarlos sin más daría un valor cercano a
+ * 2^64 que se llevaría todo el tiempo del núcleo. Se calcula con una máscara y sin saltos, por lo que los bucles que la
+ * usan siguen siendo vectorizables.
+ *
+ * @param cur Lectura actual.
+ * @param prev Lectura anterior.
+ * @return Diferencia, o 0 si la lectura actual es menor.
+ */
+static inline unsigned long long mode_delta(unsigned long long cur, unsigned long long prev)
+{
+    // La máscara vale todos unos si no retrocedió y 0 si retrocedió
+    return (cur - prev) & -(unsigned long long)(cur >= prev);
+}
+
+/**
+ * @brief Calcula el porcentaje de un modo para todos los núcleos.
+ *
+ * Bucle sin dependencias entre iteraciones ni aliasing (restrict), que el compilador puede vectorizar.
+ *
+ * @param n Cantidad de núcleos.
+ * @param cur Contadores actuales del modo.
+ * @param prev Contadores anteriores del modo; se actualizan con los actuales.
+ * @param total Tiempo total transcurrido por núcleo.
+ * @param percent Porcentaje resultante del modo por núcleo.
+ */
+static void compute_mode_percent(size_t n, const unsigned long long* restrict cur, unsigned long long* restrict prev,
+                                 const double* restrict total, double* restrict percent)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        // Si no transcurrió tiempo todas las diferencias son 0, por lo que dividir por 1 da 0 sin necesidad de un salto
+        double elapsed = total[i] > 1.0 ? total[i] : 1.0;
+        percent[i] = (double)mode_delta(cur[i], prev[i]) * 100.0 / elapsed;
+        prev[i] = cur[i];
+    }
+}
+
+/**
+ * @brief Calcula los porcentajes por núcleo a partir de la lectura actual y la anterior.
+ * @param cores Contadores por núcleo.
+ */
+void compute_cpu_core_usage(cpu_core_stats_t* cores)
+{
+    size_t n = cores->count;
+
+    // Si cambió el conjunto de núcleos, la lectura actual pasa a ser la referencia para el próximo ciclo
+    if (cores->changed)
+    {
+        for (int m = 0; m < CPU_MODE_COUNT; m++)
+        {
+            memcpy(cores->prev[m], cores->cur[m], n * sizeof(unsigned long long));
+        }
+        cores->changed = 0;
+        cores->valid = 0;
+        return;
+    }
+
+    // Tiempo total transcurrido por núcleo: suma de las diferencias de todos los modos
+    for (size_t i = 0; i < n; i++)
+    {
+        cores->total[i] = 0.0;
+    }
+    for (int m = 0; m < CPU_MODE_COUNT; m++)
+    {
+        const unsigned long long* cur = cores->cur[m];
+        const unsigned long long* prev = cores->prev[m];
+        double* total = cores->total;
+        for (size_t i = 0; i < n; i++)
+        {
+            total[i] += (double)mode_delta(cur[i], prev[i]);
+        }
+    }
+
+    for (int m = 0; m < CPU_MODE_COUNT; m++)
+    {
+        compute_mode_percent(n, cores->cur[m], cores->prev[m], cores->total, cores->percent[m]);
     }
-    fclose(fp);
+    cores->valid = 1;
+}
 
-    // Analizar los valores de tiempo de CPU
-    int ret = sscanf(buffer, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system, &idle, &iowait,
-                     &irq, &softirq, &steal);
-    if (ret < 8)
+/**
+ * @brief Obtiene el uso por núcleo correspondiente a la última lectura de /proc/stat.
+ * @return Contadores y porcentajes por núcleo.
+ */
+const cpu_core_stats_t* get_cpu_core_usage()
+{
+    compute_cpu_core_usage(&core_stats);
+    return &core_stats;
+}
+
+/**
+ * @brief Lee /proc/stat una única vez y completa la instantánea.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si la lectura fue correcta, -1 en caso de error.
+ */
+int read_proc_stat(proc_stat_snapshot_t* snapshot)
+{
+    // Releer /proc/stat sobre el descriptor persistente
+    if (proc_file_read(&stat_file) == NULL)
+    {
+        return -1;
+    }
+
+    if (parse_proc_stat(stat_file.buf, stat_file.len, snapshot, &core_stats) != 0)
     {
         fprintf(stderr, "Error al parsear /proc/stat\n");
-        return -1.0;
+        return -1;
     }
 
+    return 0;
+}
+
+/**
+ * @brief Analiza el contenido de /proc/loadavg.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si se interpretó correctamente, -1 en caso contrario.
+ */
+int parse_loadavg(const char* buf, size_t len, loadavg_snapshot_t* snapshot)
+{
+    // "0.08 0.08 0.09 3/72 10378": promedios de 1, 5 y 15 minutos, ejecutables/existentes y último pid
+    proc_scanner_t line;
+    scan_init(&line, buf, len);
+    if (!scan_decimal(&line, &snapshot->load1) || !scan_decimal(&line, &snapshot->load5) ||
+        !scan_decimal(&line, &snapshot->load15) || !scan_u64(&line, &snapshot->runnable) || line.pos >= line.end ||
+        *line.pos++ != '/' || !scan_u64(&line, &snapshot->entities))
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lee /proc/loadavg.
+ * @param snapshot Instantánea a completar.
+ * @return 0 si la lectura fue correcta, -1 en caso de error.
+ */
+int read_loadavg(loadavg_snapshot_t* snapshot)
+{
+    if (proc_file_read(&loadavg_file) == NULL)
+    {
+        return -1;
+    }
+    if (parse_loadavg(loadavg_file.buf, loadavg_file.len, snapshot) != 0)
+    {
+        fprintf(stderr, "Error al parsear /proc/loadavg\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Cuenta los descriptores de archivo abiertos por el proceso.
+ *
+ * Relee /proc/self/fd sobre el descriptor persistente con getdents64(), sin reservar memoria en cada ciclo.
+ *
+ * @return Cantidad de descriptores (sin contar el que se usa para listarlos), o -1 si no se pudo listar.
+ */
+static long count_open_fds(void)
+{
+    if (self_fd_dir < 0 || lseek(self_fd_dir, 0, SEEK_SET) < 0)
+    {
+        return -1;
+    }
+    long count = 0;
+    while (1)
+    {
+        long n = syscall(SYS_getdents64, self_fd_dir, self_fd_dirents, SELF_FD_DIRENTS_SIZE);
+        if (n < 0)
+        {
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        for (long pos = 0; pos < n;)
+        {
+            const struct linux_dirent64* dirent = (const struct linux_dirent64*)(self_fd_dirents + pos);
+            pos += dirent->d_reclen;
+            if (dirent->d_name[0] != '.')
+            {
+                count++;
+            }
+        }
+    }
+    return count > 0 ? count - 1 : 0;
+}
+
+/**
+ * @brief Obtiene el consumo del propio exportador.
+ * @param stats Consumo a completar.
+ * @return 0 si la lectura fue correcta, -1 en caso de error.
+ */
+int read_self_stats(self_stats_t* stats)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+    stats->user_seconds = (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6;
+    stats->system_seconds = (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+    stats->voluntary_csw = (unsigned long long)usage.ru_nvcsw;
+    stats->involuntary_csw = (unsigned long long)usage.ru_nivcsw;
+
+    // "size resident shared text lib data dt", en páginas
+    unsigned long long size, resident;
+    proc_scanner_t line;
+    if (proc_file_read(&statm_file) == NULL)
+    {
+        return -1;
+    }
+    scan_init(&line, statm_file.buf, statm_file.len);
+    if (!scan_u64(&line, &size) || !scan_u64(&line, &resident))
+    {
+        fprintf(stderr, "Error al parsear /proc/self/statm\n");
+        return -1;
+    }
+    unsigned long long page_size = (unsigned long long)sysconf(_SC_PAGESIZE);
+    stats->virtual_bytes = size * page_size;
+    stats->resident_bytes = resident * page_size;
+
+    long fds = count_open_fds();
+    if (fds < 0)
+    {
+        return -1;
+    }
+    stats->open_fds = (unsigned long long)fds;
+    return 0;
+}
+
+/**
+ * @brief Obtiene la información de presión del sistema para un recurso.
+ * @param resource Recurso.
+ * @return Contenido de /proc/pressure/<recurso>, o NULL si el kernel no tiene PSI o no se pudo leer.
+ */
+const pressure_sample_t* get_pressure_stats(pressure_resource_t resource)
+{
+    proc_file_t* file = &pressure_files[resource];
+    if (file->fd < 0 || proc_file_read(file) == NULL)
+    {
+        return NULL;
+    }
+    if (parse_pressure(file->buf, file->len, &pressure_stats[resource]) != 0)
+    {
+        fprintf(stderr, "Error al parsear %s\n", file->path);
+        return NULL;
+    }
+    return &pressure_stats[resource];
+}
+
+/**
+ * @brief Obtiene el porcentaje de uso del cpu.
+ * @param snapshot Instantánea actual de /proc/stat.
+ * @return Porcentaje de uso del cpu.
+ */
+double get_cpu_usage(const proc_stat_snapshot_t* snapshot)
+{
+    static unsigned long long prev_user = 0, prev_nice = 0, prev_system = 0, prev_idle = 0, prev_iowait = 0,
+                              prev_irq = 0, prev_softirq = 0, prev_steal = 0;
+    unsigned long long user = snapshot->user, nice = snapshot->nice, system = snapshot->system,
+                       idle = snapshot->idle, iowait = snapshot->iowait, irq = snapshot->irq,
+                       softirq = snapshot->softirq, steal = snapshot->steal;
+    unsigned long long totald, idled;
+    double cpu_usage_percent;
+
     // Calcular las diferencias entre las lecturas actuales y anteriores
     unsigned long long prev_idle_total = prev_idle + prev_iowait;
     unsigned long long idle_total = idle + iowait;
@@ -121,164 +874,178 @@ double get_cpu_usage()
 }
 
 /**
- * @brief Obtiene el porcentaje de uso de red.
- * @return Porcentaje de uso de red.
+ * @brief Configura los filtros de dispositivos de bloque y reinicia la tabla de dispositivos.
+ * @param include Expresión de dispositivos a incluir, o NULL.
+ * @param exclude Expresión de dispositivos a excluir, o NULL.
+ * @return 0 si los filtros son válidos, -1 en caso contrario.
  */
-
-double get_IO_disco()
+int init_disk_stats(const char* include, const char* exclude)
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long read_sectors = 0, write_sectors = 0, total_read = 0, total_write = 0;
-    static unsigned long long prev_total_read = 0, prev_total_write = 0;
-    double io_usage_percent = 0.0;
+    disk_table_destroy(&disk_table);
+    return disk_table_init(&disk_table, include, exclude);
+}
 
-    // Abrir el archivo /proc/diskstats
-    fp = fopen("/proc/diskstats", "r");
-    if (fp == NULL)
+/**
+ * @brief Obtiene las estadísticas por dispositivo de bloque.
+ * @return Tabla de dispositivos con las tasas del último intervalo, o NULL en caso de error.
+ */
+disk_table_t* get_disk_stats()
+{
+    // Releer /proc/diskstats sobre el descriptor persistente
+    if (proc_file_read(&diskstats_file) == NULL)
     {
-        perror("Error al abrir /proc/diskstats");
-        return -1.0;
+        return NULL;
     }
 
-    // Leer los valores de lectura y escritura
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        // Leer los sectores leídos y escritos
-        if (sscanf(buffer, "%*d %*d %*s %*u %*u %*u %llu %*u %*u %llu", &read_sectors, &write_sectors) == 2)
-        {
-            total_read += read_sectors;   // Agrega al total de lectura el valor de lectura de la linea actual
-            total_write += write_sectors; // Agrega al total de escritua el valor de escritura de la linea actual
-        }
-    }
+    parse_disk_devices(&disk_table, diskstats_file.buf, diskstats_file.len);
+
+    // Las tasas se dividen por el tiempo realmente transcurrido entre lecturas
+    compute_disk_rates(&disk_table, proc_file_elapsed(&diskstats_file));
 
-    fclose(fp);
+    return &disk_table;
+}
 
-    // Calcular el porcentaje de uso de I/O de disco
-    unsigned long long total_sectors = total_read + total_write;
-    unsigned long long totald = (total_read - prev_total_read) + (total_write - prev_total_write);
+/**
+ * @brief Configura los filtros de interfaces de red y reinicia la tabla de interfaces.
+ * @param include Expresión de interfaces a incluir, o NULL.
+ * @param exclude Expresión de interfaces a excluir, o NULL.
+ * @return 0 si los filtros son válidos, -1 en caso contrario.
+ */
+int init_net_stats(const char* include, const char* exclude)
+{
+    net_table_destroy(&net_table);
+    return net_table_init(&net_table, include, exclude);
+}
 
-    if (total_sectors > 0)
+/**
+ * @brief Obtiene las estadísticas por interfaz de red.
+ * @return Tabla de interfaces con las tasas del último intervalo, o NULL en caso de error.
+ */
+net_table_t* get_net_stats()
+{
+    // Releer /proc/net/dev sobre el descriptor persistente
+    if (proc_file_read(&netdev_file) == NULL)
     {
-        io_usage_percent = ((double)totald / total_sectors) * 100.0;
+        return NULL;
     }
 
-    // Actualizar los valores anteriores
-    prev_total_read = total_read;
-    prev_total_write = total_write;
+    parse_net_devices(&net_table, netdev_file.buf, netdev_file.len);
+
+    // Las tasas se dividen por el tiempo realmente transcurrido entre lecturas
+    compute_net_rates(&net_table, proc_file_elapsed(&netdev_file));
 
-    return io_usage_percent;
+    return &net_table;
 }
 
 /**
- * @brief Obtiene el porcentaje de uso de red.
- * @return Porcentaje de uso de red.
+ * @brief Abre el directorio /proc para el barrido de procesos y reinicia la tabla de procesos.
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
  */
-double get_red_usage()
+int init_process_stats()
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long total_rx_bytes = 0, total_tx_bytes = 0;
-    static unsigned long long prev_total_rx_bytes = 0, prev_total_tx_bytes = 0;
-    double net_usage_percent = 0.0;
-
-    // Abrir el archivo /proc/net/dev
-    fp = fopen("/proc/net/dev", "r");
-    if (fp == NULL)
+    if (process_table.slots != NULL)
     {
-        perror("Error al abrir /proc/net/dev");
-        return -1.0;
+        process_table_destroy(&process_table);
     }
+    return process_table_init(&process_table, procfs_root);
+}
 
-    // Leer los valores de tráfico de red
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+/**
+ * @brief Libera la tabla de procesos y cierra el directorio /proc, si se inicializaron.
+ */
+void close_process_stats()
+{
+    if (process_table.slots != NULL)
     {
-        unsigned long long rx_bytes = 0, tx_bytes = 0;
-        if (sscanf(buffer, "%*s %llu %*u %*u %*u %*u %*u %*u %*u %llu", &rx_bytes, &tx_bytes) == 2)
-        {
-            total_rx_bytes += rx_bytes;
-            total_tx_bytes += tx_bytes;
-        }
+        process_table_destroy(&process_table);
     }
+}
 
-    fclose(fp);
-
-    // Calcular el porcentaje de uso de red
-    unsigned long long total_bytes = total_rx_bytes + total_tx_bytes;
-    unsigned long long totald = (total_rx_bytes - prev_total_rx_bytes) + (total_tx_bytes - prev_total_tx_bytes);
-
-    if (total_bytes > 0)
+/**
+ * @brief Obtiene las estadísticas por proceso.
+ * @return Tabla de procesos, o NULL en caso de error.
+ */
+const process_table_t* get_process_stats()
+{
+    if (process_table.slots == NULL || process_table_scan(&process_table) != 0)
     {
-        net_usage_percent = ((double)totald / total_bytes) * 100.0;
+        return NULL;
     }
-
-    // Actualizar los valores anteriores
-    prev_total_rx_bytes = total_rx_bytes;
-    prev_total_tx_bytes = total_tx_bytes;
-
-    return net_usage_percent;
+    return &process_table;
 }
 
 /**
- * @brief Obtiene el número de procesos en ejecución.
- * @return Número de procesos en ejecución.
+ * @brief Recorre la jerarquía de cgroups y empieza a vigilarla con inotify.
+ * @param root Punto de montaje de cgroup v2.
+ * @param max_depth Profundidad máxima de los cgroups exportados (0: sin límite).
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
  */
-double get_proc_number()
+int init_cgroup_stats(const char* root, unsigned int max_depth)
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long proc_running = 0;
-
-    // Abrir el archivo /proc/stat
-    fp = fopen("/proc/stat", "r");
-    if (fp == NULL)
+    if (cgroup_tree.slots != NULL)
     {
-        perror("Error al abrir /proc/stat");
-        return -1.0;
+        cgroup_tree_destroy(&cgroup_tree);
     }
+    return cgroup_tree_init(&cgroup_tree, root, max_depth);
+}
 
-    // Leer el número de procesos en ejecución
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+/**
+ * @brief Deja de vigilar la jerarquía de cgroups y libera la tabla, si se inicializaron.
+ */
+void close_cgroup_stats()
+{
+    if (cgroup_tree.slots != NULL)
     {
-        if (sscanf(buffer, "procs_running %llu", &proc_running) == 1)
-        {
-            break; // Encontrado el número de procesos en ejecución
-        }
+        cgroup_tree_destroy(&cgroup_tree);
     }
-
-    fclose(fp);
-
-    return (double)proc_running;
 }
 
 /**
- * @brief Obtiene el número de cambios de contexto.
- * @return Número de cambios de contexto.
+ * @brief Obtiene las estadísticas por cgroup.
+ * @param scratch Memoria temporal de la ejecución.
+ * @return Jerarquía de cgroups, o NULL en caso de error.
  */
-double get_context_switches()
+const cgroup_tree_t* get_cgroup_stats(arena_t* scratch)
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long ctxt = 0;
-
-    // Abrir el archivo /proc/stat
-    fp = fopen("/proc/stat", "r");
-    if (fp == NULL)
+    if (cgroup_tree.slots == NULL || cgroup_tree_refresh(&cgroup_tree, scratch) < 0)
     {
-        perror("Error al abrir /proc/stat");
-        return -1.0;
+        return NULL;
     }
+    cgroup_tree_read(&cgroup_tree);
+    return &cgroup_tree;
+}
 
-    // Leer el número de cambios de contexto
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        if (sscanf(buffer, "ctxt %llu", &ctxt) == 1)
-        {
-            break; // Encontrado el número de cambios de contexto
-        }
-    }
+/**
+ * @brief Obtiene el número de procesos en ejecución.
+ * @param snapshot Instantánea actual de /proc/stat.
+ * @return Número de procesos en ejecución.
+ */
+double get_proc_number(const proc_stat_snapshot_t* snapshot)
+{
+    return (double)snapshot->procs_running;
+}
 
-    fclose(fp);
+/**
+ * @brief Acumula los contadores de /proc/stat y calcula sus tasas.
+ * @param snapshot Instantánea actual de /proc/stat.
+ * @return Contadores acumulados y tasas del último intervalo.
+ */
+const proc_stat_counters_t* get_proc_stat_counters(const proc_stat_snapshot_t* snapshot)
+{
+    unsigned long long ctxt = counter_update(&proc_stat_counters.ctxt, snapshot->ctxt);
+    unsigned long long intr = counter_update(&proc_stat_counters.intr, snapshot->intr);
+    unsigned long long softirqs = counter_update(&proc_stat_counters.softirqs, snapshot->softirqs);
+    unsigned long long processes = counter_update(&proc_stat_counters.processes, snapshot->processes);
 
-    return (double)ctxt;
+    // Las tasas se dividen por el tiempo realmente transcurrido entre las dos últimas lecturas de /proc/stat
+    double elapsed = proc_file_elapsed(&stat_file);
+    proc_stat_counters.valid = elapsed > 0.0;
+    if (proc_stat_counters.valid)
+    {
+        proc_stat_counters.ctxt_rate = (double)ctxt / elapsed;
+        proc_stat_counters.intr_rate = (double)intr / elapsed;
+        proc_stat_counters.softirqs_rate = (double)softirqs / elapsed;
+        proc_stat_counters.processes_rate = (double)processes / elapsed;
+    }
+    return &proc_stat_counters;
 }
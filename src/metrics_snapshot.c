@@ -0,0 +1,290 @@
+#include "../include/metrics_snapshot.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+/**
+ * @file metrics_snapshot.c
+ * @brief Implementación de la publicación de instantáneas con intercambio atómico de puntero.
+ *
+ * Un lector no puede incrementar el contador de referencias de una instantánea que el recolector ya liberó. Para
+ * evitarlo, los lectores se anotan en acquiring mientras leen el puntero y toman su referencia (unas pocas
+ * instrucciones), y el recolector, después de intercambiar el puntero, espera a que no quede ningún lector en esa
+ * ventana antes de soltar la referencia de la publicación anterior. Un lector que llegue después del intercambio ya
+ * ve la instantánea nueva.
+ *
+ * La copia gzip se arma con un único z_stream que se reinicia en cada publicación, evitando reservar el estado de
+ * deflate (unos 256 KiB) en cada ciclo.
+ *
+ * Quien suelta la última referencia de una instantánea (el recolector o un hilo HTTP) la deja de repuesto si no hay
+ * otra, y el recolector la toma en la publicación siguiente para escribir en ella la exposición. En régimen alternan
+ * dos instantáneas sin reservar nada.
+ */
+
+/**
+ * @brief Última instantánea publicada, o NULL si todavía no hay ninguna.
+ */
+static _Atomic(metrics_snapshot_t*) current;
+
+/**
+ * @brief Instantánea sin referencias cuyos buffers reutiliza la próxima publicación, o NULL.
+ */
+static _Atomic(metrics_snapshot_t*) spare;
+
+/**
+ * @brief Instantánea en armado entre metrics_snapshot_begin() y metrics_snapshot_commit(), o NULL.
+ *
+ * Sólo la usa el hilo recolector. Si la publicación no llega a hacerse, o el contenido no cambió, queda para la
+ * siguiente.
+ */
+static metrics_snapshot_t* pending;
+
+/**
+ * @brief Lectores que están tomando una referencia a la instantánea publicada.
+ */
+static atomic_uint acquiring;
+
+/**
+ * @brief Número de la última publicación.
+ */
+static unsigned long long last_seq;
+
+/**
+ * @brief Estado de compresión reutilizado entre publicaciones.
+ */
+static z_stream deflater;
+
+/**
+ * @brief 1 si deflater ya fue inicializado con deflateInit2().
+ */
+static int deflater_ready;
+
+/**
+ * @brief Calcula el hash FNV-1a de 64 bits de un buffer.
+ * @param data Buffer.
+ * @param len Longitud en bytes.
+ * @return Hash del contenido.
+ */
+static unsigned long long fnv1a64(const char* data, size_t len)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Asegura la capacidad de un buffer de una instantánea.
+ *
+ * Se reserva un cuarto más de lo pedido para que una exposición que crece de a poco no obligue a reservar en cada
+ * ciclo.
+ *
+ * @param buf Buffer; se actualiza si se agranda.
+ * @param cap Capacidad del buffer; se actualiza si se agranda.
+ * @param size Bytes necesarios.
+ * @return 0 si hay lugar, -1 si falta memoria.
+ */
+static int snapshot_reserve(void** buf, size_t* cap, size_t size)
+{
+    if (size <= *cap)
+    {
+        return 0;
+    }
+    void* grown = realloc(*buf, size + size / 4);
+    if (grown == NULL)
+    {
+        return -1;
+    }
+    *buf = grown;
+    *cap = size + size / 4;
+    return 0;
+}
+
+/**
+ * @brief Libera una instantánea y sus buffers.
+ * @param snapshot Instantánea, o NULL.
+ */
+static void snapshot_free(metrics_snapshot_t* snapshot)
+{
+    if (snapshot != NULL)
+    {
+        text_buf_free(&snapshot->body);
+        free(snapshot->gzip_buf);
+        free(snapshot);
+    }
+}
+
+/**
+ * @brief Comprime la exposición de una instantánea con gzip.
+ *
+ * Si la compresión falla la instantánea queda sin copia gzip y los scrapes se responden sin comprimir.
+ *
+ * @param snapshot Instantánea con el texto ya cargado.
+ */
+static void snapshot_compress(metrics_snapshot_t* snapshot)
+{
+    snapshot->gzip = NULL;
+    snapshot->gzip_len = 0;
+
+    if (!deflater_ready)
+    {
+        // 15 + 16: ventana máxima con encabezado y cola gzip en lugar de zlib
+        if (deflateInit2(&deflater, METRICS_SNAPSHOT_GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            fprintf(stderr, "Error al inicializar la compresión gzip\n");
+            return;
+        }
+        deflater_ready = 1;
+    }
+    else if (deflateReset(&deflater) != Z_OK)
+    {
+        return;
+    }
+
+    uLong bound = deflateBound(&deflater, (uLong)snapshot->len);
+    if (snapshot_reserve((void**)&snapshot->gzip_buf, &snapshot->gzip_cap, bound) != 0)
+    {
+        return;
+    }
+    deflater.next_in = (Bytef*)snapshot->text;
+    deflater.avail_in = (uInt)snapshot->len;
+    deflater.next_out = snapshot->gzip_buf;
+    deflater.avail_out = (uInt)bound;
+    if (deflate(&deflater, Z_FINISH) != Z_STREAM_END)
+    {
+        fprintf(stderr, "Error al comprimir las métricas\n");
+        return;
+    }
+    snapshot->gzip = snapshot->gzip_buf;
+    snapshot->gzip_len = bound - deflater.avail_out;
+}
+
+/**
+ * @brief Espera a que ningún lector esté entre la lectura del puntero y la toma de su referencia.
+ */
+static void wait_for_readers(void)
+{
+    while (atomic_load(&acquiring) != 0)
+    {
+        sched_yield();
+    }
+}
+
+/**
+ * @brief Empieza a armar la próxima instantánea sobre los buffers de la de repuesto.
+ * @return Texto vacío de la instantánea en armado, o NULL si falta memoria.
+ */
+text_buf_t* metrics_snapshot_begin(void)
+{
+    if (pending == NULL)
+    {
+        pending = atomic_exchange(&spare, NULL);
+    }
+    if (pending == NULL && (pending = calloc(1, sizeof(*pending))) == NULL)
+    {
+        fprintf(stderr, "Error al reservar la instantánea de métricas\n");
+        return NULL;
+    }
+    text_buf_reset(&pending->body);
+    return &pending->body;
+}
+
+/**
+ * @brief Publica la instantánea en armado y libera la anterior cuando deja de estar en uso.
+ * @return 0 si se publicó o el contenido no cambió, -1 si no hay una instantánea en armado.
+ */
+int metrics_snapshot_commit(void)
+{
+    metrics_snapshot_t* snapshot = pending;
+    if (snapshot == NULL)
+    {
+        return -1;
+    }
+
+    // Sólo este hilo cambia la instantánea vigente, por lo que puede leerla sin tomar una referencia. Un texto sin
+    // cambios deja la instantánea en armado para la publicación siguiente
+    const char* text = snapshot->body.data != NULL ? snapshot->body.data : "";
+    size_t len = snapshot->body.len;
+    unsigned long long hash = fnv1a64(text, len);
+    metrics_snapshot_t* cur = atomic_load(&current);
+    char etag[METRICS_SNAPSHOT_ETAG_SIZE];
+    snprintf(etag, sizeof(etag), "\"%016llx\"", hash);
+    if (cur != NULL && cur->len == len && strcmp(cur->etag, etag) == 0 && memcmp(cur->text, text, len) == 0)
+    {
+        return 0;
+    }
+
+    pending = NULL;
+    atomic_init(&snapshot->refs, 1);
+    atomic_init(&snapshot->served, 0);
+    snapshot->text = (char*)text;
+    snapshot->len = len;
+    memcpy(snapshot->etag, etag, sizeof(etag));
+    snapshot_compress(snapshot);
+    snapshot->seq = ++last_seq;
+    clock_gettime(CLOCK_MONOTONIC, &snapshot->collected_at);
+
+    metrics_snapshot_t* old = atomic_exchange(&current, snapshot);
+    if (old != NULL)
+    {
+        wait_for_readers();
+        metrics_snapshot_release(old);
+    }
+    return 0;
+}
+
+/**
+ * @brief Toma una referencia a la última instantánea publicada.
+ * @return Instantánea, o NULL si todavía no se publicó ninguna.
+ */
+metrics_snapshot_t* metrics_snapshot_acquire(void)
+{
+    atomic_fetch_add(&acquiring, 1);
+    metrics_snapshot_t* snapshot = atomic_load(&current);
+    if (snapshot != NULL)
+    {
+        atomic_fetch_add(&snapshot->refs, 1);
+    }
+    atomic_fetch_sub(&acquiring, 1);
+    return snapshot;
+}
+
+/**
+ * @brief Devuelve una referencia tomada con metrics_snapshot_acquire().
+ * @param snapshot Instantánea.
+ */
+void metrics_snapshot_release(metrics_snapshot_t* snapshot)
+{
+    if (snapshot != NULL && atomic_fetch_sub(&snapshot->refs, 1) == 1)
+    {
+        metrics_snapshot_t* none = NULL;
+        if (!atomic_compare_exchange_strong(&spare, &none, snapshot))
+        {
+            snapshot_free(snapshot);
+        }
+    }
+}
+
+/**
+ * @brief Retira la instantánea publicada.
+ */
+void metrics_snapshot_shutdown(void)
+{
+    metrics_snapshot_t* old = atomic_exchange(&current, NULL);
+    wait_for_readers();
+    metrics_snapshot_release(old);
+    snapshot_free(atomic_exchange(&spare, NULL));
+    snapshot_free(pending);
+    pending = NULL;
+
+    if (deflater_ready)
+    {
+        deflateEnd(&deflater);
+        deflater_ready = 0;
+    }
+}
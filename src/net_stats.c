@@ -0,0 +1,389 @@
+#include "../include/net_stats.h"
+#include "../include/proc_scan.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file net_stats.c
+ * @brief Implementación de las estadísticas por interfaz de red.
+ */
+
+/**
+ * @brief Capacidad inicial de la tabla de interfaces.
+ */
+#define NET_TABLE_INITIAL_CAPACITY 64
+
+/**
+ * @brief Calcula el hash FNV-1a del nombre de una interfaz.
+ * @param name Nombre (no terminado en '\0').
+ * @param len Longitud del nombre.
+ * @return Hash del nombre.
+ */
+static unsigned int net_hash(const char* name, size_t len)
+{
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Reserva una tabla vacía de la capacidad indicada.
+ * @param table Tabla de interfaces.
+ * @param capacity Cantidad de entradas (potencia de 2).
+ * @return 0 si se reservó, -1 si falta memoria.
+ */
+static int net_table_alloc(net_table_t* table, size_t capacity)
+{
+    table->slots = calloc(capacity, sizeof(net_iface_t));
+    if (table->slots == NULL)
+    {
+        return -1;
+    }
+    table->capacity = capacity;
+    table->used = 0;
+    table->live = 0;
+    return 0;
+}
+
+/**
+ * @brief Reconstruye la tabla descartando las entradas borradas y, si hace falta, duplicando su capacidad.
+ * @param table Tabla de interfaces.
+ * @return 0 si se reconstruyó, -1 si falta memoria (la tabla anterior queda intacta).
+ */
+static int net_table_rehash(net_table_t* table)
+{
+    net_iface_t* old = table->slots;
+    size_t old_capacity = table->capacity;
+    size_t capacity = table->live * 2 >= old_capacity ? old_capacity * 2 : old_capacity;
+    if (capacity < NET_TABLE_INITIAL_CAPACITY)
+    {
+        capacity = NET_TABLE_INITIAL_CAPACITY;
+    }
+
+    if (net_table_alloc(table, capacity) != 0)
+    {
+        table->slots = old;
+        table->capacity = old_capacity;
+        return -1;
+    }
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i].state != NET_SLOT_USED)
+        {
+            continue;
+        }
+        size_t j = old[i].hash & (table->capacity - 1);
+        while (table->slots[j].state != NET_SLOT_EMPTY)
+        {
+            j = (j + 1) & (table->capacity - 1);
+        }
+        table->slots[j] = old[i];
+        table->used++;
+        table->live++;
+    }
+
+    free(old);
+    return 0;
+}
+
+/**
+ * @brief Indica si una interfaz queda excluida por los filtros.
+ * @param table Tabla de interfaces.
+ * @param name Nombre de la interfaz.
+ * @return 1 si se excluye, 0 si se incluye.
+ */
+static int net_is_filtered(const net_table_t* table, const char* name)
+{
+    if (table->has_include && regexec(&table->include, name, 0, NULL, 0) != 0)
+    {
+        return 1;
+    }
+    if (table->has_exclude && regexec(&table->exclude, name, 0, NULL, 0) == 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Busca una interfaz en la tabla y, si no está, la agrega.
+ * @param table Tabla de interfaces.
+ * @param name Nombre de la interfaz (no terminado en '\0').
+ * @param len Longitud del nombre.
+ * @return Entrada de la interfaz, o NULL si falta memoria o el nombre es inválido.
+ */
+static net_iface_t* net_table_lookup(net_table_t* table, const char* name, size_t len)
+{
+    if (len == 0 || len >= NET_IFNAME_SIZE)
+    {
+        return NULL;
+    }
+
+    // Mantenemos el factor de carga (incluyendo borrados) por debajo de 3/4
+    if ((table->used + 1) * 4 > table->capacity * 3 && net_table_rehash(table) != 0)
+    {
+        return NULL;
+    }
+
+    unsigned int hash = net_hash(name, len);
+    size_t i = hash & (table->capacity - 1);
+    net_iface_t* free_slot = NULL;
+    while (table->slots[i].state != NET_SLOT_EMPTY)
+    {
+        net_iface_t* slot = &table->slots[i];
+        if (slot->state == NET_SLOT_USED && slot->hash == hash && strncmp(slot->name, name, len) == 0 &&
+            slot->name[len] == '\0')
+        {
+            return slot;
+        }
+        if (slot->state == NET_SLOT_DELETED && free_slot == NULL)
+        {
+            free_slot = slot;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+
+    // Interfaz nueva: reutilizamos una entrada borrada del sondeo si la hubo
+    net_iface_t* slot = free_slot;
+    if (slot == NULL)
+    {
+        slot = &table->slots[i];
+        table->used++;
+    }
+    memset(slot, 0, sizeof(*slot));
+    slot->state = NET_SLOT_USED;
+    slot->hash = hash;
+    memcpy(slot->name, name, len);
+    slot->name[len] = '\0';
+    slot->filtered = net_is_filtered(table, slot->name);
+    table->live++;
+    return slot;
+}
+
+/**
+ * @brief Lee la velocidad del enlace de una interfaz desde sysfs.
+ * @param table Tabla de interfaces.
+ * @param iface Interfaz.
+ * @return Velocidad en bits por segundo, o 0 si se desconoce (interfaces virtuales o enlace caído).
+ */
+static double net_read_speed(const net_table_t* table, const net_iface_t* iface)
+{
+    char path[256];
+    char buf[32];
+
+    snprintf(path, sizeof(path), "%s/%s/speed", table->sysfs_net, iface->name);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return 0.0;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+    {
+        return 0.0;
+    }
+
+    // El valor está en Mbit/s; las interfaces sin velocidad definida informan -1 o fallan la lectura
+    proc_scanner_t line;
+    unsigned long long mbps = 0;
+    scan_init(&line, buf, (size_t)n);
+    if (!scan_u64(&line, &mbps))
+    {
+        return 0.0;
+    }
+    return (double)mbps * 1e6;
+}
+
+/**
+ * @brief Inicializa la tabla de interfaces y sus filtros.
+ * @param table Tabla a inicializar.
+ * @param include Expresión de interfaces a incluir, o NULL.
+ * @param exclude Expresión de interfaces a excluir, o NULL.
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int net_table_init(net_table_t* table, const char* include, const char* exclude)
+{
+    memset(table, 0, sizeof(*table));
+    table->sysfs_net = "/sys/class/net";
+
+    if (include != NULL && *include != '\0')
+    {
+        if (regcomp(&table->include, include, REG_EXTENDED | REG_NOSUB) != 0)
+        {
+            fprintf(stderr, "Expresión de inclusión de interfaces inválida: %s\n", include);
+            return -1;
+        }
+        table->has_include = 1;
+    }
+    if (exclude != NULL && *exclude != '\0')
+    {
+        if (regcomp(&table->exclude, exclude, REG_EXTENDED | REG_NOSUB) != 0)
+        {
+            fprintf(stderr, "Expresión de exclusión de interfaces inválida: %s\n", exclude);
+            net_table_destroy(table);
+            return -1;
+        }
+        table->has_exclude = 1;
+    }
+
+    if (net_table_alloc(table, NET_TABLE_INITIAL_CAPACITY) != 0)
+    {
+        net_table_destroy(table);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Libera la tabla de interfaces y sus filtros.
+ * @param table Tabla a liberar.
+ */
+void net_table_destroy(net_table_t* table)
+{
+    if (table->has_include)
+    {
+        regfree(&table->include);
+    }
+    if (table->has_exclude)
+    {
+        regfree(&table->exclude);
+    }
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @brief Analiza /proc/net/dev actualizando los contadores de cada interfaz.
+ * @param table Tabla de interfaces.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @return Cantidad de interfaces presentes.
+ */
+size_t parse_net_devices(net_table_t* table, const char* buf, size_t len)
+{
+    proc_scanner_t file, line;
+    const char* name;
+    size_t name_len;
+
+    table->generation++;
+
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        net_counters_t c;
+
+        // "  eth0: bytes packets errs drop fifo frame compressed multicast bytes packets errs drop fifo colls carrier
+        // compressed", el número puede venir pegado a los dos puntos. Las dos líneas de encabezado no tienen un número
+        // después del primer campo.
+        if (!scan_token(&line, ':', &name, &name_len) || !scan_u64(&line, &c.rx_bytes) ||
+            !scan_u64(&line, &c.rx_packets) || !scan_u64(&line, &c.rx_errors) || !scan_u64(&line, &c.rx_drops) ||
+            !scan_skip(&line, 4) || !scan_u64(&line, &c.tx_bytes) || !scan_u64(&line, &c.tx_packets) ||
+            !scan_u64(&line, &c.tx_errors) || !scan_u64(&line, &c.tx_drops))
+        {
+            continue;
+        }
+
+        net_iface_t* iface = net_table_lookup(table, name, name_len);
+        if (iface == NULL)
+        {
+            continue;
+        }
+        iface->cur = c;
+        iface->generation = table->generation;
+    }
+
+    // Las interfaces que no aparecieron en este ciclo fueron quitadas del sistema
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        net_iface_t* iface = &table->slots[i];
+        if (iface->state == NET_SLOT_USED && iface->generation != table->generation)
+        {
+            iface->state = NET_SLOT_DELETED;
+            table->live--;
+        }
+    }
+
+    return table->live;
+}
+
+/**
+ * @brief Acumula en los contadores totales de una interfaz el incremento desde la lectura anterior.
+ * @param iface Interfaz con una lectura anterior.
+ */
+static void net_accumulate(net_iface_t* iface)
+{
+    iface->total.rx_bytes += counter_delta(iface->cur.rx_bytes, iface->prev.rx_bytes);
+    iface->total.rx_packets += counter_delta(iface->cur.rx_packets, iface->prev.rx_packets);
+    iface->total.rx_errors += counter_delta(iface->cur.rx_errors, iface->prev.rx_errors);
+    iface->total.rx_drops += counter_delta(iface->cur.rx_drops, iface->prev.rx_drops);
+    iface->total.tx_bytes += counter_delta(iface->cur.tx_bytes, iface->prev.tx_bytes);
+    iface->total.tx_packets += counter_delta(iface->cur.tx_packets, iface->prev.tx_packets);
+    iface->total.tx_errors += counter_delta(iface->cur.tx_errors, iface->prev.tx_errors);
+    iface->total.tx_drops += counter_delta(iface->cur.tx_drops, iface->prev.tx_drops);
+}
+
+/**
+ * @brief Calcula las tasas de cada interfaz a partir de la lectura actual y la anterior.
+ * @param table Tabla de interfaces.
+ * @param elapsed Segundos transcurridos entre ambas lecturas.
+ */
+void compute_net_rates(net_table_t* table, double elapsed)
+{
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        net_iface_t* iface = &table->slots[i];
+        if (iface->state != NET_SLOT_USED || iface->filtered)
+        {
+            continue;
+        }
+
+        // La velocidad del enlace se lee al descubrir la interfaz y luego sólo cada tanto, no en cada ciclo
+        if (iface->speed_checked == 0 || table->generation - iface->speed_checked >= NET_SPEED_REFRESH_TICKS)
+        {
+            iface->speed_bps = net_read_speed(table, iface);
+            iface->speed_checked = table->generation;
+        }
+
+        // Una interfaz recién aparecida no tiene lectura anterior con la cual comparar
+        if (!iface->has_prev)
+        {
+            iface->total = iface->cur;
+        }
+        else
+        {
+            net_accumulate(iface);
+        }
+        if (!iface->has_prev || elapsed <= 0.0)
+        {
+            iface->prev = iface->cur;
+            iface->has_prev = 1;
+            iface->valid = 0;
+            continue;
+        }
+
+        iface->rx_bytes_per_sec = counter_rate(iface->cur.rx_bytes, iface->prev.rx_bytes, elapsed);
+        iface->tx_bytes_per_sec = counter_rate(iface->cur.tx_bytes, iface->prev.tx_bytes, elapsed);
+        iface->rx_packets_per_sec = counter_rate(iface->cur.rx_packets, iface->prev.rx_packets, elapsed);
+        iface->tx_packets_per_sec = counter_rate(iface->cur.tx_packets, iface->prev.tx_packets, elapsed);
+        iface->rx_errors_per_sec = counter_rate(iface->cur.rx_errors, iface->prev.rx_errors, elapsed);
+        iface->tx_errors_per_sec = counter_rate(iface->cur.tx_errors, iface->prev.tx_errors, elapsed);
+        iface->rx_drops_per_sec = counter_rate(iface->cur.rx_drops, iface->prev.rx_drops, elapsed);
+        iface->tx_drops_per_sec = counter_rate(iface->cur.tx_drops, iface->prev.tx_drops, elapsed);
+        if (iface->speed_bps > 0.0)
+        {
+            iface->rx_utilization = iface->rx_bytes_per_sec * 8.0 * 100.0 / iface->speed_bps;
+            iface->tx_utilization = iface->tx_bytes_per_sec * 8.0 * 100.0 / iface->speed_bps;
+        }
+        iface->prev = iface->cur;
+        iface->valid = 1;
+    }
+}
@@ -0,0 +1,276 @@
+#include "../include/pressure_stats.h"
+#include "../include/proc_scan.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/**
+ * @file pressure_stats.c
+ * @brief Implementación de la información de presión y de los disparadores de PSI.
+ */
+
+/**
+ * @brief Nombres de los recursos, en el orden de pressure_resource_t (coinciden con los archivos de /proc/pressure).
+ */
+static const char* const resource_names[PRESSURE_RESOURCE_COUNT] = {"cpu", "memory", "io"};
+
+/**
+ * @brief Nombres de las líneas, en el orden de pressure_kind_t.
+ */
+static const char* const kind_names[PRESSURE_KIND_COUNT] = {"some", "full"};
+
+/**
+ * @brief Obtiene el nombre de un recurso con información de presión.
+ * @param resource Recurso.
+ * @return Nombre del recurso.
+ */
+const char* pressure_resource_name(pressure_resource_t resource)
+{
+    return resource < PRESSURE_RESOURCE_COUNT ? resource_names[resource] : "unknown";
+}
+
+/**
+ * @brief Obtiene el nombre de una línea de un archivo de presión.
+ * @param kind Línea.
+ * @return Nombre de la línea.
+ */
+const char* pressure_kind_name(pressure_kind_t kind)
+{
+    return kind < PRESSURE_KIND_COUNT ? kind_names[kind] : "unknown";
+}
+
+/**
+ * @brief Analiza el contenido de un archivo de presión.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Contenido a completar.
+ * @return 0 si se encontró la línea "some", -1 en caso contrario.
+ */
+int parse_pressure(const char* buf, size_t len, pressure_sample_t* sample)
+{
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+
+    sample->present = 0;
+    scan_init(&file, buf, len);
+    while (scan_next_line(&file, &line))
+    {
+        if (!scan_token(&line, '\0', &key, &key_len))
+        {
+            continue;
+        }
+        int kind = scan_token_equals(key, key_len, "some")   ? PRESSURE_SOME
+                   : scan_token_equals(key, key_len, "full") ? PRESSURE_FULL
+                                                             : -1;
+        if (kind < 0)
+        {
+            continue;
+        }
+
+        pressure_line_t* values = &sample->lines[kind];
+        int found = 0;
+        while (scan_token(&line, '=', &key, &key_len))
+        {
+            if (scan_token_equals(key, key_len, "avg10"))
+            {
+                found += scan_decimal(&line, &values->avg10);
+            }
+            else if (scan_token_equals(key, key_len, "avg60"))
+            {
+                found += scan_decimal(&line, &values->avg60);
+            }
+            else if (scan_token_equals(key, key_len, "avg300"))
+            {
+                found += scan_decimal(&line, &values->avg300);
+            }
+            else if (scan_token_equals(key, key_len, "total"))
+            {
+                found += scan_u64(&line, &values->total);
+            }
+        }
+        if (found == 4)
+        {
+            sample->present |= 1u << kind;
+        }
+    }
+    return (sample->present & (1u << PRESSURE_SOME)) ? 0 : -1;
+}
+
+/**
+ * @brief Cuerpo del hilo que espera los disparadores.
+ * @param arg Disparadores (pressure_trigger_t*).
+ * @return NULL.
+ */
+static void* pressure_trigger_loop(void* arg)
+{
+    pressure_trigger_t* trigger = arg;
+    struct pollfd fds[PRESSURE_RESOURCE_COUNT + 1];
+
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        fds[r].fd = trigger->fds[r];
+        fds[r].events = POLLPRI;
+    }
+    fds[PRESSURE_RESOURCE_COUNT].fd = trigger->wake_fd;
+    fds[PRESSURE_RESOURCE_COUNT].events = POLLIN;
+
+    while (1)
+    {
+        if (poll(fds, PRESSURE_RESOURCE_COUNT + 1, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("Error al esperar los disparadores de presión");
+            return NULL;
+        }
+        if (fds[PRESSURE_RESOURCE_COUNT].revents != 0)
+        {
+            return NULL;
+        }
+
+        int fired = 0;
+        for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+        {
+            if (fds[r].revents & POLLERR)
+            {
+                // El kernel invalida el disparador (por ejemplo, si se desmonta el archivo): dejamos de esperarlo
+                fprintf(stderr, "El disparador de presión de %s dejó de funcionar\n", resource_names[r]);
+                fds[r].fd = -1;
+            }
+            else if (fds[r].revents & POLLPRI)
+            {
+                fired = 1;
+            }
+        }
+
+        // Una sola señal por despertar: el recolector lee los tres recursos de todos modos
+        if (fired)
+        {
+            atomic_fetch_add(&trigger->events, 1);
+            pthread_kill(trigger->target, trigger->signo);
+        }
+    }
+}
+
+/**
+ * @brief Cierra los descriptores de los disparadores.
+ * @param trigger Disparadores.
+ */
+static void pressure_trigger_close(pressure_trigger_t* trigger)
+{
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        if (trigger->fds[r] >= 0)
+        {
+            close(trigger->fds[r]);
+            trigger->fds[r] = -1;
+        }
+    }
+    if (trigger->wake_fd >= 0)
+    {
+        close(trigger->wake_fd);
+        trigger->wake_fd = -1;
+    }
+}
+
+/**
+ * @brief Registra un disparador "some" en cada recurso e inicia el hilo que los espera.
+ * @param trigger Disparadores a inicializar.
+ * @param stall_ms Demora acumulada, dentro de la ventana, que activa el disparador.
+ * @param window_ms Ventana de evaluación.
+ * @param target Hilo al que se envía la señal.
+ * @param signo Señal a enviar.
+ * @return 0 si se registró al menos un disparador, -1 en caso contrario.
+ */
+int pressure_trigger_start(pressure_trigger_t* trigger, unsigned int stall_ms, unsigned int window_ms,
+                           pthread_t target, int signo)
+{
+    char path[64], request[64];
+    int registered = 0;
+
+    trigger->wake_fd = -1;
+    trigger->running = 0;
+    trigger->target = target;
+    trigger->signo = signo;
+    atomic_init(&trigger->events, 0);
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        trigger->fds[r] = -1;
+    }
+    if (window_ms < PRESSURE_TRIGGER_MIN_WINDOW_MS || window_ms > PRESSURE_TRIGGER_MAX_WINDOW_MS ||
+        stall_ms == 0 || stall_ms > window_ms)
+    {
+        fprintf(stderr, "Disparador de presión inválido: %u ms en una ventana de %u ms\n", stall_ms, window_ms);
+        return -1;
+    }
+
+    // El disparador queda registrado mientras el descriptor siga abierto
+    int len = snprintf(request, sizeof(request), "some %llu %llu", (unsigned long long)stall_ms * 1000ULL,
+                       (unsigned long long)window_ms * 1000ULL);
+    for (int r = 0; r < PRESSURE_RESOURCE_COUNT; r++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", PRESSURE_ROOT, resource_names[r]);
+        int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+        {
+            fprintf(stderr, "Error al abrir %s: %s\n", path, strerror(errno));
+            continue;
+        }
+        if (write(fd, request, (size_t)len + 1) < 0)
+        {
+            fprintf(stderr, "Error al registrar el disparador de %s: %s\n", path, strerror(errno));
+            close(fd);
+            continue;
+        }
+        trigger->fds[r] = fd;
+        registered++;
+    }
+
+    trigger->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (registered == 0 || trigger->wake_fd < 0)
+    {
+        pressure_trigger_close(trigger);
+        return -1;
+    }
+    if (pthread_create(&trigger->thread, NULL, pressure_trigger_loop, trigger) != 0)
+    {
+        fprintf(stderr, "Error al crear el hilo de los disparadores de presión\n");
+        pressure_trigger_close(trigger);
+        return -1;
+    }
+    trigger->running = 1;
+    return 0;
+}
+
+/**
+ * @brief Detiene el hilo y quita los disparadores.
+ * @param trigger Disparadores iniciados con pressure_trigger_start().
+ */
+void pressure_trigger_stop(pressure_trigger_t* trigger)
+{
+    if (!trigger->running)
+    {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(trigger->wake_fd, &one, sizeof(one)) == (ssize_t)sizeof(one))
+    {
+        pthread_join(trigger->thread, NULL);
+    }
+    else
+    {
+        pthread_cancel(trigger->thread);
+        pthread_join(trigger->thread, NULL);
+    }
+    trigger->running = 0;
+    pressure_trigger_close(trigger);
+}
@@ -0,0 +1,133 @@
+#include "../include/proc_reader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file proc_reader.c
+ * @brief Implementación de la lectura de /proc con descriptores persistentes.
+ */
+
+/**
+ * @brief Abre un archivo de /proc y reserva su buffer de lectura.
+ * @param file Estructura a inicializar.
+ * @param path Ruta del archivo.
+ * @return 0 si se abrió correctamente, -1 en caso de error.
+ */
+int proc_file_open(proc_file_t* file, const char* path)
+{
+    snprintf(file->path, sizeof(file->path), "%s", path);
+    file->len = 0;
+    file->size = PROC_FILE_INITIAL_SIZE;
+    memset(&file->read_at, 0, sizeof(file->read_at));
+    memset(&file->prev_read_at, 0, sizeof(file->prev_read_at));
+    file->buf = malloc(file->size);
+    if (file->buf == NULL)
+    {
+        file->fd = -1;
+        fprintf(stderr, "Error al reservar el buffer para %s\n", path);
+        return -1;
+    }
+    file->buf[0] = '\0';
+
+    file->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0)
+    {
+        fprintf(stderr, "Error al abrir %s: %s\n", path, strerror(errno));
+        free(file->buf);
+        file->buf = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Vuelve a leer el contenido completo del archivo con pread().
+ * @param file Archivo abierto.
+ * @return Puntero al contenido leído, o NULL en caso de error.
+ */
+char* proc_file_read(proc_file_t* file)
+{
+    if (file->fd < 0)
+    {
+        return NULL;
+    }
+
+    file->len = 0;
+    while (1)
+    {
+        // El archivo no entró en el buffer: lo duplicamos y seguimos leyendo a continuación.
+        // Dejamos siempre un byte libre para el '\0' final.
+        if (file->len + 1 >= file->size)
+        {
+            char* grown = realloc(file->buf, file->size * 2);
+            if (grown == NULL)
+            {
+                fprintf(stderr, "Error al agrandar el buffer para %s\n", file->path);
+                return NULL;
+            }
+            file->buf = grown;
+            file->size *= 2;
+        }
+
+        // Los archivos seq_file del kernel pueden entregar lecturas cortas sin haber llegado al final, por lo que
+        // seguimos leyendo hasta que pread() devuelva 0
+        ssize_t n = pread(file->fd, file->buf + file->len, file->size - file->len - 1, (off_t)file->len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "Error al leer %s: %s\n", file->path, strerror(errno));
+            return NULL;
+        }
+        if (n == 0)
+        {
+            break; // Fin de archivo
+        }
+        file->len += (size_t)n;
+    }
+
+    file->buf[file->len] = '\0';
+    file->prev_read_at = file->read_at;
+    clock_gettime(CLOCK_MONOTONIC, &file->read_at);
+    return file->buf;
+}
+
+/**
+ * @brief Devuelve el tiempo transcurrido entre las dos últimas lecturas del archivo.
+ * @param file Archivo leído.
+ * @return Segundos entre ambas lecturas, o 0.0 si todavía no hubo dos lecturas.
+ */
+double proc_file_elapsed(const proc_file_t* file)
+{
+    if (file->prev_read_at.tv_sec == 0 && file->prev_read_at.tv_nsec == 0)
+    {
+        return 0.0;
+    }
+    return (double)(file->read_at.tv_sec - file->prev_read_at.tv_sec) +
+           (double)(file->read_at.tv_nsec - file->prev_read_at.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Cierra el descriptor y libera el buffer del archivo.
+ * @param file Archivo abierto.
+ */
+void proc_file_close(proc_file_t* file)
+{
+    if (file->fd >= 0)
+    {
+        close(file->fd);
+        file->fd = -1;
+    }
+    free(file->buf);
+    file->buf = NULL;
+    file->size = 0;
+    file->len = 0;
+}
+
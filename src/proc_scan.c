@@ -0,0 +1,264 @@
+#include "../include/proc_scan.h"
+#include <string.h>
+
+/**
+ * @file proc_scan.c
+ * @brief Implementación del tokenizador de /proc.
+ */
+
+/**
+ * @brief Indica si un carácter separa campos en los archivos de /proc.
+ * @param c Carácter a evaluar.
+ * @return 1 si es espacio o tabulación, 0 en caso contrario.
+ */
+static int is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/**
+ * @brief Saltea los espacios en la posición actual.
+ * @param line Cursor sobre la línea.
+ */
+static void skip_blanks(proc_scanner_t* line)
+{
+    while (line->pos < line->end && is_blank(*line->pos))
+    {
+        line->pos++;
+    }
+}
+
+/**
+ * @brief Inicializa un cursor sobre un buffer.
+ * @param scanner Cursor a inicializar.
+ * @param buf Inicio del buffer.
+ * @param len Cantidad de bytes del buffer.
+ */
+void scan_init(proc_scanner_t* scanner, const char* buf, size_t len)
+{
+    scanner->pos = buf;
+    scanner->end = buf + len;
+}
+
+/**
+ * @brief Obtiene la siguiente línea del buffer.
+ * @param scanner Cursor sobre el archivo.
+ * @param line Cursor que queda apuntando a la línea.
+ * @return 1 si se obtuvo una línea, 0 si no quedan más.
+ */
+int scan_next_line(proc_scanner_t* scanner, proc_scanner_t* line)
+{
+    if (scanner->pos >= scanner->end)
+    {
+        return 0;
+    }
+
+    const char* eol = memchr(scanner->pos, '\n', (size_t)(scanner->end - scanner->pos));
+    line->pos = scanner->pos;
+    line->end = eol != NULL ? eol : scanner->end;
+    scanner->pos = eol != NULL ? eol + 1 : scanner->end;
+    return 1;
+}
+
+/**
+ * @brief Lee el siguiente entero decimal sin signo.
+ * @param line Cursor sobre la línea.
+ * @param value Valor leído.
+ * @return 1 si se leyó un número, 0 en caso contrario.
+ */
+int scan_u64(proc_scanner_t* line, unsigned long long* value)
+{
+    skip_blanks(line);
+
+    const char* p = line->pos;
+    unsigned long long v = 0;
+    while (p < line->end && (unsigned)(*p - '0') < 10)
+    {
+        v = v * 10 + (unsigned)(*p - '0');
+        p++;
+    }
+    if (p == line->pos)
+    {
+        return 0;
+    }
+
+    line->pos = p;
+    *value = v;
+    return 1;
+}
+
+/**
+ * @brief Lee el siguiente número decimal sin signo con parte fraccionaria opcional.
+ * @param line Cursor sobre la línea.
+ * @param value Valor leído.
+ * @return 1 si se leyó un número, 0 en caso contrario.
+ */
+int scan_decimal(proc_scanner_t* line, double* value)
+{
+    unsigned long long integer;
+    if (!scan_u64(line, &integer))
+    {
+        return 0;
+    }
+
+    double v = (double)integer;
+    if (line->pos < line->end && *line->pos == '.')
+    {
+        double scale = 0.1;
+        for (line->pos++; line->pos < line->end && (unsigned)(*line->pos - '0') < 10; line->pos++)
+        {
+            v += (double)(*line->pos - '0') * scale;
+            scale /= 10.0;
+        }
+    }
+    *value = v;
+    return 1;
+}
+
+/**
+ * @brief Saltea campos separados por espacios.
+ * @param line Cursor sobre la línea.
+ * @param count Cantidad de campos a saltear.
+ * @return 1 si se salteó la cantidad pedida, 0 si la línea terminó antes.
+ */
+int scan_skip(proc_scanner_t* line, unsigned count)
+{
+    while (count-- > 0)
+    {
+        skip_blanks(line);
+        if (line->pos >= line->end)
+        {
+            return 0;
+        }
+        while (line->pos < line->end && !is_blank(*line->pos))
+        {
+            line->pos++;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Obtiene el siguiente campo, delimitado por espacios o por el separador indicado.
+ * @param line Cursor sobre la línea.
+ * @param sep Separador adicional, o '\0' para usar sólo espacios.
+ * @param token Inicio del campo.
+ * @param len Longitud del campo.
+ * @return 1 si se obtuvo un campo, 0 si la línea terminó.
+ */
+int scan_token(proc_scanner_t* line, char sep, const char** token, size_t* len)
+{
+    skip_blanks(line);
+    if (line->pos >= line->end)
+    {
+        return 0;
+    }
+
+    const char* start = line->pos;
+    while (line->pos < line->end && !is_blank(*line->pos) && (sep == '\0' || *line->pos != sep))
+    {
+        line->pos++;
+    }
+    *token = start;
+    *len = (size_t)(line->pos - start);
+
+    if (sep != '\0' && line->pos < line->end && *line->pos == sep)
+    {
+        line->pos++;
+    }
+    return 1;
+}
+
+/**
+ * @brief Compara un campo con una cadena.
+ * @param token Inicio del campo.
+ * @param len Longitud del campo.
+ * @param str Cadena terminada en '\0'.
+ * @return 1 si son iguales, 0 en caso contrario.
+ */
+int scan_token_equals(const char* token, size_t len, const char* str)
+{
+    return strncmp(token, str, len) == 0 && str[len] == '\0';
+}
+
+/**
+ * @brief Compara una clave no terminada en '\0' con el nombre de un campo, con el mismo orden que strcmp().
+ * @param key Clave.
+ * @param len Longitud de la clave.
+ * @param name Nombre del campo, terminado en '\0'.
+ * @return Negativo, cero o positivo según la clave sea menor, igual o mayor que el nombre.
+ */
+static int compare_field_key(const char* key, size_t len, const char* name)
+{
+    int cmp = strncmp(key, name, len);
+    if (cmp != 0)
+    {
+        return cmp;
+    }
+    // La clave es prefijo del nombre: si el nombre sigue, la clave es menor
+    return name[len] == '\0' ? 0 : -1;
+}
+
+/**
+ * @brief Busca una clave en una tabla de campos ordenada.
+ * @param fields Tabla de campos ordenada por strcmp() sobre key.
+ * @param count Cantidad de campos.
+ * @param key Clave.
+ * @param len Longitud de la clave.
+ * @return Campo encontrado, o NULL si no está en la tabla.
+ */
+const scan_field_t* scan_field_lookup(const scan_field_t* fields, size_t count, const char* key, size_t len)
+{
+    size_t low = 0, high = count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        int cmp = compare_field_key(key, len, fields[mid].key);
+        if (cmp == 0)
+        {
+            return &fields[mid];
+        }
+        if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Recorre un archivo "clave valor" y guarda los valores de las claves de la tabla.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sep Separador entre la clave y el valor, o '\0' si sólo hay espacios.
+ * @param fields Tabla de campos ordenada.
+ * @param count Cantidad de campos.
+ * @param out Estructura destino.
+ * @return Cantidad de campos encontrados.
+ */
+size_t scan_fields(const char* buf, size_t len, char sep, const scan_field_t* fields, size_t count, void* out)
+{
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+    size_t found = 0;
+
+    scan_init(&file, buf, len);
+    while (found < count && scan_next_line(&file, &line))
+    {
+        if (!scan_token(&line, sep, &key, &key_len))
+        {
+            continue;
+        }
+        const scan_field_t* field = scan_field_lookup(fields, count, key, key_len);
+        if (field != NULL && scan_u64(&line, (unsigned long long*)((char*)out + field->offset)))
+        {
+            found++;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,652 @@
+#include "../include/process_stats.h"
+#include "../include/proc_reader.h"
+#include "../include/proc_scan.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @file process_stats.c
+ * @brief Implementación de las estadísticas por proceso.
+ */
+
+/**
+ * @brief Capacidad inicial de la tabla de procesos.
+ */
+#define PROCESS_TABLE_INITIAL_CAPACITY 1024
+
+/**
+ * @brief Tamaño del buffer de getdents64().
+ */
+#define PROCESS_DIRENTS_SIZE 32768
+
+/**
+ * @brief Cantidad de procesos leídos entre dos consultas del consumo de CPU durante el barrido.
+ */
+#define PROCESS_SCAN_BATCH 32
+
+/**
+ * @brief Bandera de /proc/[pid]/stat que identifica a los hilos del kernel, que no tienen I/O propia.
+ */
+#define PF_KTHREAD 0x00200000ULL
+
+/**
+ * @brief Calcula la posición inicial de sondeo para un pid.
+ * @param table Tabla de procesos.
+ * @param pid Identificador del proceso.
+ * @return Índice inicial dentro de la tabla.
+ */
+static size_t process_hash(const process_table_t* table, int pid)
+{
+    uint64_t key = (uint64_t)(unsigned int)pid * 0x9E3779B97F4A7C15ULL; // Hash multiplicativo de Fibonacci
+    return (size_t)(key >> 32) & (table->capacity - 1);
+}
+
+/**
+ * @brief Reserva una tabla vacía de la capacidad indicada.
+ * @param table Tabla de procesos.
+ * @param capacity Cantidad de entradas (potencia de 2).
+ * @return 0 si se reservó, -1 si falta memoria.
+ */
+static int process_table_alloc(process_table_t* table, size_t capacity)
+{
+    table->slots = calloc(capacity, sizeof(process_entry_t));
+    if (table->slots == NULL)
+    {
+        return -1;
+    }
+    table->capacity = capacity;
+    table->used = 0;
+    table->live = 0;
+    return 0;
+}
+
+/**
+ * @brief Reconstruye la tabla descartando las entradas borradas y, si hace falta, duplicando su capacidad.
+ * @param table Tabla de procesos.
+ * @return 0 si se reconstruyó, -1 si falta memoria (la tabla anterior queda intacta).
+ */
+static int process_table_rehash(process_table_t* table)
+{
+    process_entry_t* old = table->slots;
+    size_t old_capacity = table->capacity;
+    size_t capacity = table->live * 2 >= old_capacity ? old_capacity * 2 : old_capacity;
+    if (capacity < PROCESS_TABLE_INITIAL_CAPACITY)
+    {
+        capacity = PROCESS_TABLE_INITIAL_CAPACITY;
+    }
+
+    if (process_table_alloc(table, capacity) != 0)
+    {
+        table->slots = old;
+        table->capacity = old_capacity;
+        return -1;
+    }
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i].state != PROCESS_SLOT_USED)
+        {
+            continue;
+        }
+        size_t j = process_hash(table, old[i].pid);
+        while (table->slots[j].state != PROCESS_SLOT_EMPTY)
+        {
+            j = (j + 1) & (table->capacity - 1);
+        }
+        table->slots[j] = old[i];
+        table->used++;
+        table->live++;
+    }
+
+    free(old);
+    return 0;
+}
+
+/**
+ * @brief Inicializa la tabla de procesos y abre el directorio /proc indicado.
+ * @param table Tabla a inicializar.
+ * @param proc_root Directorio del sistema de archivos proc.
+ * @return 0 si se inicializó correctamente, -1 en caso de error.
+ */
+int process_table_init(process_table_t* table, const char* proc_root)
+{
+    memset(table, 0, sizeof(*table));
+    table->clock_ticks = sysconf(_SC_CLK_TCK);
+    table->page_size = sysconf(_SC_PAGESIZE);
+    clock_gettime(CLOCK_MONOTONIC, &table->credited_at);
+
+    table->proc_fd = open(proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (table->proc_fd < 0)
+    {
+        fprintf(stderr, "Error al abrir %s: %s\n", proc_root, strerror(errno));
+        return -1;
+    }
+
+    table->dirents = malloc(PROCESS_DIRENTS_SIZE);
+    if (table->dirents == NULL || process_table_alloc(table, PROCESS_TABLE_INITIAL_CAPACITY) != 0)
+    {
+        process_table_destroy(table);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Cierra el directorio /proc y libera la tabla de procesos.
+ * @param table Tabla a liberar.
+ */
+void process_table_destroy(process_table_t* table)
+{
+    if (table->proc_fd >= 0)
+    {
+        close(table->proc_fd);
+    }
+    free(table->dirents);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+    table->proc_fd = -1;
+}
+
+/**
+ * @brief Analiza el contenido de /proc/[pid]/stat.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar.
+ * @return 0 si se interpretó correctamente, -1 en caso contrario.
+ */
+int parse_process_stat(const char* buf, size_t len, process_sample_t* sample)
+{
+    // "pid (comm) estado ppid ...": comm puede contener cualquier carácter, incluso ')'
+    const char* open_paren = memchr(buf, '(', len);
+    const char* close_paren = NULL;
+    for (const char* p = buf + len; p > buf; p--)
+    {
+        if (p[-1] == ')')
+        {
+            close_paren = p - 1;
+            break;
+        }
+    }
+    if (open_paren == NULL || close_paren == NULL || close_paren < open_paren)
+    {
+        return -1;
+    }
+
+    size_t comm_len = (size_t)(close_paren - open_paren - 1);
+    if (comm_len >= sizeof(sample->comm))
+    {
+        comm_len = sizeof(sample->comm) - 1;
+    }
+    memcpy(sample->comm, open_paren + 1, comm_len);
+    sample->comm[comm_len] = '\0';
+
+    // Campos a partir de ")": 3 estado, 4-8 ppid..tpgid, 9 flags, 10-13 fallos de página, 14 utime, 15 stime,
+    // 16-21 cutime..itrealvalue, 22 starttime, 23 vsize, 24 rss
+    proc_scanner_t line = {close_paren + 1, buf + len};
+    unsigned long long utime, stime;
+    if (!scan_skip(&line, 6) || !scan_u64(&line, &sample->flags) || !scan_skip(&line, 4) || !scan_u64(&line, &utime) ||
+        !scan_u64(&line, &stime) || !scan_skip(&line, 6) || !scan_u64(&line, &sample->starttime) ||
+        !scan_skip(&line, 1) || !scan_u64(&line, &sample->rss_pages))
+    {
+        return -1;
+    }
+    sample->cpu_ticks = utime + stime;
+    return 0;
+}
+
+/**
+ * @brief Analiza el contenido de /proc/[pid]/io.
+ * @param buf Contenido del archivo.
+ * @param len Longitud del contenido.
+ * @param sample Lectura a completar.
+ * @return 0 si se encontraron ambos valores, -1 en caso contrario.
+ */
+int parse_process_io(const char* buf, size_t len, process_sample_t* sample)
+{
+    proc_scanner_t file, line;
+    const char* key;
+    size_t key_len;
+    int found = 0;
+
+    scan_init(&file, buf, len);
+    while (found < 2 && scan_next_line(&file, &line))
+    {
+        if (!scan_token(&line, ':', &key, &key_len))
+        {
+            continue;
+        }
+        if (scan_token_equals(key, key_len, "read_bytes"))
+        {
+            found += scan_u64(&line, &sample->read_bytes);
+        }
+        else if (scan_token_equals(key, key_len, "write_bytes"))
+        {
+            found += scan_u64(&line, &sample->write_bytes);
+        }
+    }
+    return found == 2 ? 0 : -1;
+}
+
+/**
+ * @brief Comienza un barrido.
+ * @param table Tabla de procesos.
+ */
+void process_table_begin(process_table_t* table)
+{
+    table->generation++;
+}
+
+/**
+ * @brief Guarda la lectura de un proceso en la tabla, agregándolo si es nuevo.
+ * @param table Tabla de procesos.
+ * @param pid Identificador del proceso.
+ * @param sample Lectura del proceso.
+ * @return Entrada del proceso, o NULL si falta memoria.
+ */
+process_entry_t* process_table_update(process_table_t* table, int pid, const process_sample_t* sample)
+{
+    // Mantenemos el factor de carga (incluyendo borrados) por debajo de 3/4
+    if ((table->used + 1) * 4 > table->capacity * 3 && process_table_rehash(table) != 0)
+    {
+        return NULL;
+    }
+
+    size_t i = process_hash(table, pid);
+    process_entry_t* free_slot = NULL;
+    process_entry_t* entry = NULL;
+    while (table->slots[i].state != PROCESS_SLOT_EMPTY)
+    {
+        process_entry_t* slot = &table->slots[i];
+        if (slot->state == PROCESS_SLOT_USED && slot->pid == pid)
+        {
+            entry = slot;
+            break;
+        }
+        if (slot->state == PROCESS_SLOT_DELETED && free_slot == NULL)
+        {
+            free_slot = slot;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+
+    if (entry == NULL)
+    {
+        // Proceso nuevo: reutilizamos una entrada borrada del sondeo si la hubo
+        entry = free_slot;
+        if (entry == NULL)
+        {
+            entry = &table->slots[i];
+            table->used++;
+        }
+        memset(entry, 0, sizeof(*entry));
+        entry->state = PROCESS_SLOT_USED;
+        entry->pid = pid;
+        table->live++;
+    }
+    else if (entry->cur.starttime != sample->starttime)
+    {
+        // El pid fue reutilizado por otro proceso entre dos barridos: no hay lectura anterior comparable
+        entry->has_prev = 0;
+        entry->valid = 0;
+        entry->io_denied = 0;
+    }
+
+    entry->cur = *sample;
+    entry->generation = table->generation;
+    return entry;
+}
+
+/**
+ * @brief Marca como borrados los procesos que no aparecieron en el barrido actual.
+ * @param table Tabla de procesos.
+ * @return Cantidad de procesos presentes.
+ */
+size_t process_table_sweep(process_table_t* table)
+{
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        process_entry_t* entry = &table->slots[i];
+        if (entry->state == PROCESS_SLOT_USED && entry->generation != table->generation)
+        {
+            entry->state = PROCESS_SLOT_DELETED;
+            table->live--;
+        }
+    }
+    return table->live;
+}
+
+/**
+ * @brief Diferencia entre dos lecturas de un contador de un proceso, por segundo.
+ *
+ * A diferencia de counter_rate(), un retroceso no se toma como vuelta ni reinicio: los contadores de /proc/PID son de
+ * 64 bits y sólo retroceden si el PID se reutilizó entre dos lecturas, y entonces la lectura actual no es lo contado
+ * desde la anterior.
+ *
+ * @param cur Valor actual.
+ * @param prev Valor anterior.
+ * @param elapsed Segundos transcurridos.
+ * @return Tasa por segundo, o 0 si el contador retrocedió.
+ */
+static double process_counter_rate(unsigned long long cur, unsigned long long prev, double elapsed)
+{
+    return cur >= prev ? (double)(cur - prev) / elapsed : 0.0;
+}
+
+/**
+ * @brief Calcula las tasas de cada proceso a partir de la lectura actual y la anterior.
+ * @param table Tabla de procesos.
+ */
+void compute_process_rates(process_table_t* table)
+{
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        process_entry_t* entry = &table->slots[i];
+        if (entry->state != PROCESS_SLOT_USED)
+        {
+            continue;
+        }
+
+        entry->rss_bytes = (double)entry->cur.rss_pages * (double)table->page_size;
+        double elapsed = entry->cur.taken - entry->prev.taken;
+        if (!entry->has_prev || elapsed <= 0.0)
+        {
+            entry->prev = entry->cur;
+            entry->has_prev = 1;
+            entry->valid = 0;
+            continue;
+        }
+
+        entry->cpu_percent = process_counter_rate(entry->cur.cpu_ticks, entry->prev.cpu_ticks, elapsed) * 100.0 /
+                             (double)table->clock_ticks;
+        entry->read_bytes_per_sec = process_counter_rate(entry->cur.read_bytes, entry->prev.read_bytes, elapsed);
+        entry->write_bytes_per_sec = process_counter_rate(entry->cur.write_bytes, entry->prev.write_bytes, elapsed);
+        entry->prev = entry->cur;
+        entry->valid = 1;
+    }
+}
+
+/**
+ * @brief Lee un archivo de un proceso relativo al descriptor de /proc.
+ * @param table Tabla de procesos (aporta el descriptor y el buffer).
+ * @param path Ruta relativa ("<pid>/stat").
+ * @param len Cantidad de bytes leídos.
+ * @return 0 si se leyó, o el errno de la falla (ENOENT/ESRCH si el proceso terminó, EACCES si no hay permiso).
+ */
+static int read_process_file(process_table_t* table, const char* path, size_t* len)
+{
+    int fd = openat(table->proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return errno;
+    }
+
+    // Estos archivos se generan completos en la primera lectura, por lo que alcanza con un único read()
+    ssize_t n = read(fd, table->file_buf, sizeof(table->file_buf) - 1);
+    int err = n < 0 ? errno : 0;
+    close(fd);
+    if (n < 0)
+    {
+        return err;
+    }
+    *len = (size_t)n;
+    table->file_buf[*len] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Lee y guarda en la tabla los archivos de un proceso.
+ * @param table Tabla de procesos.
+ * @param name Nombre de la entrada de /proc (el pid).
+ */
+static void scan_process(process_table_t* table, const char* name)
+{
+    char path[32];
+    size_t len;
+    process_sample_t sample;
+
+    // El proceso pudo terminar entre getdents64() y openat(): simplemente no se cuenta en este barrido
+    snprintf(path, sizeof(path), "%s/stat", name);
+    if (read_process_file(table, path, &len) != 0 || parse_process_stat(table->file_buf, len, &sample) != 0)
+    {
+        return;
+    }
+    sample.read_bytes = 0;
+    sample.write_bytes = 0;
+    sample.taken = table->batch_time;
+
+    int pid = atoi(name);
+    process_entry_t* entry = process_table_update(table, pid, &sample);
+    if (entry == NULL || entry->io_denied || (sample.flags & PF_KTHREAD))
+    {
+        return;
+    }
+
+    // Un proceso que no usó CPU no pudo emitir I/O propia: se conservan los contadores del barrido anterior y sólo se
+    // relee cada PROCESS_IO_REFRESH barridos (escalonado por pid) para tomar escrituras diferidas atribuidas tarde
+    if (entry->has_prev && entry->cur.cpu_ticks == entry->prev.cpu_ticks &&
+        (table->generation + (unsigned long long)pid) % PROCESS_IO_REFRESH != 0)
+    {
+        entry->cur.read_bytes = entry->prev.read_bytes;
+        entry->cur.write_bytes = entry->prev.write_bytes;
+        return;
+    }
+
+    // /proc/[pid]/io exige permisos de ptrace sobre el proceso; si se niega una vez no se vuelve a intentar
+    snprintf(path, sizeof(path), "%s/io", name);
+    int err = read_process_file(table, path, &len);
+    if (err == EACCES || err == EPERM)
+    {
+        entry->io_denied = 1;
+    }
+    else if (err == 0)
+    {
+        parse_process_io(table->file_buf, len, &entry->cur);
+    }
+}
+
+/**
+ * @brief Diferencia en segundos entre dos instantes.
+ * @param end Instante final.
+ * @param start Instante inicial.
+ * @return Segundos transcurridos.
+ */
+static double timespec_seconds(const struct timespec* end, const struct timespec* start)
+{
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Instante de un reloj en segundos.
+ * @param clock Reloj.
+ * @return Segundos.
+ */
+static double clock_seconds(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Termina el barrido en curso: descarta los procesos que no aparecieron y calcula las tasas.
+ * @param table Tabla de procesos.
+ */
+static void process_table_finish(process_table_t* table)
+{
+    struct timespec now;
+
+    process_table_sweep(table);
+    compute_process_rates(table);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    table->scan_duration = timespec_seconds(&now, &table->sweep_start);
+    table->scanned_wall = clock_seconds(CLOCK_REALTIME);
+    table->sweeping = 0;
+    table->scanned = 1;
+}
+
+/**
+ * @brief Avanza el barrido de /proc hasta agotar el crédito de CPU acumulado.
+ * @param table Tabla de procesos.
+ * @return 0 si se avanzó o no había crédito, -1 en caso de error.
+ */
+int process_table_scan(process_table_t* table)
+{
+    struct timespec now;
+
+    table->scanned = 0;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    table->cpu_credit += timespec_seconds(&now, &table->credited_at) * PROCESS_CPU_RATE;
+    table->credited_at = now;
+    if (table->cpu_credit > PROCESS_CPU_CREDIT_MAX)
+    {
+        table->cpu_credit = PROCESS_CPU_CREDIT_MAX;
+    }
+    if (table->cpu_credit <= 0.0)
+    {
+        return 0; // Todavía se está devolviendo el exceso de la llamada anterior
+    }
+
+    double cpu_start = clock_seconds(CLOCK_THREAD_CPUTIME_ID);
+    if (!table->sweeping)
+    {
+        // Releemos el directorio desde el principio sobre el descriptor persistente
+        if (lseek(table->proc_fd, 0, SEEK_SET) < 0)
+        {
+            perror("Error al reposicionar /proc");
+            return -1;
+        }
+        process_table_begin(table);
+        table->dirents_len = 0;
+        table->dirents_pos = 0;
+        table->sweep_start = now;
+        table->sweep_cpu = 0.0;
+        table->sweeping = 1;
+    }
+    table->batch_time = (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+
+    // El consumo se consulta cada PROCESS_SCAN_BATCH procesos; lo que se exceda se descuenta del próximo crédito
+    double spent = 0.0;
+    int batch = 0, done = 0;
+    while (spent < table->cpu_credit)
+    {
+        if (table->dirents_pos >= table->dirents_len)
+        {
+            long n = syscall(SYS_getdents64, table->proc_fd, table->dirents, PROCESS_DIRENTS_SIZE);
+            if (n < 0)
+            {
+                perror("Error al leer /proc");
+                table->sweeping = 0;
+                return -1;
+            }
+            if (n == 0)
+            {
+                done = 1;
+                break;
+            }
+            table->dirents_len = n;
+            table->dirents_pos = 0;
+        }
+
+        const struct linux_dirent64* dirent = (const struct linux_dirent64*)(table->dirents + table->dirents_pos);
+        table->dirents_pos += dirent->d_reclen;
+        if (dirent->d_name[0] < '1' || dirent->d_name[0] > '9')
+        {
+            continue;
+        }
+        scan_process(table, dirent->d_name);
+        if (++batch == PROCESS_SCAN_BATCH)
+        {
+            batch = 0;
+            spent = clock_seconds(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+            table->batch_time = clock_seconds(CLOCK_MONOTONIC);
+        }
+    }
+
+    if (done)
+    {
+        process_table_finish(table);
+    }
+
+    // El cierre del barrido también se descuenta, así el costo por barrido refleja todo el trabajo
+    spent = clock_seconds(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    table->cpu_credit -= spent;
+    table->sweep_cpu += spent;
+    if (done)
+    {
+        table->last_scan_cpu = table->sweep_cpu;
+    }
+    return 0;
+}
+
+/**
+ * @brief Valor de un proceso según el criterio de ordenamiento.
+ * @param entry Proceso.
+ * @param key Criterio.
+ * @return Valor a comparar, o 0 si el proceso no tiene tasas válidas para el criterio.
+ */
+static double process_key_value(const process_entry_t* entry, process_top_key_t key)
+{
+    switch (key)
+    {
+    case PROCESS_TOP_CPU:
+        return entry->valid ? entry->cpu_percent : 0.0;
+    case PROCESS_TOP_IO:
+        return entry->valid ? entry->read_bytes_per_sec + entry->write_bytes_per_sec : 0.0;
+    case PROCESS_TOP_RSS:
+    default:
+        return entry->rss_bytes;
+    }
+}
+
+/**
+ * @brief Selecciona los N procesos con mayor valor según un criterio.
+ *
+ * Mantiene los N mejores ordenados por inserción: con N chico frente a la cantidad de procesos, casi todos se
+ * descartan con una sola comparación contra el menor de los seleccionados.
+ *
+ * @param table Tabla de procesos.
+ * @param key Criterio de ordenamiento.
+ * @param top Arreglo de al menos n punteros.
+ * @param n Cantidad de procesos a seleccionar.
+ * @return Cantidad de procesos seleccionados.
+ */
+size_t process_top_n(const process_table_t* table, process_top_key_t key, const process_entry_t** top, size_t n)
+{
+    double values[PROCESS_TOP_MAX];
+    size_t count = 0;
+
+    if (n > PROCESS_TOP_MAX)
+    {
+        n = PROCESS_TOP_MAX;
+    }
+    for (size_t i = 0; i < table->capacity && n > 0; i++)
+    {
+        const process_entry_t* entry = &table->slots[i];
+        if (entry->state != PROCESS_SLOT_USED)
+        {
+            continue;
+        }
+        double value = process_key_value(entry, key);
+        if (value <= 0.0 || (count == n && value <= values[n - 1]))
+        {
+            continue;
+        }
+
+        size_t j = count < n ? count++ : n - 1;
+        while (j > 0 && values[j - 1] < value)
+        {
+            values[j] = values[j - 1];
+            top[j] = top[j - 1];
+            j--;
+        }
+        values[j] = value;
+        top[j] = entry;
+    }
+    return count;
+}
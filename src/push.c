@@ -0,0 +1,1005 @@
+#include "../include/push.h"
+#include "../include/snappy.h"
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file push.c
+ * @brief Implementación del envío de métricas por remote-write o por line protocol sobre UDP.
+ */
+
+/**
+ * @brief Etiquetas máximas de una muestra, además del nombre.
+ */
+#define PUSH_MAX_LABELS 16
+
+/**
+ * @brief Resultado de un intento de envío que no tiene sentido reintentar (el receptor rechazó el lote).
+ */
+#define PUSH_REJECTED (-2)
+
+/**
+ * @brief Etiqueta de una muestra, apuntando al texto de la serie o a su valor ya desescapado.
+ */
+typedef struct
+{
+    const char* name;  /**< Nombre de la etiqueta. */
+    size_t name_len;   /**< Longitud del nombre. */
+    const char* value; /**< Valor, sin escapes. */
+    size_t value_len;  /**< Longitud del valor. */
+} push_label_t;
+
+/**
+ * @brief Completa la configuración con los valores por defecto.
+ * @param config Configuración a completar.
+ */
+void push_config_default(push_config_t* config)
+{
+    memset(config, 0, sizeof(*config));
+    config->queue_size = PUSH_DEFAULT_QUEUE;
+    config->batch_size = PUSH_DEFAULT_BATCH;
+    config->flush_ms = PUSH_DEFAULT_FLUSH_MS;
+    config->max_retries = PUSH_DEFAULT_RETRIES;
+}
+
+/**
+ * @brief Interpreta el destino del envío.
+ * @param config Configuración a completar.
+ * @param url Destino.
+ * @return 0 si el destino es válido, -1 en caso contrario.
+ */
+int push_parse_url(push_config_t* config, const char* url)
+{
+    const char* rest;
+    if (strncmp(url, "http://", 7) == 0)
+    {
+        config->format = PUSH_REMOTE_WRITE;
+        rest = url + 7;
+        snprintf(config->port, sizeof(config->port), "80");
+    }
+    else if (strncmp(url, "udp://", 6) == 0)
+    {
+        config->format = PUSH_LINE_UDP;
+        rest = url + 6;
+        config->port[0] = '\0';
+    }
+    else
+    {
+        fprintf(stderr, "Destino de envío inválido (se admite http:// o udp://): %s\n", url);
+        return -1;
+    }
+
+    // El host puede ser una dirección IPv6 entre corchetes
+    const char* host = rest;
+    const char* host_end;
+    if (*rest == '[')
+    {
+        host = rest + 1;
+        host_end = strchr(host, ']');
+        rest = host_end != NULL ? host_end + 1 : NULL;
+    }
+    else
+    {
+        host_end = rest + strcspn(rest, ":/");
+        rest = host_end;
+    }
+    if (rest == NULL || host_end == host || (size_t)(host_end - host) >= sizeof(config->host))
+    {
+        fprintf(stderr, "Host inválido en el destino de envío: %s\n", url);
+        return -1;
+    }
+    memcpy(config->host, host, (size_t)(host_end - host));
+    config->host[host_end - host] = '\0';
+
+    if (*rest == ':')
+    {
+        size_t digits = strspn(rest + 1, "0123456789");
+        if (digits == 0 || digits >= sizeof(config->port) || (rest[1 + digits] != '\0' && rest[1 + digits] != '/'))
+        {
+            fprintf(stderr, "Puerto inválido en el destino de envío: %s\n", url);
+            return -1;
+        }
+        memcpy(config->port, rest + 1, digits);
+        config->port[digits] = '\0';
+        rest += 1 + digits;
+    }
+
+    if (config->format == PUSH_LINE_UDP && (config->port[0] == '\0' || *rest != '\0'))
+    {
+        fprintf(stderr, "El destino UDP debe ser udp://HOST:PUERTO: %s\n", url);
+        return -1;
+    }
+    if (strlen(rest) >= sizeof(config->path))
+    {
+        fprintf(stderr, "Ruta demasiado larga en el destino de envío: %s\n", url);
+        return -1;
+    }
+    snprintf(config->path, sizeof(config->path), "%s", *rest != '\0' ? rest : "/");
+    return 0;
+}
+
+/**
+ * @brief Separa una línea de la exposición en la serie (nombre y etiquetas) y el valor.
+ * @param line Comienzo de la línea.
+ * @param len Longitud de la línea, sin el '\n'.
+ * @param series_len Longitud de la serie.
+ * @param value Valor de la muestra.
+ * @return 0 si la línea es una muestra, -1 si no.
+ */
+static int parse_sample_line(const char* line, size_t len, size_t* series_len, double* value)
+{
+    size_t i = 0;
+    while (i < len && line[i] != '{' && line[i] != ' ')
+    {
+        i++;
+    }
+    if (i == 0)
+    {
+        return -1;
+    }
+    if (i < len && line[i] == '{')
+    {
+        // Los valores de las etiquetas pueden contener '}' o espacios entre comillas
+        int quoted = 0;
+        for (i++; i < len && (quoted || line[i] != '}'); i++)
+        {
+            if (line[i] == '\\' && quoted)
+            {
+                i++;
+            }
+            else if (line[i] == '"')
+            {
+                quoted = !quoted;
+            }
+        }
+        if (i >= len)
+        {
+            return -1;
+        }
+        i++;
+    }
+    if (i >= len || line[i] != ' ')
+    {
+        return -1;
+    }
+    *series_len = i;
+
+    // strtod() necesita un '\0': la línea termina en '\n' dentro de la exposición, así que copiamos el valor
+    char number[64];
+    size_t number_len = strcspn(line + i + 1, " \n");
+    if (number_len == 0 || number_len >= sizeof(number) || i + 1 + number_len > len)
+    {
+        return -1;
+    }
+    memcpy(number, line + i + 1, number_len);
+    number[number_len] = '\0';
+    char* end;
+    *value = strtod(number, &end);
+    return *end == '\0' ? 0 : -1;
+}
+
+/**
+ * @brief Encola las muestras de una exposición en formato de texto.
+ * @param pusher Envío iniciado.
+ * @param text Exposición.
+ * @param len Longitud de la exposición.
+ * @param ms Instante de las muestras.
+ */
+void push_enqueue_exposition(pusher_t* pusher, const char* text, size_t len, int64_t ms)
+{
+    if (!pusher->running)
+    {
+        return;
+    }
+
+    unsigned long long dropped = 0;
+    pthread_mutex_lock(&pusher->lock);
+    const char* end = text + len;
+    for (const char* line = text; line < end;)
+    {
+        const char* newline = memchr(line, '\n', (size_t)(end - line));
+        size_t line_len = newline != NULL ? (size_t)(newline - line) : (size_t)(end - line);
+        size_t series_len;
+        double value;
+        if (line_len > 0 && line[0] != '#' && parse_sample_line(line, line_len, &series_len, &value) == 0)
+        {
+            if (series_len >= PUSH_SERIES_SIZE)
+            {
+                dropped++;
+            }
+            else
+            {
+                // Cola llena: se pierde la muestra más vieja, nunca la nueva
+                if (pusher->len == pusher->config.queue_size)
+                {
+                    pusher->head = (pusher->head + 1) % pusher->config.queue_size;
+                    pusher->len--;
+                    dropped++;
+                }
+                push_sample_t* sample = &pusher->queue[(pusher->head + pusher->len) % pusher->config.queue_size];
+                sample->ms = ms;
+                sample->value = value;
+                memcpy(sample->series, line, series_len);
+                sample->series[series_len] = '\0';
+                pusher->len++;
+            }
+        }
+        line += line_len + 1;
+    }
+    if (pusher->len >= pusher->config.batch_size)
+    {
+        pthread_cond_signal(&pusher->ready);
+    }
+    atomic_store_explicit(&pusher->queued, pusher->len, memory_order_relaxed);
+    pthread_mutex_unlock(&pusher->lock);
+    atomic_fetch_add_explicit(&pusher->dropped, dropped, memory_order_relaxed);
+}
+
+/**
+ * @brief Separa una serie en su nombre y sus etiquetas, desescapando los valores.
+ * @param series Serie ("nombre{clave=\"valor\",...}").
+ * @param name_len Longitud del nombre.
+ * @param labels Etiquetas (a lo sumo PUSH_MAX_LABELS).
+ * @param count Cantidad de etiquetas.
+ * @param scratch Buffer de PUSH_SERIES_SIZE bytes para los valores desescapados.
+ * @return 0 si se interpretó, -1 si la serie está mal formada o tiene demasiadas etiquetas.
+ */
+static int parse_series(const char* series, size_t* name_len, push_label_t* labels, size_t* count, char* scratch)
+{
+    const char* p = strchr(series, '{');
+    *count = 0;
+    if (p == NULL)
+    {
+        *name_len = strlen(series);
+        return 0;
+    }
+    *name_len = (size_t)(p - series);
+    p++;
+
+    while (*p != '}')
+    {
+        if (*count == PUSH_MAX_LABELS)
+        {
+            return -1;
+        }
+        push_label_t* label = &labels[(*count)++];
+        label->name = p;
+        while (*p != '=' && *p != '\0')
+        {
+            p++;
+        }
+        label->name_len = (size_t)(p - label->name);
+        if (p[0] != '=' || p[1] != '"')
+        {
+            return -1;
+        }
+        p += 2;
+        label->value = scratch;
+        while (*p != '"')
+        {
+            if (*p == '\0')
+            {
+                return -1;
+            }
+            if (*p == '\\' && p[1] != '\0')
+            {
+                p++;
+                *scratch++ = *p == 'n' ? '\n' : *p;
+            }
+            else
+            {
+                *scratch++ = *p;
+            }
+            p++;
+        }
+        label->value_len = (size_t)(scratch - label->value);
+        p++;
+        if (*p == ',')
+        {
+            p++;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Compara dos etiquetas por nombre, como exige remote-write.
+ * @param a Primera etiqueta.
+ * @param b Segunda etiqueta.
+ * @return Negativo, 0 o positivo, como strcmp().
+ */
+static int compare_labels(const push_label_t* a, const push_label_t* b)
+{
+    size_t n = a->name_len < b->name_len ? a->name_len : b->name_len;
+    int cmp = memcmp(a->name, b->name, n);
+    return cmp != 0 ? cmp : (a->name_len > b->name_len) - (a->name_len < b->name_len);
+}
+
+/**
+ * @brief Bytes de un entero codificado como varint de protobuf.
+ * @param value Entero.
+ * @return Cantidad de bytes.
+ */
+static size_t varint_size(uint64_t value)
+{
+    size_t n = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Agrega un varint de protobuf.
+ * @param out Buffer.
+ * @param value Entero.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+static int put_varint(text_buf_t* out, uint64_t value)
+{
+    char bytes[10];
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        bytes[n++] = (char)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = (char)value;
+    return text_buf_append(out, bytes, n);
+}
+
+/**
+ * @brief Agrega un campo de longitud variable de protobuf (string o mensaje): clave, longitud y, si hay, los bytes.
+ * @param out Buffer.
+ * @param field Número de campo.
+ * @param data Contenido, o NULL si el mensaje se escribe a continuación.
+ * @param len Longitud del contenido.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+static int put_bytes_field(text_buf_t* out, unsigned int field, const char* data, size_t len)
+{
+    if (put_varint(out, (field << 3) | 2) != 0 || put_varint(out, len) != 0)
+    {
+        return -1;
+    }
+    return data != NULL ? text_buf_append(out, data, len) : 0;
+}
+
+/**
+ * @brief Bytes de un mensaje Label de remote-write.
+ * @param label Etiqueta.
+ * @return Cantidad de bytes.
+ */
+static size_t label_size(const push_label_t* label)
+{
+    return 1 + varint_size(label->name_len) + label->name_len + 1 + varint_size(label->value_len) + label->value_len;
+}
+
+/**
+ * @brief Agrega una muestra como un TimeSeries de un WriteRequest de remote-write.
+ *
+ * WriteRequest { repeated TimeSeries timeseries = 1; }
+ * TimeSeries { repeated Label labels = 1; repeated Sample samples = 2; }
+ * Label { string name = 1; string value = 2; }
+ * Sample { double value = 1; int64 timestamp = 2; }
+ *
+ * @param out Buffer del WriteRequest.
+ * @param sample Muestra.
+ * @return 0 si se agregó, 1 si la serie está mal formada (se saltea), -1 si falta memoria.
+ */
+static int encode_remote_write_sample(text_buf_t* out, const push_sample_t* sample)
+{
+    push_label_t labels[PUSH_MAX_LABELS + 1];
+    char scratch[PUSH_SERIES_SIZE];
+    size_t name_len;
+    size_t count;
+
+    if (parse_series(sample->series, &name_len, labels + 1, &count, scratch) != 0)
+    {
+        return 1;
+    }
+    labels[0] = (push_label_t){"__name__", 8, sample->series, name_len};
+    count++;
+
+    // Inserción: las muestras tienen pocas etiquetas
+    for (size_t i = 1; i < count; i++)
+    {
+        push_label_t label = labels[i];
+        size_t j = i;
+        while (j > 0 && compare_labels(&labels[j - 1], &label) > 0)
+        {
+            labels[j] = labels[j - 1];
+            j--;
+        }
+        labels[j] = label;
+    }
+
+    uint64_t timestamp = (uint64_t)sample->ms;
+    size_t sample_size = 1 + 8 + 1 + varint_size(timestamp);
+    size_t series_size = 1 + varint_size(sample_size) + sample_size;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t size = label_size(&labels[i]);
+        series_size += 1 + varint_size(size) + size;
+    }
+
+    int err = put_bytes_field(out, 1, NULL, series_size);
+    for (size_t i = 0; i < count; i++)
+    {
+        err |= put_bytes_field(out, 1, NULL, label_size(&labels[i]));
+        err |= put_bytes_field(out, 1, labels[i].name, labels[i].name_len);
+        err |= put_bytes_field(out, 2, labels[i].value, labels[i].value_len);
+    }
+    // El double va en little-endian, como en la memoria de x86 y ARM
+    char value[9] = {(1 << 3) | 1};
+    memcpy(value + 1, &sample->value, sizeof(double));
+    err |= put_bytes_field(out, 2, NULL, sample_size);
+    err |= text_buf_append(out, value, sizeof(value));
+    err |= put_varint(out, (2 << 3) | 0);
+    err |= put_varint(out, timestamp);
+    return err != 0 ? -1 : 0;
+}
+
+/**
+ * @brief Agrega texto escapando con '\\' los caracteres que el line protocol usa como separadores.
+ * @param out Buffer.
+ * @param text Texto.
+ * @param len Longitud del texto.
+ * @param special Caracteres a escapar.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+static int put_line_escaped(text_buf_t* out, const char* text, size_t len, const char* special)
+{
+    int err = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (text[i] == '\n')
+        {
+            err |= text_buf_append(out, "\\n", 2);
+            continue;
+        }
+        if (strchr(special, text[i]) != NULL)
+        {
+            err |= text_buf_append(out, "\\", 1);
+        }
+        err |= text_buf_append(out, &text[i], 1);
+    }
+    return err;
+}
+
+/**
+ * @brief Agrega una muestra como una línea del line protocol de InfluxDB: "nombre,clave=valor value=V ns".
+ * @param out Buffer de líneas.
+ * @param sample Muestra.
+ * @return 0 si se agregó, 1 si la muestra no se puede representar (se saltea), -1 si falta memoria.
+ */
+static int encode_line_sample(text_buf_t* out, const push_sample_t* sample)
+{
+    push_label_t labels[PUSH_MAX_LABELS];
+    char scratch[PUSH_SERIES_SIZE];
+    size_t name_len;
+    size_t count;
+
+    // El line protocol no admite NaN ni infinitos
+    if (!isfinite(sample->value) || parse_series(sample->series, &name_len, labels, &count, scratch) != 0)
+    {
+        return 1;
+    }
+    int err = put_line_escaped(out, sample->series, name_len, ", ");
+    for (size_t i = 0; i < count; i++)
+    {
+        // Las etiquetas vacías no se admiten: equivalen a no tener la etiqueta
+        if (labels[i].value_len == 0)
+        {
+            continue;
+        }
+        err |= text_buf_append(out, ",", 1);
+        err |= put_line_escaped(out, labels[i].name, labels[i].name_len, ",= ");
+        err |= text_buf_append(out, "=", 1);
+        err |= put_line_escaped(out, labels[i].value, labels[i].value_len, ",= ");
+    }
+    err |= text_buf_printf(out, " value=%.17g %lld000000\n", sample->value, (long long)sample->ms);
+    return err != 0 ? -1 : 0;
+}
+
+/**
+ * @brief Espera a que un socket esté listo.
+ * @param fd Socket.
+ * @param events POLLIN o POLLOUT.
+ * @return 0 si está listo, -1 si venció PUSH_TIMEOUT_MS o hubo un error.
+ */
+static int wait_socket(int fd, short events)
+{
+    struct pollfd pfd = {.fd = fd, .events = events};
+    int ret;
+    do
+    {
+        ret = poll(&pfd, 1, PUSH_TIMEOUT_MS);
+    } while (ret < 0 && errno == EINTR);
+    if (ret == 0)
+    {
+        errno = ETIMEDOUT;
+    }
+    return ret > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Abre una conexión TCP con el receptor, con plazo.
+ * @param config Configuración con el host y el puerto.
+ * @return Socket conectado (no bloqueante), o -1 en caso de error.
+ */
+static int connect_receiver(const push_config_t* config)
+{
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    struct addrinfo* res;
+    int err = getaddrinfo(config->host, config->port, &hints, &res);
+    if (err != 0)
+    {
+        fprintf(stderr, "Error al resolver %s: %s\n", config->host, gai_strerror(err));
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != NULL && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, ai->ai_protocol);
+        if (fd < 0)
+        {
+            continue;
+        }
+        int so_error = 0;
+        socklen_t so_len = sizeof(so_error);
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0 &&
+            (errno != EINPROGRESS || wait_socket(fd, POLLOUT) != 0 ||
+             getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &so_len) != 0 || so_error != 0))
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+/**
+ * @brief Envía un buffer completo por un socket no bloqueante.
+ * @param fd Socket.
+ * @param data Datos.
+ * @param len Longitud.
+ * @return 0 si se envió, -1 en caso de error.
+ */
+static int send_all(int fd, const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(fd, POLLOUT) == 0)
+            {
+                continue;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Envía el lote ya comprimido por remote-write y espera la respuesta.
+ * @param pusher Envío con el cuerpo comprimido en packet.
+ * @return 0 si el receptor lo aceptó, PUSH_REJECTED si lo rechazó (4xx salvo 429), -1 si conviene reintentar.
+ */
+static int send_remote_write(pusher_t* pusher)
+{
+    const push_config_t* config = &pusher->config;
+    int fd = connect_receiver(config);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    int host_is_ipv6 = strchr(config->host, ':') != NULL;
+    char header[1024];
+    int header_len = snprintf(header, sizeof(header),
+                              "POST %s HTTP/1.1\r\n"
+                              "Host: %s%s%s:%s\r\n"
+                              "User-Agent: metrics-exporter\r\n"
+                              "Content-Type: application/x-protobuf\r\n"
+                              "Content-Encoding: snappy\r\n"
+                              "X-Prometheus-Remote-Write-Version: 0.1.0\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n",
+                              config->path, host_is_ipv6 ? "[" : "", config->host, host_is_ipv6 ? "]" : "",
+                              config->port, pusher->packet.len);
+    if (header_len < 0 || (size_t)header_len >= sizeof(header) || send_all(fd, header, (size_t)header_len) != 0 ||
+        send_all(fd, pusher->packet.data, pusher->packet.len) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    // Sólo interesa la línea de estado
+    char response[256];
+    size_t len = 0;
+    while (len < sizeof(response) - 1 && memchr(response, '\n', len) == NULL)
+    {
+        ssize_t n = recv(fd, response + len, sizeof(response) - 1 - len, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && wait_socket(fd, POLLIN) == 0)
+        {
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        len += (size_t)n;
+    }
+    close(fd);
+    response[len] = '\0';
+
+    int status;
+    if (sscanf(response, "HTTP/%*d.%*d %d", &status) != 1)
+    {
+        fprintf(stderr, "Respuesta inválida del receptor de remote-write\n");
+        return -1;
+    }
+    if (status >= 200 && status < 300)
+    {
+        return 0;
+    }
+    fprintf(stderr, "El receptor de remote-write respondió %d\n", status);
+    return status >= 400 && status < 500 && status != 429 ? PUSH_REJECTED : -1;
+}
+
+/**
+ * @brief Envía las líneas del lote por UDP, en datagramas que terminan en un fin de línea.
+ * @param pusher Envío con las líneas en body.
+ * @return 0 si se enviaron, -1 si conviene reintentar.
+ */
+static int send_line_udp(pusher_t* pusher)
+{
+    const char* data = pusher->body.data;
+    size_t len = pusher->body.len;
+    while (len > 0)
+    {
+        // Cortamos en el último '\n' que entra; una línea más larga que un datagrama va sola
+        size_t chunk = len;
+        if (chunk > PUSH_UDP_PAYLOAD)
+        {
+            chunk = PUSH_UDP_PAYLOAD;
+            while (chunk > 0 && data[chunk - 1] != '\n')
+            {
+                chunk--;
+            }
+            if (chunk == 0)
+            {
+                chunk = (size_t)((const char*)memchr(data, '\n', len) - data) + 1;
+            }
+        }
+        if (send(pusher->udp_fd, data, chunk, MSG_NOSIGNAL) < 0)
+        {
+            fprintf(stderr, "Error al enviar por UDP a %s:%s: %s\n", pusher->config.host, pusher->config.port,
+                    strerror(errno));
+            return -1;
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * @brief Codifica el lote en body (y, para remote-write, lo comprime en packet).
+ * @param pusher Envío con el lote en batch.
+ * @param count Muestras del lote.
+ * @return 0 si se codificó, -1 si falta memoria.
+ */
+static int encode_batch(pusher_t* pusher, size_t count)
+{
+    text_buf_reset(&pusher->body);
+    text_buf_reset(&pusher->packet);
+    for (size_t i = 0; i < count; i++)
+    {
+        int ret = pusher->config.format == PUSH_REMOTE_WRITE ? encode_remote_write_sample(&pusher->body,
+                                                                                          &pusher->batch[i])
+                                                             : encode_line_sample(&pusher->body, &pusher->batch[i]);
+        if (ret < 0)
+        {
+            return -1;
+        }
+    }
+    if (pusher->config.format == PUSH_REMOTE_WRITE)
+    {
+        return snappy_compress((const unsigned char*)pusher->body.data, pusher->body.len, &pusher->packet);
+    }
+    return 0;
+}
+
+/**
+ * @brief Suma milisegundos a un instante.
+ * @param ts Instante.
+ * @param ms Milisegundos.
+ */
+static void timespec_add_ms(struct timespec* ts, unsigned long ms)
+{
+    ts->tv_sec += (time_t)(ms / 1000);
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Envía un lote, reintentando con espera exponencial y jitter.
+ * @param pusher Envío con el lote en batch.
+ * @param count Muestras del lote.
+ * @param final 1 si se está terminando: un único intento.
+ * @return 0 si se envió, -1 si se descartó.
+ */
+static int send_batch(pusher_t* pusher, size_t count, int final)
+{
+    if (encode_batch(pusher, count) != 0)
+    {
+        fprintf(stderr, "Error al reservar el lote de envío\n");
+        atomic_fetch_add_explicit(&pusher->failed, count, memory_order_relaxed);
+        return -1;
+    }
+
+    for (unsigned int attempt = 0;; attempt++)
+    {
+        int ret = pusher->config.format == PUSH_REMOTE_WRITE ? send_remote_write(pusher) : send_line_udp(pusher);
+        if (ret == 0)
+        {
+            atomic_fetch_add_explicit(&pusher->sent, count, memory_order_relaxed);
+            return 0;
+        }
+        if (ret == PUSH_REJECTED || final || attempt >= pusher->config.max_retries)
+        {
+            fprintf(stderr, "Se descartó un lote de %zu muestras sin enviar\n", count);
+            atomic_fetch_add_explicit(&pusher->failed, count, memory_order_relaxed);
+            return -1;
+        }
+
+        // Jitter "equal": entre la mitad y el total de la espera, para que varios exportadores no reintenten juntos
+        unsigned long backoff = PUSH_RETRY_BASE_MS << (attempt < 16 ? attempt : 16);
+        if (backoff > PUSH_RETRY_MAX_MS)
+        {
+            backoff = PUSH_RETRY_MAX_MS;
+        }
+        unsigned long delay = backoff / 2 + (unsigned long)rand_r(&pusher->seed) % (backoff / 2 + 1);
+        atomic_fetch_add_explicit(&pusher->retries, 1, memory_order_relaxed);
+
+        struct timespec retry_at;
+        clock_gettime(CLOCK_MONOTONIC, &retry_at);
+        timespec_add_ms(&retry_at, delay);
+        pthread_mutex_lock(&pusher->lock);
+        while (!pusher->stopping && pthread_cond_timedwait(&pusher->ready, &pusher->lock, &retry_at) != ETIMEDOUT)
+        {
+            // ready también se señala con cada lote completo: seguimos esperando hasta el plazo
+        }
+        final = pusher->stopping;
+        pthread_mutex_unlock(&pusher->lock);
+    }
+}
+
+/**
+ * @brief Saca de la cola el próximo lote.
+ * @param pusher Envío, con el mutex tomado.
+ * @return Muestras del lote.
+ */
+static size_t take_batch(pusher_t* pusher)
+{
+    size_t count = pusher->len < pusher->config.batch_size ? pusher->len : pusher->config.batch_size;
+    size_t first = pusher->config.queue_size - pusher->head;
+    if (first > count)
+    {
+        first = count;
+    }
+    memcpy(pusher->batch, pusher->queue + pusher->head, first * sizeof(push_sample_t));
+    memcpy(pusher->batch + first, pusher->queue, (count - first) * sizeof(push_sample_t));
+    pusher->head = (pusher->head + count) % pusher->config.queue_size;
+    pusher->len -= count;
+    atomic_store_explicit(&pusher->queued, pusher->len, memory_order_relaxed);
+    return count;
+}
+
+/**
+ * @brief Hilo de envío: manda un lote cuando se completa o cuando vence el período de envío.
+ * @param arg Envío (pusher_t).
+ * @return NULL.
+ */
+static void* push_worker(void* arg)
+{
+    pusher_t* pusher = arg;
+
+    pthread_mutex_lock(&pusher->lock);
+    while (1)
+    {
+        struct timespec flush_at;
+        clock_gettime(CLOCK_MONOTONIC, &flush_at);
+        timespec_add_ms(&flush_at, pusher->config.flush_ms);
+        while (!pusher->stopping && pusher->len < pusher->config.batch_size &&
+               pthread_cond_timedwait(&pusher->ready, &pusher->lock, &flush_at) != ETIMEDOUT)
+        {
+        }
+        if (pusher->stopping && pusher->len == 0)
+        {
+            break;
+        }
+
+        size_t count = take_batch(pusher);
+        int final = pusher->stopping;
+        pthread_mutex_unlock(&pusher->lock);
+        int failed = count > 0 && send_batch(pusher, count, final) != 0;
+        pthread_mutex_lock(&pusher->lock);
+
+        // Al terminar con el receptor caído no tiene sentido intentar el resto de la cola
+        if (final && failed)
+        {
+            atomic_fetch_add_explicit(&pusher->failed, pusher->len, memory_order_relaxed);
+            pusher->len = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pusher->lock);
+    return NULL;
+}
+
+/**
+ * @brief Abre el socket UDP conectado al receptor.
+ * @param config Configuración con el host y el puerto.
+ * @return Socket, o -1 en caso de error.
+ */
+static int open_udp(const push_config_t* config)
+{
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo* res;
+    int err = getaddrinfo(config->host, config->port, &hints, &res);
+    if (err != 0)
+    {
+        fprintf(stderr, "Error al resolver %s: %s\n", config->host, gai_strerror(err));
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != NULL && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error al abrir el socket UDP hacia %s:%s\n", config->host, config->port);
+    }
+    return fd;
+}
+
+/**
+ * @brief Reserva la cola y crea el hilo de envío.
+ * @param pusher Estado a inicializar.
+ * @param config Configuración.
+ * @return 0 si se inició, -1 en caso de error.
+ */
+int push_start(pusher_t* pusher, const push_config_t* config)
+{
+    memset(pusher, 0, sizeof(*pusher));
+    pusher->config = *config;
+    pusher->udp_fd = -1;
+    if (config->queue_size == 0 || config->batch_size == 0)
+    {
+        fprintf(stderr, "La cola y los lotes de envío deben tener al menos una muestra\n");
+        return -1;
+    }
+    if (pusher->config.batch_size > config->queue_size)
+    {
+        pusher->config.batch_size = config->queue_size;
+    }
+
+    pusher->queue = malloc(pusher->config.queue_size * sizeof(push_sample_t));
+    pusher->batch = malloc(pusher->config.batch_size * sizeof(push_sample_t));
+    if (pusher->queue == NULL || pusher->batch == NULL)
+    {
+        fprintf(stderr, "Error al reservar la cola de envío\n");
+        free(pusher->queue);
+        free(pusher->batch);
+        return -1;
+    }
+    if (config->format == PUSH_LINE_UDP && (pusher->udp_fd = open_udp(config)) < 0)
+    {
+        free(pusher->queue);
+        free(pusher->batch);
+        return -1;
+    }
+    pusher->seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+    atomic_init(&pusher->sent, 0);
+    atomic_init(&pusher->dropped, 0);
+    atomic_init(&pusher->failed, 0);
+    atomic_init(&pusher->retries, 0);
+    atomic_init(&pusher->queued, 0);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&pusher->lock, NULL);
+    pthread_cond_init(&pusher->ready, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // Como los hilos de los colectores, el de envío no recibe las señales del programa
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    int err = pthread_create(&pusher->thread, NULL, push_worker, pusher);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (err != 0)
+    {
+        fprintf(stderr, "Error al crear el hilo de envío\n");
+        pthread_cond_destroy(&pusher->ready);
+        pthread_mutex_destroy(&pusher->lock);
+        if (pusher->udp_fd >= 0)
+        {
+            close(pusher->udp_fd);
+        }
+        free(pusher->queue);
+        free(pusher->batch);
+        return -1;
+    }
+    pusher->running = 1;
+    return 0;
+}
+
+/**
+ * @brief Envía lo que quede en la cola, detiene el hilo y libera la cola.
+ * @param pusher Envío iniciado o no.
+ */
+void push_stop(pusher_t* pusher)
+{
+    if (!pusher->running)
+    {
+        return;
+    }
+    pthread_mutex_lock(&pusher->lock);
+    pusher->stopping = 1;
+    pthread_cond_signal(&pusher->ready);
+    pthread_mutex_unlock(&pusher->lock);
+    pthread_join(pusher->thread, NULL);
+    pusher->running = 0;
+
+    pthread_cond_destroy(&pusher->ready);
+    pthread_mutex_destroy(&pusher->lock);
+    if (pusher->udp_fd >= 0)
+    {
+        close(pusher->udp_fd);
+    }
+    free(pusher->queue);
+    free(pusher->batch);
+    text_buf_free(&pusher->body);
+    text_buf_free(&pusher->packet);
+}
@@ -0,0 +1,85 @@
+#include "../include/sampler.h"
+#include <stdio.h>
+
+/**
+ * @file sampler.c
+ * @brief Implementación del muestreador periódico.
+ */
+
+/**
+ * @brief Nanosegundos en un segundo.
+ */
+#define NSEC_PER_SEC 1000000000LL
+
+/**
+ * @brief Convierte un instante a nanosegundos.
+ * @param ts Instante.
+ * @return Nanosegundos desde el origen del reloj.
+ */
+static long long timespec_to_ns(const struct timespec* ts)
+{
+    return (long long)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+/**
+ * @brief Convierte nanosegundos a un instante.
+ * @param ns Nanosegundos desde el origen del reloj.
+ * @param ts Instante resultante.
+ */
+static void ns_to_timespec(long long ns, struct timespec* ts)
+{
+    ts->tv_sec = (time_t)(ns / NSEC_PER_SEC);
+    ts->tv_nsec = (long)(ns % NSEC_PER_SEC);
+}
+
+/**
+ * @brief Inicializa el muestreador tomando el instante actual como inicio del primer ciclo.
+ * @param sampler Muestreador a inicializar.
+ * @param interval_ms Período de muestreo en milisegundos.
+ * @return 0 si se inicializó correctamente, -1 si el período es inválido.
+ */
+int sampler_init(sampler_t* sampler, unsigned long interval_ms)
+{
+    if (interval_ms < SAMPLER_MIN_INTERVAL_MS)
+    {
+        fprintf(stderr, "El intervalo de muestreo debe ser de al menos %d ms\n", SAMPLER_MIN_INTERVAL_MS);
+        return -1;
+    }
+
+    sampler->period_ns = (long long)interval_ms * 1000000LL;
+    sampler->ticks = 0;
+    sampler->missed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &sampler->next);
+    return 0;
+}
+
+/**
+ * @brief Programa el instante de comienzo del próximo ciclo.
+ * @param sampler Muestreador inicializado.
+ */
+static void sampler_arm(sampler_t* sampler)
+{
+    struct timespec now;
+    long long next = timespec_to_ns(&sampler->next) + sampler->period_ns;
+
+    // Si ya pasó el instante programado salteamos los ciclos vencidos, manteniendo la fase original
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long late = timespec_to_ns(&now) - next;
+    if (late >= 0)
+    {
+        long long skipped = late / sampler->period_ns + 1;
+        sampler->missed += (unsigned long long)skipped;
+        next += skipped * sampler->period_ns;
+    }
+    ns_to_timespec(next, &sampler->next);
+}
+
+/**
+ * @brief Pasa al ciclo siguiente sin esperar.
+ * @param sampler Muestreador inicializado.
+ */
+void sampler_advance(sampler_t* sampler)
+{
+    sampler_arm(sampler);
+    sampler->ticks++;
+}
@@ -0,0 +1,513 @@
+#include "../include/series.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file series.c
+ * @brief Implementación de las series etiquetadas con conjuntos de etiquetas internados.
+ */
+
+/**
+ * @brief Posición borrada del índice.
+ */
+#define SERIES_INDEX_DELETED UINT_MAX
+
+/**
+ * @brief Máscara de la entrada dentro del número de un conjunto de etiquetas.
+ */
+#define SERIES_INDEX_MASK ((1U << SERIES_INDEX_BITS) - 1)
+
+/**
+ * @brief Máscara de la generación dentro del número de un conjunto de etiquetas.
+ */
+#define SERIES_GENERATION_MASK (UINT_MAX >> SERIES_INDEX_BITS)
+
+/**
+ * @brief Capacidad inicial del slab de conjuntos y del índice.
+ */
+#define SERIES_INITIAL_CAPACITY 64
+
+/**
+ * @brief Cantidad de tablas inicializadas, de la que sale la generación inicial de las entradas de cada una.
+ */
+static atomic_uint series_epoch;
+
+/**
+ * @brief Calcula el hash FNV-1a de un conjunto de etiquetas renderizado.
+ * @param text Texto.
+ * @param len Longitud del texto.
+ * @return Hash.
+ */
+static unsigned int series_hash(const char* text, size_t len)
+{
+    unsigned int hash = 2166136261U;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * @brief Arma el número de un conjunto de etiquetas a partir de su entrada.
+ * @param labels Tabla.
+ * @param entry Entrada del slab.
+ * @return Número del conjunto.
+ */
+static unsigned int series_labels_id(const series_labels_t* labels, unsigned int entry)
+{
+    return entry | (labels->sets[entry].generation & SERIES_GENERATION_MASK) << SERIES_INDEX_BITS;
+}
+
+/**
+ * @brief Comprueba que un número guardado siga identificando un conjunto de etiquetas.
+ * @param labels Tabla.
+ * @param id Número guardado.
+ * @return El mismo número, o SERIES_NO_LABELS si el conjunto se liberó o nunca se resolvió.
+ */
+unsigned int series_labels_lookup(series_labels_t* labels, unsigned int id)
+{
+    unsigned int entry = id & SERIES_INDEX_MASK;
+    if (entry == 0 || entry >= labels->len || !labels->sets[entry].used || series_labels_id(labels, entry) != id)
+    {
+        return SERIES_NO_LABELS;
+    }
+    labels->sets[entry].last_tick = labels->tick;
+    return id;
+}
+
+/**
+ * @brief Reconstruye el índice con los conjuntos internados, descartando las posiciones borradas.
+ * @param labels Tabla.
+ * @param capacity Cantidad de posiciones (potencia de 2).
+ * @return 0 si se reconstruyó, -1 si falta memoria (el índice anterior queda intacto).
+ */
+static int series_index_rebuild(series_labels_t* labels, size_t capacity)
+{
+    unsigned int* index = calloc(capacity, sizeof(unsigned int));
+    if (index == NULL)
+    {
+        return -1;
+    }
+    for (size_t entry = 1; entry < labels->len; entry++)
+    {
+        if (labels->sets[entry].used)
+        {
+            size_t i = labels->sets[entry].hash & (capacity - 1);
+            while (index[i] != 0)
+            {
+                i = (i + 1) & (capacity - 1);
+            }
+            index[i] = (unsigned int)entry;
+        }
+    }
+    free(labels->index);
+    labels->index = index;
+    labels->index_capacity = capacity;
+    labels->index_used = labels->live;
+    return 0;
+}
+
+/**
+ * @brief Libera un conjunto de etiquetas y deja su entrada para reutilizarla.
+ * @param labels Tabla.
+ * @param entry Entrada del slab.
+ */
+static void series_labels_free(series_labels_t* labels, unsigned int entry)
+{
+    series_label_set_t* set = &labels->sets[entry];
+    size_t i = set->hash & (labels->index_capacity - 1);
+    while (labels->index[i] != entry)
+    {
+        i = (i + 1) & (labels->index_capacity - 1);
+    }
+    labels->index[i] = SERIES_INDEX_DELETED;
+
+    // La generación nueva invalida los números que los colectores guardaron
+    set->used = 0;
+    set->generation++;
+    set->next_free = labels->free_head;
+    labels->free_head = entry;
+    labels->live--;
+}
+
+/**
+ * @brief Inicializa una tabla de conjuntos de etiquetas vacía.
+ * @param labels Tabla a inicializar.
+ * @param max_idle Ciclos sin actualizarse tras los cuales se quita una serie.
+ */
+void series_labels_init(series_labels_t* labels, unsigned long max_idle)
+{
+    memset(labels, 0, sizeof(*labels));
+    labels->len = 1;
+    labels->max_idle = max_idle > 0 ? max_idle : 1;
+
+    // Con otra generación inicial, un número guardado antes de reinicializar la tabla no coincide con los nuevos
+    labels->epoch = atomic_fetch_add_explicit(&series_epoch, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Libera una tabla de conjuntos de etiquetas.
+ * @param labels Tabla.
+ */
+void series_labels_destroy(series_labels_t* labels)
+{
+    free(labels->sets);
+    free(labels->index);
+    series_labels_init(labels, labels->max_idle);
+}
+
+/**
+ * @brief Avanza el ciclo y libera los conjuntos sin series que no se resolvieron en los últimos ciclos.
+ * @param labels Tabla.
+ */
+void series_labels_tick(series_labels_t* labels)
+{
+    labels->tick++;
+    for (size_t entry = 1; entry < labels->len; entry++)
+    {
+        const series_label_set_t* set = &labels->sets[entry];
+        if (set->used && set->refs == 0 && labels->tick - set->last_tick > labels->max_idle)
+        {
+            series_labels_free(labels, (unsigned int)entry);
+        }
+    }
+}
+
+/**
+ * @brief Renderiza un conjunto de etiquetas escapando sus valores.
+ * @param buf Destino, de SERIES_LABELS_SIZE bytes.
+ * @param names Nombres de las etiquetas.
+ * @param values Valores de las etiquetas.
+ * @param count Cantidad de etiquetas.
+ * @return Longitud del texto, o -1 si no entra.
+ */
+static int series_labels_render(char* buf, const char* const* names, const char* const* values, size_t count)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t name_len = strlen(names[i]);
+        if (len + name_len + 4 >= SERIES_LABELS_SIZE)
+        {
+            return -1;
+        }
+        if (i > 0)
+        {
+            buf[len++] = ',';
+        }
+        memcpy(buf + len, names[i], name_len);
+        len += name_len;
+        buf[len++] = '=';
+        buf[len++] = '"';
+        for (const char* p = values[i]; *p != '\0'; p++)
+        {
+            char escaped = *p == '\\' ? '\\' : *p == '"' ? '"' : *p == '\n' ? 'n' : '\0';
+            if (len + 3 >= SERIES_LABELS_SIZE)
+            {
+                return -1;
+            }
+            if (escaped != '\0')
+            {
+                buf[len++] = '\\';
+                buf[len++] = escaped;
+            }
+            else
+            {
+                buf[len++] = *p;
+            }
+        }
+        buf[len++] = '"';
+    }
+    buf[len] = '\0';
+    return (int)len;
+}
+
+/**
+ * @brief Resuelve el número de un conjunto de etiquetas, internándolo si hace falta.
+ * @param labels Tabla.
+ * @param cached Número guardado por el colector; se actualiza.
+ * @param names Nombres de las etiquetas.
+ * @param values Valores de las etiquetas.
+ * @param count Cantidad de etiquetas.
+ * @return Número del conjunto, o SERIES_NO_LABELS si no se pudo internar.
+ */
+unsigned int series_labels_resolve(series_labels_t* labels, unsigned int* cached, const char* const* names,
+                                   const char* const* values, size_t count)
+{
+    // Camino habitual: el número guardado sigue vigente
+    if (series_labels_lookup(labels, *cached) != SERIES_NO_LABELS)
+    {
+        return *cached;
+    }
+
+    char text[SERIES_LABELS_SIZE];
+    int len = series_labels_render(text, names, values, count);
+    if (len < 0)
+    {
+        return SERIES_NO_LABELS;
+    }
+    unsigned int hash = series_hash(text, (size_t)len);
+
+    // Un conjunto igual ya internado (por ejemplo, por otro objeto con el mismo nombre) se comparte
+    if (labels->index_capacity > 0)
+    {
+        size_t i = hash & (labels->index_capacity - 1);
+        while (labels->index[i] != 0)
+        {
+            unsigned int entry = labels->index[i];
+            if (entry != SERIES_INDEX_DELETED && labels->sets[entry].hash == hash &&
+                labels->sets[entry].len == (unsigned int)len && memcmp(labels->sets[entry].text, text, len) == 0)
+            {
+                labels->sets[entry].last_tick = labels->tick;
+                *cached = series_labels_id(labels, entry);
+                return *cached;
+            }
+            i = (i + 1) & (labels->index_capacity - 1);
+        }
+    }
+
+    // El índice se mantiene por debajo de 3/4 de ocupación contando las posiciones borradas
+    if ((labels->index_used + 1) * 4 > labels->index_capacity * 3)
+    {
+        size_t capacity = labels->index_capacity > 0 ? labels->index_capacity : SERIES_INITIAL_CAPACITY;
+        while ((labels->live + 1) * 2 > capacity)
+        {
+            capacity *= 2;
+        }
+        if (series_index_rebuild(labels, capacity) != 0)
+        {
+            return SERIES_NO_LABELS;
+        }
+    }
+
+    unsigned int entry = labels->free_head;
+    if (entry != 0)
+    {
+        labels->free_head = labels->sets[entry].next_free;
+    }
+    else
+    {
+        if (labels->len > SERIES_INDEX_MASK)
+        {
+            return SERIES_NO_LABELS;
+        }
+        if (labels->len >= labels->capacity)
+        {
+            size_t capacity = labels->capacity > 0 ? labels->capacity * 2 : SERIES_INITIAL_CAPACITY;
+            series_label_set_t* sets = realloc(labels->sets, capacity * sizeof(series_label_set_t));
+            if (sets == NULL)
+            {
+                return SERIES_NO_LABELS;
+            }
+            memset(sets + labels->capacity, 0, (capacity - labels->capacity) * sizeof(series_label_set_t));
+            labels->sets = sets;
+            labels->capacity = capacity;
+        }
+        entry = (unsigned int)labels->len++;
+        labels->sets[entry].generation = labels->epoch;
+    }
+
+    series_label_set_t* set = &labels->sets[entry];
+    memcpy(set->text, text, (size_t)len + 1);
+    set->len = (unsigned int)len;
+    set->hash = hash;
+    set->refs = 0;
+    set->next_free = 0;
+    set->used = 1;
+    set->last_tick = labels->tick;
+    labels->live++;
+
+    size_t i = hash & (labels->index_capacity - 1);
+    while (labels->index[i] != 0 && labels->index[i] != SERIES_INDEX_DELETED)
+    {
+        i = (i + 1) & (labels->index_capacity - 1);
+    }
+    if (labels->index[i] == 0)
+    {
+        labels->index_used++;
+    }
+    labels->index[i] = entry;
+
+    *cached = series_labels_id(labels, entry);
+    return *cached;
+}
+
+/**
+ * @brief Inicializa una familia sin series.
+ * @param family Familia a inicializar.
+ * @param labels Tabla de conjuntos de etiquetas del colector.
+ * @param name Nombre de la métrica.
+ * @param help Descripción de la métrica.
+ * @param counter 1 si es un contador entero.
+ * @param limit Series admitidas.
+ */
+void series_family_init(series_family_t* family, series_labels_t* labels, const char* name, const char* help,
+                        int counter, size_t limit)
+{
+    family->name = name;
+    family->help = help;
+    family->counter = counter;
+    family->labels = labels;
+    family->series = NULL;
+    family->capacity = 0;
+    family->count = 0;
+    family->limit = limit;
+    atomic_init(&family->dropped, 0);
+}
+
+/**
+ * @brief Quita una serie y suelta su conjunto de etiquetas.
+ * @param family Familia.
+ * @param entry Entrada de la serie.
+ */
+static void series_remove(series_family_t* family, size_t entry)
+{
+    family->labels->sets[entry].refs--;
+    family->series[entry].labels = SERIES_NO_LABELS;
+    family->count--;
+}
+
+/**
+ * @brief Libera las series de una familia.
+ * @param family Familia.
+ */
+void series_family_destroy(series_family_t* family)
+{
+    for (size_t entry = 0; entry < family->capacity; entry++)
+    {
+        if (family->series[entry].labels != SERIES_NO_LABELS)
+        {
+            series_remove(family, entry);
+        }
+    }
+    free(family->series);
+    family->series = NULL;
+    family->capacity = 0;
+}
+
+/**
+ * @brief Busca la serie de un conjunto de etiquetas, creándola si no existe y el límite lo permite.
+ * @param family Familia.
+ * @param labels Conjunto de etiquetas.
+ * @return Serie, o NULL si se descartó.
+ */
+static series_t* series_get(series_family_t* family, unsigned int labels)
+{
+    size_t entry = labels & SERIES_INDEX_MASK;
+    if (labels == SERIES_NO_LABELS)
+    {
+        atomic_fetch_add_explicit(&family->dropped, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    // Las series acompañan al slab de conjuntos: crecen hasta su capacidad y no se mueven de entrada
+    if (entry >= family->capacity)
+    {
+        size_t capacity = family->labels->capacity;
+        series_t* series = realloc(family->series, capacity * sizeof(series_t));
+        if (series == NULL)
+        {
+            atomic_fetch_add_explicit(&family->dropped, 1, memory_order_relaxed);
+            return NULL;
+        }
+        memset(series + family->capacity, 0, (capacity - family->capacity) * sizeof(series_t));
+        family->series = series;
+        family->capacity = capacity;
+    }
+
+    series_t* series = &family->series[entry];
+    if (series->labels != labels)
+    {
+        if (family->count >= family->limit)
+        {
+            atomic_fetch_add_explicit(&family->dropped, 1, memory_order_relaxed);
+            return NULL;
+        }
+        series->labels = labels;
+        family->labels->sets[entry].refs++;
+        family->count++;
+    }
+    series->last_tick = family->labels->tick;
+    return series;
+}
+
+/**
+ * @brief Actualiza el valor de una serie de un gauge.
+ * @param family Familia.
+ * @param labels Conjunto de etiquetas.
+ * @param value Valor.
+ * @return 0 si se actualizó, -1 si la serie se descartó.
+ */
+int series_set(series_family_t* family, unsigned int labels, double value)
+{
+    series_t* series = series_get(family, labels);
+    if (series == NULL)
+    {
+        return -1;
+    }
+    series->value = value;
+    return 0;
+}
+
+/**
+ * @brief Actualiza el valor de una serie de un contador.
+ * @param family Familia.
+ * @param labels Conjunto de etiquetas.
+ * @param count Valor.
+ * @return 0 si se actualizó, -1 si la serie se descartó.
+ */
+int series_set_count(series_family_t* family, unsigned int labels, unsigned long long count)
+{
+    series_t* series = series_get(family, labels);
+    if (series == NULL)
+    {
+        return -1;
+    }
+    series->count = count;
+    return 0;
+}
+
+/**
+ * @brief Quita las series que no se actualizaron en los últimos ciclos y renderiza las demás.
+ * @param family Familia.
+ * @param text Sección.
+ */
+void series_family_render(series_family_t* family, text_buf_t* text)
+{
+    const series_labels_t* labels = family->labels;
+    for (size_t entry = 0; entry < family->capacity; entry++)
+    {
+        const series_t* series = &family->series[entry];
+        if (series->labels != SERIES_NO_LABELS && labels->tick - series->last_tick > labels->max_idle)
+        {
+            series_remove(family, entry);
+        }
+    }
+    if (family->count == 0)
+    {
+        return;
+    }
+
+    text_buf_printf(text, "# HELP %s %s\n# TYPE %s %s\n", family->name, family->help, family->name,
+                    family->counter ? "counter" : "gauge");
+    for (size_t entry = 0; entry < family->capacity; entry++)
+    {
+        const series_t* series = &family->series[entry];
+        if (series->labels == SERIES_NO_LABELS)
+        {
+            continue;
+        }
+        const char* set = labels->sets[entry].text;
+        if (family->counter)
+        {
+            text_buf_printf(text, "%s{%s} %llu\n", family->name, set, series->count);
+        }
+        else
+        {
+            text_buf_printf(text, "%s{%s} %.17g\n", family->name, set, series->value);
+        }
+    }
+}
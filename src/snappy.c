@@ -0,0 +1,153 @@
+#include "../include/snappy.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file snappy.c
+ * @brief Implementación del compresor de bloques de Snappy.
+ *
+ * Un bloque es la longitud descomprimida (varint) seguida de elementos: literales (tag 0) y copias con un
+ * desplazamiento de 2 bytes (tag 2), que alcanzan a los 64 KiB anteriores.
+ */
+
+/**
+ * @brief Bits de la tabla hash de posiciones.
+ */
+#define SNAPPY_HASH_BITS 14
+
+/**
+ * @brief Mayor desplazamiento de una copia con tag 2.
+ */
+#define SNAPPY_MAX_OFFSET 65535
+
+/**
+ * @brief Lee 4 bytes sin requerir alineación.
+ * @param p Posición.
+ * @return Los 4 bytes como entero.
+ */
+static uint32_t load32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Agrega un literal.
+ * @param out Buffer.
+ * @param p Bytes del literal.
+ * @param n Longitud del literal.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+static int emit_literal(text_buf_t* out, const unsigned char* p, size_t n)
+{
+    unsigned char tag[5];
+    size_t tag_len = 1;
+    size_t len = n - 1;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (len < 60)
+    {
+        tag[0] = (unsigned char)(len << 2);
+    }
+    else
+    {
+        // Tags 60 a 63: la longitud - 1 sigue en 1 a 4 bytes little-endian
+        size_t bytes = len < (1U << 8) ? 1 : len < (1U << 16) ? 2 : len < (1U << 24) ? 3 : 4;
+        tag[0] = (unsigned char)((59 + bytes) << 2);
+        for (size_t i = 0; i < bytes; i++)
+        {
+            tag[tag_len++] = (unsigned char)(len >> (8 * i));
+        }
+    }
+    if (text_buf_append(out, (const char*)tag, tag_len) != 0)
+    {
+        return -1;
+    }
+    return text_buf_append(out, (const char*)p, n);
+}
+
+/**
+ * @brief Agrega las copias que repiten len bytes desde offset bytes atrás.
+ * @param out Buffer.
+ * @param offset Desplazamiento (1 a SNAPPY_MAX_OFFSET).
+ * @param len Longitud de la coincidencia.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+static int emit_copy(text_buf_t* out, size_t offset, size_t len)
+{
+    while (len > 0)
+    {
+        // Una copia con tag 2 repite de 1 a 64 bytes
+        size_t chunk = len > 64 ? 64 : len;
+        unsigned char tag[3] = {(unsigned char)(((chunk - 1) << 2) | 2), (unsigned char)offset,
+                                (unsigned char)(offset >> 8)};
+        if (text_buf_append(out, (const char*)tag, sizeof(tag)) != 0)
+        {
+            return -1;
+        }
+        len -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * @brief Comprime un bloque y lo agrega a un buffer.
+ * @param in Datos a comprimir.
+ * @param len Longitud de los datos.
+ * @param out Buffer al que se agrega el bloque comprimido.
+ * @return 0 si se comprimió, -1 si falta memoria.
+ */
+int snappy_compress(const unsigned char* in, size_t len, text_buf_t* out)
+{
+    uint32_t table[1 << SNAPPY_HASH_BITS];
+    unsigned char varint[5];
+    size_t varint_len = 0;
+
+    for (size_t v = len; ; v >>= 7)
+    {
+        varint[varint_len++] = (unsigned char)(v >= 0x80 ? (v & 0x7f) | 0x80 : v);
+        if (v < 0x80)
+        {
+            break;
+        }
+    }
+    if (text_buf_append(out, (const char*)varint, varint_len) != 0)
+    {
+        return -1;
+    }
+
+    // Cada entrada guarda la última posición + 1 con esos 4 bytes (0: ninguna)
+    memset(table, 0, sizeof(table));
+    size_t literal = 0;
+    size_t i = 0;
+    while (i + 4 <= len)
+    {
+        uint32_t bytes = load32(in + i);
+        uint32_t hash = (bytes * 0x1e35a7bdU) >> (32 - SNAPPY_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t)(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > SNAPPY_MAX_OFFSET || load32(in + candidate - 1) != bytes)
+        {
+            i++;
+            continue;
+        }
+
+        candidate--;
+        size_t match = 4;
+        while (i + match < len && in[candidate + match] == in[i + match])
+        {
+            match++;
+        }
+        if (emit_literal(out, in + literal, i - literal) != 0 || emit_copy(out, i - candidate, match) != 0)
+        {
+            return -1;
+        }
+        i += match;
+        literal = i;
+    }
+    return emit_literal(out, in + literal, len - literal);
+}
@@ -0,0 +1,154 @@
+#include "../include/text_buf.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file text_buf.c
+ * @brief Implementación del buffer de texto.
+ */
+
+/**
+ * @brief Capacidad inicial del buffer.
+ */
+#define TEXT_BUF_INITIAL_CAP 4096
+
+/**
+ * @brief Asegura lugar para len bytes más el '\0' final.
+ * @param buf Buffer.
+ * @param len Bytes a agregar.
+ * @return 0 si hay lugar, -1 si falta memoria.
+ */
+static int text_buf_reserve(text_buf_t* buf, size_t len)
+{
+    if (buf->len + len + 1 <= buf->cap)
+    {
+        return 0;
+    }
+
+    size_t cap = buf->cap == 0 ? TEXT_BUF_INITIAL_CAP : buf->cap;
+    while (cap < buf->len + len + 1)
+    {
+        cap *= 2;
+    }
+    char* data = realloc(buf->data, cap);
+    if (data == NULL)
+    {
+        return -1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Vacía el buffer conservando la memoria reservada.
+ * @param buf Buffer.
+ */
+void text_buf_reset(text_buf_t* buf)
+{
+    buf->len = 0;
+    if (buf->data != NULL)
+    {
+        buf->data[0] = '\0';
+    }
+}
+
+/**
+ * @brief Agrega texto al final del buffer.
+ * @param buf Buffer.
+ * @param str Texto a agregar.
+ * @param len Longitud del texto.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int text_buf_append(text_buf_t* buf, const char* str, size_t len)
+{
+    if (text_buf_reserve(buf, len) != 0)
+    {
+        return -1;
+    }
+    memcpy(buf->data + buf->len, str, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Agrega texto con formato al final del buffer.
+ * @param buf Buffer.
+ * @param fmt Formato, como en printf().
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int text_buf_printf(text_buf_t* buf, const char* fmt, ...)
+{
+    va_list args;
+
+    // Primero intentamos en el lugar libre; si no alcanza, agrandamos y formateamos de nuevo
+    size_t avail = buf->cap > buf->len ? buf->cap - buf->len : 0;
+    va_start(args, fmt);
+    int n = vsnprintf(avail > 0 ? buf->data + buf->len : NULL, avail, fmt, args);
+    va_end(args);
+    if (n < 0)
+    {
+        return -1;
+    }
+    if ((size_t)n >= avail)
+    {
+        if (text_buf_reserve(buf, (size_t)n) != 0)
+        {
+            return -1;
+        }
+        va_start(args, fmt);
+        vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, args);
+        va_end(args);
+    }
+    buf->len += (size_t)n;
+    return 0;
+}
+
+/**
+ * @brief Agrega el valor de una etiqueta escapado según el formato de exposición.
+ * @param buf Buffer.
+ * @param value Valor de la etiqueta.
+ * @return 0 si se agregó, -1 si falta memoria.
+ */
+int text_buf_append_label_value(text_buf_t* buf, const char* value)
+{
+    for (const char* p = value; *p != '\0'; p++)
+    {
+        int ret;
+        switch (*p)
+        {
+        case '\\':
+            ret = text_buf_append(buf, "\\\\", 2);
+            break;
+        case '"':
+            ret = text_buf_append(buf, "\\\"", 2);
+            break;
+        case '\n':
+            ret = text_buf_append(buf, "\\n", 2);
+            break;
+        default:
+            ret = text_buf_append(buf, p, 1);
+            break;
+        }
+        if (ret != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Libera la memoria del buffer.
+ * @param buf Buffer.
+ */
+void text_buf_free(text_buf_t* buf)
+{
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
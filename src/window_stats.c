@@ -0,0 +1,189 @@
+#include "../include/window_stats.h"
+#include <math.h>
+#include <time.h>
+
+/**
+ * @file window_stats.c
+ * @brief Implementación de las estadísticas sobre una ventana deslizante.
+ */
+
+/**
+ * @brief Posición en el buffer circular de la muestra (o del elemento de una cola) número n.
+ */
+#define WINDOW_SLOT(n) ((size_t)((n) % WINDOW_STATS_MAX_SAMPLES))
+
+/**
+ * @brief Inicializa una ventana vacía.
+ * @param window Ventana.
+ * @param window_ms Duración de la ventana en milisegundos.
+ */
+void window_stats_init(window_stats_t* window, unsigned long window_ms)
+{
+    window->window_ms = window_ms;
+    window->first = 0;
+    window->next = 0;
+    window->min_head = 0;
+    window->min_len = 0;
+    window->max_head = 0;
+    window->max_len = 0;
+    window->sum = 0;
+    ddsketch_init(&window->sketch);
+    pthread_mutex_init(&window->lock, NULL);
+}
+
+/**
+ * @brief Libera los recursos de una ventana.
+ * @param window Ventana inicializada.
+ */
+void window_stats_destroy(window_stats_t* window)
+{
+    pthread_mutex_destroy(&window->lock);
+}
+
+/**
+ * @brief Instante actual del reloj monótono.
+ * @return Milisegundos.
+ */
+static int64_t monotonic_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Descarta la muestra más vieja de la ventana.
+ * @param window Ventana con al menos una muestra.
+ */
+static void window_stats_evict(window_stats_t* window)
+{
+    uint64_t seq = window->first++;
+    double value = window->values[WINDOW_SLOT(seq)];
+
+    ddsketch_remove(&window->sketch, value);
+    if (window->first == window->next)
+    {
+        window->sum = 0; // Sin muestras, descartamos el error de redondeo acumulado
+    }
+    else
+    {
+        window->sum -= value;
+    }
+    if (window->min_len > 0 && window->min_queue[window->min_head] == seq)
+    {
+        window->min_head = WINDOW_SLOT(window->min_head + 1);
+        window->min_len--;
+    }
+    if (window->max_len > 0 && window->max_queue[window->max_head] == seq)
+    {
+        window->max_head = WINDOW_SLOT(window->max_head + 1);
+        window->max_len--;
+    }
+}
+
+/**
+ * @brief Descarta las muestras que quedaron fuera de la ventana.
+ * @param window Ventana.
+ * @param now_ms Fin de la ventana.
+ */
+static void window_stats_expire(window_stats_t* window, int64_t now_ms)
+{
+    while (window->first != window->next &&
+           now_ms - window->times[WINDOW_SLOT(window->first)] >= (int64_t)window->window_ms)
+    {
+        window_stats_evict(window);
+    }
+}
+
+/**
+ * @brief Agrega una muestra con el instante actual.
+ * @param window Ventana inicializada.
+ * @param value Valor de la muestra.
+ */
+void window_stats_add(window_stats_t* window, double value)
+{
+    window_stats_add_at(window, monotonic_ms(), value);
+}
+
+/**
+ * @brief Agrega una muestra con un instante dado.
+ * @param window Ventana inicializada.
+ * @param now_ms Instante de la muestra.
+ * @param value Valor de la muestra.
+ */
+void window_stats_add_at(window_stats_t* window, int64_t now_ms, double value)
+{
+    if (isnan(value))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&window->lock);
+    window_stats_expire(window, now_ms);
+    if (window->next - window->first == WINDOW_STATS_MAX_SAMPLES)
+    {
+        window_stats_evict(window);
+    }
+
+    uint64_t seq = window->next++;
+    window->times[WINDOW_SLOT(seq)] = now_ms;
+    window->values[WINDOW_SLOT(seq)] = value;
+    window->sum += value;
+    ddsketch_add(&window->sketch, value);
+
+    // Una muestra nueva descarta de cada cola a las anteriores que ya no pueden ser el mínimo (o el máximo): cada
+    // muestra entra y sale una sola vez, así que el costo amortizado es O(1)
+    while (window->min_len > 0 &&
+           window->values[WINDOW_SLOT(window->min_queue[WINDOW_SLOT(window->min_head + window->min_len - 1)])] >=
+               value)
+    {
+        window->min_len--;
+    }
+    window->min_queue[WINDOW_SLOT(window->min_head + window->min_len++)] = seq;
+    while (window->max_len > 0 &&
+           window->values[WINDOW_SLOT(window->max_queue[WINDOW_SLOT(window->max_head + window->max_len - 1)])] <=
+               value)
+    {
+        window->max_len--;
+    }
+    window->max_queue[WINDOW_SLOT(window->max_head + window->max_len++)] = seq;
+    pthread_mutex_unlock(&window->lock);
+}
+
+/**
+ * @brief Resume las muestras de la ventana que termina en el instante actual.
+ * @param window Ventana inicializada.
+ * @param summary Resumen.
+ */
+void window_stats_summary(window_stats_t* window, window_summary_t* summary)
+{
+    window_stats_summary_at(window, monotonic_ms(), summary);
+}
+
+/**
+ * @brief Resume las muestras de la ventana que termina en un instante dado.
+ * @param window Ventana inicializada.
+ * @param now_ms Fin de la ventana.
+ * @param summary Resumen.
+ */
+void window_stats_summary_at(window_stats_t* window, int64_t now_ms, window_summary_t* summary)
+{
+    static const double quantiles[] = {0.5, 0.95, 0.99};
+    double values[3];
+
+    pthread_mutex_lock(&window->lock);
+    // Un colector demorado deja de agregar muestras: las viejas vencen igual y la ventana queda vacía
+    window_stats_expire(window, now_ms);
+    summary->count = (size_t)(window->next - window->first);
+    if (summary->count > 0)
+    {
+        summary->min = window->values[WINDOW_SLOT(window->min_queue[window->min_head])];
+        summary->max = window->values[WINDOW_SLOT(window->max_queue[window->max_head])];
+        summary->mean = window->sum / (double)summary->count;
+        ddsketch_quantiles(&window->sketch, quantiles, values, 3);
+        summary->p50 = values[0];
+        summary->p95 = values[1];
+        summary->p99 = values[2];
+    }
+    pthread_mutex_unlock(&window->lock);
+}